@@ -1,53 +1,371 @@
 #include "ast.hpp"
+#include "python.hpp"
 #include <fstream>
 #include <iostream>
 #include <list>
+#include <map>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
-void indent(std::ofstream &fs, int lvl) {
-        for (int i = 0; i < lvl; ++i) {
-                fs << '\t';
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief  Python literal of a float. The shortest representation that gives
+ *         back the same value is used, and it always contains a '.' or an
+ *         exponent, otherwise python would read an int.
+ */
+std::string floatLiteral(double value) {
+        std::ostringstream oss;
+
+        if (std::isnan(value)) {
+                return "float('nan')";
+        } else if (std::isinf(value)) {
+                return value > 0 ? "float('inf')" : "float('-inf')";
+        }
+        for (int precision = 1; precision <= 17; ++precision) {
+                oss.str("");
+                oss << std::setprecision(precision) << value;
+                if (std::stod(oss.str()) == value) {
+                        break;
+                }
+        }
+        std::string literal = oss.str();
+        if (literal.find_first_of(".e") == std::string::npos) {
+                literal += ".0";
         }
+        return literal;
 }
 
-/* -------------------------------------------------------------------------- */
+/**
+ * @brief  Split a string literal (with its '"') in the python literals of its
+ *         characters. The escape sequences are kept as they are written.
+ */
+std::vector<std::string> characters(std::string const &literal) {
+        std::vector<std::string> chars;
+        size_t end = literal.size() - 1;
+
+        for (size_t i = 1; i < end;) {
+                size_t length = 1;
+                if (literal[i] == '\\' && i + 1 < end) {
+                        char escape = literal[i + 1];
+                        size_t digits = 0;
+                        if (escape == 'x') {
+                                digits = 2;
+                        } else if (escape == 'u') {
+                                digits = 4;
+                        } else if (escape == 'U') {
+                                digits = 8;
+                        }
+                        length = 2 + digits;
+                        // octal escapes have up to 3 digits
+                        if ('0' <= escape && escape <= '7') {
+                                length = 2;
+                                while (length < 4 && i + length < end &&
+                                       '0' <= literal[i + length] &&
+                                       literal[i + length] <= '7') {
+                                        ++length;
+                                }
+                        }
+                }
+                length = std::min(length, end - i);
+                chars.push_back("\"" + literal.substr(i, length) + "\"");
+                i += length;
+        }
+        return chars;
+}
+
+/**
+ * @brief  Code of a character given by its python literal (see characters).
+ */
+long long characterCode(std::string const &character) {
+        std::string text = character.substr(1, character.size() - 2);
+
+        if (text.size() < 2 || text[0] != '\\') {
+                return text.empty() ? 0 : (unsigned char)text[0];
+        }
+        switch (text[1]) {
+        case 'n':
+                return '\n';
+        case 't':
+                return '\t';
+        case 'r':
+                return '\r';
+        case 'a':
+                return '\a';
+        case 'b':
+                return '\b';
+        case 'f':
+                return '\f';
+        case 'v':
+                return '\v';
+        case '\\':
+        case '\'':
+        case '"':
+                return text[1];
+        case 'x':
+        case 'u':
+        case 'U':
+                return std::strtoll(text.c_str() + 2, nullptr, 16);
+        default:
+                if ('0' <= text[1] && text[1] <= '7') {
+                        return std::strtoll(text.c_str() + 1, nullptr, 8);
+                }
+                // python keeps the unknown escape sequences as they are
+                return '\\';
+        }
+}
+
+/**
+ * @brief  Bytes (UTF-8) of the text of a string literal, as python writes it.
+ */
+std::string utf8(std::string const &literal) {
+        std::string bytes;
+
+        for (std::string const &character : characters(literal)) {
+                long long code = characterCode(character);
+                if (character.size() == 3 || code < 0x80) {
+                        // the bytes of the source are already UTF-8
+                        bytes += character.size() == 3 ? character[1]
+                                                       : (char)code;
+                } else if (code < 0x800) {
+                        bytes += (char)(0xC0 | code >> 6);
+                        bytes += (char)(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                        bytes += (char)(0xE0 | code >> 12);
+                        bytes += (char)(0x80 | (code >> 6 & 0x3F));
+                        bytes += (char)(0x80 | (code & 0x3F));
+                } else {
+                        bytes += (char)(0xF0 | code >> 18);
+                        bytes += (char)(0x80 | (code >> 12 & 0x3F));
+                        bytes += (char)(0x80 | (code >> 6 & 0x3F));
+                        bytes += (char)(0x80 | (code & 0x3F));
+                }
+        }
+        return bytes;
+}
+
+/**
+ * @brief  Python tuple of the characters of a string followed by `zeros` zeros.
+ *         The tuple is a constant for python, so it is built only once.
+ */
+static void charactersTuple(Emitter &fs, std::vector<std::string> const &chars,
+                            size_t zeros) {
+        fs << "(";
+        for (std::string const &c : chars) {
+                fs << c << ",";
+        }
+        fs << ")";
+        if (zeros > 0) {
+                fs << "+(0,)*" << zeros;
+        }
+}
+
+/**
+ * @brief  Python builtin that converts a value of type `source` to the type
+ *         `target`. There is no conversion when the types are the same (the
+ *         static types are the ones of the values at runtime).
+ *
+ * @return  The name of the builtin or nullptr if no conversion is needed.
+ */
+char const *conversion(PrimitiveType target, PrimitiveType source) {
+        if (source == target) {
+                return nullptr;
+        }
+        switch (target) {
+        case INT:
+                return "int";
+        case FLT:
+                return "float";
+        case CHR:
+                // chr() converts a code, the characters are already strings
+                return source == INT ? "chr" : nullptr;
+        default:
+                return nullptr;
+        }
+}
+
+/**
+ * @brief  Open the python conversion of a value of type `source` to the type
+ *         `target`.
+ *
+ * @return  true if a conversion has been opened (it must be closed with ')').
+ */
+static bool openConversion(Emitter &fs, PrimitiveType target,
+                           PrimitiveType source) {
+        char const *builtin = conversion(target, source);
+        if (builtin != nullptr) {
+                fs << fs.name(builtin) << "(";
+        }
+        return builtin != nullptr;
+}
+
+/**
+ * @brief  Integer expression that can't be negative: sums and products of
+ *         non-negative integer constants.
+ */
+static bool isNonNegative(std::shared_ptr<Node> const &node) {
+        bool nonNegative = true;
+        visit(node, [&](std::shared_ptr<Node> const &n) {
+                auto value = std::dynamic_pointer_cast<Value>(n);
+                if (value != nullptr) {
+                        nonNegative = nonNegative && value->type() == INT &&
+                                      value->value()._int >= 0;
+                } else if (!std::dynamic_pointer_cast<AddOP>(n) &&
+                           !std::dynamic_pointer_cast<TmsOP>(n)) {
+                        nonNegative = false;
+                }
+        });
+        return nonNegative;
+}
+
+/**
+ * @brief  Compile the value given to a target of type `target`. `div` is the
+ *         true division, so an integer target gets int(a/b) which rounds
+ *         toward zero. When the operands are a non-negative integer and a
+ *         positive constant, `//` gives the same result without the float
+ *         (and the same error: there is no division by zero).
+ */
+static void compileValue(Emitter &fs, PrimitiveType target,
+                         std::shared_ptr<TypedNode> const &value) {
+        auto division = std::dynamic_pointer_cast<DivOP>(value);
+        auto divisor = division != nullptr
+                               ? std::dynamic_pointer_cast<Value>(
+                                         division->right())
+                               : nullptr;
+        if (target == INT && divisor != nullptr && divisor->type() == INT &&
+            divisor->value()._int > 0 && isNonNegative(division->left())) {
+                fs << "(";
+                fs.node(division->left());
+                fs << "//";
+                fs.node(division->right());
+                fs << ")";
+                return;
+        }
+        bool conversion = openConversion(fs, target, value->type());
+        fs.node(value);
+        if (conversion) {
+                fs << ")";
+        }
+}
+
+/**
+ * @brief  Read conversion of the value given by `input()`.
+ */
+char const *readConversion(PrimitiveType type) {
+        switch (type) {
+        case INT:
+                return "int";
+        case FLT:
+                return "float";
+        default:
+                return nullptr;
+        }
+}
+
+/**
+ * @brief  Globals and builtins that are looked up at each iteration of the
+ *         loops of a function. The nested loops are marked when their outer
+ *         loop is treated, so each node is visited at most twice.
+ */
+static std::set<std::string> loopGlobals(std::shared_ptr<Block> const &block) {
+        std::set<std::string> globals;
+        std::unordered_set<Node *> nested;
+
+        visit(block, [&](std::shared_ptr<Node> const &loop) {
+                if ((!std::dynamic_pointer_cast<For>(loop) &&
+                     !std::dynamic_pointer_cast<Whl>(loop)) ||
+                    nested.count(loop.get())) {
+                        return;
+                }
+                visit(loop, [&](std::shared_ptr<Node> const &node) {
+                        char const *builtin = nullptr;
+
+                        if (node == loop) {
+                                return;
+                        } else if (std::dynamic_pointer_cast<For>(node)) {
+                                nested.insert(node.get());
+                                builtin = "range";
+                        } else if (std::dynamic_pointer_cast<Whl>(node)) {
+                                nested.insert(node.get());
+                        } else if (auto call = std::dynamic_pointer_cast<
+                                           FunctionCall>(node)) {
+                                globals.insert(call->functionName());
+                        } else if (std::dynamic_pointer_cast<Print>(node)) {
+                                builtin = "print";
+                        } else if (auto read =
+                                           std::dynamic_pointer_cast<Read>(
+                                                   node)) {
+                                globals.insert("input");
+                                builtin = readConversion(
+                                        read->variable()->type());
+                        } else if (auto assignment = std::dynamic_pointer_cast<
+                                           Assignment>(node)) {
+                                builtin = conversion(
+                                        assignment->variable()->type(),
+                                        assignment->value()->type());
+                        } else if (auto ret = std::dynamic_pointer_cast<
+                                           Return>(node)) {
+                                auto value = std::dynamic_pointer_cast<
+                                        TypedNode>(ret->returnExpr());
+                                if (value != nullptr && value->type() != NIL) {
+                                        builtin = conversion(ret->type(),
+                                                             value->type());
+                                }
+                        }
+                        if (builtin != nullptr) {
+                                globals.insert(builtin);
+                        }
+                });
+        });
+        return globals;
+}
 
-void Value::display() {
+void Value::display(Emitter &fs) {
         switch (type_) {
         case INT:
-                std::cout << value_._int;
+                fs << value_._int;
                 break;
         case FLT:
-                std::cout << value_._flt;
+                fs << value_._flt;
                 break;
         case CHR:
-                std::cout << "'" << value_._chr << "'";
+                fs << "'" << value_._chr << "'";
                 break;
         default:
                 break;
         }
 }
 
-void Value::compile(std::ofstream &fs, int) {
+void Value::compile(Emitter &fs, int) {
         switch (type_) {
         case INT:
                 fs << value_._int;
                 break;
         case FLT:
-                fs << value_._flt;
+                fs << floatLiteral(value_._flt);
                 break;
         case CHR:
                 fs << "'" << value_._chr << "'";
                 break;
         case ARR_CHR: {
                 // WARN: the '"' are in the string (this may change).
-                // TODO: this doesn't work, the value is technically correct but
-                // it doesn't take in count the size of the targeted array.
-                std::string str = value_._str;
-                fs << "[c for c in " << str << "]+[0]";
+                // the size of the targeted array is given by the assignment
+                // or the call (see FunctionCall::sizes)
+                fs << "[";
+                for (std::string const &c : characters(value_._str)) {
+                        fs << c << ",";
+                }
+                fs << "0]";
         } break;
         default:
                 break;
@@ -56,140 +374,332 @@ void Value::compile(std::ofstream &fs, int) {
 
 /* -------------------------------------------------------------------------- */
 
-void Variable::display() { std::cout << id_; }
+void Variable::display(Emitter &fs) { fs << id_; }
 
-void Variable::compile(std::ofstream &fs, int) { fs << id_; }
+void Variable::compile(Emitter &fs, int) { fs << id_; }
 
 /* -------------------------------------------------------------------------- */
 
-void ArrayDeclaration::display() {
-        std::cout << this->id() << "[" << size_ << "]";
+void ArrayDeclaration::display(Emitter &fs) {
+        fs << this->id() << "[" << size_ << "]";
 }
 
-void ArrayDeclaration::compile(std::ofstream &fs, int lvl) {
+void ArrayDeclaration::compile(Emitter &fs, int lvl) {
         indent(fs, lvl);
-        fs << this->id() << "=[0 for _ in range(" << size_ << ")]";
+        if (buffer_) {
+                fs << this->id() << "=numpy.zeros(" << size_ << ",dtype=numpy."
+                   << (type_ == ARR_FLT ? "float64" : "int64") << ")";
+        } else {
+                fs << this->id() << "=[" << (type_ == ARR_FLT ? "0.0" : "0")
+                   << "]*" << size_;
+        }
 }
 
-void ArrayAccess::display() {
-        std::cout << Variable::id() << "[";
-        index_->display();
-        std::cout << "]";
+void ArrayAccess::display(Emitter &fs) {
+        fs << Variable::id() << "[";
+        fs.node(index_);
+        fs << "]";
 }
 
-void ArrayAccess::compile(std::ofstream &fs, int) {
+void ArrayAccess::compile(Emitter &fs, int) {
         fs << Variable::id() << "[";
-        index_->compile(fs, 0);
+        fs.node(index_);
         fs << "]";
 }
 
 /* -------------------------------------------------------------------------- */
 
 
-void Function::display() {
-        std::cout << "Function(" << id_ << ", [";
+void Function::display(Emitter &fs) {
+        fs << "Function(" << id_ << ", [";
         for (Variable p : parameters_) {
-                p.display();
-                std::cout << ", ";
+                fs << p.id();
+                fs << ", ";
+        }
+        fs << "], ";
+        fs.node(block_);
+        fs << ")" << std::endl;
+}
+
+/**
+ * @brief  Increment of a counter of the profile in the instrumented script
+ *         (see Profile).
+ */
+static void increment(Emitter &fs, int lvl, size_t counter,
+                      std::string const &amount = "1") {
+        indent(fs, lvl);
+        fs << "_profile[" << counter << "]+=" << amount << std::endl;
+}
+
+/**
+ * @brief  Annotation of a type in the typed script. The arrays of characters
+ *         hold strings and the zeros of their end, so they are plain lists.
+ */
+static std::string annotation(PrimitiveType type) {
+        switch (type) {
+        case INT:
+                return "int";
+        case FLT:
+                return "float";
+        case CHR:
+                return "str";
+        case ARR_INT:
+                return "list[int]";
+        case ARR_FLT:
+                return "list[float]";
+        case ARR_CHR:
+                return "list";
+        default:
+                return "None";
+        }
+}
+
+/**
+ * @brief  Locals of a function (the variables of its body, the declarations
+ *         may have been removed by the optimizations), with their annotation.
+ *         A name used with different types is not annotated.
+ */
+static std::list<std::pair<std::string, std::string>>
+typedLocals(std::shared_ptr<Block> const &block,
+            std::list<Variable> const &parameters) {
+        std::list<std::pair<std::string, std::string>> locals;
+        std::map<std::string, PrimitiveType> types;
+        std::set<std::string> conflicts;
+        auto add = [&](Variable const &variable) {
+                auto found = types.find(variable.id());
+                if (found == types.end()) {
+                        types[variable.id()] = variable.type();
+                        locals.push_back(
+                                {variable.id(), annotation(variable.type())});
+                } else if (found->second != variable.type()) {
+                        conflicts.insert(variable.id());
+                }
+        };
+
+        for (Variable const &parameter : parameters) {
+                conflicts.insert(parameter.id());
+        }
+        visit(block, [&](std::shared_ptr<Node> const &node) {
+                if (auto declaration =
+                            std::dynamic_pointer_cast<Declaration>(node)) {
+                        add(declaration->variable());
+                } else if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+                        add(loop->variable());
+                } else if (std::dynamic_pointer_cast<ArrayAccess>(node)) {
+                        return; // typed with the type of the element
+                } else if (auto variable =
+                                   std::dynamic_pointer_cast<Variable>(node)) {
+                        add(*variable);
+                }
+        });
+        locals.remove_if([&](auto const &local) {
+                return conflicts.count(local.first) > 0 ||
+                       local.second == "None";
+        });
+        return locals;
+}
+
+/**
+ * @brief  Type of a value given to the library of the native functions.
+ */
+static char const *ctype(PrimitiveType type) {
+        return type == FLT ? "ctypes.c_double" : "ctypes.c_int64";
+}
+
+/**
+ * @brief  The native function calls its entry in the library (see
+ *         CEmitter::emitLibrary), the arrays are given as the address of their
+ *         elements and their size.
+ */
+void Function::compileNative(Emitter &fs) {
+        std::string entry = "_py_" + id_ + "_";
+        std::list<std::string> types;
+        std::list<std::string> arguments;
+
+        for (Variable const &parameter : parameters_) {
+                if (isArray(parameter.type())) {
+                        types.push_back("ctypes.c_void_p");
+                        types.push_back("ctypes.c_int64");
+                        arguments.push_back(parameter.id() + ".ctypes.data");
+                        arguments.push_back("len(" + parameter.id() + ")");
+                } else {
+                        types.push_back(ctype(parameter.type()));
+                        arguments.push_back(parameter.id());
+                }
+        }
+        fs << entry << "=_native_.py_" << id_ << std::endl;
+        fs << entry << ".argtypes=(";
+        for (std::string const &type : types) {
+                fs << type << ",";
+        }
+        fs << ")" << std::endl;
+        fs << entry << ".restype="
+           << (type() == NIL ? "None" : ctype(type())) << std::endl;
+        fs << "def " << id_ << "(";
+        for (Variable const &parameter : parameters_) {
+                fs << (&parameter == &parameters_.front() ? "" : ",")
+                   << parameter.id();
+                if (typed_) {
+                        fs << ":" << annotation(parameter.type());
+                }
+        }
+        fs << ")";
+        if (typed_) {
+                fs << "->" << annotation(type());
+        }
+        fs << ":" << std::endl;
+        indent(fs, 1);
+        fs << (type() == NIL ? "" : "_r=") << entry << "(";
+        for (std::string const &argument : arguments) {
+                fs << (&argument == &arguments.front() ? "" : ",")
+                   << argument;
+        }
+        fs << ")" << std::endl;
+        indent(fs, 1);
+        fs << "if _native_failed_.value:" << std::endl;
+        indent(fs, 2);
+        fs << "_native_error_()" << std::endl;
+        if (type() != NIL) {
+                indent(fs, 1);
+                fs << "return _r" << std::endl;
         }
-        std::cout << "], ";
-        block_->display();
-        std::cout << ")" << std::endl;
 }
 
-void Function::compile(std::ofstream &fs, int) {
+/**
+ * @brief  The globals and the builtins used in the loops are bound to locals
+ *         (LOAD_FAST instead of a dictionary lookup at each iteration). The
+ *         builtins are given as default arguments, so they are bound once when
+ *         the function is defined. The user functions may not be defined yet at
+ *         this point, so they are bound when the function starts.
+ */
+void Function::compile(Emitter &fs, int) {
+        if (native_) {
+                compileNative(fs);
+                return;
+        }
+        std::set<std::string> globals = loopGlobals(block_);
+        std::list<std::string> arguments;
+        std::list<std::string> prologue;
+
+        for (Variable const &parameter : parameters_) {
+                arguments.push_back(
+                        typed_ ? parameter.id() + ":" +
+                                         annotation(parameter.type())
+                               : parameter.id());
+        }
+        for (std::string const &global : globals) {
+                std::string local = "_" + global + "_";
+                bool builtin = global == "print" || global == "input" ||
+                               global == "int" || global == "float" ||
+                               global == "chr" || global == "range";
+                if (builtin) {
+                        arguments.push_back(local + "=" + global);
+                } else {
+                        prologue.push_back(local + "=" + global);
+                }
+                fs.local(global, local);
+        }
+
+        if (memoized_) {
+                fs << "@functools.lru_cache(maxsize=None)" << std::endl;
+        }
         fs << "def " << id_ << "(";
-        if (parameters_.size() > 0) {
-                std::list<Variable> tmp = parameters_;
-                tmp.front().compile(fs, 0);
-                tmp.pop_front();
-                for (Variable v : tmp) {
+        for (std::string const &argument : arguments) {
+                if (argument != arguments.front()) {
                         fs << ",";
-                        v.compile(fs, 0);
                 }
+                fs << argument;
         }
-        fs << "):" << std::endl;
-        block_->compile(fs, 0);
+        fs << ")";
+        if (typed_) {
+                fs << "->" << annotation(type());
+        }
+        fs << ":" << std::endl;
+        // the annotations don't assign the locals, reading them before their
+        // assignment is still an error
+        if (typed_) {
+                for (auto const &[id, type] :
+                     typedLocals(block_, parameters_)) {
+                        indent(fs, 1);
+                        fs << id << ":" << type << std::endl;
+                }
+        }
+        for (std::string const &binding : prologue) {
+                indent(fs, 1);
+                fs << binding << std::endl;
+        }
+        if (instrumented()) {
+                increment(fs, 1, site());
+        }
+        fs.node(block_);
 }
 
 /* -------------------------------------------------------------------------- */
 
 
-void Block::display() {
-        std::cout << "Block(" << std::endl;
+void Block::display(Emitter &fs) {
+        fs << "Block(" << std::endl;
         for (std::shared_ptr<Node> o : instructions_) {
-                o->display();
+                fs.node(o);
         }
-        std::cout << ")" << std::endl;
+        fs << ")" << std::endl;
 }
 
-void Block::compile(std::ofstream &fs, int lvl) {
+void Block::compile(Emitter &fs, int lvl) {
+        // python doesn't allow empty blocks
+        if (instructions_.empty()) {
+                indent(fs, lvl + 1);
+                fs << "pass" << std::endl;
+        }
         for (std::shared_ptr<Node> op : instructions_) {
-                op->compile(fs, lvl + 1);
+                fs.node(op, lvl + 1);
                 fs << std::endl;
         }
 }
 
 /* -------------------------------------------------------------------------- */
 
-void Assignment::display() {
-        std::cout << "Assignment(";
-        variable_->display();
-        std::cout << ",";
-        value_->display();
-        std::cout << ")" << std::endl;
+void Assignment::display(Emitter &fs) {
+        fs << "Assignment(";
+        fs.node(variable_);
+        fs << ",";
+        fs.node(value_);
+        fs << ")" << std::endl;
 }
 
-void Assignment::compile(std::ofstream &fs, int lvl) {
+void Assignment::compile(Emitter &fs, int lvl) {
         indent(fs, lvl);
-        // TODO: find a better way to handle this case
-        if (variable_->type() == ARR_CHR && value_->type() == ARR_CHR) {
-                std::shared_ptr<Array> array = std::dynamic_pointer_cast<Array>(variable_);
-                std::shared_ptr<Value> val = std::dynamic_pointer_cast<Value>(value_);
-                // WARN: the value contains the '"'
-                std::string str = val->value()._str;
+        // a string is copied in the array (the end is filled with zeros)
+        auto str = std::dynamic_pointer_cast<Value>(value_);
+        if (variable_->type() == ARR_CHR && str != nullptr &&
+            str->type() == ARR_CHR) {
+                std::shared_ptr<Array> array =
+                        std::dynamic_pointer_cast<Array>(variable_);
+                std::vector<std::string> chars = characters(str->value()._str);
                 // TODO: this should be done at runtime !
-                unsigned int size = std::min(array->size(), (int) str.size() - 2 + 1);
+                size_t size = array->size();
+                // the last character is always a zero
+                chars.resize(std::min(chars.size(), size > 0 ? size - 1 : 0));
 
-                // reset the array before assignment of the string
-                fs << array->id() << "=[0 for _ in range(" << array->size() << ")]" << std::endl;
-                indent(fs, lvl);
-                fs << "for _ZZ_TRANSPILER_STRINGSET_INDEX in range(" << size - 1 << "):" << std::endl;
-                indent(fs, lvl + 1);
-                fs << variable_->id() << "[_ZZ_TRANSPILER_STRINGSET_INDEX]=";
-                fs << str << "[_ZZ_TRANSPILER_STRINGSET_INDEX]";
+                fs << array->id() << "[:]=";
+                charactersTuple(fs, chars, size - chars.size());
         } else {
-                variable_->compile(fs, lvl);
+                fs.node(variable_, lvl);
                 fs << "=";
-                switch (variable_->type()) {
-                case INT:
-                        fs << "int(";
-                        break;
-                case CHR:
-                        fs << "chr(";
-                        break;
-                case FLT:
-                        fs << "float(";
-                        break;
-                default:
-                        fs << "(";
-                        break;
-                }
-                value_->compile(fs, lvl);
-                fs << ")";
+                compileValue(fs, variable_->type(), value_);
         }
 }
 
 /* -------------------------------------------------------------------------- */
 
 
-void Declaration::display() {
-        std::cout << "Declaration(";
-        variable_.display();
-        std::cout << ")" << std::endl;
+void Declaration::display(Emitter &fs) {
+        fs << "Declaration(";
+        fs << variable_.id();
+        fs << ")" << std::endl;
 }
 
-void Declaration::compile(std::ofstream &fs, int lvl) {
+void Declaration::compile(Emitter &fs, int lvl) {
         indent(fs, lvl);
         fs << "# " << variable_.type() << " "
            << variable_.id();
@@ -197,23 +707,43 @@ void Declaration::compile(std::ofstream &fs, int lvl) {
 
 /* -------------------------------------------------------------------------- */
 
-void FunctionCall::display() {
-        std::cout << "Funcall(" << functionName_ << ", [";
+void FunctionCall::display(Emitter &fs) {
+        fs << "Funcall(" << functionName_ << ", [";
         for (std::shared_ptr<Node> p : params_) {
-                p->display();
-                std::cout << ", ";
+                fs.node(p);
+                fs << ", ";
         }
-        std::cout << "])" << std::endl;
+        fs << "])" << std::endl;
 }
 
-void FunctionCall::compile(std::ofstream &fs, int lvl) {
-        // TODO: there is more work to do when we pas a string to the function
+void FunctionCall::compile(Emitter &fs, int lvl) {
         indent(fs, lvl);
-        fs << functionName_ << "(";
-        for (std::shared_ptr<Node> p : params_) {
-                p->compile(fs, 0);
-                if (p != params_.back())
+        fs << fs.name(functionName_) << "(";
+        // the same node can be given twice (see CommonSubexpressionEliminator)
+        auto size = sizes_.begin();
+        auto type = parameterTypes_.begin();
+        for (auto it = params_.begin(); it != params_.end(); ++it) {
+                if (it != params_.begin()) {
                         fs << ',';
+                }
+                // the parameters have their declared types (see Assignment)
+                if (type != parameterTypes_.end()) {
+                        compileValue(fs, *type++, *it);
+                } else {
+                        fs.node(*it);
+                }
+                // a string is filled with zeros up to the size of the array
+                auto str = std::dynamic_pointer_cast<Value>(*it);
+                if (str != nullptr && str->type() == ARR_CHR &&
+                    size != sizes_.end()) {
+                        int length = characters(str->value()._str).size() + 1;
+                        if (*size > length) {
+                                fs << "+[0]*" << *size - length;
+                        }
+                }
+                if (size != sizes_.end()) {
+                        ++size;
+                }
         }
         fs << ")";
 }
@@ -224,141 +754,394 @@ void FunctionCall::compile(std::ofstream &fs, int lvl) {
 
 /* -------------------------------------------------------------------------- */
 
-void Cnd::display() {
-        std::cout << "If(";
-        condition_->display();
-        std::cout << ", ";
-        block_->display();
+void Cnd::display(Emitter &fs) {
+        fs << "If(";
+        fs.node(condition_);
+        fs << ", ";
+        fs.node(block_);
         if (elseBlock_ != nullptr) { // print else block if needed
-                std::cout << ", Else(";
-                elseBlock_->display();
-                std::cout << ")" << std::endl;
+                fs << ", Else(";
+                fs.node(elseBlock_);
+                fs << ")" << std::endl;
         }
-        std::cout << ")" << std::endl;
+        fs << ")" << std::endl;
 }
 
-void Cnd::compile(std::ofstream &fs, int lvl) {
+void Cnd::compile(Emitter &fs, int lvl) {
+        if (instrumented()) {
+                increment(fs, lvl, site());
+        }
         indent(fs, lvl);
         fs << "if ";
-        condition_->compile(fs, 0);
+        fs.node(condition_);
         fs << ":" << std::endl;
-        block_->compile(fs, lvl);
+        if (instrumented()) {
+                increment(fs, lvl + 1, site() + 1);
+        }
+        fs.node(block_, lvl);
         if (elseBlock_ != nullptr) {
                 indent(fs, lvl);
                 fs << "else:" << std::endl;
-                elseBlock_->compile(fs, lvl);
+                fs.node(elseBlock_, lvl);
         }
 }
 
 /* -------------------------------------------------------------------------- */
 
-void For::display() {
-        std::cout << "For(";
-        variable_.display();
-        std::cout << ", range(";
-        begin_->display();
-        std::cout << ",";
-        end_->display();
-        std::cout << ",";
-        step_->display();
-        std::cout << "), ";
-        block_->display();
-        std::cout << ")" << std::endl;
-}
-
-void For::compile(std::ofstream &fs, int lvl) {
+void For::display(Emitter &fs) {
+        fs << "For(";
+        fs << variable_.id();
+        fs << ", range(";
+        fs.node(begin_);
+        fs << ",";
+        fs.node(end_);
+        fs << ",";
+        fs.node(step_);
+        fs << "), ";
+        fs.node(block_);
+        fs << ")" << std::endl;
+}
+
+/**
+ * @brief  Assignment of a vectorized loop on the slices of the arrays. The loop
+ *         variable is a range (`numpy.arange`) and the other variables are
+ *         broadcast. NumPy converts the values to the type of the array. The
+ *         `exact` assignment computes the int values on Python integers (the
+ *         NumPy integers have 64 bits and wrap around silently).
+ */
+static std::string vectorize(std::shared_ptr<Node> const &assignment,
+                             std::string const &variable, bool exact) {
+        std::ostringstream oss;
+        char const *object = exact ? ".astype(object)" : "";
+
+        Emitter::generate(oss, assignment, 0, [&](Node &node, Emitter &fs,
+                                                  int) {
+                if (auto set = dynamic_cast<Assignment *>(&node)) {
+                        fs << set->variable()->id() << "[_lo:_hi]=";
+                        fs.node(set->value());
+                } else if (auto access = dynamic_cast<ArrayAccess *>(&node)) {
+                        fs << access->id() << "[_lo:_hi]"
+                           << (access->type() == INT ? object : "");
+                } else if (dynamic_cast<Variable *>(&node) != nullptr &&
+                           dynamic_cast<Variable *>(&node)->id() == variable) {
+                        fs << "numpy.arange(_lo,_hi"
+                           << (exact ? ",dtype=object" : "") << ")";
+                } else {
+                        node.compile(fs, 0);
+                }
+        });
+        return oss.str();
+}
+
+static bool isIntArithmetic(std::shared_ptr<Node> const &node) {
+        auto typed = std::dynamic_pointer_cast<TypedNode>(node);
+        return typed != nullptr && typed->type() == INT &&
+               (std::dynamic_pointer_cast<AddOP>(node) ||
+                std::dynamic_pointer_cast<MnsOP>(node) ||
+                std::dynamic_pointer_cast<TmsOP>(node));
+}
+
+/**
+ * @brief  Condition under which the int operations of a vectorized assignment
+ *         cannot overflow (empty when there is none). The magnitude of each
+ *         value, plus one, is bounded in flt by the largest element of the
+ *         slices and the variables, then the sum of the bounds for `add` and
+ *         `mns` and their product for `tms`, so the bound of an operation is
+ *         above the ones of its operands. The margin of 2**62 covers the
+ *         rounding of the flt.
+ */
+static std::string overflowGuard(std::shared_ptr<Node> const &assignment,
+                                 std::string const &variable) {
+        std::list<std::shared_ptr<Node>> operations;
+        std::vector<std::shared_ptr<Node>> stack = {
+                std::dynamic_pointer_cast<Assignment>(assignment)->value()};
+        std::ostringstream oss;
+
+        // the outermost int operations, the flt ones are not bounded
+        while (!stack.empty()) {
+                std::shared_ptr<Node> node = stack.back();
+                stack.pop_back();
+                auto operation =
+                        std::dynamic_pointer_cast<BinaryOperation>(node);
+                if (isIntArithmetic(node)) {
+                        operations.push_back(node);
+                } else if (operation != nullptr) {
+                        stack.push_back(operation->right());
+                        stack.push_back(operation->left());
+                }
+        }
+        for (std::shared_ptr<Node> const &operation : operations) {
+                oss << (oss.tellp() > 0 ? " and " : "");
+                Emitter::generate(oss, operation, 0, [&](Node &node,
+                                                         Emitter &fs, int) {
+                        auto binary = dynamic_cast<BinaryOperation *>(&node);
+                        auto access = dynamic_cast<ArrayAccess *>(&node);
+                        auto var = dynamic_cast<Variable *>(&node);
+                        auto value = dynamic_cast<Value *>(&node);
+                        if (binary != nullptr) {
+                                fs << "(";
+                                fs.node(binary->left());
+                                fs << (dynamic_cast<TmsOP *>(&node) ? "*"
+                                                                    : "+");
+                                fs.node(binary->right());
+                                fs << ")";
+                        } else if (access != nullptr) {
+                                fs << "(numpy.abs(" << access->id()
+                                   << "[_lo:_hi],dtype=numpy.float64)"
+                                   << ".max()+1)";
+                        } else if (var != nullptr && var->id() == variable) {
+                                fs << "_hi";
+                        } else if (value != nullptr) {
+                                long long v = value->value()._int;
+                                fs << (v < 0 ? 0ULL - v : 0ULL + v) + 1;
+                        } else {
+                                fs << "(numpy.abs(numpy.float64(";
+                                node.compile(fs, 0);
+                                fs << "))+1)";
+                        }
+                });
+                oss << "<2**62";
+        }
+        return oss.str();
+}
+
+/**
+ * @brief  Statement of a loop idiom on the slice of the array (see LoopIdioms).
+ *         The sum and the extrema start from the value of the variable, so
+ *         the additions and the comparisons are done in the same order as in
+ *         the loop.
+ */
+void For::compileIdiom(Emitter &fs) {
+        std::shared_ptr<Node> statement = block_->instructions().front();
+        char const *extremum = idiom_ == MINIMUM ? "min" : "max";
+
+        if (auto cnd = std::dynamic_pointer_cast<Cnd>(statement)) {
+                statement = cnd->block()->instructions().front();
+        }
+        auto assignment = std::dynamic_pointer_cast<Assignment>(statement);
+        std::shared_ptr<Variable> target = assignment->variable();
+        std::shared_ptr<Node> value = assignment->value();
+
+        switch (idiom_) {
+        case SUM: {
+                auto add = std::dynamic_pointer_cast<BinaryOperation>(value);
+                auto access = std::dynamic_pointer_cast<ArrayAccess>(
+                        add->left());
+                if (access == nullptr) {
+                        access = std::dynamic_pointer_cast<ArrayAccess>(
+                                add->right());
+                }
+                fs << target->id() << "=" << fs.name("sum") << "("
+                   << access->id() << "[_lo:_hi]," << target->id() << ")";
+        } break;
+        case MINIMUM:
+        case MAXIMUM:
+                fs << target->id() << "=" << fs.name(extremum) << "("
+                   << target->id() << ",*"
+                   << std::dynamic_pointer_cast<ArrayAccess>(value)->id()
+                   << "[_lo:_hi])";
+                break;
+        default: {
+                auto typed = std::dynamic_pointer_cast<TypedNode>(value);
+                fs << target->id() << "[_lo:_hi]=[";
+                bool conversion =
+                        openConversion(fs, target->type(), typed->type());
+                fs.node(value);
+                fs << (conversion ? ")" : "") << "]*(_hi-_lo)";
+        } break;
+        }
+}
+
+/**
+ * @brief  Loop generated with operations on the slices of the arrays (see
+ *         Vectorizer and LoopIdioms). The slices are used only when the loop
+ *         runs and its indices are in the arrays (a negative index or an
+ *         index after the end is an error in the loop but not in a slice),
+ *         otherwise the loop is run. There is no check when the range is
+ *         known to be in the arrays.
+ */
+void For::compileSliced(Emitter &fs, int lvl) {
+        std::set<std::string> arrays;
+        int inner = inBounds_ ? lvl : lvl + 1;
+
+        visit(block_, [&](std::shared_ptr<Node> const &node) {
+                auto access = std::dynamic_pointer_cast<ArrayAccess>(node);
+                if (access != nullptr) {
+                        arrays.insert(access->id());
+                }
+        });
+        if (instrumented()) {
+                increment(fs, lvl, site());
+        }
+        indent(fs, lvl);
+        fs << "_lo,_hi=";
+        fs.node(begin_);
+        fs << ",";
+        fs.node(end_);
+        fs << std::endl;
+        if (!inBounds_) {
+                indent(fs, lvl);
+                fs << "if 0<=_lo<_hi";
+                for (std::string const &array : arrays) {
+                        fs << " and _hi<=len(" << array << ")";
+                }
+                fs << ":" << std::endl;
+        }
+        if (instrumented()) {
+                increment(fs, inner, site() + 1, "_hi-_lo");
+        }
+        if (vectorized_) {
+                for (std::shared_ptr<Node> const &assignment :
+                     block_->instructions()) {
+                        std::string guard =
+                                overflowGuard(assignment, variable_.id());
+                        indent(fs, inner);
+                        if (guard.empty()) {
+                                fs << vectorize(assignment, variable_.id(),
+                                                false)
+                                   << std::endl;
+                                continue;
+                        }
+                        fs << "if " << guard << ":" << std::endl;
+                        indent(fs, inner + 1);
+                        fs << vectorize(assignment, variable_.id(), false)
+                           << std::endl;
+                        indent(fs, inner);
+                        fs << "else:" << std::endl;
+                        indent(fs, inner + 1);
+                        fs << vectorize(assignment, variable_.id(), true)
+                           << std::endl;
+                }
+        } else {
+                indent(fs, inner);
+                compileIdiom(fs);
+                fs << std::endl;
+        }
+        indent(fs, inner);
+        fs << variable_.id() << "=_hi-1" << std::endl;
+        if (inBounds_) {
+                return;
+        }
+        indent(fs, lvl);
+        fs << "else:" << std::endl;
+        indent(fs, lvl + 1);
+        fs << "for " << variable_.id() << " in " << fs.name("range")
+           << "(_lo,_hi):" << std::endl;
+        if (instrumented()) {
+                increment(fs, lvl + 2, site() + 1);
+        }
+        fs.node(block_, lvl + 1);
+}
+
+void For::compile(Emitter &fs, int lvl) {
+        if (vectorized_ || idiom_ != LOOP) {
+                compileSliced(fs, lvl);
+                return;
+        }
         // TODO: vérifier les type et cast si besoin
+        if (instrumented()) {
+                increment(fs, lvl, site());
+        }
         indent(fs, lvl);
         fs << "for ";
-        variable_.compile(fs, 0);
-        fs << " in range(";
-        begin_->compile(fs, 0);
+        fs << variable_.id();
+        fs << " in " << fs.name("range") << "(";
+        fs.node(begin_);
         fs << ",";
-        end_->compile(fs, 0);
+        fs.node(end_);
         fs << ",";
-        step_->compile(fs, 0);
+        fs.node(step_);
         fs << "):" << std::endl;
-        block_->compile(fs, lvl);
+        if (instrumented()) {
+                increment(fs, lvl + 1, site() + 1);
+        }
+        fs.node(block_, lvl);
 }
 
 /* -------------------------------------------------------------------------- */
 
-void Whl::display() {
-        std::cout << "While(";
-        condition_->display();
-        std::cout << ", ";
-        block_->display();
-        std::cout << ")" << std::endl;
+void Whl::display(Emitter &fs) {
+        fs << "While(";
+        fs.node(condition_);
+        fs << ", ";
+        fs.node(block_);
+        fs << ")" << std::endl;
 }
 
-void Whl::compile(std::ofstream &fs, int lvl) {
+void Whl::compile(Emitter &fs, int lvl) {
+        if (instrumented()) {
+                increment(fs, lvl, site());
+        }
         indent(fs, lvl);
         fs << "while ";
-        condition_->compile(fs, 0);
+        fs.node(condition_);
         fs << ":" << std::endl;
-        block_->compile(fs, lvl);
+        if (instrumented()) {
+                increment(fs, lvl + 1, site() + 1);
+        }
+        fs.node(block_, lvl);
 }
 
 /******************************************************************************/
 /*                           arithemtic operations                            */
 /******************************************************************************/
 
-void BinaryOperation::display() {
-        left_->display();
-        std::cout << ", ";
-        right_->display();
-        std::cout << ")";
+void BinaryOperation::display(Emitter &fs) {
+        fs.node(left_);
+        fs << ", ";
+        fs.node(right_);
+        fs << ")";
 }
 
-void AddOP::display() {
-        std::cout << "AddOP(";
-        BinaryOperation::display();
+void AddOP::display(Emitter &fs) {
+        fs << "AddOP(";
+        BinaryOperation::display(fs);
 }
 
-void AddOP::compile(std::ofstream &fs, int) {
+void AddOP::compile(Emitter &fs, int) {
         fs << "(";
-        left_->compile(fs, 0);
+        fs.node(left_);
         fs << "+";
-        right_->compile(fs, 0);
+        fs.node(right_);
         fs << ")";
 }
 
-void MnsOP::display() {
-        std::cout << "MnsOP(";
-        BinaryOperation::display();
+void MnsOP::display(Emitter &fs) {
+        fs << "MnsOP(";
+        BinaryOperation::display(fs);
 }
 
-void MnsOP::compile(std::ofstream &fs, int) {
+void MnsOP::compile(Emitter &fs, int) {
         fs << "(";
-        left_->compile(fs, 0);
+        fs.node(left_);
         fs << "-";
-        right_->compile(fs, 0);
+        fs.node(right_);
         fs << ")";
 }
 
-void TmsOP::display() {
-        std::cout << "TmsOP(";
-        BinaryOperation::display();
+void TmsOP::display(Emitter &fs) {
+        fs << "TmsOP(";
+        BinaryOperation::display(fs);
 }
 
-void TmsOP::compile(std::ofstream &fs, int) {
+void TmsOP::compile(Emitter &fs, int) {
         fs << "(";
-        left_->compile(fs, 0);
+        fs.node(left_);
         fs << "*";
-        right_->compile(fs, 0);
+        fs.node(right_);
         fs << ")";
 }
 
-void DivOP::display() {
-        std::cout << "DivOP(";
-        BinaryOperation::display();
+void DivOP::display(Emitter &fs) {
+        fs << "DivOP(";
+        BinaryOperation::display(fs);
 }
 
-void DivOP::compile(std::ofstream &fs, int) {
+void DivOP::compile(Emitter &fs, int) {
         fs << "(";
-        left_->compile(fs, 0);
+        fs.node(left_);
         fs << "/";
-        right_->compile(fs, 0);
+        fs.node(right_);
         fs << ")";
 }
 
@@ -366,103 +1149,109 @@ void DivOP::compile(std::ofstream &fs, int) {
 /*                             boolean operations                             */
 /******************************************************************************/
 
-void EqlOP::display() {
-        std::cout << "EqlOP(";
-        BinaryOperation::display();
+void EqlOP::display(Emitter &fs) {
+        fs << "EqlOP(";
+        BinaryOperation::display(fs);
 }
 
-void EqlOP::compile(std::ofstream &fs, int) {
-        left_->compile(fs, 0);
+void EqlOP::compile(Emitter &fs, int) {
+        fs.node(left_);
         fs << "==";
-        right_->compile(fs, 0);
+        fs.node(right_);
 }
 
-void SupOP::display() {
-        std::cout << "SupOP(";
-        BinaryOperation::display();
+void SupOP::display(Emitter &fs) {
+        fs << "SupOP(";
+        BinaryOperation::display(fs);
 }
 
-void SupOP::compile(std::ofstream &fs, int) {
-        left_->compile(fs, 0);
+void SupOP::compile(Emitter &fs, int) {
+        fs.node(left_);
         fs << ">";
-        right_->compile(fs, 0);
+        fs.node(right_);
 }
 
-void InfOP::display() {
-        std::cout << "InfOP(";
-        BinaryOperation::display();
+void InfOP::display(Emitter &fs) {
+        fs << "InfOP(";
+        BinaryOperation::display(fs);
 }
 
-void InfOP::compile(std::ofstream &fs, int) {
-        left_->compile(fs, 0);
+void InfOP::compile(Emitter &fs, int) {
+        fs.node(left_);
         fs << "<";
-        right_->compile(fs, 0);
+        fs.node(right_);
 }
 
-void SeqOP::display() {
-        std::cout << "SeqOP(";
-        BinaryOperation::display();
+void SeqOP::display(Emitter &fs) {
+        fs << "SeqOP(";
+        BinaryOperation::display(fs);
 }
 
-void SeqOP::compile(std::ofstream &fs, int) {
-        left_->compile(fs, 0);
+void SeqOP::compile(Emitter &fs, int) {
+        fs.node(left_);
         fs << ">=";
-        right_->compile(fs, 0);
+        fs.node(right_);
 }
 
-void IeqOP::display() {
-        std::cout << "IeqOP(";
-        BinaryOperation::display();
+void IeqOP::display(Emitter &fs) {
+        fs << "IeqOP(";
+        BinaryOperation::display(fs);
 }
 
-void IeqOP::compile(std::ofstream &fs, int) {
-        left_->compile(fs, 0);
+void IeqOP::compile(Emitter &fs, int) {
+        fs.node(left_);
         fs << "<=";
-        right_->compile(fs, 0);
+        fs.node(right_);
 }
 
-void OrOP::display() {
-        std::cout << "OrOP(";
-        BinaryOperation::display();
+void OrOP::display(Emitter &fs) {
+        fs << "OrOP(";
+        BinaryOperation::display(fs);
 }
 
-void OrOP::compile(std::ofstream &fs, int) {
-        left_->compile(fs, 0);
+void OrOP::compile(Emitter &fs, int) {
+        fs << "(";
+        fs.node(left_);
         fs << " or ";
-        right_->compile(fs, 0);
+        fs.node(right_);
+        fs << ")";
 }
 
-void AndOP::display() {
-        std::cout << "AndOP(";
-        BinaryOperation::display();
+void AndOP::display(Emitter &fs) {
+        fs << "AndOP(";
+        BinaryOperation::display(fs);
 }
 
-void AndOP::compile(std::ofstream &fs, int) {
-        left_->compile(fs, 0);
+void AndOP::compile(Emitter &fs, int) {
+        fs << "(";
+        fs.node(left_);
         fs << " and ";
-        right_->compile(fs, 0);
+        fs.node(right_);
+        fs << ")";
 }
 
-void XorOP::display() {
-        std::cout << "XorOP(";
-        BinaryOperation::display();
+void XorOP::display(Emitter &fs) {
+        fs << "XorOP(";
+        BinaryOperation::display(fs);
 }
 
-void XorOP::compile(std::ofstream &fs, int) {
-        left_->compile(fs, 0);
-        fs << " and ";
-        right_->compile(fs, 0);
+void XorOP::compile(Emitter &fs, int) {
+        fs << "((";
+        fs.node(left_);
+        fs << ")!=(";
+        fs.node(right_);
+        fs << "))";
 }
 
-void NotOP::display() {
-        std::cout << "NotOP(";
-        param->display();
-        std::cout << ")";
+void NotOP::display(Emitter &fs) {
+        fs << "NotOP(";
+        fs.node(param_);
+        fs << ")";
 }
 
-void NotOP::compile(std::ofstream &fs, int) {
+void NotOP::compile(Emitter &fs, int) {
         fs << "not(";
-        param->compile(fs, 0);
+        fs.node(param_);
         fs << ") ";
 }
 
@@ -470,46 +1259,45 @@ void NotOP::compile(std::ofstream &fs, int) {
 /*                                     IO                                     */
 /******************************************************************************/
 
-void Print::display() {
-        std::cout << "Print(";
+void Print::display(Emitter &fs) {
+        fs << "Print(";
         if (content_ != nullptr) {
-                content_->display();
+                fs.node(content_);
         } else {
-                std::cout << str_;
+                fs << str_;
         }
-        std::cout << ");" << std::endl;
+        fs << ");" << std::endl;
 }
 
-void Print::compile(std::ofstream &fs, int lvl) {
+void Print::compile(Emitter &fs, int lvl) {
         indent(fs, lvl);
-        fs << "print(";
+        fs << fs.name("print") << "(";
         if (content_ == nullptr) {
                 fs << str_;
         } else {
-                content_->compile(fs, 0);
+                fs.node(content_);
+        }
+        if (buffer_) {
+                fs << ".tolist()";
         }
         fs << ",end=\"\")";
 }
 
-void Read::display() {
-        std::cout << "Read(";
-        variable_->display();
-        std::cout << ")" << std::endl;
+void Read::display(Emitter &fs) {
+        fs << "Read(";
+        fs.node(variable_);
+        fs << ")" << std::endl;
 }
 
-void Read::compile(std::ofstream &fs, int lvl) {
+void Read::compile(Emitter &fs, int lvl) {
         indent(fs, lvl);
-        variable_->compile(fs, 0);
-        switch (variable_->type()) {
-        case INT:
-                fs << " = int(input())";
-                break;
-        case FLT:
-                fs << " = flt(input())";
-                break;
-        default:
-                fs << " = input()";
-                break;
+        fs.node(variable_);
+        fs << " = ";
+        char const *builtin = readConversion(variable_->type());
+        if (builtin != nullptr) {
+                fs << fs.name(builtin) << "(" << fs.name("input") << "())";
+        } else {
+                fs << fs.name("input") << "()";
         }
 }
 
@@ -517,14 +1305,175 @@ void Read::compile(std::ofstream &fs, int lvl) {
 /*                                   return                                   */
 /******************************************************************************/
 
-void Return::display() {
-        std::cout << "Return(";
-        returnExpr_->display();
-        std::cout << ")";
+void Return::display(Emitter &fs) {
+        fs << "Return(";
+        fs.node(returnExpr_);
+        fs << ")";
 }
 
-void Return::compile(std::ofstream &fs, int lvl) {
+void Return::compile(Emitter &fs, int lvl) {
+        auto typedExpr = std::dynamic_pointer_cast<TypedNode>(returnExpr_);
+
         indent(fs, lvl);
         fs << "return ";
-        returnExpr_->compile(fs, 0);
+        if (typedExpr != nullptr && typedExpr->type() != NIL) {
+                compileValue(fs, type_, typedExpr);
+        } else {
+                fs.node(returnExpr_);
+        }
+}
+
+/******************************************************************************/
+/*                                 sub-nodes                                  */
+/******************************************************************************/
+
+/**
+ * @brief  Replace `slot` by `node` if it contains `old`.
+ */
+template <typename T>
+static void replaceSlot(std::shared_ptr<T> &slot,
+                        std::shared_ptr<Node> const &old,
+                        std::shared_ptr<Node> const &node) {
+        if (slot == old) {
+                slot = std::dynamic_pointer_cast<T>(node);
+        }
+}
+
+std::list<std::shared_ptr<Node>> ArrayAccess::children() const {
+        return {index_};
+}
+
+void ArrayAccess::replace(std::shared_ptr<Node> const &old,
+                          std::shared_ptr<Node> const &node) {
+        replaceSlot(index_, old, node);
+}
+
+std::list<std::shared_ptr<Node>> FunctionCall::children() const {
+        return {params_.begin(), params_.end()};
+}
+
+void FunctionCall::replace(std::shared_ptr<Node> const &old,
+                           std::shared_ptr<Node> const &node) {
+        for (auto &p : params_) {
+                replaceSlot(p, old, node);
+        }
+}
+
+std::list<std::shared_ptr<Node>> Function::children() const {
+        return {block_};
+}
+
+void Function::replace(std::shared_ptr<Node> const &old,
+                       std::shared_ptr<Node> const &node) {
+        replaceSlot(block_, old, node);
+}
+
+std::list<std::shared_ptr<Node>> Block::children() const {
+        return instructions_;
+}
+
+void Block::replace(std::shared_ptr<Node> const &old,
+                    std::shared_ptr<Node> const &node) {
+        for (auto it = instructions_.begin(); it != instructions_.end();) {
+                if (*it != old) {
+                        ++it;
+                } else if (node == nullptr) {
+                        it = instructions_.erase(it);
+                } else {
+                        *it++ = node;
+                }
+        }
+}
+
+std::list<std::shared_ptr<Node>> Assignment::children() const {
+        return {variable_, value_};
+}
+
+void Assignment::replace(std::shared_ptr<Node> const &old,
+                         std::shared_ptr<Node> const &node) {
+        replaceSlot(variable_, old, node);
+        replaceSlot(value_, old, node);
+}
+
+std::list<std::shared_ptr<Node>> Cnd::children() const {
+        if (elseBlock_ == nullptr) {
+                return {condition_, block_};
+        }
+        return {condition_, block_, elseBlock_};
+}
+
+void Cnd::replace(std::shared_ptr<Node> const &old,
+                  std::shared_ptr<Node> const &node) {
+        replaceSlot(condition_, old, node);
+        replaceSlot(block_, old, node);
+        replaceSlot(elseBlock_, old, node);
+}
+
+std::list<std::shared_ptr<Node>> For::children() const {
+        return {begin_, end_, step_, block_};
+}
+
+void For::replace(std::shared_ptr<Node> const &old,
+                  std::shared_ptr<Node> const &node) {
+        replaceSlot(begin_, old, node);
+        replaceSlot(end_, old, node);
+        replaceSlot(step_, old, node);
+        replaceSlot(block_, old, node);
+}
+
+std::list<std::shared_ptr<Node>> Whl::children() const {
+        return {condition_, block_};
+}
+
+void Whl::replace(std::shared_ptr<Node> const &old,
+                  std::shared_ptr<Node> const &node) {
+        replaceSlot(condition_, old, node);
+        replaceSlot(block_, old, node);
+}
+
+std::list<std::shared_ptr<Node>> BinaryOperation::children() const {
+        return {left_, right_};
+}
+
+void BinaryOperation::replace(std::shared_ptr<Node> const &old,
+                              std::shared_ptr<Node> const &node) {
+        replaceSlot(left_, old, node);
+        replaceSlot(right_, old, node);
+}
+
+std::list<std::shared_ptr<Node>> NotOP::children() const { return {param_}; }
+
+void NotOP::replace(std::shared_ptr<Node> const &old,
+                    std::shared_ptr<Node> const &node) {
+        replaceSlot(param_, old, node);
+}
+
+std::list<std::shared_ptr<Node>> Print::children() const {
+        if (content_ == nullptr) {
+                return {};
+        }
+        return {content_};
+}
+
+void Print::replace(std::shared_ptr<Node> const &old,
+                    std::shared_ptr<Node> const &node) {
+        replaceSlot(content_, old, node);
+}
+
+std::list<std::shared_ptr<Node>> Read::children() const {
+        return {variable_};
+}
+
+void Read::replace(std::shared_ptr<Node> const &old,
+                   std::shared_ptr<Node> const &node) {
+        replaceSlot(variable_, old, node);
+}
+
+std::list<std::shared_ptr<Node>> Return::children() const {
+        return {returnExpr_};
+}
+
+void Return::replace(std::shared_ptr<Node> const &old,
+                     std::shared_ptr<Node> const &node) {
+        replaceSlot(returnExpr_, old, node);
 }
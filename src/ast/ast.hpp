@@ -4,6 +4,7 @@
 #include "node.hpp"
 #include "builtins.hpp"
 #include "declarations.hpp"
+#include "emitter.hpp"
 #include "node.hpp"
 #include "operators.hpp"
 #include "statements.hpp"
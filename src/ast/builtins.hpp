@@ -18,12 +18,29 @@ class Print : public Node {
     Print(std::string str)
         : str_(str), content_(std::shared_ptr<Node>(nullptr)) {}
 
-    void compile(std::ofstream &, int) override;
-    void display() override;
+    std::string const &str() const { return str_; }
+    std::shared_ptr<Node> content() const { return content_; }
+
+    /**
+     * @brief  The content is a NumPy array, printed as a list like the other
+     *         arrays (see Vectorizer).
+     */
+    bool buffer() const { return buffer_; }
+    void buffer(bool buffer) { buffer_ = buffer; }
+
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Print>(*this);
+    }
+    void display(Emitter &) override;
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
     std::string str_;
     std::shared_ptr<Node> content_ = nullptr;
+    bool buffer_ = false;
 };
 
 /**
@@ -33,8 +50,16 @@ class Read : public Node {
   public:
     Read(std::shared_ptr<TypedNode> variable) : variable_(variable) {}
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    std::shared_ptr<TypedNode> variable() const { return variable_; }
+
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Read>(*this);
+    }
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
     std::shared_ptr<TypedNode> variable_ = nullptr;
@@ -10,8 +10,14 @@ class Declaration : public Node {
   public:
     Declaration(Variable variable) : variable_(variable) {}
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    Variable const &variable() const { return variable_; }
+    void variable(Variable const &variable) { variable_ = variable; }
+
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Declaration>(*this);
+    }
 
   private:
     Variable variable_;
@@ -26,8 +32,20 @@ class ArrayDeclaration : public Array {
     ArrayDeclaration(std::string name, int size, PrimitiveType type)
         : Array(name, size, type) {}
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    /**
+     * @brief  The array is a NumPy array (see Vectorizer).
+     */
+    bool buffer() const { return buffer_; }
+    void buffer(bool buffer) { buffer_ = buffer; }
+
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<ArrayDeclaration>(*this);
+    }
+
+  private:
+    bool buffer_ = false;
 };
 
 #endif
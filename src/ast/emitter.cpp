@@ -0,0 +1,83 @@
+#include "ast/emitter.hpp"
+#include <vector>
+
+void indent(Emitter &fs, int lvl) {
+    for (int i = 0; i < lvl; ++i) {
+        fs << '\t';
+    }
+}
+
+/**
+ * @brief  Save the pending text as a fragment.
+ */
+void Emitter::flush() {
+    std::string text = text_.str();
+    if (!text.empty()) {
+        fragments_.push_back({text, nullptr, 0});
+        text_.str("");
+    }
+}
+
+/**
+ * @brief  Record a sub-node that will be generated at the indentation level
+ *         `lvl`, after the text written so far.
+ */
+void Emitter::node(std::shared_ptr<Node> const &node, int lvl) {
+    flush();
+    fragments_.push_back({"", node, lvl});
+}
+
+std::string const &Emitter::name(std::string const &global) const {
+    auto it = locals_->find(global);
+    return it != locals_->end() ? it->second : global;
+}
+
+void Emitter::local(std::string const &global, std::string const &name) {
+    (*locals_)[global] = name;
+}
+
+/**
+ * @brief  Generate the output of `root` using an explicit stack. The generator
+ *         runs the method of one node (`compile`, `display`, ...), then the
+ *         fragments it produced are pushed on the stack in reverse order so the
+ *         first one is treated next.
+ *
+ * @param  os         Output stream.
+ * @param  root       First node to generate.
+ * @param  lvl        Indentation level of the root.
+ * @param  generator  Method to run on each node.
+ */
+void Emitter::generate(std::ostream &os, std::shared_ptr<Node> const &root,
+                       int lvl, Generator const &generator) {
+    std::vector<Fragment> stack = {{"", root, lvl}};
+    std::shared_ptr<Locals> locals = std::make_shared<Locals>();
+
+    while (!stack.empty()) {
+        Fragment fragment = std::move(stack.back());
+        stack.pop_back();
+
+        if (fragment.node == nullptr) {
+            os << fragment.text;
+            continue;
+        }
+        Emitter emitter;
+        emitter.locals_ = locals;
+        generator(*fragment.node, emitter, fragment.lvl);
+        emitter.flush();
+        for (auto it = emitter.fragments_.rbegin();
+             it != emitter.fragments_.rend(); ++it) {
+            stack.push_back(std::move(*it));
+        }
+    }
+}
+
+void Emitter::compile(std::ostream &os, std::shared_ptr<Node> const &root,
+                      int lvl) {
+    generate(os, root, lvl,
+             [](Node &node, Emitter &fs, int lvl) { node.compile(fs, lvl); });
+}
+
+void Emitter::display(std::ostream &os, std::shared_ptr<Node> const &root) {
+    generate(os, root, 0,
+             [](Node &node, Emitter &fs, int) { node.display(fs); });
+}
@@ -0,0 +1,66 @@
+#ifndef EMITTER_H
+#define EMITTER_H
+#include "node.hpp"
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+/**
+ * @brief  Output of one node during a traversal. A node writes its text with
+ *         `<<` and gives its sub-nodes with `node()`. The text and the
+ *         sub-nodes are recorded in order, and the traversal functions below
+ *         push them on a work stack instead of recursing.
+ */
+class Emitter {
+  public:
+    using Generator = std::function<void(Node &, Emitter &, int)>;
+
+    template <typename T> Emitter &operator<<(T const &value) {
+        text_ << value;
+        return *this;
+    }
+
+    Emitter &operator<<(std::ostream &(*manipulator)(std::ostream &)) {
+        text_ << manipulator;
+        return *this;
+    }
+
+    void node(std::shared_ptr<Node> const &node, int lvl = 0);
+
+    /**
+     * @brief  Name of a global or a builtin in the generated code: the ones
+     *         used in the loops are bound to locals (see Function::compile).
+     */
+    std::string const &name(std::string const &global) const;
+    void local(std::string const &global, std::string const &name);
+
+    static void generate(std::ostream &, std::shared_ptr<Node> const &, int,
+                         Generator const &);
+    static void compile(std::ostream &, std::shared_ptr<Node> const &,
+                        int lvl = 0);
+    static void display(std::ostream &, std::shared_ptr<Node> const &);
+
+  private:
+    struct Fragment {
+        std::string text;
+        std::shared_ptr<Node> node;
+        int lvl;
+    };
+
+    void flush();
+
+    using Locals = std::map<std::string, std::string>;
+
+    std::ostringstream text_;
+    // shared by all the emitters of a traversal
+    std::shared_ptr<Locals> locals_ = std::make_shared<Locals>();
+    std::list<Fragment> fragments_ = {};
+};
+
+void indent(Emitter &, int);
+
+#endif
@@ -0,0 +1,146 @@
+#include "ast/node.hpp"
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief  Destroy a tree without recursion. The default destructors would
+ *         destroy the sub-nodes recursively, which overflows the stack on
+ *         deeply nested programs. Here the sub-nodes are detached from their
+ *         parent and kept on a stack, so each node is destroyed without
+ *         children.
+ *
+ * NOTE: the sub-nodes of a node still used somewhere else are not detached.
+ *
+ * @param  root  Root of the tree.
+ */
+void release(std::shared_ptr<Node> root) {
+    std::vector<std::shared_ptr<Node>> stack;
+
+    stack.push_back(std::move(root));
+    while (!stack.empty()) {
+        std::shared_ptr<Node> node = std::move(stack.back());
+        stack.pop_back();
+
+        if (node == nullptr || node.use_count() > 1) {
+            continue;
+        }
+        for (std::shared_ptr<Node> child : node->children()) {
+            node->replace(child, nullptr);
+            stack.push_back(std::move(child));
+        }
+    }
+}
+
+/**
+ * @brief  Call `visitor` on all the nodes of the tree (pre-order), using an
+ *         explicit stack.
+ *
+ * @param  root     Root of the tree.
+ * @param  visitor  Function called on each node.
+ */
+void visit(std::shared_ptr<Node> const &root, Visitor const &visitor) {
+    std::vector<std::shared_ptr<Node>> stack = {root};
+
+    while (!stack.empty()) {
+        std::shared_ptr<Node> node = std::move(stack.back());
+        stack.pop_back();
+
+        if (node == nullptr) {
+            continue;
+        }
+        visitor(node);
+        std::list<std::shared_ptr<Node>> children = node->children();
+        stack.insert(stack.end(), children.rbegin(), children.rend());
+    }
+}
+
+/**
+ * @brief  Rewrite the tree in post-order, using an explicit stack: the
+ *         sub-nodes are rewritten before their parent. When `rewriter`
+ *         returns another node, it replaces the original one in the parent
+ *         (nullptr removes the node from a block), and the original one is
+ *         released.
+ *
+ * @param  root      Root of the tree.
+ * @param  rewriter  Function that gives the replacement of a node.
+ *
+ * @return  Replacement of the root.
+ */
+std::shared_ptr<Node> rewrite(std::shared_ptr<Node> const &root,
+                              Rewriter const &rewriter) {
+    struct Item {
+        std::shared_ptr<Node> node;
+        std::shared_ptr<Node> parent;
+        bool expanded;
+    };
+    std::vector<Item> stack = {{root, nullptr, false}};
+    std::shared_ptr<Node> result = root;
+
+    while (!stack.empty()) {
+        Item &item = stack.back();
+
+        if (item.node == nullptr) {
+            stack.pop_back();
+        } else if (!item.expanded) {
+            item.expanded = true;
+            std::shared_ptr<Node> parent = item.node;
+            std::list<std::shared_ptr<Node>> children = parent->children();
+            for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                stack.push_back({*it, parent, false});
+            }
+        } else {
+            Item done = std::move(item);
+            stack.pop_back();
+            std::shared_ptr<Node> replacement = rewriter(done.node);
+            if (replacement == done.node) {
+                continue;
+            }
+            if (done.parent == nullptr) {
+                result = replacement;
+            } else {
+                done.parent->replace(done.node, replacement);
+            }
+            release(std::move(done.node));
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief  Deep copy of a tree, using an explicit stack. The nodes shared in the
+ *         original tree are shared in the copy too.
+ *
+ * @param  root  Root of the tree.
+ *
+ * @return  Copy of the tree.
+ */
+std::shared_ptr<Node> clone(std::shared_ptr<Node> const &root) {
+    std::unordered_map<Node *, std::shared_ptr<Node>> copies;
+    std::vector<std::shared_ptr<Node>> stack;
+
+    if (root == nullptr) {
+        return nullptr;
+    }
+    std::shared_ptr<Node> result = root->copy();
+    stack.push_back(result);
+    while (!stack.empty()) {
+        std::shared_ptr<Node> node = std::move(stack.back());
+        stack.pop_back();
+
+        for (std::shared_ptr<Node> const &child : node->children()) {
+            if (child == nullptr) {
+                continue;
+            }
+            auto it = copies.find(child.get());
+            if (it != copies.end()) {
+                node->replace(child, it->second);
+                continue;
+            }
+            std::shared_ptr<Node> copy = child->copy();
+            copies[child.get()] = copy;
+            node->replace(child, copy);
+            stack.push_back(copy);
+        }
+    }
+    return result;
+}
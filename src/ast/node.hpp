@@ -1,16 +1,52 @@
 #ifndef NODE_H
 #define NODE_H
 #include <fstream>
+#include <functional>
+#include <list>
+#include <memory>
+
+class Emitter;
 
 /**
  * @brief  Generic AST node class.
+ *
+ * NOTE: the nodes never call `compile` or `display` on their sub-nodes
+ *       directly, they give them to the emitter which uses an explicit stack
+ *       (see emitter.hpp). This way, deeply nested programs can't overflow the
+ *       call stack of the compiler.
  */
 class Node {
   public:
     virtual ~Node() = default;
-    virtual void compile(std::ofstream &, int) = 0;
-    virtual void display() = 0;
+    virtual void compile(Emitter &, int) = 0;
+    virtual void display(Emitter &) = 0;
+
+    /**
+     * @brief  Shallow copy of the node (the sub-nodes are shared, see clone).
+     */
+    virtual std::shared_ptr<Node> copy() const = 0;
+
+    /**
+     * @brief  Direct sub-nodes of the node (used by the traversals).
+     */
+    virtual std::list<std::shared_ptr<Node>> children() const { return {}; }
+
+    /**
+     * @brief  Replace the sub-node `old` by `node`. Replacing a node by
+     *         nullptr removes it.
+     */
+    virtual void replace(std::shared_ptr<Node> const &,
+                         std::shared_ptr<Node> const &) {}
 };
 
+using Visitor = std::function<void(std::shared_ptr<Node> const &)>;
+using Rewriter =
+    std::function<std::shared_ptr<Node>(std::shared_ptr<Node> const &)>;
+
+void release(std::shared_ptr<Node> root);
+void visit(std::shared_ptr<Node> const &root, Visitor const &visitor);
+std::shared_ptr<Node> rewrite(std::shared_ptr<Node> const &root,
+                              Rewriter const &rewriter);
+std::shared_ptr<Node> clone(std::shared_ptr<Node> const &root);
 
 #endif
@@ -19,8 +19,14 @@ class Assignment : public Node {
     std::shared_ptr<Variable> variable() const { return variable_; }
     std::shared_ptr<TypedNode> value() const { return value_; }
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Assignment>(*this);
+    }
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
     std::shared_ptr<Variable> variable_ = nullptr;
@@ -31,12 +37,18 @@ class Assignment : public Node {
 /*                           arithmetic operations                            */
 /******************************************************************************/
 
-class BinaryOperation : public Node {
+class BinaryOperation : public virtual Node {
   public:
     BinaryOperation(std::shared_ptr<Node> left, std::shared_ptr<Node> right)
         : left_(left), right_(right) {}
 
-    void display() override;
+    std::shared_ptr<Node> left() const { return left_; }
+    std::shared_ptr<Node> right() const { return right_; }
+
+    void display(Emitter &) override;
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   protected:
     std::shared_ptr<Node> left_ = nullptr;
@@ -49,8 +61,11 @@ class AddOP : public BinaryOperation, public TypedNode {
         : BinaryOperation(left, right),
           TypedNode(selectType(left->type(), right->type())) {}
 
-    void display() override; // +
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // +
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<AddOP>(*this);
+    }
 };
 
 class MnsOP : public BinaryOperation, public TypedNode {
@@ -59,8 +74,11 @@ class MnsOP : public BinaryOperation, public TypedNode {
         : BinaryOperation(left, right),
           TypedNode(selectType(left->type(), right->type())) {}
 
-    void display() override; // -
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // -
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<MnsOP>(*this);
+    }
 };
 
 class TmsOP : public BinaryOperation, public TypedNode {
@@ -69,8 +87,11 @@ class TmsOP : public BinaryOperation, public TypedNode {
         : BinaryOperation(left, right),
           TypedNode(selectType(left->type(), right->type())) {}
 
-    void display() override; // *
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // *
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<TmsOP>(*this);
+    }
 };
 
 class DivOP : public BinaryOperation, public TypedNode {
@@ -79,8 +100,11 @@ class DivOP : public BinaryOperation, public TypedNode {
         : BinaryOperation(left, right),
           TypedNode(selectType(left->type(), right->type())) {}
 
-    void display() override; // /
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // /
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<DivOP>(*this);
+    }
 };
 
 /******************************************************************************/
@@ -92,8 +116,11 @@ class EqlOP : public BinaryOperation {
     EqlOP(std::shared_ptr<Node> left, std::shared_ptr<Node> right)
         : BinaryOperation(left, right) {}
 
-    void display() override; // left == right
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // left == right
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<EqlOP>(*this);
+    }
 };
 
 class SupOP : public BinaryOperation {
@@ -101,8 +128,11 @@ class SupOP : public BinaryOperation {
     SupOP(std::shared_ptr<Node> left, std::shared_ptr<Node> right)
         : BinaryOperation(left, right) {}
 
-    void display() override; // left == right
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // left == right
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<SupOP>(*this);
+    }
 };
 
 class InfOP : public BinaryOperation {
@@ -110,8 +140,11 @@ class InfOP : public BinaryOperation {
     InfOP(std::shared_ptr<Node> left, std::shared_ptr<Node> right)
         : BinaryOperation(left, right) {}
 
-    void display() override; // left == right
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // left == right
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<InfOP>(*this);
+    }
 };
 
 class SeqOP : public BinaryOperation {
@@ -119,8 +152,11 @@ class SeqOP : public BinaryOperation {
     SeqOP(std::shared_ptr<Node> left, std::shared_ptr<Node> right)
         : BinaryOperation(left, right) {}
 
-    void display() override; // left == right
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // left == right
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<SeqOP>(*this);
+    }
 };
 
 class IeqOP : public BinaryOperation {
@@ -128,8 +164,11 @@ class IeqOP : public BinaryOperation {
     IeqOP(std::shared_ptr<Node> left, std::shared_ptr<Node> right)
         : BinaryOperation(left, right) {}
 
-    void display() override; // left == right
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // left == right
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<IeqOP>(*this);
+    }
 };
 
 class OrOP : public BinaryOperation {
@@ -137,8 +176,11 @@ class OrOP : public BinaryOperation {
     OrOP(std::shared_ptr<Node> left, std::shared_ptr<Node> right)
         : BinaryOperation(left, right) {}
 
-    void display() override; // left || right
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // left || right
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<OrOP>(*this);
+    }
 };
 
 class AndOP : public BinaryOperation {
@@ -146,8 +188,11 @@ class AndOP : public BinaryOperation {
     AndOP(std::shared_ptr<Node> left, std::shared_ptr<Node> right)
         : BinaryOperation(left, right) {}
 
-    void display() override; // left && right
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // left && right
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<AndOP>(*this);
+    }
 };
 
 class XorOP : public BinaryOperation {
@@ -155,19 +200,30 @@ class XorOP : public BinaryOperation {
     XorOP(std::shared_ptr<Node> left, std::shared_ptr<Node> right)
         : BinaryOperation(left, right) {}
 
-    void display() override; // left ^ right
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // left ^ right
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<XorOP>(*this);
+    }
 };
 
 class NotOP : public Node {
   public:
-    NotOP(std::shared_ptr<Node> param) : param(param) {}
+    NotOP(std::shared_ptr<Node> param) : param_(param) {}
+
+    std::shared_ptr<Node> param() const { return param_; }
 
-    void display() override; // !param
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override; // !param
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<NotOP>(*this);
+    }
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
-    std::shared_ptr<Node> param;
+    std::shared_ptr<Node> param_;
 };
 
 #endif
@@ -2,13 +2,31 @@
 #include <memory>
 #include <iostream>
 
+Program::~Program() {
+    for (std::shared_ptr<Function> &function : functions_) {
+        release(std::move(function));
+    }
+}
+
 void Program::addFunction(std::shared_ptr<Function> f) {
     functions_.push_back(f);
 }
 
+/**
+ * @brief  Replace the functions of the program (the removed ones are
+ *         released).
+ */
+void Program::functions(std::list<std::shared_ptr<Function>> const &functions) {
+    std::list<std::shared_ptr<Function>> old = std::move(functions_);
+    functions_ = functions;
+    for (std::shared_ptr<Function> &function : old) {
+        release(std::move(function));
+    }
+}
+
 void Program::display() {
     for (std::shared_ptr<Function> f : functions_) {
-        f->display();
+        Emitter::display(std::cout, f);
     }
 }
 
@@ -16,12 +34,146 @@ std::list<std::shared_ptr<Function>> const &Program::functions() const {
     return functions_;
 }
 
-void Program::compile(std::ofstream &fs) {
+void Program::instrument(std::string const &file, std::string const &header,
+                         size_t counters) {
+    profile_ = file;
+    profileHeader_ = header;
+    counters_ = counters;
+}
+
+/**
+ * @brief  Python literal of a string.
+ */
+static std::string literal(std::string const &str) {
+    std::string result = "'";
+
+    for (char c : str) {
+        if (c == '\\' || c == '\'') {
+            result += '\\';
+        } else if (c == '\n') {
+            result += "\\n";
+            continue;
+        }
+        result += c;
+    }
+    return result + "'";
+}
+
+/**
+ * @brief  Counters of the instrumented script. The counters start at 1 (0 is
+ *         not a site), they are added to the ones of the profile file when it
+ *         was written by the same program.
+ */
+static void compileProfile(std::ostream &fs, std::string const &file,
+                           std::string const &header, size_t counters) {
+    fs << "import atexit" << std::endl << std::endl;
+    fs << "_profile=[0]*" << counters + 1 << std::endl << std::endl;
+    fs << "def _write_profile():" << std::endl;
+    fs << "\tcounts=_profile[1:]" << std::endl;
+    fs << "\ttry:" << std::endl;
+    fs << "\t\twith open(" << literal(file) << ") as f:" << std::endl;
+    fs << "\t\t\tif f.readline()==" << literal(header + "\n") << ":"
+       << std::endl;
+    fs << "\t\t\t\tcounts=[c+int(l) for c,l in zip(counts,f)]" << std::endl;
+    fs << "\texcept (OSError,ValueError):" << std::endl;
+    fs << "\t\tpass" << std::endl;
+    fs << "\twith open(" << literal(file) << ",'w') as f:" << std::endl;
+    fs << "\t\tf.write(" << literal(header + "\n")
+       << "+''.join('%d\\n'%c for c in counts))" << std::endl << std::endl;
+    fs << "atexit.register(_write_profile)" << std::endl << std::endl;
+}
+
+/**
+ * @brief  Modules used by the functions: functools for the memoized ones and
+ *         NumPy for the buffers.
+ */
+static void
+compileImports(std::ostream &fs,
+               std::list<std::shared_ptr<Function>> const &functions,
+               bool buffers) {
+    for (std::shared_ptr<Function> function : functions) {
+        if (function->memoized()) {
+            fs << "import functools" << std::endl << std::endl;
+            break;
+        }
+    }
+    if (buffers) {
+        // the overflows of the fixed size integers are errors, like the
+        // divisions by zero
+        fs << "import numpy" << std::endl;
+        fs << "numpy.seterr(divide='raise',over='raise',invalid='raise')"
+           << std::endl << std::endl;
+    }
+}
+
+/**
+ * @brief  Shared library of the native functions, loaded with ctypes. The
+ *         errors of the library are raised as the python exceptions they
+ *         name.
+ */
+static void compileNative(std::ostream &fs, std::string const &library) {
+    fs << "import builtins" << std::endl;
+    fs << "import ctypes" << std::endl;
+    fs << "import os" << std::endl << std::endl;
+    fs << "_native_=ctypes.CDLL(os.path.join(os.path.dirname("
+       << "os.path.abspath(__file__))," << literal(library) << "))"
+       << std::endl;
+    fs << "_native_failed_=ctypes.c_int.in_dll(_native_,'s3_failed')"
+       << std::endl;
+    fs << "_native_.s3_message.restype=ctypes.c_char_p" << std::endl
+       << std::endl;
+    fs << "def _native_error_():" << std::endl;
+    fs << "\tname,_,message=_native_.s3_message().decode().partition(': ')"
+       << std::endl;
+    fs << "\traise getattr(builtins,name)(message)" << std::endl << std::endl;
+}
+
+void Program::compile(std::ostream &fs) {
     fs << "#!/usr/bin/env python3" << std::endl;
     fs << "# generated using ISIMA's transpiler" << std::endl << std::endl;
+    compileImports(fs, functions_, buffers_);
+    if (!profile_.empty()) {
+        compileProfile(fs, profile_, profileHeader_, counters_);
+    }
+    if (!library_.empty()) {
+        compileNative(fs, library_);
+    }
     for (std::shared_ptr<Function> function : functions_) {
-        function->compile(fs, 0);
+        Emitter::compile(fs, function);
         fs << std::endl;
     }
     fs << std::endl << "if __name__ == '__main__':" << std::endl << "\tmain()";
 }
+
+/**
+ * @brief  Module of the functions defined in `file` (see `--modules`). The
+ *         functions of the other modules of the package are imported after the
+ *         definitions, so the modules can import each other (the imported
+ *         names are only used when the functions run).
+ *
+ * @param  imports  Functions imported from each module.
+ */
+void Program::compileModule(
+    std::ostream &fs, std::string const &file,
+    std::map<std::string, std::set<std::string>> const &imports) {
+    std::list<std::shared_ptr<Function>> functions;
+
+    for (std::shared_ptr<Function> function : functions_) {
+        if (function->file() == file) {
+            functions.push_back(function);
+        }
+    }
+    fs << "# generated using ISIMA's transpiler" << std::endl << std::endl;
+    compileImports(fs, functions, buffers_);
+    for (std::shared_ptr<Function> function : functions) {
+        Emitter::compile(fs, function);
+        fs << std::endl;
+    }
+    for (auto const &[module, names] : imports) {
+        fs << std::endl << "from ." << module << " import ";
+        for (std::string const &name : names) {
+            fs << (name == *names.begin() ? "" : ", ") << name;
+        }
+    }
+    fs << std::endl;
+}
@@ -1,7 +1,12 @@
 #ifndef PROGRAM_H
 #define PROGRAM_H
 #include "ast.hpp"
+#include <cstddef>
 #include <fstream>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
 
 /******************************************************************************/
 /*                                  program                                   */
@@ -10,13 +15,44 @@
 class Program {
   public:
     Program() = default;
+    ~Program();
     std::list<std::shared_ptr<Function>> const &functions() const;
     void addFunction(std::shared_ptr<Function>);
-    void compile(std::ofstream &);
+    void functions(std::list<std::shared_ptr<Function>> const &);
+
+    /**
+     * @brief  The int and flt arrays are NumPy arrays (see Vectorizer).
+     */
+    bool buffers() const { return buffers_; }
+    void buffers(bool buffers) { buffers_ = buffers; }
+
+    /**
+     * @brief  The instrumented script has `counters` counters, which are
+     *         added to the ones of `file` when it exits. `header` is the first
+     *         line of the file, it identifies the program (see Profile).
+     */
+    void instrument(std::string const &file, std::string const &header,
+                    size_t counters);
+
+    /**
+     * @brief  The native functions are in the shared library `library`, in
+     *         the directory of the script (see NativeSelector).
+     */
+    void native(std::string const &library) { library_ = library; }
+
+    void compile(std::ostream &);
+    void compileModule(
+        std::ostream &, std::string const &file,
+        std::map<std::string, std::set<std::string>> const &imports);
     void display();
 
   private:
     std::list<std::shared_ptr<Function>> functions_ = {};
+    bool buffers_ = false;
+    std::string profile_ = "";
+    std::string profileHeader_ = "";
+    size_t counters_ = 0;
+    std::string library_ = "";
 };
 
 #endif
@@ -0,0 +1,19 @@
+#ifndef PYTHON_H
+#define PYTHON_H
+#include "typesystem/types.hpp"
+#include <string>
+#include <vector>
+
+/*
+ * Python literals and conversions, shared by the emitters of the AST and of
+ * the IR (see ast.cpp).
+ */
+
+std::string floatLiteral(double value);
+std::vector<std::string> characters(std::string const &literal);
+long long characterCode(std::string const &literal);
+std::string utf8(std::string const &literal);
+char const *conversion(PrimitiveType target, PrimitiveType source);
+char const *readConversion(PrimitiveType type);
+
+#endif
@@ -2,6 +2,7 @@
 #define STATEMENTS_H
 #include "node.hpp"
 #include "typednodes.hpp"
+#include <cstddef>
 #include <memory>
 #include <list>
 
@@ -21,13 +22,74 @@ class Block : public Node {
         instructions_.push_back(instruction);
     }
 
-    void compile(std::ofstream &, int = 0) override;
-    void display() override;
+    std::list<std::shared_ptr<Node>> const &instructions() const {
+        return instructions_;
+    }
+    void instructions(std::list<std::shared_ptr<Node>> const &instructions) {
+        instructions_ = instructions;
+    }
+
+    void compile(Emitter &, int = 0) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Block>(*this);
+    }
+    void display(Emitter &) override;
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
     std::list<std::shared_ptr<Node>> instructions_ = {};
 };
 
+/******************************************************************************/
+/*                                  profile                                   */
+/******************************************************************************/
+
+/**
+ * @brief  Counters of a function, a loop or a `cnd` in the profile of the
+ *         program (see Profile). `count` is the number of executions of the
+ *         statement (the calls of a function), and `body` the number of
+ *         executions of its block (the iterations of a loop, the true
+ *         conditions of a `cnd`). The copies keep the counters, so the inlined
+ *         code is counted for its function.
+ */
+class Profiled {
+  public:
+    /**
+     * @brief  Index of the first counter of the node in the instrumented
+     *         script, 0 when the node is not in the profile.
+     */
+    size_t site() const { return site_; }
+    void site(size_t site) { site_ = site; }
+
+    /**
+     * @brief  The instrumented nodes increment their counters in the
+     *         generated script.
+     */
+    bool instrumented() const { return instrumented_; }
+    void instrumented(bool instrumented) { instrumented_ = instrumented; }
+
+    /**
+     * @brief  True when the counts have been read from a profile.
+     */
+    bool profiled() const { return profiled_; }
+    size_t count() const { return count_; }
+    size_t body() const { return body_; }
+    void counts(size_t count, size_t body) {
+        count_ = count;
+        body_ = body;
+        profiled_ = true;
+    }
+
+  private:
+    size_t site_ = 0;
+    bool instrumented_ = false;
+    bool profiled_ = false;
+    size_t count_ = 0;
+    size_t body_ = 0;
+};
+
 /******************************************************************************/
 /*                                 statements                                 */
 /******************************************************************************/
@@ -38,34 +100,95 @@ class Block : public Node {
  *
  * TODO: create a return statment and manage return type.
  */
-class Function : public TypedNode {
+class Function : public TypedNode, public Profiled {
   public:
     Function(std::string id, std::list<Variable> parameters,
              std::shared_ptr<Block> instructions, std::list<PrimitiveType> type)
         : id_(id), parameters_(parameters), type_(type), block_(instructions) {}
     PrimitiveType type() const override { return type_.back(); }
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    std::string const &id() const { return id_; }
+    std::list<Variable> const &parameters() const { return parameters_; }
+    std::shared_ptr<Block> block() const { return block_; }
+
+    /**
+     * @brief  Declared sizes of the parameters, 0 for the scalars.
+     */
+    std::list<int> const &sizes() const { return sizes_; }
+    void sizes(std::list<int> const &sizes) { sizes_ = sizes; }
+
+    /**
+     * @brief  The results of a memoized function are cached in the generated
+     *         code (see Memoizer).
+     */
+    bool memoized() const { return memoized_; }
+    void memoized(bool memoized) { memoized_ = memoized; }
+
+    /**
+     * @brief  The parameters, the result and the locals of a typed function
+     *         are annotated in the generated code, for the compilation of the
+     *         script with mypyc or Cython (see `--typed`).
+     */
+    bool typed() const { return typed_; }
+    void typed(bool typed) { typed_ = typed; }
+
+    /**
+     * @brief  A native function is compiled in C in a shared library, the
+     *         script calls it through ctypes (see NativeSelector).
+     */
+    bool native() const { return native_; }
+    void native(bool native) { native_ = native; }
+
+    /**
+     * @brief  Source file where the function is defined (its module with
+     *         `--modules`).
+     */
+    std::string const &file() const { return file_; }
+    void file(std::string const &file) { file_ = file; }
+
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Function>(*this);
+    }
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
+    void compileNative(Emitter &);
+
     std::string id_;
     std::list<Variable> parameters_;
+    std::list<int> sizes_;
     std::list<PrimitiveType> type_;
     std::shared_ptr<Block> block_ = nullptr;
+    bool memoized_ = false;
+    bool typed_ = false;
+    bool native_ = false;
+    std::string file_ = "";
 };
 
 /**
  * @brief  Cnd statement.
  */
-class Cnd : public Node {
+class Cnd : public Node, public Profiled {
   public:
     Cnd(std::shared_ptr<Node> condition, std::shared_ptr<Block> block)
         : condition_(condition), block_(block), elseBlock_(nullptr) {}
 
+    std::shared_ptr<Node> condition() const { return condition_; }
+    std::shared_ptr<Block> block() const { return block_; }
+    std::shared_ptr<Block> elseBlock() const { return elseBlock_; }
     void elseBlock(std::shared_ptr<Block> block) { elseBlock_ = block; }
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Cnd>(*this);
+    }
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
     std::shared_ptr<Node> condition_ = nullptr;
@@ -78,35 +201,84 @@ class Cnd : public Node {
  *         expressions that determine the begining, the end and the step of the
  *         loop.
  */
-class For : public Node {
+class For : public Node, public Profiled {
   public:
+    /**
+     * @brief  Loops computed by a builtin or a slice assignment (see
+     *         LoopIdioms).
+     */
+    enum Idiom { LOOP, SUM, MINIMUM, MAXIMUM, FILL };
+
     For(Variable variable, std::shared_ptr<Node> begin,
         std::shared_ptr<Node> end, std::shared_ptr<Node> step,
         std::shared_ptr<Block> block)
         : variable_(variable), begin_(begin), end_(end), step_(step),
           block_(block) {}
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    Variable const &variable() const { return variable_; }
+    void variable(Variable const &variable) { variable_ = variable; }
+    std::shared_ptr<Node> begin() const { return begin_; }
+    std::shared_ptr<Node> end() const { return end_; }
+    std::shared_ptr<Node> step() const { return step_; }
+    std::shared_ptr<Block> block() const { return block_; }
+
+    /**
+     * @brief  A vectorized loop is generated as NumPy operations on slices
+     *         when its range is in the arrays (see Vectorizer).
+     */
+    bool vectorized() const { return vectorized_; }
+    void vectorized(bool vectorized) { vectorized_ = vectorized; }
+    Idiom idiom() const { return idiom_; }
+    void idiom(Idiom idiom) { idiom_ = idiom; }
+    /**
+     * @brief  The range of a sliced loop is known to be in its arrays, so the
+     *         slices are used without checking it (see inBounds).
+     */
+    bool inBounds() const { return inBounds_; }
+    void inBounds(bool inBounds) { inBounds_ = inBounds; }
+
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<For>(*this);
+    }
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
+    void compileSliced(Emitter &, int);
+    void compileIdiom(Emitter &);
+
     Variable variable_;
     std::shared_ptr<Node> begin_;
     std::shared_ptr<Node> end_;
     std::shared_ptr<Node> step_;
     std::shared_ptr<Block> block_ = nullptr;
+    bool vectorized_ = false;
+    Idiom idiom_ = LOOP;
+    bool inBounds_ = false;
 };
 
 /**
  * @brief  While declaration. The while loop just has a condition.
  */
-class Whl : public Node {
+class Whl : public Node, public Profiled {
   public:
     Whl(std::shared_ptr<Node> condition, std::shared_ptr<Block> block)
         : condition_(condition), block_(block) {}
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    std::shared_ptr<Node> condition() const { return condition_; }
+    std::shared_ptr<Block> block() const { return block_; }
+
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Whl>(*this);
+    }
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
     std::shared_ptr<Node> condition_ = nullptr;
@@ -117,15 +289,30 @@ class Whl : public Node {
 /*                                   return                                   */
 /******************************************************************************/
 
+/**
+ * @brief  Return statement. The type is the return type of the function (the
+ *         returned value is converted if its type is different).
+ */
 class Return : public Node {
   public:
-    Return(std::shared_ptr<Node> returnExpr) : returnExpr_(returnExpr) {}
+    Return(std::shared_ptr<Node> returnExpr, PrimitiveType type = NIL)
+        : returnExpr_(returnExpr), type_(type) {}
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    std::shared_ptr<Node> returnExpr() const { return returnExpr_; }
+    PrimitiveType type() const { return type_; }
+
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Return>(*this);
+    }
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
     std::shared_ptr<Node> returnExpr_ = nullptr;
+    PrimitiveType type_ = NIL;
 };
 
 #endif
@@ -7,7 +7,7 @@
 /**
  * @brief  Interface for typed nodes.
  */
-class TypedNode : public Node {
+class TypedNode : public virtual Node {
   public:
     TypedNode(PrimitiveType type = NIL) : type_(type) {}
     virtual ~TypedNode() = default;
@@ -28,8 +28,11 @@ class Value : public TypedNode {
     Value() : TypedNode() {}
     LiteralValue const &value() const { return value_; }
 
-    void compile(std::ofstream &, int) override;
-    void display() override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Value>(*this);
+    }
+    void display(Emitter &) override;
 
   private:
     LiteralValue value_;
@@ -42,9 +45,13 @@ class Variable : public TypedNode {
   public:
     Variable(std::string id, PrimitiveType type) : TypedNode(type), id_(id) {}
     std::string const &id() const { return id_; }
+    void id(std::string const &id) { id_ = id; }
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Variable>(*this);
+    }
 
   private:
     std::string id_;
@@ -60,6 +67,10 @@ class Array : public Variable {
         : Variable(name, type), size_(size) {}
     int size() const { return size_; }
 
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<Array>(*this);
+    }
+
   protected:
     int size_;
 };
@@ -74,8 +85,14 @@ class ArrayAccess : public Array {
         : Array(name, -1, type), index_(index) {}
     std::shared_ptr<Node> index() const { return index_; }
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<ArrayAccess>(*this);
+    }
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
     std::shared_ptr<Node> index_ = nullptr;
@@ -97,12 +114,37 @@ class FunctionCall : public TypedNode {
     }
     std::string const &functionName() const { return functionName_; }
 
-    void display() override;
-    void compile(std::ofstream &, int) override;
+    /**
+     * @brief  Declared sizes of the parameters of the function (0 for the
+     *         scalars), the strings given to the arrays have these sizes.
+     */
+    std::list<int> const &sizes() const { return sizes_; }
+    void sizes(std::list<int> const &sizes) { sizes_ = sizes; }
+    /**
+     * @brief  Declared types of the parameters of the function, the
+     *         arguments are converted to these types.
+     */
+    std::list<PrimitiveType> const &parameterTypes() const {
+        return parameterTypes_;
+    }
+    void parameterTypes(std::list<PrimitiveType> const &types) {
+        parameterTypes_ = types;
+    }
+
+    void display(Emitter &) override;
+    void compile(Emitter &, int) override;
+    std::shared_ptr<Node> copy() const override {
+        return std::make_shared<FunctionCall>(*this);
+    }
+    std::list<std::shared_ptr<Node>> children() const override;
+    void replace(std::shared_ptr<Node> const &,
+                 std::shared_ptr<Node> const &) override;
 
   private:
     std::string functionName_;
     std::list<std::shared_ptr<TypedNode>> params_ = {};
+    std::list<int> sizes_ = {};
+    std::list<PrimitiveType> parameterTypes_ = {};
 };
 
 #endif
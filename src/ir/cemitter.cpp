@@ -0,0 +1,1074 @@
+#include "cemitter.hpp"
+#include "ast/python.hpp"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <tuple>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief  The arrays of the frame larger than this number of elements are on
+ *         the heap.
+ */
+static constexpr size_t STACK_ELEMENTS = 4096;
+
+/**
+ * @brief  Runtime of the generated programs. The error messages are the ones
+ *         of the python exceptions, the functions are inline so the unused
+ *         ones are not reported by the C compiler.
+ */
+static char const *RUNTIME = R"runtime(#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+typedef long long s3_int;
+typedef double s3_flt;
+typedef long s3_chr;
+typedef struct { s3_int *data; s3_int size; } s3_ints;
+typedef struct { s3_flt *data; s3_int size; } s3_flts;
+typedef struct { s3_chr *data; s3_int size; } s3_chrs;
+
+static char const *S3_LOAD = "IndexError: list index out of range";
+static char const *S3_STORE = "IndexError: list assignment index out of range";
+
+#ifdef S3_LIBRARY
+#include <setjmp.h>
+
+/* the errors return to the entry called by the script, which raises them */
+int s3_failed = 0;
+static char s3_text[512];
+static jmp_buf s3_exit;
+
+char const *s3_message(void) {
+    s3_failed = 0;
+    return s3_text;
+}
+
+static inline void s3_error(char const *message) {
+    snprintf(s3_text, sizeof(s3_text), "%s", message);
+    s3_failed = 1;
+    longjmp(s3_exit, 1);
+}
+#else
+static inline void s3_error(char const *message) {
+    fflush(stdout);
+    fprintf(stderr, "%s\n", message);
+    exit(1);
+}
+#endif
+
+static inline void s3_overflow(void) {
+    s3_error("OverflowError: integer overflow (the integers have 64 bits)");
+}
+
+/* the recursion stops before the end of the stack (it grows down): the
+   functions that call compare the address of their frame to this limit,
+   which leaves room for the largest frame */
+static uintptr_t s3_stack_limit = 0;
+
+static inline void s3_stack(char const *base, size_t frame) {
+    static size_t size = 0;
+#ifdef S3_LIBRARY
+    size_t margin = frame + (1 << 20); /* python already uses the stack */
+#else
+    size_t margin = frame + (1 << 16);
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+    struct rlimit limit;
+
+    if (size == 0 && getrlimit(RLIMIT_STACK, &limit) == 0 &&
+        limit.rlim_cur != RLIM_INFINITY) {
+        size = (size_t)limit.rlim_cur;
+    }
+    if (size == 0) {
+        size = (size_t)8 << 20;
+    }
+#else
+    size = (size_t)1 << 20;
+#endif
+    s3_stack_limit = (uintptr_t)base - (size > 2 * margin ? size - margin
+                                                          : size / 2);
+}
+
+static inline void s3_enter(char const *frame) {
+    if ((uintptr_t)frame < s3_stack_limit) {
+        s3_error("RecursionError: maximum recursion depth exceeded");
+    }
+}
+
+static inline void s3_unbound(char const *variable) {
+    char message[512];
+    snprintf(message, sizeof(message),
+             "UnboundLocalError: cannot access local variable '%s' where it "
+             "is not associated with a value", variable);
+    s3_error(message);
+}
+
+static inline void *s3_alloc(s3_int size, size_t element) {
+    void *data = calloc(size > 0 ? (size_t)size : 1, element);
+    if (data == NULL) {
+        s3_error("MemoryError");
+    }
+    return data;
+}
+
+/* the character in UTF-8, the number of bytes is returned */
+static inline int s3_utf8(s3_chr c, char *bytes) {
+    if (c < 0x80) {
+        bytes[0] = (char)c;
+        return 1;
+    } else if (c < 0x800) {
+        bytes[0] = (char)(0xC0 | c >> 6);
+        bytes[1] = (char)(0x80 | (c & 0x3F));
+        return 2;
+    } else if (c < 0x10000) {
+        bytes[0] = (char)(0xE0 | c >> 12);
+        bytes[1] = (char)(0x80 | (c >> 6 & 0x3F));
+        bytes[2] = (char)(0x80 | (c & 0x3F));
+        return 3;
+    }
+    bytes[0] = (char)(0xF0 | c >> 18);
+    bytes[1] = (char)(0x80 | (c >> 12 & 0x3F));
+    bytes[2] = (char)(0x80 | (c >> 6 & 0x3F));
+    bytes[3] = (char)(0x80 | (c & 0x3F));
+    return 4;
+}
+
+/* the message followed by python's repr of the text (UTF-8) */
+static inline void s3_literal_error(char const *message, char const *text) {
+    unsigned char const *p = (unsigned char const *)text;
+    char quote = strchr(text, '\'') != NULL && strchr(text, '"') == NULL
+                         ? '"'
+                         : '\'';
+    char *result = (char *)s3_alloc(
+            (s3_int)(strlen(message) + 4 * strlen(text) + 5), 1);
+    char *q = result + sprintf(result, "%s: %c", message, quote);
+
+    while (*p != '\0') {
+        unsigned char const *start = p;
+        s3_chr c = *p++;
+        int length = c < 0x80 ? 0 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : 3;
+
+        if (length > 0) {
+            c &= 0x3F >> length;
+        }
+        while (length-- > 0 && (*p & 0xC0) == 0x80) {
+            c = c << 6 | (*p++ & 0x3F);
+        }
+        if (c == quote || c == '\\') {
+            *q++ = '\\';
+            *q++ = (char)c;
+        } else if (c == '\n' || c == '\t' || c == '\r') {
+            *q++ = '\\';
+            *q++ = c == '\n' ? 'n' : c == '\t' ? 't' : 'r';
+        } else if (c < 0x20 || (0x7F <= c && c <= 0xA0)) {
+            q += sprintf(q, "\\x%02lx", c);
+        } else {
+            memcpy(q, start, (size_t)(p - start));
+            q += p - start;
+        }
+    }
+    *q++ = quote;
+    *q = '\0';
+    s3_error(result);
+}
+
+/* the error of a character that isn't a digit */
+static inline void s3_digit_error(char const *message, s3_chr c) {
+    char text[5];
+    text[s3_utf8(c, text)] = '\0';
+    s3_literal_error(message, text);
+}
+
+/* arithmetic */
+
+static inline s3_int s3_add(s3_int a, s3_int b) {
+#if defined(__GNUC__) || defined(__clang__)
+    s3_int r;
+    if (__builtin_add_overflow(a, b, &r)) {
+        s3_overflow();
+    }
+    return r;
+#else
+    if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN - b)) {
+        s3_overflow();
+    }
+    return a + b;
+#endif
+}
+
+static inline s3_int s3_sub(s3_int a, s3_int b) {
+#if defined(__GNUC__) || defined(__clang__)
+    s3_int r;
+    if (__builtin_sub_overflow(a, b, &r)) {
+        s3_overflow();
+    }
+    return r;
+#else
+    if ((b < 0 && a > LLONG_MAX + b) || (b > 0 && a < LLONG_MIN + b)) {
+        s3_overflow();
+    }
+    return a - b;
+#endif
+}
+
+static inline s3_int s3_mul(s3_int a, s3_int b) {
+#if defined(__GNUC__) || defined(__clang__)
+    s3_int r;
+    if (__builtin_mul_overflow(a, b, &r)) {
+        s3_overflow();
+    }
+    return r;
+#else
+    if (a != 0 && b != 0 &&
+        (a > 0 ? (b > 0 ? a > LLONG_MAX / b : b < LLONG_MIN / a)
+               : (b > 0 ? a < LLONG_MIN / b : a < LLONG_MAX / b))) {
+        s3_overflow();
+    }
+    return a * b;
+#endif
+}
+
+/* the quotient is rounded toward zero, like python's int(a/b) */
+static inline s3_int s3_div(s3_int a, s3_int b) {
+    if (b == 0) {
+        s3_error("ZeroDivisionError: division by zero");
+    } else if (a == LLONG_MIN && b == -1) {
+        s3_overflow();
+    }
+    return a / b;
+}
+
+/* true division of integers */
+static inline s3_flt s3_idiv(s3_int a, s3_int b) {
+    if (b == 0) {
+        s3_error("ZeroDivisionError: division by zero");
+    }
+    return (s3_flt)a / (s3_flt)b;
+}
+
+static inline s3_flt s3_fdiv(s3_flt a, s3_flt b) {
+    if (b == 0) {
+        s3_error("ZeroDivisionError: float division by zero");
+    }
+    return a / b;
+}
+
+/* the negative indices count from the end */
+static inline s3_int s3_index(s3_int index, s3_int size,
+                            char const *message) {
+    if (index < 0) {
+        index += size;
+    }
+    if (index < 0 || index >= size) {
+        s3_error(message);
+    }
+    return index;
+}
+
+/* conversions (the zeros of the strings are the integer 0) */
+
+static inline s3_int s3_ftoi(s3_flt x) {
+    if (x != x) {
+        s3_error("ValueError: cannot convert float NaN to integer");
+    } else if (x == HUGE_VAL || x == -HUGE_VAL) {
+        s3_error("OverflowError: cannot convert float infinity to integer");
+    } else if (x >= 9223372036854775808.0 || x < -9223372036854775808.0) {
+        s3_overflow();
+    }
+    return (s3_int)x;
+}
+
+static inline s3_int s3_ctoi(s3_chr c) {
+    if (c != 0 && (c < '0' || c > '9')) {
+        s3_digit_error("ValueError: invalid literal for int() with base 10", c);
+    }
+    return c == 0 ? 0 : c - '0';
+}
+
+static inline s3_flt s3_ctof(s3_chr c) {
+    if (c != 0 && (c < '0' || c > '9')) {
+        s3_digit_error("ValueError: could not convert string to float", c);
+    }
+    return c == 0 ? 0 : c - '0';
+}
+
+static inline s3_chr s3_itoc(s3_int i) {
+    if (i < 0 || i > 0x10FFFF) {
+        s3_error("ValueError: chr() arg not in range(0x110000)");
+    }
+    return (s3_chr)i;
+}
+
+/* output */
+
+static inline void s3_put(s3_chr c) {
+    char bytes[4];
+    int length = s3_utf8(c, bytes), i;
+
+    for (i = 0; i < length; ++i) {
+        putchar(bytes[i]);
+    }
+}
+
+static inline void s3_print_int(s3_int x) {
+    printf("%lld", x);
+}
+
+/* the shortest digits that give back the value, written like python's repr */
+static inline void s3_print_flt(s3_flt x) {
+    char buffer[32];
+    char digits[20];
+    char const *p = buffer;
+    int precision, exponent, n = 0, i;
+
+    if (x != x) {
+        fputs("nan", stdout);
+        return;
+    } else if (x == HUGE_VAL || x == -HUGE_VAL) {
+        fputs(x > 0 ? "inf" : "-inf", stdout);
+        return;
+    }
+    for (precision = 1; precision <= 17; ++precision) {
+        snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, x);
+        if (strtod(buffer, NULL) == x) {
+            break;
+        }
+    }
+    if (*p == '-') {
+        putchar('-');
+        ++p;
+    }
+    for (; *p != 'e'; ++p) {
+        if (*p != '.') {
+            digits[n++] = *p;
+        }
+    }
+    exponent = atoi(p + 1);
+    while (n > 1 && digits[n - 1] == '0') {
+        --n;
+    }
+    if (exponent < -4 || exponent >= 16) {
+        putchar(digits[0]);
+        if (n > 1) {
+            printf(".%.*s", n - 1, digits + 1);
+        }
+        printf("e%c%02d", exponent < 0 ? '-' : '+', abs(exponent));
+    } else if (exponent < 0) {
+        printf("0.%.*s%.*s", -exponent - 1, "0000", n, digits);
+    } else {
+        for (i = 0; i <= exponent; ++i) {
+            putchar(i < n ? digits[i] : '0');
+        }
+        printf(".%.*s", n > exponent + 1 ? n - exponent - 1 : 1,
+               n > exponent + 1 ? digits + exponent + 1 : "0");
+    }
+}
+
+static inline void s3_print_chr(s3_chr c) {
+    if (c == 0) {
+        putchar('0');
+    } else {
+        s3_put(c);
+    }
+}
+
+/* element of a list of characters, like python's repr */
+static inline void s3_repr_chr(s3_chr c) {
+    if (c == 0) {
+        putchar('0');
+    } else if (c == '\'') {
+        fputs("\"'\"", stdout);
+    } else if (c == '\\') {
+        fputs("'\\\\'", stdout);
+    } else if (c == '\n') {
+        fputs("'\\n'", stdout);
+    } else if (c == '\t') {
+        fputs("'\\t'", stdout);
+    } else if (c == '\r') {
+        fputs("'\\r'", stdout);
+    } else if (c < 0x20 || (0x7F <= c && c <= 0xA0)) {
+        printf("'\\x%02lx'", c);
+    } else {
+        putchar('\'');
+        s3_put(c);
+        putchar('\'');
+    }
+}
+
+static inline void s3_print_ints(s3_ints a) {
+    s3_int i;
+    putchar('[');
+    for (i = 0; i < a.size; ++i) {
+        if (i > 0) {
+            fputs(", ", stdout);
+        }
+        s3_print_int(a.data[i]);
+    }
+    putchar(']');
+}
+
+static inline void s3_print_flts(s3_flts a) {
+    s3_int i;
+    putchar('[');
+    for (i = 0; i < a.size; ++i) {
+        if (i > 0) {
+            fputs(", ", stdout);
+        }
+        s3_print_flt(a.data[i]);
+    }
+    putchar(']');
+}
+
+static inline void s3_print_chrs(s3_chrs a) {
+    s3_int i;
+    putchar('[');
+    for (i = 0; i < a.size; ++i) {
+        if (i > 0) {
+            fputs(", ", stdout);
+        }
+        s3_repr_chr(a.data[i]);
+    }
+    putchar(']');
+}
+
+/* input: a line without its '\n' */
+
+static inline char *s3_line(void) {
+    static char *line = NULL;
+    static size_t capacity = 0;
+    size_t length = 0;
+    int c;
+
+    while ((c = getchar()) != EOF && c != '\n') {
+        if (length + 1 >= capacity) {
+            capacity = capacity == 0 ? 64 : 2 * capacity;
+            line = (char *)realloc(line, capacity);
+            if (line == NULL) {
+                s3_error("MemoryError");
+            }
+        }
+        line[length++] = (char)c;
+    }
+    if (c == EOF && length == 0) {
+        s3_error("EOFError: EOF when reading a line");
+    }
+    if (line == NULL) {
+        line = (char *)s3_alloc(capacity = 64, 1);
+    }
+    line[length] = '\0';
+    return line;
+}
+
+/* python's int(): blanks around a sign and digits (single '_' between) */
+static inline s3_int s3_read_int(void) {
+    char const *line = s3_line();
+    char const *p = line;
+    s3_int value = 0;
+    int negative = 0, digits = 0;
+
+    while (isspace((unsigned char)*p)) {
+        ++p;
+    }
+    if (*p == '+' || *p == '-') {
+        negative = *p++ == '-';
+    }
+    while (isdigit((unsigned char)*p) ||
+           (*p == '_' && digits > 0 && isdigit((unsigned char)p[1]))) {
+        if (*p != '_') {
+            if (value > (LLONG_MAX - (*p - '0')) / 10) {
+                s3_overflow();
+            }
+            value = 10 * value + (*p - '0');
+            ++digits;
+        }
+        ++p;
+    }
+    while (isspace((unsigned char)*p)) {
+        ++p;
+    }
+    if (digits == 0 || *p != '\0') {
+        s3_literal_error("ValueError: invalid literal for int() with base 10",
+                         line);
+    }
+    return negative ? -value : value;
+}
+
+/* python's float(): strtod without the single '_' between two digits */
+static inline s3_flt s3_read_flt(void) {
+    static char const *message =
+            "ValueError: could not convert string to float";
+    char const *line = s3_line();
+    char *text = (char *)s3_alloc((s3_int)strlen(line) + 1, 1);
+    char *p = text, *end;
+    char const *c;
+    s3_flt value;
+
+    for (c = line; *c != '\0'; ++c) {
+        if (*c != '_') {
+            *p++ = *c;
+        } else if (c == line || !isdigit((unsigned char)c[-1]) ||
+                   !isdigit((unsigned char)c[1])) {
+            s3_literal_error(message, line);
+        }
+    }
+    *p = '\0';
+    p = text;
+    while (isspace((unsigned char)*p)) {
+        ++p;
+    }
+    value = strtod(p, &end);
+    if (end == p || strpbrk(p, "xX(") != NULL) {
+        s3_literal_error(message, line);
+    }
+    while (isspace((unsigned char)*end)) {
+        ++end;
+    }
+    if (*end != '\0') {
+        s3_literal_error(message, line);
+    }
+    free(text);
+    return value;
+}
+
+/* the first character of the line (UTF-8) */
+static inline s3_chr s3_read_chr(void) {
+    unsigned char const *p = (unsigned char const *)s3_line();
+    s3_chr c = *p;
+    int length = c < 0x80 ? 0 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : 3;
+
+    if (length > 0) {
+        c &= 0x3F >> length;
+    }
+    while (length-- > 0 && (*++p & 0xC0) == 0x80) {
+        c = c << 6 | (*p & 0x3F);
+    }
+    return c;
+}
+)runtime";
+
+/**
+ * @brief  C type of the values of type `type`.
+ */
+static char const *typeName(PrimitiveType type) {
+    switch (type) {
+    case INT:
+        return "s3_int";
+    case FLT:
+        return "s3_flt";
+    case CHR:
+        return "s3_chr";
+    case ARR_INT:
+        return "s3_ints";
+    case ARR_FLT:
+        return "s3_flts";
+    case ARR_CHR:
+        return "s3_chrs";
+    default:
+        return "void";
+    }
+}
+
+/**
+ * @brief  Identifier of a function or a variable of the program, the prefix
+ *         avoids the keywords and the names of the runtime.
+ */
+static std::string identifier(char const *prefix, std::string const &name) {
+    std::string result = prefix;
+
+    for (char c : name) {
+        result += std::isalnum((unsigned char)c) ? c : '_';
+    }
+    return result;
+}
+
+/**
+ * @brief  C literal of a string given by its python literal: the characters
+ *         are encoded in UTF-8, and the ones that are not printable are
+ *         written in octal.
+ *
+ * @param  size  Set to the number of bytes of the string.
+ */
+static std::string stringLiteral(std::string const &literal, size_t &size) {
+    std::string bytes = utf8(literal);
+    std::string result = "\"";
+    char buffer[8];
+
+    for (char c : bytes) {
+        if (c >= ' ' && c <= '~' && c != '"' && c != '\\' && c != '?') {
+            result += c;
+        } else {
+            snprintf(buffer, sizeof(buffer), "\\%03o", (unsigned char)c);
+            result += buffer;
+        }
+    }
+    size = bytes.size();
+    return result + "\"";
+}
+
+void CEmitter::emit(std::ostream &os, Module const &module) {
+    frame_ = 0;
+    os << "/* generated using ISIMA's transpiler */" << std::endl;
+    os << RUNTIME << std::endl;
+    for (auto const &function : module.functions()) {
+        prototype(os, *function);
+        os << ";" << std::endl;
+    }
+    for (auto const &function : module.functions()) {
+        os << std::endl;
+        emit(os, *function);
+    }
+    os << std::endl << "int main(void) {" << std::endl;
+    os << "    char base;" << std::endl;
+    os << "    s3_stack(&base, " << frame_ << ");" << std::endl;
+    os << "    f_main();" << std::endl;
+    os << "    return 0;" << std::endl;
+    os << "}" << std::endl;
+}
+
+/**
+ * @brief  Shared library of the native functions (see NativeSelector), which
+ *         the script calls through ctypes. Each function has an entry `py_`
+ *         that takes the arrays as a pointer to their elements and their size.
+ *         When an error stops the function, the entry returns, `s3_failed` is
+ *         set and `s3_message` gives the message of the python exception.
+ *
+ * @param  functions  Native functions, with the functions they call.
+ */
+void CEmitter::emitLibrary(std::ostream &os, Module const &module,
+                           std::set<std::string> const &functions) {
+    std::vector<Function const *> native;
+
+    for (auto const &function : module.functions()) {
+        if (functions.count(function->name())) {
+            native.push_back(function.get());
+        }
+    }
+    frame_ = 0;
+    os << "/* generated using ISIMA's transpiler */" << std::endl;
+    os << "#define S3_LIBRARY" << std::endl;
+    os << RUNTIME << std::endl;
+    for (Function const *function : native) {
+        prototype(os, *function);
+        os << ";" << std::endl;
+    }
+    for (Function const *function : native) {
+        os << std::endl;
+        emit(os, *function);
+    }
+    for (Function const *function : native) {
+        size_t i = 0;
+        os << std::endl
+           << typeName(function->type()) << " "
+           << identifier("py_", function->name()) << "(";
+        for (auto const &parameter : function->parameters()) {
+            PrimitiveType type = parameter->type();
+            os << (i > 0 ? ", " : "");
+            if (isArray(type)) {
+                os << typeName(getValueType(type)) << " *d" << i
+                   << ", s3_int s" << i;
+            } else {
+                os << typeName(type) << " a" << i;
+            }
+            ++i;
+        }
+        os << (i == 0 ? "void" : "") << ") {" << std::endl;
+        os << "    char base;" << std::endl;
+        os << "    s3_stack(&base, " << frame_ << ");" << std::endl;
+        os << "    if (setjmp(s3_exit)) {" << std::endl;
+        os << "        return" << (function->type() == NIL ? ";" : " 0;")
+           << std::endl;
+        os << "    }" << std::endl;
+        os << "    " << (function->type() == NIL ? "" : "return ")
+           << identifier("f_", function->name()) << "(";
+        i = 0;
+        for (auto const &parameter : function->parameters()) {
+            os << (i > 0 ? ", " : "");
+            if (isArray(parameter->type())) {
+                os << "(" << typeName(parameter->type()) << "){d" << i
+                   << ", s" << i << "}";
+            } else {
+                os << "a" << i;
+            }
+            ++i;
+        }
+        os << ");" << std::endl;
+        os << "}" << std::endl;
+    }
+}
+
+void CEmitter::prototype(std::ostream &os, Function const &function) {
+    os << "static " << typeName(function.type()) << " "
+       << identifier("f_", function.name()) << "(";
+    for (auto const &parameter : function.parameters()) {
+        if (parameter != function.parameters().front()) {
+            os << ", ";
+        }
+        os << typeName(parameter->type()) << " " << name(parameter.get());
+    }
+    if (function.parameters().empty()) {
+        os << "void";
+    }
+    os << ")";
+}
+
+/**
+ * @brief  The results of the instructions and the storage of the arrays are
+ *         declared at the beginning of the function, so the gotos never jump
+ *         over a declaration.
+ */
+void CEmitter::emit(std::ostream &os, Function const &function) {
+    used_.clear();
+    escaping_.clear();
+    heap_.clear();
+    copies_.clear();
+    unbound_ = unboundPhis(function);
+    for (auto const &block : function.blocks()) {
+        for (auto const &instruction : block->instructions()) {
+            used_.insert(instruction->operands().begin(),
+                         instruction->operands().end());
+            if (instruction->opcode() != Opcode::Phi) {
+                continue;
+            }
+            escaping_.insert(instruction->operands().begin(),
+                             instruction->operands().end());
+            for (size_t i = 0; i < instruction->targets().size(); ++i) {
+                Value *value = instruction->operands()[i];
+                Block *source = instruction->targets()[i];
+                auto &copies = copies_[{source, block.get()}];
+                // a block can be twice a predecessor (branch to the same
+                // block)
+                if (!copies.empty() &&
+                    copies.back().first == instruction.get()) {
+                    continue;
+                }
+                copies.push_back({instruction.get(), value});
+            }
+        }
+    }
+
+    prototype(os, function);
+    os << " {" << std::endl;
+    size_t frame = 0; // bytes of the arrays on the stack
+    bool calls = false;
+    for (auto const &block : function.blocks()) {
+        for (auto const &instruction : block->instructions()) {
+            Opcode opcode = instruction->opcode();
+            calls = calls || opcode == Opcode::Call;
+            if (!hasResult(opcode) ||
+                (opcode == Opcode::Call && !used_.count(instruction.get()))) {
+                continue;
+            }
+            os << "    " << typeName(instruction->type()) << " "
+               << name(instruction.get(), false) << ";" << std::endl;
+            if (unbound_.count(instruction.get())) {
+                os << "    int _u" << instruction->id() << ";" << std::endl;
+            }
+            if (opcode != Opcode::NewArray ||
+                escaping_.count(instruction.get())) {
+                continue;
+            }
+            char const *element = typeName(getValueType(instruction->type()));
+            size_t size = std::max<size_t>(instruction->size(), 1);
+            if (size <= STACK_ELEMENTS) {
+                os << "    " << element << " " << storage(instruction.get())
+                   << "[" << size << "];" << std::endl;
+                frame += 8 * size;
+            } else {
+                heap_.insert(instruction.get());
+                os << "    " << element << " *" << storage(instruction.get())
+                   << " = s3_alloc(" << size << ", sizeof(" << element
+                   << "));" << std::endl;
+            }
+        }
+    }
+    frame_ = std::max(frame_, frame);
+    // the functions that call check the depth of the stack
+    if (calls) {
+        os << "    char frame;" << std::endl;
+        os << "    s3_enter(&frame);" << std::endl;
+    }
+    for (auto const &block : function.blocks()) {
+        // the entry has no predecessor
+        if (block.get() != function.entry()) {
+            os << "b" << block->id() << ":;" << std::endl;
+        }
+        for (auto const &instruction : block->instructions()) {
+            if (instruction->opcode() != Opcode::Phi) {
+                emit(os, *instruction);
+            }
+        }
+    }
+    os << "}" << std::endl;
+}
+
+void CEmitter::emit(std::ostream &os, Instruction const &instruction) {
+    auto const &operands = instruction.operands();
+    Opcode opcode = instruction.opcode();
+    PrimitiveType type = instruction.type();
+    bool integer = type == INT || type == CHR;
+
+    if (opcode == Opcode::Jump) {
+        edge(os, instruction.block(), instruction.targets()[0], 1);
+        return;
+    } else if (opcode == Opcode::Branch) {
+        os << "    if (" << name(operands[0]) << ") {" << std::endl;
+        edge(os, instruction.block(), instruction.targets()[0], 2);
+        os << "    } else {" << std::endl;
+        edge(os, instruction.block(), instruction.targets()[1], 2);
+        os << "    }" << std::endl;
+        return;
+    } else if (opcode == Opcode::Ret) {
+        for (Value const *array : heap_) {
+            os << "    free(" << storage(static_cast<Instruction const *>(
+                                             array))
+               << ");" << std::endl;
+        }
+        os << "    return";
+        if (!operands.empty()) {
+            os << " " << name(operands[0]);
+        } else if (instruction.block()->function()->type() != NIL) {
+            // the function ends without `ret` (the script returns None)
+            os << " 0";
+        }
+        os << ";" << std::endl;
+        return;
+    }
+    os << "    ";
+    if (hasResult(opcode) &&
+        (opcode != Opcode::Call || used_.count(&instruction) > 0)) {
+        os << name(&instruction) << " = ";
+    }
+    switch (opcode) {
+    case Opcode::Add:
+        os << (integer ? "s3_add(" : "(") << name(operands[0])
+           << (integer ? ", " : " + ") << name(operands[1]) << ")";
+        break;
+    case Opcode::Sub:
+        os << (integer ? "s3_sub(" : "(") << name(operands[0])
+           << (integer ? ", " : " - ") << name(operands[1]) << ")";
+        break;
+    case Opcode::Mul:
+        os << (integer ? "s3_mul(" : "(") << name(operands[0])
+           << (integer ? ", " : " * ") << name(operands[1]) << ")";
+        break;
+    case Opcode::Div: {
+        // python: "float division" only when an operand is a float
+        bool integers =
+            operands[0]->type() != FLT && operands[1]->type() != FLT;
+        os << (integer ? "s3_div(" : integers ? "s3_idiv(" : "s3_fdiv(")
+           << name(operands[0]) << ", " << name(operands[1]) << ")";
+    } break;
+    case Opcode::Eq:
+        os << name(operands[0]) << " == " << name(operands[1]);
+        break;
+    case Opcode::Gt:
+        os << name(operands[0]) << " > " << name(operands[1]);
+        break;
+    case Opcode::Lt:
+        os << name(operands[0]) << " < " << name(operands[1]);
+        break;
+    case Opcode::Ge:
+        os << name(operands[0]) << " >= " << name(operands[1]);
+        break;
+    case Opcode::Le:
+        os << name(operands[0]) << " <= " << name(operands[1]);
+        break;
+    case Opcode::Not:
+        os << "!" << name(operands[0]);
+        break;
+    case Opcode::Xor:
+        os << "(" << name(operands[0]) << " != 0) != (" << name(operands[1])
+           << " != 0)";
+        break;
+    case Opcode::Conv: {
+        PrimitiveType source = operands[0]->type();
+        char const *function = "";
+        if (type == INT) {
+            function = source == FLT ? "s3_ftoi" : "s3_ctoi";
+        } else if (type == FLT) {
+            function = source == CHR ? "s3_ctof" : "(s3_flt)";
+        } else if (type == CHR) {
+            function = "s3_itoc";
+        }
+        os << function << "(" << name(operands[0]) << ")";
+    } break;
+    case Opcode::NewArray:
+        if (escaping_.count(&instruction)) {
+            os << "(" << typeName(type) << "){s3_alloc(" << instruction.size()
+               << ", sizeof(" << typeName(getValueType(type)) << ")), "
+               << instruction.size() << "}";
+        } else {
+            std::string elements = storage(&instruction);
+            os << "(" << typeName(type) << "){" << elements << ", "
+               << instruction.size() << "};" << std::endl;
+            os << "    memset(" << elements << ", 0, "
+               << std::max<size_t>(instruction.size(), 1) << " * sizeof(*"
+               << elements << "))";
+        }
+        break;
+    case Opcode::Load:
+        os << name(operands[0]) << ".data[s3_index(" << name(operands[1])
+           << ", " << name(operands[0]) << ".size, S3_LOAD)]";
+        break;
+    case Opcode::Store:
+        os << name(operands[0]) << ".data[s3_index(" << name(operands[1])
+           << ", " << name(operands[0]) << ".size, S3_STORE)] = "
+           << name(operands[2]);
+        break;
+    case Opcode::Call:
+        os << identifier("f_", instruction.symbol()) << "(";
+        for (size_t i = 0; i < operands.size(); ++i) {
+            os << (i == 0 ? "" : ", ") << name(operands[i]);
+        }
+        os << ")";
+        break;
+    case Opcode::Print:
+        if (operands.empty()) {
+            size_t size;
+            std::string literal = stringLiteral(instruction.symbol(), size);
+            os << "fwrite(" << literal << ", 1, " << size << ", stdout)";
+            break;
+        }
+        switch (operands[0]->type()) {
+        case FLT:
+            os << "s3_print_flt(";
+            break;
+        case CHR:
+            os << "s3_print_chr(";
+            break;
+        case ARR_INT:
+            os << "s3_print_ints(";
+            break;
+        case ARR_FLT:
+            os << "s3_print_flts(";
+            break;
+        case ARR_CHR:
+            os << "s3_print_chrs(";
+            break;
+        default:
+            os << "s3_print_int(";
+            break;
+        }
+        os << name(operands[0]) << ")";
+        break;
+    case Opcode::Read:
+        os << (type == FLT   ? "s3_read_flt()"
+               : type == CHR ? "s3_read_chr()"
+                             : "s3_read_int()");
+        break;
+    default:
+        break;
+    }
+    os << ";" << std::endl;
+}
+
+/**
+ * @brief  Assign the phis of the target with their values for the edge from
+ *         the source, and jump to the target. The phis that may be unbound
+ *         have a flag, which is false when the variable is not assigned.
+ */
+void CEmitter::edge(std::ostream &os, Block *source, Block *target, int lvl) {
+    std::string indent(4 * lvl, ' ');
+    // type, variable and value of the assignments
+    std::vector<std::tuple<char const *, std::string, std::string>> copies;
+
+    auto phis = copies_.find({source, target});
+    if (phis != copies_.end()) {
+        for (auto const &[phi, value] : phis->second) {
+            std::string flag = "_u" + std::to_string(phi->id());
+            if (value->kind() == Value::UNDEFINED) {
+                if (unbound_.count(phi)) {
+                    copies.emplace_back("int", flag, "0");
+                }
+                continue;
+            }
+            copies.emplace_back(typeName(phi->type()), name(phi, false),
+                                name(value, false));
+            if (unbound_.count(phi)) {
+                copies.emplace_back("int", flag,
+                                    unbound_.count(value)
+                                        ? "_u" + std::to_string(value->id())
+                                        : "1");
+            }
+        }
+    }
+    if (copies.size() == 1) {
+        os << indent << std::get<1>(copies[0]) << " = "
+           << std::get<2>(copies[0]) << ";" << std::endl;
+    } else if (!copies.empty()) {
+        // the values are read before the phis are assigned
+        os << indent << "{" << std::endl;
+        for (size_t i = 0; i < copies.size(); ++i) {
+            os << indent << "    " << std::get<0>(copies[i]) << " _c" << i
+               << " = " << std::get<2>(copies[i]) << ";" << std::endl;
+        }
+        for (size_t i = 0; i < copies.size(); ++i) {
+            os << indent << "    " << std::get<1>(copies[i]) << " = _c" << i
+               << ";" << std::endl;
+        }
+        os << indent << "}" << std::endl;
+    }
+    os << indent << "goto b" << target->id() << ";" << std::endl;
+}
+
+/**
+ * @brief  Expression of a value. Reading a phi that may be unbound checks its
+ *         flag, unless `checked` is false (the phi is copied).
+ */
+std::string CEmitter::name(Value const *value, bool checked) const {
+    switch (value->kind()) {
+    case Value::CONSTANT:
+        if (value->type() == FLT) {
+            if (std::isnan(value->floating())) {
+                return "NAN";
+            } else if (std::isinf(value->floating())) {
+                return value->floating() > 0 ? "HUGE_VAL" : "(-HUGE_VAL)";
+            }
+            return floatLiteral(value->floating());
+        } else if (value->integer() == LLONG_MIN) {
+            return "(-9223372036854775807LL - 1)";
+        }
+        return std::to_string(value->integer()) +
+               (value->type() == INT ? "LL" : "");
+    case Value::PARAMETER:
+        return identifier("v_", value->name());
+    case Value::INSTRUCTION: {
+        std::string id = std::to_string(value->id());
+        if (checked && unbound_.count(value)) {
+            Instruction const *phi = static_cast<Instruction const *>(value);
+            return "(_u" + id + " ? _" + id + " : (s3_unbound(\"" +
+                   phi->symbol() + "\"), _" + id + "))";
+        }
+        return "_" + id;
+    }
+    default: {
+        // never assigned, reading it stops the program like the script
+        std::string zero = "0";
+        if (isArray(value->type())) {
+            zero = std::string("(") + typeName(value->type()) + "){0}";
+        }
+        return "(s3_unbound(\"" + value->name() + "\"), " + zero + ")";
+    }
+    }
+}
+
+/**
+ * @brief  Elements of an array that doesn't escape from its frame.
+ */
+std::string CEmitter::storage(Instruction const *array) const {
+    return "_s" + std::to_string(array->id());
+}
+
+} // namespace ir
@@ -0,0 +1,65 @@
+#ifndef C_EMITTER_H
+#define C_EMITTER_H
+#include "ir.hpp"
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief  Generation of a C program from the IR (see `--target=c`). The blocks
+ *         are labels and the branches are gotos, the phis are variables
+ *         assigned on the edges that lead to their block (through temporaries
+ *         when there are several, the copies are parallel).
+ *
+ *         A small runtime written before the functions keeps the semantics of
+ *         the python script: the integer division rounds toward zero, the
+ *         negative indices count from the end of the arrays, the errors
+ *         (division by zero, index out of range, bad input) stop the program
+ *         with the message of the python exception, and `shw` writes the
+ *         floats and the arrays like python does.
+ *
+ *         An array is a pointer to its elements with its size. Its elements
+ *         are in the frame of the function that creates it (on the stack,
+ *         or on the heap for the large ones), unless the array may still be
+ *         used when its `newarray` runs again (it flows in a phi), then they
+ *         are allocated at each execution and never freed, like the lists of
+ *         the script would be kept alive.
+ *
+ * NOTE: the integers have 64 bits, an overflow stops the program (python has
+ *       arbitrary precision integers). The recursion stops with a
+ *       RecursionError near the end of the stack (its size is given by
+ *       getrlimit), and the memoized functions are not cached.
+ */
+class CEmitter {
+  public:
+    void emit(std::ostream &os, Module const &module);
+    void emitLibrary(std::ostream &os, Module const &module,
+                     std::set<std::string> const &functions);
+
+  private:
+    void prototype(std::ostream &os, Function const &function);
+    void emit(std::ostream &os, Function const &function);
+    void emit(std::ostream &os, Instruction const &instruction);
+    void edge(std::ostream &os, Block *source, Block *target, int lvl);
+    std::string name(Value const *value, bool checked = true) const;
+    std::string storage(Instruction const *array) const;
+
+    std::set<Value const *> used_ = {};
+    std::set<Value const *> escaping_ = {}; //< arrays that flow in a phi
+    std::set<Value const *> heap_ = {};     //< large arrays of the frame
+    std::set<Value const *> unbound_ = {};  //< see unboundPhis
+    size_t frame_ = 0; //< largest arrays of a frame on the stack (bytes)
+    // assignments of the phis on the edges (source and target blocks)
+    std::map<std::pair<Block const *, Block const *>,
+             std::vector<std::pair<Value const *, Value const *>>>
+            copies_ = {};
+};
+
+} // namespace ir
+
+#endif
@@ -0,0 +1,166 @@
+#include "dominators.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace ir {
+
+static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+DominatorTree::DominatorTree(Function const &function) {
+    search(function.entry());
+    dominators();
+    frontiers();
+}
+
+/**
+ * @brief  Depth first search from the entry, without recursion (the graphs
+ *         can be deep). The nodes are numbered in pre-order, the reverse
+ *         post-order is kept for the users of the tree.
+ */
+void DominatorTree::search(Block *entry) {
+    std::vector<std::pair<Block *, size_t>> stack = {{entry, 0}};
+
+    index_[entry] = 0;
+    nodes_.push_back(Node{entry});
+    while (!stack.empty()) {
+        auto &[block, next] = stack.back();
+        std::vector<Block *> successors = block->successors();
+        if (next < successors.size()) {
+            Block *successor = successors[next++];
+            if (index_.count(successor) == 0) {
+                Node node{successor};
+                node.parent = index_[block];
+                index_[successor] = nodes_.size();
+                nodes_.push_back(node);
+                stack.push_back({successor, 0});
+            }
+        } else {
+            order_.push_back(block);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order_.begin(), order_.end());
+}
+
+/**
+ * @brief  Immediate dominators with the semi-dominators (Lengauer and Tarjan,
+ *         simple version with path compression).
+ */
+void DominatorTree::dominators() {
+    size_t size = nodes_.size();
+    std::vector<size_t> semi(size);
+    std::vector<size_t> label(size);
+    std::vector<size_t> ancestor(size, NONE);
+    std::vector<std::vector<size_t>> bucket(size);
+    std::vector<size_t> path;
+
+    // node of the forest with the lowest semi-dominator on the path to v
+    auto eval = [&](size_t v) {
+        if (ancestor[v] == NONE) {
+            return v;
+        }
+        path.clear();
+        for (size_t x = v; ancestor[ancestor[x]] != NONE; x = ancestor[x]) {
+            path.push_back(x);
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            size_t a = ancestor[*it];
+            if (semi[label[a]] < semi[label[*it]]) {
+                label[*it] = label[a];
+            }
+            ancestor[*it] = ancestor[a];
+        }
+        return label[v];
+    };
+
+    for (size_t v = 0; v < size; ++v) {
+        semi[v] = label[v] = v;
+    }
+    for (size_t w = size - 1; w > 0; --w) {
+        size_t parent = nodes_[w].parent;
+        for (Block *predecessor : nodes_[w].block->predecessors()) {
+            auto found = index_.find(predecessor);
+            if (found != index_.end()) {
+                semi[w] = std::min(semi[w], semi[eval(found->second)]);
+            }
+        }
+        bucket[semi[w]].push_back(w);
+        ancestor[w] = parent;
+        for (size_t v : bucket[parent]) {
+            size_t u = eval(v);
+            nodes_[v].idom = semi[u] < semi[v] ? u : parent;
+        }
+        bucket[parent].clear();
+    }
+    for (size_t w = 1; w < size; ++w) {
+        if (nodes_[w].idom != semi[w]) {
+            nodes_[w].idom = nodes_[nodes_[w].idom].idom;
+        }
+        nodes_[nodes_[w].idom].children.push_back(nodes_[w].block);
+    }
+
+    // pre-order numbering of the tree
+    size_t clock = 0;
+    std::vector<std::pair<size_t, size_t>> walk = {{0, 0}};
+    nodes_[0].enter = clock++;
+    while (!walk.empty()) {
+        auto &[v, next] = walk.back();
+        Node &node = nodes_[v];
+        if (next < node.children.size()) {
+            size_t child = index_[node.children[next++]];
+            nodes_[child].enter = clock++;
+            walk.push_back({child, 0});
+        } else {
+            node.exit = clock;
+            walk.pop_back();
+        }
+    }
+}
+
+/**
+ * @brief  Dominance frontiers computed bottom-up on the tree (Cytron et al.):
+ *         the frontier of a block is made of its successors and of the
+ *         frontiers of its children that it does not strictly dominate.
+ */
+void DominatorTree::frontiers() {
+    // last block that added a block to its frontier, to avoid the duplicates
+    std::vector<size_t> added(nodes_.size(), NONE);
+
+    // the children have a higher number than their parent in the tree
+    std::vector<size_t> bottomUp(nodes_.size());
+    for (size_t v = 0; v < nodes_.size(); ++v) {
+        bottomUp[nodes_[v].enter] = v;
+    }
+    std::reverse(bottomUp.begin(), bottomUp.end());
+    for (size_t x : bottomUp) {
+        auto add = [&](Block *block) {
+            size_t y = index_[block];
+            if (nodes_[y].idom != x && added[y] != x) {
+                added[y] = x;
+                nodes_[x].frontier.push_back(block);
+            }
+        };
+        for (Block *successor : nodes_[x].block->successors()) {
+            add(successor);
+        }
+        for (Block *child : nodes_[x].children) {
+            for (Block *block : nodes_[index_[child]].frontier) {
+                add(block);
+            }
+        }
+    }
+}
+
+Block *DominatorTree::idom(Block *block) const {
+    Node const &node = nodes_[index_.at(block)];
+    return nodes_[node.idom].block;
+}
+
+bool DominatorTree::dominates(Block *dominator, Block *block) const {
+    Node const &outer = nodes_[index_.at(dominator)];
+    Node const &inner = nodes_[index_.at(block)];
+    return outer.enter <= inner.enter && inner.exit <= outer.exit;
+}
+
+} // namespace ir
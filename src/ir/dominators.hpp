@@ -0,0 +1,61 @@
+#ifndef DOMINATORS_H
+#define DOMINATORS_H
+#include "ir.hpp"
+#include <unordered_map>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief  Dominator tree of the control flow graph of a function
+ *         (Lengauer and Tarjan's algorithm), with the dominance frontiers.
+ *         The predecessors of the blocks must be up to date, and only the
+ *         blocks reachable from the entry are in the tree.
+ *
+ * NOTE: the structured code gives blocks with many predecessors (the end of
+ *       nested `cnd` for instance), the simpler iterative algorithms are
+ *       quadratic on them.
+ */
+class DominatorTree {
+  public:
+    DominatorTree(Function const &function);
+
+    /**
+     * @brief  Reachable blocks in reverse post-order.
+     */
+    std::vector<Block *> const &order() const { return order_; }
+    bool reachable(Block *block) const { return index_.count(block) > 0; }
+    Block *idom(Block *block) const;
+    std::vector<Block *> const &children(Block *block) const {
+        return nodes_[index_.at(block)].children;
+    }
+    std::vector<Block *> const &frontier(Block *block) const {
+        return nodes_[index_.at(block)].frontier;
+    }
+    bool dominates(Block *dominator, Block *block) const;
+
+  private:
+    struct Node {
+        Block *block;
+        size_t parent = 0; //< parent in the depth first search
+        size_t idom = 0;
+        std::vector<Block *> children = {};
+        std::vector<Block *> frontier = {};
+        // interval of the block in a pre-order walk of the tree
+        size_t enter = 0;
+        size_t exit = 0;
+    };
+
+    void search(Block *entry);
+    void dominators();
+    void frontiers();
+
+    // the nodes are numbered in the pre-order of the depth first search
+    std::vector<Node> nodes_ = {};
+    std::unordered_map<Block *, size_t> index_ = {};
+    std::vector<Block *> order_ = {};
+};
+
+} // namespace ir
+
+#endif
@@ -0,0 +1,350 @@
+#include "ir.hpp"
+#include "ast/python.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace ir {
+
+char const *name(Opcode opcode) {
+    switch (opcode) {
+    case Opcode::Add:
+        return "add";
+    case Opcode::Sub:
+        return "sub";
+    case Opcode::Mul:
+        return "mul";
+    case Opcode::Div:
+        return "div";
+    case Opcode::Eq:
+        return "eq";
+    case Opcode::Gt:
+        return "gt";
+    case Opcode::Lt:
+        return "lt";
+    case Opcode::Ge:
+        return "ge";
+    case Opcode::Le:
+        return "le";
+    case Opcode::Not:
+        return "not";
+    case Opcode::Xor:
+        return "xor";
+    case Opcode::Conv:
+        return "conv";
+    case Opcode::Phi:
+        return "phi";
+    case Opcode::NewArray:
+        return "newarray";
+    case Opcode::Load:
+        return "load";
+    case Opcode::Store:
+        return "store";
+    case Opcode::Call:
+        return "call";
+    case Opcode::Print:
+        return "print";
+    case Opcode::Read:
+        return "read";
+    case Opcode::Get:
+        return "get";
+    case Opcode::Set:
+        return "set";
+    case Opcode::Jump:
+        return "jump";
+    case Opcode::Branch:
+        return "branch";
+    case Opcode::Ret:
+        return "ret";
+    }
+    return "";
+}
+
+bool isTerminator(Opcode opcode) {
+    return opcode == Opcode::Jump || opcode == Opcode::Branch ||
+           opcode == Opcode::Ret;
+}
+
+bool hasResult(Opcode opcode) {
+    return opcode != Opcode::Store && opcode != Opcode::Print &&
+           opcode != Opcode::Set && !isTerminator(opcode);
+}
+
+std::string characterLiteral(Value const &constant) {
+    if (!constant.literal().empty()) {
+        return constant.literal();
+    }
+    long long code = constant.integer();
+    char buffer[32];
+
+    if (code >= ' ' && code <= '~' && code != '"' && code != '\\') {
+        return std::string("\"") + (char)code + "\"";
+    } else if (code < 0x100) {
+        snprintf(buffer, sizeof(buffer), "\"\\x%02llx\"", code);
+    } else if (code < 0x10000) {
+        snprintf(buffer, sizeof(buffer), "\"\\u%04llx\"", code);
+    } else {
+        snprintf(buffer, sizeof(buffer), "\"\\U%08llx\"", code);
+    }
+    return buffer;
+}
+
+/**
+ * @brief  The phis read where their variable may not be assigned: one of their
+ *         operands is undefined or is such a phi (a loop can carry the
+ *         unassigned variable).
+ */
+std::set<Value const *> unboundPhis(Function const &function) {
+    std::set<Value const *> unbound;
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+        for (auto const &block : function.blocks()) {
+            for (auto const &instruction : block->instructions()) {
+                if (instruction->opcode() != Opcode::Phi ||
+                    unbound.count(instruction.get())) {
+                    continue;
+                }
+                for (Value const *operand : instruction->operands()) {
+                    if (operand->kind() == Value::UNDEFINED ||
+                        unbound.count(operand)) {
+                        unbound.insert(instruction.get());
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return unbound;
+}
+
+/******************************************************************************/
+/*                                   blocks                                   */
+/******************************************************************************/
+
+Instruction *Block::add(std::unique_ptr<Instruction> instruction) {
+    instruction->block(this);
+    instructions_.push_back(std::move(instruction));
+    return instructions_.back().get();
+}
+
+Instruction *Block::terminator() const {
+    if (instructions_.empty() ||
+        !isTerminator(instructions_.back()->opcode())) {
+        return nullptr;
+    }
+    return instructions_.back().get();
+}
+
+std::vector<Block *> Block::successors() const {
+    Instruction *last = terminator();
+    return last == nullptr ? std::vector<Block *>() : last->targets();
+}
+
+/******************************************************************************/
+/*                                 functions                                  */
+/******************************************************************************/
+
+Value *Function::parameter(std::string const &name, PrimitiveType type) {
+    parameters_.push_back(std::make_unique<Value>(Value::PARAMETER, type));
+    parameters_.back()->name(name);
+    return parameters_.back().get();
+}
+
+Value *Function::constant(PrimitiveType type, long long integer) {
+    constants_.push_back(std::make_unique<Value>(Value::CONSTANT, type));
+    constants_.back()->integer(integer);
+    return constants_.back().get();
+}
+
+Value *Function::constant(double floating) {
+    constants_.push_back(std::make_unique<Value>(Value::CONSTANT, FLT));
+    constants_.back()->floating(floating);
+    return constants_.back().get();
+}
+
+Value *Function::undefined(std::string const &variable, PrimitiveType type) {
+    constants_.push_back(std::make_unique<Value>(Value::UNDEFINED, type));
+    constants_.back()->name(variable);
+    return constants_.back().get();
+}
+
+Block *Function::block() {
+    blocks_.push_back(std::make_unique<Block>(this, blocks_.size()));
+    return blocks_.back().get();
+}
+
+void Function::computePredecessors() {
+    for (auto const &block : blocks_) {
+        block->predecessors().clear();
+    }
+    for (auto const &block : blocks_) {
+        for (Block *successor : block->successors()) {
+            successor->predecessors().push_back(block.get());
+        }
+    }
+}
+
+/**
+ * @brief  Number the blocks in their order and the results of the
+ *         instructions from 1.
+ */
+void Function::number() {
+    size_t id = 0;
+
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        blocks_[i]->id(i);
+        for (auto const &instruction : blocks_[i]->instructions()) {
+            if (hasResult(instruction->opcode())) {
+                instruction->id(++id);
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+/*                                   module                                   */
+/******************************************************************************/
+
+Function *Module::function(std::string const &name) const {
+    auto it = std::find_if(functions_.begin(), functions_.end(),
+                           [&](auto const &f) { return f->name() == name; });
+    return it == functions_.end() ? nullptr : it->get();
+}
+
+Function *Module::add(std::unique_ptr<Function> function) {
+    functions_.push_back(std::move(function));
+    return functions_.back().get();
+}
+
+/******************************************************************************/
+/*                                    dump                                    */
+/******************************************************************************/
+
+std::ostream &operator<<(std::ostream &os, Value const &value) {
+    switch (value.kind()) {
+    case Value::CONSTANT:
+        if (value.type() == FLT) {
+            os << floatLiteral(value.floating());
+        } else if (value.type() == CHR) {
+            os << characterLiteral(value);
+        } else {
+            os << value.integer();
+        }
+        break;
+    case Value::PARAMETER:
+        os << "%" << value.name();
+        break;
+    case Value::INSTRUCTION:
+        os << "%" << value.id();
+        break;
+    case Value::UNDEFINED:
+        os << "undef";
+        break;
+    }
+    return os;
+}
+
+static void operands(std::ostream &os, Instruction const &instruction) {
+    for (size_t i = 0; i < instruction.operands().size(); ++i) {
+        os << (i == 0 ? "" : ", ") << *instruction.operands()[i];
+    }
+}
+
+std::ostream &operator<<(std::ostream &os, Instruction const &instruction) {
+    Opcode opcode = instruction.opcode();
+
+    if (hasResult(opcode)) {
+        os << static_cast<Value const &>(instruction) << " = ";
+    }
+    os << name(opcode);
+    if (hasResult(opcode)) {
+        os << " " << instruction.type();
+    }
+    switch (opcode) {
+    case Opcode::Phi:
+        for (size_t i = 0; i < instruction.operands().size(); ++i) {
+            os << (i == 0 ? " [" : ", [") << *instruction.operands()[i]
+               << ", b" << instruction.targets()[i]->id() << "]";
+        }
+        break;
+    case Opcode::NewArray:
+        os << " " << instruction.size();
+        break;
+    case Opcode::Call:
+        os << " @" << instruction.symbol() << "(";
+        operands(os, instruction);
+        os << ")";
+        break;
+    case Opcode::Print:
+        os << " " << instruction.symbol();
+        operands(os, instruction);
+        break;
+    case Opcode::Get:
+    case Opcode::Set:
+        os << " " << instruction.symbol();
+        if (!instruction.operands().empty()) {
+            os << ", ";
+            operands(os, instruction);
+        }
+        break;
+    case Opcode::Jump:
+        os << " b" << instruction.targets()[0]->id();
+        break;
+    case Opcode::Branch:
+        os << " ";
+        operands(os, instruction);
+        os << ", b" << instruction.targets()[0]->id() << ", b"
+           << instruction.targets()[1]->id();
+        break;
+    default:
+        if (!instruction.operands().empty()) {
+            os << " ";
+            operands(os, instruction);
+        }
+        break;
+    }
+    return os;
+}
+
+std::ostream &operator<<(std::ostream &os, Function const &function) {
+    os << "fn " << function.name() << "(";
+    for (auto const &parameter : function.parameters()) {
+        if (parameter != function.parameters().front()) {
+            os << ", ";
+        }
+        os << parameter->type() << " " << *parameter;
+    }
+    os << ") -> " << function.type();
+    if (function.memoized()) {
+        os << " memoized";
+    }
+    os << " {" << std::endl;
+    for (auto const &block : function.blocks()) {
+        os << "b" << block->id() << ":";
+        if (!block->predecessors().empty()) {
+            os << "  ; preds:";
+            for (Block *predecessor : block->predecessors()) {
+                os << " b" << predecessor->id();
+            }
+        }
+        os << std::endl;
+        for (auto const &instruction : block->instructions()) {
+            os << "    " << *instruction << std::endl;
+        }
+    }
+    return os << "}" << std::endl;
+}
+
+std::ostream &operator<<(std::ostream &os, Module const &module) {
+    for (auto const &function : module.functions()) {
+        if (function != module.functions().front()) {
+            os << std::endl;
+        }
+        os << *function;
+    }
+    return os;
+}
+
+} // namespace ir
@@ -0,0 +1,270 @@
+#ifndef IR_H
+#define IR_H
+#include "typesystem/types.hpp"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief  Typed intermediate representation in SSA form, between the AST and
+ *         the backends. A function is a control flow graph of basic blocks,
+ *         each variable is defined once (the values that depend on the path
+ *         are merged with phi instructions) and the arrays are accessed with
+ *         explicit loads and stores.
+ *
+ *         The values are owned by their function (constants and parameters)
+ *         or by their block (instructions), the operands and the branch
+ *         targets are plain pointers.
+ */
+namespace ir {
+
+class Block;
+class Function;
+
+enum class Opcode {
+    // arithmetic (`div` on `int` is int(a/b), rounded toward zero)
+    Add,
+    Sub,
+    Mul,
+    Div,
+    // comparisons and boolean operations (the result is an `int` 0 or 1)
+    Eq,
+    Gt,
+    Lt,
+    Ge,
+    Le,
+    Not,
+    Xor,
+    // conversion of the operand to the type of the instruction
+    Conv,
+    Phi,
+    // arrays
+    NewArray,
+    Load,
+    Store,
+    // calls and IO
+    Call,
+    Print,
+    Read,
+    // local variables, they only exist before the SSA construction
+    Get,
+    Set,
+    // terminators
+    Jump,
+    Branch,
+    Ret,
+};
+
+char const *name(Opcode opcode);
+bool isTerminator(Opcode opcode);
+bool hasResult(Opcode opcode);
+
+/**
+ * @brief  Operand of an instruction: a constant, a parameter of the function,
+ *         the result of an instruction or an undefined value (a variable read
+ *         on a path where it is not assigned).
+ */
+class Value {
+  public:
+    enum Kind { CONSTANT, PARAMETER, INSTRUCTION, UNDEFINED };
+
+    Value(Kind kind, PrimitiveType type) : kind_(kind), type_(type) {}
+    virtual ~Value() = default;
+
+    Kind kind() const { return kind_; }
+    PrimitiveType type() const { return type_; }
+    void type(PrimitiveType type) { type_ = type; }
+
+    /**
+     * @brief  Value of a constant (the characters are given by their code).
+     */
+    long long integer() const { return integer_; }
+    double floating() const { return floating_; }
+    void integer(long long integer) { integer_ = integer; }
+    void floating(double floating) { floating_ = floating; }
+
+    /**
+     * @brief  Python literal of a character constant when it is written with
+     *         an escape sequence (empty otherwise).
+     */
+    std::string const &literal() const { return literal_; }
+    void literal(std::string const &literal) { literal_ = literal; }
+
+    /**
+     * @brief  Name of a parameter, or of the variable of an undefined value.
+     */
+    std::string const &name() const { return name_; }
+    void name(std::string const &name) { name_ = name; }
+
+    /**
+     * @brief  Number of the value in its function (see Function::number).
+     */
+    size_t id() const { return id_; }
+    void id(size_t id) { id_ = id; }
+
+  private:
+    Kind kind_;
+    PrimitiveType type_;
+    long long integer_ = 0;
+    double floating_ = 0;
+    std::string literal_ = "";
+    std::string name_ = "";
+    size_t id_ = 0;
+};
+
+/**
+ * @brief  Instruction of a basic block. The result of the instruction is the
+ *         value itself. The phi instructions have one operand per predecessor
+ *         of their block, the incoming blocks are given in the same order.
+ */
+class Instruction : public Value {
+  public:
+    Instruction(Opcode opcode, PrimitiveType type,
+                std::vector<Value *> operands = {})
+        : Value(INSTRUCTION, type), opcode_(opcode), operands_(operands) {}
+
+    Opcode opcode() const { return opcode_; }
+    Block *block() const { return block_; }
+    void block(Block *block) { block_ = block; }
+
+    std::vector<Value *> const &operands() const { return operands_; }
+    std::vector<Value *> &operands() { return operands_; }
+
+    /**
+     * @brief  Targets of the terminators (`jump` has one, `branch` jumps to
+     *         the first one if its operand is true), or incoming blocks of a
+     *         phi.
+     */
+    std::vector<Block *> const &targets() const { return targets_; }
+    std::vector<Block *> &targets() { return targets_; }
+
+    /**
+     * @brief  Callee of a call, variable of get, set and phi instructions,
+     *         or string literal written by a print (with its '"').
+     */
+    std::string const &symbol() const { return symbol_; }
+    void symbol(std::string const &symbol) { symbol_ = symbol; }
+
+    /**
+     * @brief  Size of the array created by `newarray`.
+     */
+    size_t size() const { return size_; }
+    void size(size_t size) { size_ = size; }
+
+  private:
+    Opcode opcode_;
+    Block *block_ = nullptr;
+    std::vector<Value *> operands_;
+    std::vector<Block *> targets_ = {};
+    std::string symbol_ = "";
+    size_t size_ = 0;
+};
+
+/**
+ * @brief  Basic block: a sequence of instructions that ends with a
+ *         terminator. The phi instructions are at the beginning.
+ */
+class Block {
+  public:
+    using Instructions = std::list<std::unique_ptr<Instruction>>;
+
+    Block(Function *function, size_t id) : function_(function), id_(id) {}
+
+    Function *function() const { return function_; }
+    size_t id() const { return id_; }
+    void id(size_t id) { id_ = id; }
+
+    Instructions const &instructions() const { return instructions_; }
+    Instructions &instructions() { return instructions_; }
+    Instruction *add(std::unique_ptr<Instruction> instruction);
+    Instruction *terminator() const;
+    std::vector<Block *> successors() const;
+
+    std::vector<Block *> const &predecessors() const { return predecessors_; }
+    std::vector<Block *> &predecessors() { return predecessors_; }
+
+  private:
+    Function *function_;
+    size_t id_;
+    Instructions instructions_ = {};
+    std::vector<Block *> predecessors_ = {};
+};
+
+/**
+ * @brief  Function: its parameters and its control flow graph (the first
+ *         block is the entry).
+ */
+class Function {
+  public:
+    Function(std::string const &name, PrimitiveType type)
+        : name_(name), type_(type) {}
+
+    std::string const &name() const { return name_; }
+    PrimitiveType type() const { return type_; }
+    bool memoized() const { return memoized_; }
+    void memoized(bool memoized) { memoized_ = memoized; }
+
+    std::vector<std::unique_ptr<Value>> const &parameters() const {
+        return parameters_;
+    }
+    std::vector<std::unique_ptr<Block>> const &blocks() const {
+        return blocks_;
+    }
+    std::vector<std::unique_ptr<Block>> &blocks() { return blocks_; }
+    Block *entry() const { return blocks_.front().get(); }
+
+    Value *parameter(std::string const &name, PrimitiveType type);
+    Value *constant(PrimitiveType type, long long integer);
+    Value *constant(double floating);
+    Value *undefined(std::string const &variable, PrimitiveType type);
+    Block *block();
+
+    void computePredecessors();
+    void number();
+
+  private:
+    std::string name_;
+    PrimitiveType type_;
+    bool memoized_ = false;
+    std::vector<std::unique_ptr<Value>> parameters_ = {};
+    std::vector<std::unique_ptr<Value>> constants_ = {};
+    std::vector<std::unique_ptr<Block>> blocks_ = {};
+};
+
+/**
+ * @brief  The functions of a program.
+ */
+class Module {
+  public:
+    std::vector<std::unique_ptr<Function>> const &functions() const {
+        return functions_;
+    }
+    Function *function(std::string const &name) const;
+    Function *add(std::unique_ptr<Function> function);
+
+  private:
+    std::vector<std::unique_ptr<Function>> functions_ = {};
+};
+
+/**
+ * @brief  Python literal of a character constant.
+ */
+std::string characterLiteral(Value const &constant);
+
+std::set<Value const *> unboundPhis(Function const &function);
+
+/**
+ * @brief  Textual dump of the IR (see `--emit-ir`).
+ */
+std::ostream &operator<<(std::ostream &os, Value const &value);
+std::ostream &operator<<(std::ostream &os, Instruction const &instruction);
+std::ostream &operator<<(std::ostream &os, Function const &function);
+std::ostream &operator<<(std::ostream &os, Module const &module);
+
+} // namespace ir
+
+#endif
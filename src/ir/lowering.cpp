@@ -0,0 +1,591 @@
+#include "lowering.hpp"
+#include "ast/python.hpp"
+#include "dominators.hpp"
+#include "ssa.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace ir {
+
+std::unique_ptr<Module> Lowering::lower(std::shared_ptr<Program> program) {
+    auto module = std::make_unique<Module>();
+
+    module_ = module.get();
+    for (auto const &function : program->functions()) {
+        lower(function);
+    }
+    module_ = nullptr;
+    return module;
+}
+
+void Lowering::lower(std::shared_ptr<::Function> function) {
+    auto lowered = std::make_unique<Function>(function->id(), function->type());
+
+    lowered->memoized(function->memoized());
+    function_ = module_->add(std::move(lowered));
+    current_ = function_->block();
+    temporaries_ = 0;
+    for (Variable const &parameter : function->parameters()) {
+        Value *value = function_->parameter(parameter.id(), parameter.type());
+        set(parameter.id(), parameter.type(), value);
+    }
+    run([this, function] { statement(function->block()); });
+    // the functions that end without `ret` return None
+    if (current_->terminator() == nullptr) {
+        emit(Opcode::Ret, NIL);
+    }
+    simplify();
+    SSABuilder().build(*function_);
+    function_->number();
+}
+
+/**
+ * @brief  Run the task and the tasks it schedules. A task schedules its
+ *         sub-tasks on the top of the stack, so they are run before the tasks
+ *         that follow it.
+ */
+void Lowering::run(Task const &task) {
+    tasks_.push_back(task);
+    while (!tasks_.empty()) {
+        Task next = std::move(tasks_.back());
+        tasks_.pop_back();
+        next();
+    }
+}
+
+void Lowering::schedule(std::vector<Task> const &tasks) {
+    for (auto it = tasks.rbegin(); it != tasks.rend(); ++it) {
+        tasks_.push_back(*it);
+    }
+}
+
+/******************************************************************************/
+/*                                 statements                                 */
+/******************************************************************************/
+
+void Lowering::statement(Node const &node) {
+    if (auto block = std::dynamic_pointer_cast<::Block>(node)) {
+        std::vector<Task> tasks;
+        for (Node const &instruction : block->instructions()) {
+            tasks.push_back([this, instruction] { statement(instruction); });
+        }
+        schedule(tasks);
+    } else if (auto assignment = std::dynamic_pointer_cast<Assignment>(node)) {
+        this->assignment(assignment);
+    } else if (auto array = std::dynamic_pointer_cast<ArrayDeclaration>(node)) {
+        Instruction *created = emit(Opcode::NewArray, array->type());
+        created->size(array->size());
+        set(array->id(), array->type(), created);
+    } else if (auto call = std::dynamic_pointer_cast<FunctionCall>(node)) {
+        schedule({[this, call] { expression(call); }, [this] { pop(); }});
+    } else if (auto cnd = std::dynamic_pointer_cast<Cnd>(node)) {
+        Block *onTrue = function_->block();
+        Block *join = function_->block();
+        Block *onFalse = cnd->elseBlock() ? function_->block() : join;
+        std::vector<Task> tasks = {
+            [=] { condition(cnd->condition(), onTrue, onFalse); },
+            [=] {
+                current_ = onTrue;
+                statement(cnd->block());
+            },
+        };
+        if (cnd->elseBlock()) {
+            tasks.push_back([=] {
+                jump(join);
+                current_ = onFalse;
+                statement(cnd->elseBlock());
+            });
+        }
+        tasks.push_back([=] {
+            jump(join);
+            current_ = join;
+        });
+        schedule(tasks);
+    } else if (auto whl = std::dynamic_pointer_cast<Whl>(node)) {
+        Block *header = function_->block();
+        Block *body = function_->block();
+        Block *exit = function_->block();
+        jump(header);
+        current_ = header;
+        schedule({[=] { condition(whl->condition(), body, exit); },
+                  [=] {
+                      current_ = body;
+                      then([=] {
+                          jump(header);
+                          current_ = exit;
+                      });
+                      statement(whl->block());
+                  }});
+    } else if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+        this->loop(loop);
+    } else if (auto ret = std::dynamic_pointer_cast<Return>(node)) {
+        auto typed = std::dynamic_pointer_cast<TypedNode>(ret->returnExpr());
+        if (ret->returnExpr() == nullptr) {
+            emit(Opcode::Ret, NIL);
+            current_ = function_->block();
+            return;
+        }
+        schedule({[=] { expression(ret->returnExpr()); },
+                  [=] {
+                      Value *value = pop();
+                      if (typed != nullptr && typed->type() != NIL) {
+                          value = convert(value, ret->type(), typed->type());
+                      }
+                      emit(Opcode::Ret, NIL, {value});
+                      // the following statements can't be reached
+                      current_ = function_->block();
+                  }});
+    } else if (auto print = std::dynamic_pointer_cast<Print>(node)) {
+        if (print->content() == nullptr) {
+            emit(Opcode::Print, NIL)->symbol(print->str());
+        } else {
+            schedule({[=] { expression(print->content()); },
+                      [this] { emit(Opcode::Print, NIL, {pop()}); }});
+        }
+    } else if (auto read = std::dynamic_pointer_cast<Read>(node)) {
+        PrimitiveType type = read->variable()->type();
+        auto access = std::dynamic_pointer_cast<ArrayAccess>(read->variable());
+        auto variable = std::dynamic_pointer_cast<Variable>(read->variable());
+        if (access != nullptr) {
+            // python evaluates the value before the index
+            schedule({[=] { values_.push_back(emit(Opcode::Read, type)); },
+                      [=] { expression(access->index()); },
+                      [=] {
+                          Value *index = pop();
+                          Value *value = pop();
+                          Value *array = get(access->id(), getArrayType(type));
+                          emit(Opcode::Store, NIL, {array, index, value});
+                      }});
+        } else {
+            set(variable->id(), type, emit(Opcode::Read, type));
+        }
+    }
+}
+
+void Lowering::assignment(std::shared_ptr<Assignment> const &assignment) {
+    std::shared_ptr<Variable> variable = assignment->variable();
+    std::shared_ptr<TypedNode> value = assignment->value();
+    PrimitiveType target = variable->type();
+    PrimitiveType source = value->type();
+    auto str = std::dynamic_pointer_cast<::Value>(value);
+
+    // a string is copied in the array (the end is filled with zeros)
+    if (target == ARR_CHR && str != nullptr && source == ARR_CHR) {
+        auto array = std::dynamic_pointer_cast<Array>(variable);
+        std::vector<std::string> chars = characters(str->value()._str);
+        size_t size = array->size();
+        Value *copy = get(array->id(), ARR_CHR);
+
+        chars.resize(std::min(chars.size(), size > 0 ? size - 1 : 0));
+        for (size_t i = 0; i < size; ++i) {
+            Value *c = i < chars.size() ? character(chars[i])
+                                        : function_->constant(INT, 0);
+            emit(Opcode::Store, NIL,
+                 {copy, function_->constant(INT, (long long)i), c});
+        }
+    } else if (auto access = std::dynamic_pointer_cast<ArrayAccess>(variable)) {
+        // python evaluates the value before the index
+        schedule({[=] { expression(value); },
+                  [=] { values_.push_back(convert(pop(), target, source)); },
+                  [=] { expression(access->index()); },
+                  [=] {
+                      Value *index = pop();
+                      Value *converted = pop();
+                      Value *array = get(access->id(), getArrayType(target));
+                      emit(Opcode::Store, NIL, {array, index, converted});
+                  }});
+    } else {
+        schedule({[=] { expression(value); },
+                  [=] {
+                      set(variable->id(), target,
+                          convert(pop(), target, source));
+                  }});
+    }
+}
+
+/**
+ * @brief  The bounds of the range are evaluated once and the loop variable is
+ *         assigned at the beginning of each iteration from a hidden counter.
+ *         When the step is not a constant, its sign is tested at each
+ *         iteration to know which comparison ends the loop.
+ *
+ * NOTE: python raises an error when the step is zero, here the loop never
+ *       ends unless the begin is lower or equal to the end.
+ */
+void Lowering::loop(std::shared_ptr<For> const &loop) {
+    Variable const &variable = loop->variable();
+    std::string counter = "." + std::to_string(temporaries_++);
+    Block *header = function_->block();
+    Block *body = function_->block();
+    Block *exit = function_->block();
+
+    schedule({[=] { expression(loop->begin()); },
+              [=] { expression(loop->end()); },
+              [=] { expression(loop->step()); },
+              [=] {
+                  Value *step = pop();
+                  Value *end = pop();
+                  set(counter, INT, pop());
+                  jump(header);
+                  current_ = header;
+                  Value *index = get(counter, INT);
+                  if (step->kind() == Value::CONSTANT && step->type() == INT &&
+                      step->integer() != 0) {
+                      Opcode test = step->integer() > 0 ? Opcode::Lt
+                                                        : Opcode::Gt;
+                      branch(emit(test, INT, {index, end}), body, exit);
+                  } else {
+                      Block *up = function_->block();
+                      Block *down = function_->block();
+                      Value *zero = function_->constant(INT, 0);
+                      branch(emit(Opcode::Gt, INT, {step, zero}), up, down);
+                      current_ = up;
+                      branch(emit(Opcode::Lt, INT, {index, end}), body, exit);
+                      current_ = down;
+                      branch(emit(Opcode::Gt, INT, {index, end}), body, exit);
+                  }
+                  current_ = body;
+                  set(variable.id(), variable.type(), index);
+                  then([=] {
+                      Value *next = emit(Opcode::Add, INT,
+                                         {get(counter, INT), step});
+                      set(counter, INT, next);
+                      jump(header);
+                      current_ = exit;
+                  });
+                  statement(loop->block());
+              }});
+}
+
+/******************************************************************************/
+/*                                expressions                                 */
+/******************************************************************************/
+
+static Opcode opcode(std::shared_ptr<::Node> const &node) {
+    if (std::dynamic_pointer_cast<AddOP>(node)) {
+        return Opcode::Add;
+    } else if (std::dynamic_pointer_cast<MnsOP>(node)) {
+        return Opcode::Sub;
+    } else if (std::dynamic_pointer_cast<TmsOP>(node)) {
+        return Opcode::Mul;
+    } else if (std::dynamic_pointer_cast<DivOP>(node)) {
+        return Opcode::Div;
+    } else if (std::dynamic_pointer_cast<EqlOP>(node)) {
+        return Opcode::Eq;
+    } else if (std::dynamic_pointer_cast<SupOP>(node)) {
+        return Opcode::Gt;
+    } else if (std::dynamic_pointer_cast<InfOP>(node)) {
+        return Opcode::Lt;
+    } else if (std::dynamic_pointer_cast<SeqOP>(node)) {
+        return Opcode::Ge;
+    } else if (std::dynamic_pointer_cast<IeqOP>(node)) {
+        return Opcode::Le;
+    }
+    return Opcode::Xor;
+}
+
+/**
+ * @brief  Schedule the translation of an expression, its value is pushed on
+ *         the stack of values.
+ */
+void Lowering::expression(Node const &node) {
+    auto binary = std::dynamic_pointer_cast<BinaryOperation>(node);
+
+    if (auto value = std::dynamic_pointer_cast<::Value>(node)) {
+        values_.push_back(constant(value));
+    } else if (auto access = std::dynamic_pointer_cast<ArrayAccess>(node)) {
+        schedule({[=] { expression(access->index()); },
+                  [=] {
+                      Value *index = pop();
+                      Value *array =
+                              get(access->id(), getArrayType(access->type()));
+                      values_.push_back(emit(Opcode::Load, access->type(),
+                                             {array, index}));
+                  }});
+    } else if (auto variable = std::dynamic_pointer_cast<Variable>(node)) {
+        values_.push_back(get(variable->id(), variable->type()));
+    } else if (auto call = std::dynamic_pointer_cast<FunctionCall>(node)) {
+        std::vector<Task> tasks;
+        for (auto const &parameter : call->params()) {
+            tasks.push_back([=] { expression(parameter); });
+        }
+        tasks.push_back([=] {
+            std::vector<Value *> arguments(call->params().size());
+            for (auto it = arguments.rbegin(); it != arguments.rend(); ++it) {
+                *it = pop();
+            }
+            // the arguments are converted to the declared types of the
+            // parameters
+            auto argument = call->params().begin();
+            auto type = call->parameterTypes().begin();
+            for (size_t i = 0; i < arguments.size() &&
+                               type != call->parameterTypes().end();
+                 ++i, ++argument, ++type) {
+                arguments[i] =
+                        convert(arguments[i], *type, (*argument)->type());
+            }
+            // the strings have the declared size of the parameters
+            auto parameter = call->params().begin();
+            auto size = call->sizes().begin();
+            for (size_t i = 0; i < arguments.size() &&
+                               size != call->sizes().end();
+                 ++i, ++parameter, ++size) {
+                auto string = std::dynamic_pointer_cast<::Value>(*parameter);
+                if (string != nullptr && string->type() == ARR_CHR) {
+                    auto array = static_cast<Instruction *>(arguments[i]);
+                    array->size(std::max(array->size(), (size_t)*size));
+                }
+            }
+            Instruction *result =
+                    emit(Opcode::Call, call->type(), arguments);
+            result->symbol(call->functionName());
+            values_.push_back(result);
+        });
+        schedule(tasks);
+    } else if (std::dynamic_pointer_cast<AndOP>(node) ||
+               std::dynamic_pointer_cast<OrOP>(node)) {
+        // the value of a lazy operation is given by the branch taken
+        std::string result = "." + std::to_string(temporaries_++);
+        Block *onTrue = function_->block();
+        Block *onFalse = function_->block();
+        Block *join = function_->block();
+        schedule({[=] { condition(node, onTrue, onFalse); },
+                  [=] {
+                      current_ = onTrue;
+                      set(result, INT, function_->constant(INT, 1));
+                      jump(join);
+                      current_ = onFalse;
+                      set(result, INT, function_->constant(INT, 0));
+                      jump(join);
+                      current_ = join;
+                      values_.push_back(get(result, INT));
+                  }});
+    } else if (auto negation = std::dynamic_pointer_cast<NotOP>(node)) {
+        schedule({[=] { expression(negation->param()); },
+                  [this] {
+                      values_.push_back(emit(Opcode::Not, INT, {pop()}));
+                  }});
+    } else if (binary != nullptr) {
+        auto typed = std::dynamic_pointer_cast<TypedNode>(node);
+        // the comparisons give a boolean
+        PrimitiveType type = typed != nullptr ? typed->type() : INT;
+        Opcode operation = opcode(node);
+        schedule({[=] { expression(binary->left()); },
+                  [=] { expression(binary->right()); },
+                  [=] {
+                      Value *right = pop();
+                      Value *left = pop();
+                      values_.push_back(emit(operation, type, {left, right}));
+                  }});
+    } else {
+        throw std::logic_error("unexpected node in an expression");
+    }
+}
+
+/**
+ * @brief  Schedule the translation of a condition: the current block ends
+ *         with a branch to `onTrue` or `onFalse`.
+ */
+void Lowering::condition(Node const &node, Block *onTrue, Block *onFalse) {
+    if (auto conjunction = std::dynamic_pointer_cast<AndOP>(node)) {
+        Block *next = function_->block();
+        schedule({[=] { condition(conjunction->left(), next, onFalse); },
+                  [=] {
+                      current_ = next;
+                      condition(conjunction->right(), onTrue, onFalse);
+                  }});
+    } else if (auto disjunction = std::dynamic_pointer_cast<OrOP>(node)) {
+        Block *next = function_->block();
+        schedule({[=] { condition(disjunction->left(), onTrue, next); },
+                  [=] {
+                      current_ = next;
+                      condition(disjunction->right(), onTrue, onFalse);
+                  }});
+    } else if (auto negation = std::dynamic_pointer_cast<NotOP>(node)) {
+        then([=] { condition(negation->param(), onFalse, onTrue); });
+    } else {
+        schedule({[=] { expression(node); },
+                  [=] { branch(pop(), onTrue, onFalse); }});
+    }
+}
+
+Value *Lowering::constant(std::shared_ptr<::Value> const &value) {
+    LiteralValue const &literal = value->value();
+
+    switch (value->type()) {
+    case FLT:
+        return function_->constant(literal._flt);
+    case CHR:
+        return function_->constant(CHR, (unsigned char)literal._chr);
+    case ARR_CHR: {
+        std::vector<std::string> chars = characters(literal._str);
+        Instruction *array = emit(Opcode::NewArray, ARR_CHR);
+        // the strings end with a zero
+        array->size(chars.size() + 1);
+        for (size_t i = 0; i < chars.size(); ++i) {
+            emit(Opcode::Store, NIL,
+                 {array, function_->constant(INT, (long long)i),
+                  character(chars[i])});
+        }
+        return array;
+    }
+    default:
+        return function_->constant(INT, literal._int);
+    }
+}
+
+Value *Lowering::character(std::string const &literal) {
+    Value *value = function_->constant(CHR, characterCode(literal));
+    value->literal(literal);
+    return value;
+}
+
+/******************************************************************************/
+/*                                instructions                                */
+/******************************************************************************/
+
+Instruction *Lowering::emit(Opcode opcode, PrimitiveType type,
+                            std::vector<Value *> const &operands) {
+    return current_->add(std::make_unique<Instruction>(opcode, type, operands));
+}
+
+Value *Lowering::pop() {
+    Value *value = values_.back();
+    values_.pop_back();
+    return value;
+}
+
+Value *Lowering::get(std::string const &variable, PrimitiveType type) {
+    Instruction *get = emit(Opcode::Get, type);
+    get->symbol(variable);
+    return get;
+}
+
+/**
+ * @brief  The type of a `set` is the one of the variable.
+ */
+void Lowering::set(std::string const &variable, PrimitiveType type,
+                   Value *value) {
+    emit(Opcode::Set, type, {value})->symbol(variable);
+}
+
+/**
+ * @brief  Conversion of a value where the python code converts it (see
+ *         conversion). The true division of two integers converted to an
+ *         integer becomes the integer division (int(a/b) rounds toward zero),
+ *         which doesn't need the floats.
+ */
+Value *Lowering::convert(Value *value, PrimitiveType type,
+                         PrimitiveType source) {
+    Instruction *division = value->kind() == Value::INSTRUCTION
+                                    ? static_cast<Instruction *>(value)
+                                    : nullptr;
+
+    if (conversion(type, source) == nullptr) {
+        return value;
+    } else if (type == INT && division != nullptr &&
+               division->opcode() == Opcode::Div &&
+               division->type() == FLT &&
+               division->operands()[0]->type() == INT &&
+               division->operands()[1]->type() == INT) {
+        division->type(INT);
+        return division;
+    }
+    return emit(Opcode::Conv, type, {value});
+}
+
+void Lowering::jump(Block *target) {
+    emit(Opcode::Jump, NIL)->targets() = {target};
+}
+
+void Lowering::branch(Value *condition, Block *onTrue, Block *onFalse) {
+    emit(Opcode::Branch, NIL, {condition})->targets() = {onTrue, onFalse};
+}
+
+/**
+ * @brief  Bypass the blocks that only jump, remove the unreachable blocks,
+ *         merge the blocks with their only predecessor when it jumps to them,
+ *         and sort the blocks in reverse post-order.
+ */
+void Lowering::simplify() {
+    std::map<Block *, Block *> forward;
+    std::set<Block *> merged;
+
+    // the blocks that only jump are bypassed
+    for (auto const &block : function_->blocks()) {
+        Instruction *last = block->terminator();
+        if (block.get() != function_->entry() &&
+            block->instructions().size() == 1 && last != nullptr &&
+            last->opcode() == Opcode::Jump) {
+            forward[block.get()] = last->targets()[0];
+        }
+    }
+    auto destination = [&](Block *block) {
+        std::set<Block *> seen;
+        Block *target = block;
+        while (forward.count(target) > 0 && seen.insert(target).second) {
+            target = forward[target];
+        }
+        // the chains are shortened for the next blocks
+        for (Block *bypassed : seen) {
+            forward[bypassed] = target;
+        }
+        return target;
+    };
+    for (auto const &block : function_->blocks()) {
+        if (Instruction *last = block->terminator()) {
+            for (Block *&target : last->targets()) {
+                target = destination(target);
+            }
+        }
+    }
+
+    function_->computePredecessors();
+    DominatorTree tree(*function_);
+
+    for (Block *block : tree.order()) {
+        if (merged.count(block) > 0) {
+            continue;
+        }
+        for (;;) {
+            Instruction *last = block->terminator();
+            if (last->opcode() != Opcode::Jump) {
+                break;
+            }
+            Block *next = last->targets()[0];
+            auto predecessors = std::count_if(
+                    next->predecessors().begin(), next->predecessors().end(),
+                    [&](Block *b) { return tree.reachable(b); });
+            if (next == block || next == function_->entry() ||
+                predecessors != 1) {
+                break;
+            }
+            block->instructions().pop_back();
+            for (auto const &instruction : next->instructions()) {
+                instruction->block(block);
+            }
+            // the predecessors are computed again at the end, merging does
+            // not change their number
+            block->instructions().splice(block->instructions().end(),
+                                         next->instructions());
+            merged.insert(next);
+        }
+    }
+
+    std::map<Block *, std::unique_ptr<Block>> owned;
+    for (auto &block : function_->blocks()) {
+        owned[block.get()] = std::move(block);
+    }
+    function_->blocks().clear();
+    for (Block *block : tree.order()) {
+        if (merged.count(block) == 0) {
+            function_->blocks().push_back(std::move(owned[block]));
+        }
+    }
+    function_->computePredecessors();
+}
+
+} // namespace ir
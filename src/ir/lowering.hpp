@@ -0,0 +1,72 @@
+#ifndef LOWERING_H
+#define LOWERING_H
+#include "ast/program.hpp"
+#include "ir.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief  Lowering of the AST in the IR. The statements are translated in
+ *         basic blocks where the variables are read and written with `get` and
+ *         `set`, then the SSA form is built (see SSABuilder). The blocks that
+ *         only jump are bypassed, the ones that can't be reached are removed,
+ *         and a block is merged with its only predecessor when it is the only
+ *         successor of this one.
+ *
+ *         The `and` and `lor` are translated into branches (python evaluates
+ *         them lazily), and the strings into new arrays of characters. A
+ *         string assigned to an array is stored in each element of its
+ *         declared size (the python code replaces the whole list, whatever
+ *         its size), and a string given to an array parameter is created
+ *         with the declared size of the parameter, so the callee can assign
+ *         it.
+ *
+ * NOTE: the translation is done with a stack of tasks instead of recursive
+ *       calls, so the deeply nested programs don't overflow the stack.
+ */
+class Lowering {
+  public:
+    std::unique_ptr<Module> lower(std::shared_ptr<Program> program);
+
+  private:
+    using Task = std::function<void()>;
+    using Node = std::shared_ptr<::Node>;
+
+    void lower(std::shared_ptr<::Function> function);
+    void run(Task const &task);
+    void schedule(std::vector<Task> const &tasks);
+    void then(Task const &task) { tasks_.push_back(task); }
+
+    void statement(Node const &node);
+    void expression(Node const &node);
+    void condition(Node const &node, Block *onTrue, Block *onFalse);
+    void assignment(std::shared_ptr<Assignment> const &assignment);
+    void loop(std::shared_ptr<For> const &loop);
+
+    Instruction *emit(Opcode opcode, PrimitiveType type,
+                      std::vector<Value *> const &operands = {});
+    Value *pop();
+    Value *get(std::string const &variable, PrimitiveType type);
+    void set(std::string const &variable, PrimitiveType type, Value *value);
+    Value *convert(Value *value, PrimitiveType type, PrimitiveType source);
+    Value *constant(std::shared_ptr<::Value> const &value);
+    Value *character(std::string const &literal);
+    void jump(Block *target);
+    void branch(Value *condition, Block *onTrue, Block *onFalse);
+    void simplify();
+
+    Module *module_ = nullptr;
+    Function *function_ = nullptr;
+    Block *current_ = nullptr; //< block where the instructions are added
+    std::vector<Task> tasks_ = {};
+    std::vector<Value *> values_ = {}; //< results of the expressions
+    size_t temporaries_ = 0;
+};
+
+} // namespace ir
+
+#endif
@@ -0,0 +1,275 @@
+#include "pyemitter.hpp"
+#include "ast/python.hpp"
+#include <vector>
+
+namespace ir {
+
+static void indent(std::ostream &os, int lvl) {
+    for (int i = 0; i < lvl; ++i) {
+        os << '\t';
+    }
+}
+
+/**
+ * @brief  Python operator of the binary instructions.
+ */
+static char const *symbol(Instruction const &instruction) {
+    switch (instruction.opcode()) {
+    case Opcode::Add:
+        return "+";
+    case Opcode::Sub:
+        return "-";
+    case Opcode::Mul:
+        return "*";
+    case Opcode::Div:
+        return "/";
+    case Opcode::Eq:
+        return "==";
+    case Opcode::Gt:
+        return ">";
+    case Opcode::Lt:
+        return "<";
+    case Opcode::Ge:
+        return ">=";
+    case Opcode::Le:
+        return "<=";
+    default:
+        return "!=";
+    }
+}
+
+void PythonEmitter::emit(std::ostream &os, Module const &module) {
+    os << "#!/usr/bin/env python3" << std::endl;
+    os << "# generated using ISIMA's transpiler" << std::endl << std::endl;
+    for (auto const &function : module.functions()) {
+        if (function->memoized()) {
+            os << "import functools" << std::endl << std::endl;
+            break;
+        }
+    }
+    for (auto const &function : module.functions()) {
+        emit(os, *function);
+        os << std::endl;
+    }
+    os << std::endl << "if __name__ == '__main__':" << std::endl << "\tmain()";
+}
+
+void PythonEmitter::emit(std::ostream &os, Function const &function) {
+    used_.clear();
+    copies_.clear();
+    for (auto const &block : function.blocks()) {
+        for (auto const &instruction : block->instructions()) {
+            used_.insert(instruction->operands().begin(),
+                         instruction->operands().end());
+            if (instruction->opcode() != Opcode::Phi) {
+                continue;
+            }
+            for (size_t i = 0; i < instruction->targets().size(); ++i) {
+                Value *value = instruction->operands()[i];
+                Block *source = instruction->targets()[i];
+                auto &copies = copies_[{source, block.get()}];
+                // the variable stays unassigned on this path, and a block can
+                // be twice a predecessor (branch to the same block)
+                if (value->kind() == Value::UNDEFINED ||
+                    (!copies.empty() &&
+                     copies.back().first == instruction.get())) {
+                    continue;
+                }
+                copies.push_back({instruction.get(), value});
+            }
+        }
+    }
+
+    if (function.memoized()) {
+        os << "@functools.lru_cache(maxsize=None)" << std::endl;
+    }
+    os << "def " << function.name() << "(";
+    for (auto const &parameter : function.parameters()) {
+        if (parameter != function.parameters().front()) {
+            os << ",";
+        }
+        os << parameter->name();
+    }
+    os << "):" << std::endl;
+    // the entry has no predecessor, it is run once before the loop
+    emit(os, *function.entry(), 1);
+    if (function.blocks().size() > 1) {
+        indent(os, 1);
+        os << "while True:" << std::endl;
+        dispatch(os, function, 1, function.blocks().size(), 2);
+    }
+}
+
+/**
+ * @brief  Binary search of the current block among the blocks from `begin`
+ *         to `end` (excluded).
+ */
+void PythonEmitter::dispatch(std::ostream &os, Function const &function,
+                             size_t begin, size_t end, int lvl) {
+    if (end - begin == 1) {
+        emit(os, *function.blocks()[begin], lvl);
+        return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    indent(os, lvl);
+    os << "if _b<" << function.blocks()[middle]->id() << ":" << std::endl;
+    dispatch(os, function, begin, middle, lvl + 1);
+    indent(os, lvl);
+    os << "else:" << std::endl;
+    dispatch(os, function, middle, end, lvl + 1);
+}
+
+void PythonEmitter::emit(std::ostream &os, Block const &block, int lvl) {
+    for (auto const &instruction : block.instructions()) {
+        if (instruction->opcode() != Opcode::Phi) {
+            emit(os, *instruction, lvl);
+        }
+    }
+}
+
+void PythonEmitter::emit(std::ostream &os, Instruction const &instruction,
+                         int lvl) {
+    auto const &operands = instruction.operands();
+    Opcode opcode = instruction.opcode();
+
+    if (opcode == Opcode::Jump) {
+        edge(os, instruction.block(), instruction.targets()[0], lvl);
+        return;
+    }
+    indent(os, lvl);
+    if (hasResult(opcode) &&
+        (opcode != Opcode::Call || used_.count(&instruction) > 0)) {
+        os << name(&instruction) << "=";
+    }
+    switch (opcode) {
+    case Opcode::Not:
+        os << "not(" << name(operands[0]) << ")";
+        break;
+    case Opcode::Conv: {
+        char const *builtin =
+                conversion(instruction.type(), operands[0]->type());
+        if (builtin != nullptr) {
+            os << builtin << "(" << name(operands[0]) << ")";
+        } else {
+            os << name(operands[0]);
+        }
+    } break;
+    case Opcode::NewArray:
+        os << "[" << (instruction.type() == ARR_FLT ? "0.0" : "0") << "]*"
+           << instruction.size();
+        break;
+    case Opcode::Load:
+        os << name(operands[0]) << "[" << name(operands[1]) << "]";
+        break;
+    case Opcode::Store:
+        os << name(operands[0]) << "[" << name(operands[1])
+           << "]=" << name(operands[2]);
+        break;
+    case Opcode::Call:
+        os << instruction.symbol() << "(";
+        for (size_t i = 0; i < operands.size(); ++i) {
+            os << (i == 0 ? "" : ",") << name(operands[i]);
+        }
+        os << ")";
+        break;
+    case Opcode::Print:
+        os << "print("
+           << (operands.empty() ? instruction.symbol() : name(operands[0]))
+           << ",end=\"\")";
+        break;
+    case Opcode::Read: {
+        char const *builtin = readConversion(instruction.type());
+        if (builtin != nullptr) {
+            os << builtin << "(input())";
+        } else {
+            os << "input()";
+        }
+    } break;
+    case Opcode::Branch:
+        os << "if " << name(operands[0]) << ":" << std::endl;
+        edge(os, instruction.block(), instruction.targets()[0], lvl + 1);
+        indent(os, lvl);
+        os << "else:" << std::endl;
+        edge(os, instruction.block(), instruction.targets()[1], lvl + 1);
+        return;
+    case Opcode::Ret:
+        os << "return";
+        if (!operands.empty()) {
+            os << " " << name(operands[0]);
+        }
+        break;
+    case Opcode::Xor:
+        os << "(" << name(operands[0]) << ")!=(" << name(operands[1]) << ")";
+        break;
+    case Opcode::Div:
+        // the integer division is the true division rounded toward zero
+        if (instruction.type() == INT) {
+            os << "int(" << name(operands[0]) << "/" << name(operands[1])
+               << ")";
+        } else {
+            os << name(operands[0]) << "/" << name(operands[1]);
+        }
+        break;
+    default:
+        os << name(operands[0]) << symbol(instruction) << name(operands[1]);
+        break;
+    }
+    os << std::endl;
+}
+
+/**
+ * @brief  Assign the phis of the target with their values for the edge from
+ *         the source, and select the target.
+ */
+void PythonEmitter::edge(std::ostream &os, Block *source, Block *target,
+                         int lvl) {
+    std::vector<std::string> phis;
+    std::vector<std::string> values;
+
+    auto copies = copies_.find({source, target});
+    if (copies != copies_.end()) {
+        for (auto const &[phi, value] : copies->second) {
+            phis.push_back(name(phi));
+            values.push_back(name(value));
+        }
+    }
+    if (!phis.empty()) {
+        indent(os, lvl);
+        for (size_t i = 0; i < phis.size(); ++i) {
+            os << (i == 0 ? "" : ",") << phis[i];
+        }
+        os << "=";
+        for (size_t i = 0; i < values.size(); ++i) {
+            os << (i == 0 ? "" : ",") << values[i];
+        }
+        os << std::endl;
+    }
+    indent(os, lvl);
+    os << "_b=" << target->id() << std::endl;
+}
+
+std::string PythonEmitter::name(Value const *value) const {
+    switch (value->kind()) {
+    case Value::CONSTANT:
+        if (value->type() == FLT) {
+            return floatLiteral(value->floating());
+        } else if (value->type() == CHR) {
+            return characterLiteral(*value);
+        }
+        return std::to_string(value->integer());
+    case Value::PARAMETER:
+        return value->name();
+    case Value::INSTRUCTION:
+        return "_" + std::to_string(value->id());
+    default: {
+        // never assigned, reading it raises a NameError like the variable
+        std::string variable = value->name();
+        for (char &c : variable) {
+            c = c == '.' ? '_' : c;
+        }
+        return "_undef_" + variable;
+    }
+    }
+}
+
+} // namespace ir
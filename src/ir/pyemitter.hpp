@@ -0,0 +1,45 @@
+#ifndef PY_EMITTER_H
+#define PY_EMITTER_H
+#include "ir.hpp"
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief  Generation of the python script from the IR (see `--via-ir`). The
+ *         entry block of a function is written first, then the other blocks
+ *         are dispatched in a loop on the number of the current block (the
+ *         tests form a binary tree). The phis are variables assigned on the
+ *         edges that lead to their block, all at once with a tuple assignment.
+ *
+ * NOTE: python has no goto and no labeled break, so the blocks are not
+ *       translated back in `if` and `while` statements.
+ */
+class PythonEmitter {
+  public:
+    void emit(std::ostream &os, Module const &module);
+
+  private:
+    void emit(std::ostream &os, Function const &function);
+    void dispatch(std::ostream &os, Function const &function, size_t begin,
+                  size_t end, int lvl);
+    void emit(std::ostream &os, Block const &block, int lvl);
+    void emit(std::ostream &os, Instruction const &instruction, int lvl);
+    void edge(std::ostream &os, Block *source, Block *target, int lvl);
+    std::string name(Value const *value) const;
+
+    std::set<Value const *> used_ = {};
+    // assignments of the phis on the edges (source and target blocks)
+    std::map<std::pair<Block const *, Block const *>,
+             std::vector<std::pair<Value const *, Value const *>>>
+            copies_ = {};
+};
+
+} // namespace ir
+
+#endif
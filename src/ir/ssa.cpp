@@ -0,0 +1,245 @@
+#include "ssa.hpp"
+#include "dominators.hpp"
+#include <set>
+#include <utility>
+
+namespace ir {
+
+void SSABuilder::build(Function &function) {
+    function.computePredecessors();
+    place(function);
+    rename(function);
+    simplify(function);
+    phis_.clear();
+    replaced_.clear();
+}
+
+/**
+ * @brief  Value that replaces `value` (the chains of replacements are
+ *         shortened on the way).
+ */
+Value *SSABuilder::resolve(Value *value) {
+    Value *result = value;
+    while (replaced_.count(result) > 0) {
+        result = replaced_[result];
+    }
+    while (value != result) {
+        Value *next = replaced_[value];
+        replaced_[value] = result;
+        value = next;
+    }
+    return result;
+}
+
+void SSABuilder::place(Function &function) {
+    DominatorTree tree(function);
+    std::map<std::string, std::set<Block *>> definitions;
+    std::map<std::string, PrimitiveType> types;
+
+    for (Block *block : tree.order()) {
+        for (auto const &instruction : block->instructions()) {
+            if (instruction->opcode() == Opcode::Set) {
+                definitions[instruction->symbol()].insert(block);
+                types[instruction->symbol()] = instruction->type();
+            }
+        }
+    }
+    for (auto const &[variable, blocks] : definitions) {
+        std::set<Block *> placed;
+        std::vector<Block *> work(blocks.begin(), blocks.end());
+        while (!work.empty()) {
+            Block *block = work.back();
+            work.pop_back();
+            for (Block *frontier : tree.frontier(block)) {
+                if (!placed.insert(frontier).second) {
+                    continue;
+                }
+                auto phi = std::make_unique<Instruction>(Opcode::Phi,
+                                                         types[variable]);
+                phi->symbol(variable);
+                phi->block(frontier);
+                phis_[frontier].push_back(phi.get());
+                frontier->instructions().push_front(std::move(phi));
+                if (blocks.count(frontier) == 0) {
+                    work.push_back(frontier);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief  Walk of the dominator tree with a stack of definitions per
+ *         variable (without recursion, the trees can be deep).
+ */
+void SSABuilder::rename(Function &function) {
+    DominatorTree tree(function);
+    std::map<std::string, std::vector<Value *>> stacks;
+    std::map<Block *, std::vector<std::string>> pushed;
+    std::map<std::string, Value *> undefined;
+    std::set<Instruction *> removed;
+    std::vector<std::pair<Block *, bool>> walk = {{function.entry(), false}};
+
+    auto reaching = [&](Instruction const *instruction) {
+        std::string const &variable = instruction->symbol();
+        std::vector<Value *> &stack = stacks[variable];
+        if (!stack.empty()) {
+            return stack.back();
+        } else if (undefined.count(variable) == 0) {
+            undefined[variable] =
+                    function.undefined(variable, instruction->type());
+        }
+        return undefined[variable];
+    };
+
+    while (!walk.empty()) {
+        auto [block, done] = walk.back();
+        walk.pop_back();
+        if (done) {
+            for (std::string const &variable : pushed[block]) {
+                stacks[variable].pop_back();
+            }
+            continue;
+        }
+        for (auto const &instruction : block->instructions()) {
+            for (Value *&operand : instruction->operands()) {
+                operand = resolve(operand);
+            }
+            switch (instruction->opcode()) {
+            case Opcode::Phi:
+                stacks[instruction->symbol()].push_back(instruction.get());
+                pushed[block].push_back(instruction->symbol());
+                break;
+            case Opcode::Get:
+                replaced_[instruction.get()] = reaching(instruction.get());
+                removed.insert(instruction.get());
+                break;
+            case Opcode::Set:
+                stacks[instruction->symbol()].push_back(
+                        instruction->operands()[0]);
+                pushed[block].push_back(instruction->symbol());
+                removed.insert(instruction.get());
+                break;
+            default:
+                break;
+            }
+        }
+        for (Block *successor : block->successors()) {
+            for (Instruction *phi : phis_[successor]) {
+                phi->operands().push_back(reaching(phi));
+                phi->targets().push_back(block);
+            }
+        }
+        walk.push_back({block, true});
+        for (Block *child : tree.children(block)) {
+            walk.push_back({child, false});
+        }
+    }
+    // all the uses are renamed, the addresses of the removed instructions
+    // must not stay in the replacements
+    replaced_.clear();
+
+    for (auto const &block : function.blocks()) {
+        block->instructions().remove_if(
+                [&](auto const &i) { return removed.count(i.get()) > 0; });
+    }
+}
+
+/**
+ * @brief  Remove the trivial phis (all their operands are the same value or
+ *         the phi itself) and the phis that are not used.
+ */
+void SSABuilder::simplify(Function &function) {
+    std::map<Instruction *, std::vector<Instruction *>> users;
+    std::vector<Instruction *> work;
+    std::set<Instruction *> removed;
+
+    for (auto const &[block, phis] : phis_) {
+        for (Instruction *phi : phis) {
+            for (Value *operand : phi->operands()) {
+                if (operand->kind() == Value::INSTRUCTION) {
+                    users[static_cast<Instruction *>(operand)].push_back(phi);
+                }
+            }
+            work.push_back(phi);
+        }
+    }
+    while (!work.empty()) {
+        Instruction *phi = work.back();
+        work.pop_back();
+        if (removed.count(phi) > 0) {
+            continue;
+        }
+        Value *same = nullptr;
+        bool trivial = true;
+        for (Value *operand : phi->operands()) {
+            operand = resolve(operand);
+            if (operand == phi || operand == same) {
+                continue;
+            } else if (same != nullptr) {
+                trivial = false;
+                break;
+            }
+            same = operand;
+        }
+        if (!trivial) {
+            continue;
+        }
+        if (same == nullptr) {
+            same = function.undefined(phi->symbol(), phi->type());
+        }
+        replaced_[phi] = same;
+        removed.insert(phi);
+        for (Instruction *user : users[phi]) {
+            work.push_back(user);
+            if (same->kind() == Value::INSTRUCTION) {
+                users[static_cast<Instruction *>(same)].push_back(user);
+            }
+        }
+    }
+
+    // the phis are live when they are used by another instruction or a live
+    // phi
+    std::set<Instruction *> live;
+    work.clear();
+    for (auto const &block : function.blocks()) {
+        for (auto const &instruction : block->instructions()) {
+            for (Value *&operand : instruction->operands()) {
+                operand = resolve(operand);
+            }
+            if (instruction->opcode() == Opcode::Phi ||
+                removed.count(instruction.get()) > 0) {
+                continue;
+            }
+            for (Value *operand : instruction->operands()) {
+                if (operand->kind() != Value::INSTRUCTION) {
+                    continue;
+                }
+                auto phi = static_cast<Instruction *>(operand);
+                if (phi->opcode() == Opcode::Phi && live.insert(phi).second) {
+                    work.push_back(phi);
+                }
+            }
+        }
+    }
+    while (!work.empty()) {
+        Instruction *phi = work.back();
+        work.pop_back();
+        for (Value *operand : phi->operands()) {
+            if (operand->kind() != Value::INSTRUCTION) {
+                continue;
+            }
+            auto used = static_cast<Instruction *>(operand);
+            if (used->opcode() == Opcode::Phi && live.insert(used).second) {
+                work.push_back(used);
+            }
+        }
+    }
+    for (auto const &block : function.blocks()) {
+        block->instructions().remove_if([&](auto const &i) {
+            return i->opcode() == Opcode::Phi && live.count(i.get()) == 0;
+        });
+    }
+}
+
+} // namespace ir
@@ -0,0 +1,37 @@
+#ifndef SSA_H
+#define SSA_H
+#include "ir.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ir {
+
+/**
+ * @brief  Construction of the SSA form (Cytron et al.): the phi instructions
+ *         are placed on the iterated dominance frontiers of the blocks that
+ *         assign each variable, then the `get` are replaced by the reaching
+ *         definitions during a walk of the dominator tree and the `set` are
+ *         removed. Finally, the phis that merge only one value are replaced by
+ *         this value, and the ones that are not used are removed.
+ *
+ *         A variable read where it may not be assigned gives an undefined
+ *         value.
+ */
+class SSABuilder {
+  public:
+    void build(Function &function);
+
+  private:
+    void place(Function &function);
+    void rename(Function &function);
+    void simplify(Function &function);
+    Value *resolve(Value *value);
+
+    std::map<Block *, std::vector<Instruction *>> phis_ = {};
+    std::map<Value *, Value *> replaced_ = {};
+};
+
+} // namespace ir
+
+#endif
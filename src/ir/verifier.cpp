@@ -0,0 +1,265 @@
+#include "verifier.hpp"
+#include "dominators.hpp"
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace ir {
+
+bool Verifier::verify(Module const &module) {
+    errors_.clear();
+    for (auto const &function : module.functions()) {
+        verify(module, *function);
+    }
+    return errors_.empty();
+}
+
+void Verifier::error(Function const &function, Block const *block,
+                     std::string const &message) {
+    std::ostringstream oss;
+
+    oss << function.name();
+    if (block != nullptr) {
+        oss << ": b" << block->id();
+    }
+    oss << ": " << message;
+    errors_.push_back(oss.str());
+}
+
+/**
+ * @brief  Number of operands of an instruction, or -1 when it depends on the
+ *         instruction.
+ */
+static int arity(Opcode opcode) {
+    switch (opcode) {
+    case Opcode::NewArray:
+    case Opcode::Read:
+    case Opcode::Get:
+    case Opcode::Jump:
+        return 0;
+    case Opcode::Not:
+    case Opcode::Conv:
+    case Opcode::Set:
+    case Opcode::Branch:
+        return 1;
+    case Opcode::Load:
+        return 2;
+    case Opcode::Store:
+        return 3;
+    case Opcode::Phi:
+    case Opcode::Call:
+    case Opcode::Print:
+    case Opcode::Ret:
+        return -1;
+    default:
+        return 2;
+    }
+}
+
+void Verifier::verify(Module const &module, Function const &function) {
+    size_t count = errors_.size();
+    std::set<Block *> blocks;
+    std::set<Value const *> parameters;
+    // block and index of the instructions
+    std::map<Value const *, std::pair<Block *, size_t>> positions;
+    std::map<Block *, std::multiset<Block *>> predecessors;
+
+    if (function.blocks().empty()) {
+        error(function, nullptr, "no entry block");
+        return;
+    }
+    for (auto const &parameter : function.parameters()) {
+        parameters.insert(parameter.get());
+    }
+    for (auto const &block : function.blocks()) {
+        size_t index = 0;
+        blocks.insert(block.get());
+        for (auto const &instruction : block->instructions()) {
+            positions[instruction.get()] = {block.get(), index++};
+        }
+    }
+
+    // structure of the blocks
+    for (auto const &block : function.blocks()) {
+        bool body = false;
+        if (block->terminator() == nullptr) {
+            error(function, block.get(), "missing terminator");
+        }
+        for (auto const &instruction : block->instructions()) {
+            Opcode opcode = instruction->opcode();
+            if (instruction->block() != block.get()) {
+                error(function, block.get(), "instruction of another block");
+            }
+            if (isTerminator(opcode) &&
+                instruction != block->instructions().back()) {
+                error(function, block.get(), "terminator before the end");
+            }
+            if (opcode == Opcode::Phi && body) {
+                error(function, block.get(), "phi after other instructions");
+            }
+            body = body || opcode != Opcode::Phi;
+            if (opcode == Opcode::Get || opcode == Opcode::Set) {
+                error(function, block.get(), "variable outside of SSA form");
+            }
+            for (Block *target : instruction->targets()) {
+                if (blocks.count(target) == 0) {
+                    error(function, block.get(), "target out of the function");
+                }
+            }
+        }
+    }
+    if (errors_.size() > count) {
+        return;
+    }
+    for (auto const &block : function.blocks()) {
+        for (Block *successor : block->successors()) {
+            predecessors[successor].insert(block.get());
+        }
+    }
+    if (!predecessors[function.entry()].empty()) {
+        error(function, function.entry(), "the entry has predecessors");
+    }
+    for (auto const &block : function.blocks()) {
+        std::multiset<Block *> stored(block->predecessors().begin(),
+                                      block->predecessors().end());
+        if (stored != predecessors[block.get()]) {
+            error(function, block.get(), "wrong predecessors");
+        }
+    }
+    if (errors_.size() > count) {
+        return;
+    }
+
+    // operands
+    DominatorTree tree(function);
+    for (auto const &block : function.blocks()) {
+        if (!tree.reachable(block.get())) {
+            error(function, block.get(), "unreachable block");
+        }
+    }
+    if (errors_.size() > count) {
+        return;
+    }
+    auto defined = [&](Value const *value, Block *block, size_t index) {
+        switch (value->kind()) {
+        case Value::PARAMETER:
+            return parameters.count(value) > 0;
+        case Value::INSTRUCTION: {
+            auto position = positions.find(value);
+            if (position == positions.end() ||
+                !hasResult(static_cast<Instruction const *>(value)->opcode())) {
+                return false;
+            }
+            auto [definition, at] = position->second;
+            return definition == block ? at < index
+                                       : tree.dominates(definition, block);
+        }
+        default:
+            return true;
+        }
+    };
+    for (auto const &block : function.blocks()) {
+        size_t index = 0;
+        for (auto const &instruction : block->instructions()) {
+            size_t at = index++;
+            Opcode opcode = instruction->opcode();
+            auto const &operands = instruction->operands();
+            auto const &targets = instruction->targets();
+            std::string what = name(opcode);
+            int expected = arity(opcode);
+
+            if (expected >= 0 && operands.size() != (size_t)expected) {
+                error(function, block.get(), what + ": wrong operands");
+                continue;
+            }
+            switch (opcode) {
+            case Opcode::Eq:
+            case Opcode::Gt:
+            case Opcode::Lt:
+            case Opcode::Ge:
+            case Opcode::Le:
+            case Opcode::Not:
+            case Opcode::Xor:
+                if (instruction->type() != INT) {
+                    error(function, block.get(), what + ": not an int");
+                }
+                break;
+            case Opcode::Conv:
+                if (instruction->type() != INT && instruction->type() != FLT &&
+                    instruction->type() != CHR) {
+                    error(function, block.get(), "conv: bad type");
+                }
+                break;
+            case Opcode::Phi: {
+                std::multiset<Block *> incoming(targets.begin(), targets.end());
+                if (operands.size() != targets.size() ||
+                    incoming != predecessors[block.get()]) {
+                    error(function, block.get(), "phi: wrong incoming blocks");
+                    continue;
+                }
+            } break;
+            case Opcode::NewArray:
+                if (!isArray(instruction->type())) {
+                    error(function, block.get(), "newarray: not an array");
+                }
+                break;
+            case Opcode::Load:
+                if (!isArray(operands[0]->type()) ||
+                    getValueType(operands[0]->type()) != instruction->type()) {
+                    error(function, block.get(), "load: bad types");
+                }
+                break;
+            case Opcode::Store:
+                if (!isArray(operands[0]->type())) {
+                    error(function, block.get(), "store: not an array");
+                }
+                break;
+            case Opcode::Call: {
+                Function *callee = module.function(instruction->symbol());
+                if (callee == nullptr) {
+                    error(function, block.get(),
+                          "call: unknown function " + instruction->symbol());
+                } else if (callee->parameters().size() != operands.size()) {
+                    error(function, block.get(), "call: wrong arguments");
+                }
+            } break;
+            case Opcode::Print: {
+                // either a literal or a value
+                size_t values = instruction->symbol().empty() ? 1 : 0;
+                if (operands.size() != values) {
+                    error(function, block.get(), "print: wrong operands");
+                }
+            } break;
+            case Opcode::Jump:
+            case Opcode::Branch:
+                if (targets.size() != (opcode == Opcode::Jump ? 1 : 2)) {
+                    error(function, block.get(), what + ": wrong targets");
+                }
+                break;
+            case Opcode::Ret:
+                if (operands.size() > 1) {
+                    error(function, block.get(), "ret: wrong operands");
+                }
+                break;
+            default:
+                break;
+            }
+            for (size_t i = 0; i < operands.size(); ++i) {
+                // the operands of a phi are used at the end of the incoming
+                // blocks
+                bool dominated =
+                        opcode == Opcode::Phi
+                                ? defined(operands[i], targets[i],
+                                          std::numeric_limits<size_t>::max())
+                                : defined(operands[i], block.get(), at);
+                if (!dominated) {
+                    error(function, block.get(),
+                          what + ": operand not defined before its use");
+                }
+            }
+        }
+    }
+}
+
+} // namespace ir
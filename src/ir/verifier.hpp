@@ -0,0 +1,32 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+#include "ir.hpp"
+#include <list>
+#include <string>
+
+namespace ir {
+
+/**
+ * @brief  Check that a module is well formed: each block ends with a
+ *         terminator which targets are blocks of the function, the phis are
+ *         at the beginning of the blocks with one operand per predecessor, the
+ *         instructions have the right number of operands and types, the
+ *         callees exist, and each value is defined in a block that dominates
+ *         its uses.
+ */
+class Verifier {
+  public:
+    bool verify(Module const &module);
+    std::list<std::string> const &errors() const { return errors_; }
+
+  private:
+    void verify(Module const &module, Function const &function);
+    void error(Function const &function, Block const *block,
+               std::string const &message);
+
+    std::list<std::string> errors_ = {};
+};
+
+} // namespace ir
+
+#endif
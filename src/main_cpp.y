@@ -5,6 +5,8 @@
 #include <FlexLexer.h>
 #include <fstream>
 #include <filesystem>
+#include <map>
+#include <sstream>
 #include "ast/ast.hpp"
 #include "symtable/symtable.hpp"
 #include "symtable/symbol.hpp"
@@ -12,6 +14,22 @@
 #include "tools/programbuilder.hpp"
 #include "tools/errormanager.hpp"
 #include "preprocessor/preprocessor.hpp"
+#include "optimizer/constantfolder.hpp"
+#include "optimizer/cse.hpp"
+#include "optimizer/deadcode.hpp"
+#include "optimizer/deadfunctions.hpp"
+#include "optimizer/evaluator.hpp"
+#include "optimizer/idioms.hpp"
+#include "optimizer/inliner.hpp"
+#include "optimizer/licm.hpp"
+#include "optimizer/memoizer.hpp"
+#include "optimizer/native.hpp"
+#include "optimizer/profile.hpp"
+#include "optimizer/tailcalls.hpp"
+#include "optimizer/typeinference.hpp"
+#include "optimizer/vectorizer.hpp"
+#include "tools/driver.hpp"
+#include "tools/options.hpp"
 #define YYLOCATION_PRINT   location_print
 #define YYDEBUG 1
 #define DBG_PARS 0
@@ -78,7 +96,7 @@
 %token <std::string> PREPROCESSOR_LOCATION
 
 %nterm <PrimitiveType> type
-%nterm <Value> value
+%nterm <std::shared_ptr<Value>> value
 %nterm <std::shared_ptr<TypedNode>> expression
 %nterm <std::shared_ptr<TypedNode>> variable
 %nterm <std::shared_ptr<TypedNode>> arithmeticOperation
@@ -106,9 +124,6 @@ programUnit:
         // the current file name. To avoid conflicts in lexer's rules we
         // use the string token, however there must be a better way.
         currentFile = $1;
-        // suppression des '"':
-        currentFile.erase(0, 1);
-        currentFile.pop_back();
     }
     ;
 
@@ -139,7 +154,8 @@ functionDefinition:
         contextManager.newGlobalSymbol(currentFunctionName, funType, FUNCTION);
     } block[ops] {
         // error if there is a return statement
-        pb.createFunction(currentFunctionName, $ops, currentFunctionReturnType);
+        pb.createFunction(currentFunctionName, $ops, currentFunctionReturnType,
+                          currentFile);
         contextManager.leaveScope();
     }
     ;
@@ -153,7 +169,7 @@ parameterDeclarationList:
 parameterDeclaration:
     type[t] IDENTIFIER {
         DEBUG("new param: " << $2);
-        contextManager.newSymbol($2, std::list<PrimitiveType>($t), FUN_PARAM);
+        contextManager.newSymbol($2, std::list<PrimitiveType>{$t}, FUN_PARAM);
         pb.pushFunctionParam(Variable($2, $t));
     }
     | type[t] IDENTIFIER OSQUAREB INT[size] CSQUAREB {
@@ -162,7 +178,8 @@ parameterDeclaration:
         // -1 (or any default value) in order to specify that we don't
         // want to check the size at compile time when we treat the
         // function
-        contextManager.newSymbol($2, std::list<PrimitiveType>($t), LOCAL_ARRAY);
+        contextManager.newSymbol($2, std::list<PrimitiveType>{getArrayType($t)},
+                                 $size, LOCAL_ARRAY);
         pb.pushFunctionParam(Array($2, $size, getArrayType($t)));
     }
     ;
@@ -221,7 +238,7 @@ code:
                                         currentFunctionName, foundType, expectedType);
         }
         // else verify the type and throw a warning
-        pb.pushBlock(std::make_shared<Return>($rs));
+        pb.pushBlock(std::make_shared<Return>($rs, expectedType));
     }
     ;
 
@@ -244,8 +261,8 @@ shw:
     SHW'('expression[ic]')' {
         DEBUG("shw var");
         // spcial case for strings
-        if ($ic->type() == ARR_CHR) {
-            auto stringValue = std::dynamic_pointer_cast<Value>($ic);
+        auto stringValue = std::dynamic_pointer_cast<Value>($ic);
+        if (stringValue != nullptr && $ic->type() == ARR_CHR) {
             std::string str = stringValue->value()._str;
             pb.pushBlock(std::make_shared<Print>(str));
         } else {
@@ -257,7 +274,7 @@ shw:
 expression:
     arithmeticOperation { $$ = $1; }
     | functionCall { $$ = $1; }
-    | value { $$ = std::make_shared<Value>($1); }
+    | value { $$ = $1; }
     | variable { $$ = $1; }
     ;
 
@@ -378,7 +395,10 @@ functionCall:
     parameterList')' {
         std::shared_ptr<FunctionCall> funcall = pb.createFuncall();
         // TODO: save the funcall and params in a vector (create a struct)
-        funcall->type(NIL); // type to NIL by default, will change on the type check
+        // the type is the return type of the function if it's already
+        // defined, NIL otherwise (it will change on the type check)
+        std::optional<Symbol> sym = contextManager.lookup($1);
+        funcall->type(sym.has_value() ? sym.value().getType().back() : NIL);
         std::pair<std::string, int> position = std::make_pair(currentFile, @1.begin.line);
         funcallsToCheck.push_back(std::make_pair(funcall, position));
         // the type check is done at the end !
@@ -436,17 +456,17 @@ value:
     INT {
         DEBUG("new int: " << $1);
         LiteralValue v = { ._int = $1 };
-        $$ = Value(v, INT);
+        $$ = std::make_shared<Value>(v, INT);
     }
     | FLT {
         DEBUG("new double: " << $1);
         LiteralValue v = { ._flt = $1 };
-        $$ = Value(v, FLT);
+        $$ = std::make_shared<Value>(v, FLT);
     }
     | CHR {
         DEBUG("new char: " << $1);
         LiteralValue v = { ._chr = $1 };
-        $$ = Value(v, CHR);
+        $$ = std::make_shared<Value>(v, CHR);
     }
     | STRING {
         DEBUG("new char: " << $1);
@@ -456,7 +476,7 @@ value:
             return 1;
         }
         memcpy(v._str, $1.c_str(), $1.size());
-        $$ = Value(v, ARR_CHR);
+        $$ = std::make_shared<Value>(v, ARR_CHR);
     }
     ;
 
@@ -543,21 +563,16 @@ void cli() {
     interpreter::Parser parser{ &scanner, pb };
     contextManager.enterScope();
     parser.parse();
+    // the nodes are not needed anymore, this allows the program to release
+    // its tree (see release)
+    funcallsToCheck.clear();
+    assignmentsToCheck.clear();
     errMgr.report();
     if (!errMgr.getErrors()) {
         pb.display();
     }
 }
 
-/* add execution rights to the result file */
-void makeExecutable(std::string file) {
-    std::filesystem::permissions(file,
-            std::filesystem::perms::owner_exec
-            | std::filesystem::perms::group_exec
-            | std::filesystem::perms::others_exec,
-            std::filesystem::perm_options::add);
-}
-
 /* Verify the types of all assignments that involve funcalls.
  * It's done because we want to be able to use functions that are declared after
  * the function in which we make the call. This force to parse all the functions
@@ -573,9 +588,15 @@ void checkAssignments() {
 }
 
 /* Verify the types of all funcalls. To check the type, we have to verify the
- * types of all the parameters. The return type is not important here.
+ * types of all the parameters. The return type is not important here. The
+ * calls get the declared sizes of the parameters (for the strings).
  */
-void checkFuncalls() {
+void checkFuncalls(std::shared_ptr<Program> program) {
+    // declared sizes of the parameters, given to the calls
+    std::map<std::string, std::list<int>> sizes;
+    for (auto const &function : program->functions()) {
+        sizes[function->id()] = function->sizes();
+    }
     // TODO: add the file location in the list
     for (auto fp : funcallsToCheck) {
         std::list<PrimitiveType> funcallType = getTypes(fp.first->params());
@@ -585,9 +606,11 @@ void checkFuncalls() {
         if (sym.has_value()) {
             // get the found return type (types of the parameters)
             std::list<PrimitiveType> funcallType = getTypes(fp.first->params());
-            fp.first->type(expectedType.back());
             expectedType = sym.value().getType();
+            fp.first->type(expectedType.back());
+            fp.first->sizes(sizes[fp.first->functionName()]);
             expectedType.pop_back(); // remove the return type
+            fp.first->parameterTypes(expectedType);
 
             if (checkTypeError(expectedType, funcallType)) {
                 errMgr.addFuncallTypeError(fp.second.first,
@@ -601,18 +624,115 @@ void checkFuncalls() {
     }
 }
 
-void compile(std::string fileName, std::string outputName) {
+/* run the optimization passes on the program */
+void optimize(std::shared_ptr<Program> program, Options const &options,
+              Profile &profile) {
+    ConstantFolder constantFolder;
+    CompileTimeEvaluator evaluator(options.evalSteps);
+    DeadCodeEliminator deadCodeEliminator;
+    DeadFunctionEliminator deadFunctionEliminator;
+    // the instrumented script counts the calls of all the functions
+    Inliner inliner(options.profileGenerate.empty() ? options.inlineThreshold
+                                                    : 0,
+                    &profile);
+    TypeInference typeInference;
+    LoopInvariantCodeMotion licm;
+    CommonSubexpressionEliminator cse;
+    LoopIdioms idioms;
+    TailCallEliminator tailCallEliminator;
+    Memoizer memoizer;
+    Vectorizer vectorizer;
+    NativeSelector nativeSelector;
+
+    typeInference.infer(program);
+    constantFolder.optimize(program);
+    evaluator.optimize(program);
+    deadCodeEliminator.optimize(program);
+    tailCallEliminator.optimize(program);
+    // the native functions are not inlined in the python functions
+    if (options.native && options.nativeFunctions.empty()) {
+        nativeSelector.select(program, profile.hotFunctions());
+    } else if (options.native) {
+        nativeSelector.select(program, options.nativeFunctions);
+        for (std::string const &function : nativeSelector.rejected()) {
+            std::cerr << "warning: " << function << " can't be compiled in "
+                      << "C, it stays in python." << std::endl;
+        }
+    }
+    inliner.optimize(program);
+    // the inlined bodies can be simplified with the arguments of the calls
+    typeInference.infer(program);
+    constantFolder.optimize(program);
+    deadCodeEliminator.optimize(program);
+    deadFunctionEliminator.optimize(program);
+    licm.optimize(program);
+    cse.optimize(program);
+    idioms.optimize(program);
+    if (options.memoize) {
+        memoizer.optimize(program);
+    }
+    if (options.vectorize) {
+        vectorizer.optimize(program);
+    }
+    profile.layout(program);
+
+    if (options.stats) {
+        std::cerr << "compile-time evaluation: " << evaluator.evaluated()
+                  << " calls evaluated" << std::endl;
+        std::cerr << "tail calls: " << tailCallEliminator.eliminated()
+                  << " calls eliminated" << std::endl;
+        std::cerr << "inlining: " << inliner.inlined() << " calls inlined"
+                  << std::endl;
+        std::cerr << "dead code elimination: "
+                  << deadCodeEliminator.removed() << " nodes removed"
+                  << std::endl;
+        std::cerr << "dead function elimination: "
+                  << deadFunctionEliminator.removed().size()
+                  << " functions removed, " << deadFunctionEliminator.saved()
+                  << " bytes saved" << std::endl;
+        for (std::string const &function : deadFunctionEliminator.removed()) {
+            std::cerr << "  removed " << function << std::endl;
+        }
+        std::cerr << "loop-invariant code motion: " << licm.hoisted()
+                  << " expressions hoisted" << std::endl;
+        std::cerr << "common subexpressions: " << cse.eliminated()
+                  << " expressions reused" << std::endl;
+        std::cerr << "loop idioms: " << idioms.counted()
+                  << " counted loops, " << idioms.fused() << " loops fused, "
+                  << idioms.replaced() << " loops replaced" << std::endl;
+        std::cerr << "memoization: " << memoizer.memoized()
+                  << " functions memoized" << std::endl;
+        std::cerr << "vectorization: " << vectorizer.vectorized()
+                  << " loops vectorized" << std::endl;
+        std::cerr << "native: " << nativeSelector.selected().size()
+                  << " functions compiled in C" << std::endl;
+        for (std::string const &function : nativeSelector.selected()) {
+            std::cerr << "  native " << function << std::endl;
+        }
+        std::cerr << "profile: " << profile.hotFunctions().size()
+                  << " hot functions, " << profile.inverted()
+                  << " conditions inverted" << std::endl;
+        for (std::string const &function : profile.hotFunctions()) {
+            std::cerr << "  hot " << function << std::endl;
+        }
+    }
+}
+
+/* compile the program, the result is the exit status of the compiler (or of
+ * the program with --run and --exec) */
+int compile(Options const &options) {
+    int status = 0;
     int parserOutput;
     int preprocessorErrorStatus = 0;
 
     ProgramBuilder pb;
     Preprocessor pp(PREPROCESSOR_OUTPUT_FILE);
 
-    currentFile = fileName;
+    currentFile = options.input;
     contextManager.enterScope(); // update the scope
 
     try {
-        pp.process(fileName); // launch the preprocessor
+        pp.process(options.input); // launch the preprocessor
     } catch (std::logic_error& e) {
         errMgr.addError(e.what());
         preprocessorErrorStatus = 1;
@@ -623,34 +743,73 @@ void compile(std::string fileName, std::string outputName) {
     interpreter::Scanner scanner{ is , std::cerr };
     interpreter::Parser parser{ &scanner, pb };
     parserOutput = parser.parse();
-    checkFuncalls();
+    checkFuncalls(pb.getProgram());
     checkAssignments();
+    // the nodes are not needed anymore, this allows the program to release
+    // its tree (see release)
+    funcallsToCheck.clear();
+    assignmentsToCheck.clear();
 
     // loock for main
     std::optional<Symbol> sym = contextManager.lookup("main");
     if (0 == parserOutput && 0 == preprocessorErrorStatus && !sym.has_value()) {
         errMgr.addNoEntryPointError();
     }
+    // the sites of the profile are numbered before the optimizations, so the
+    // instrumented program and the optimized one have the same sites
+    Profile profile;
+    if (!errMgr.getErrors() && !options.profileGenerate.empty()) {
+        profile.instrument(pb.getProgram(), options.profileGenerate);
+    } else if (!errMgr.getErrors() && !options.profileUse.empty()) {
+        try {
+            profile.read(pb.getProgram(), options.profileUse);
+        } catch (std::runtime_error &e) {
+            errMgr.addWarning(std::string(e.what()) + " It is ignored.\n");
+        }
+    }
     // report errors and warnings
     errMgr.report();
 
     // if no errors, transpile the file
     if (!errMgr.getErrors()) {
-        std::ofstream fs(outputName);
-        pb.getProgram()->compile(fs);
-        makeExecutable(outputName);
+        optimize(pb.getProgram(), options, profile);
+        for (std::shared_ptr<Function> function : pb.getProgram()->functions()) {
+            function->typed(options.typed);
+        }
+        if (options.run) {
+            status = run(pb.getProgram());
+        } else if (options.exec) {
+            status = execute(pb.getProgram(), options);
+        } else if (options.target == Options::C) {
+            generateC(pb.getProgram(), options);
+        } else if (options.target == Options::X86_64) {
+            generateNative(pb.getProgram(), options);
+        } else if (options.modules) {
+            generateModules(pb.getProgram(), options);
+        } else if (options.native) {
+            generateHybrid(pb.getProgram(), options);
+        } else {
+            generateScript(pb.getProgram(), options);
+        }
     }
 
     // remove the preprocessor output file
     if (REMOVE_PREPROCESSOR_FILE) {
         std::filesystem::remove(PREPROCESSOR_OUTPUT_FILE);
     }
+    return errMgr.getErrors() ? 1 : status;
 }
 
 int main(int argc, char **argv) {
-    if (argc == 2) {
-        compile(argv[1], "a.out"); // TODO: add an option to choose the name of the created script
-    } else { // launch the interpreter for debugging
+    if (argc == 1) { // launch the interpreter for debugging
         cli();
+        return 0;
+    }
+    try {
+        return compile(parseOptions(argc, argv));
+    } catch (std::invalid_argument &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        printUsage(std::cerr, argv[0]);
+        return 1;
     }
 }
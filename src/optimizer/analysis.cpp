@@ -0,0 +1,208 @@
+#include "optimizer/analysis.hpp"
+
+/**
+ * @brief  Number of nodes in the tree `node`.
+ */
+size_t countNodes(std::shared_ptr<Node> const &node) {
+    size_t count = 0;
+    visit(node, [&](std::shared_ptr<Node> const &) { ++count; });
+    return count;
+}
+
+/**
+ * @brief  An expression is pure when its evaluation has no side effects: it
+ *         doesn't call any function (the builtins of the language are
+ *         statements).
+ */
+bool isPure(std::shared_ptr<Node> const &node) {
+    bool pure = true;
+    visit(node, [&](std::shared_ptr<Node> const &n) {
+        if (std::dynamic_pointer_cast<FunctionCall>(n)) {
+            pure = false;
+        }
+    });
+    return pure;
+}
+
+/**
+ * @brief  A node is a constant when it's a scalar value (the strings are
+ *         values too but they are never folded).
+ */
+bool isConstant(std::shared_ptr<Node> const &node) {
+    auto value = std::dynamic_pointer_cast<Value>(node);
+    return value != nullptr && (value->type() == INT || value->type() == FLT ||
+                                value->type() == CHR);
+}
+
+/**
+ * @brief  An expression can fail at runtime unless it's only arithmetic on
+ *         numbers: python raises an error on a division by zero, an index out
+ *         of range or the arithmetic with characters, and the functions can
+ *         fail too.
+ */
+bool canFail(std::shared_ptr<Node> const &node) {
+    bool fail = false;
+    visit(node, [&](std::shared_ptr<Node> const &n) {
+        auto typed = std::dynamic_pointer_cast<TypedNode>(n);
+        if (typed == nullptr ||
+            (typed->type() != INT && typed->type() != FLT)) {
+            fail = true;
+        } else if (auto division = std::dynamic_pointer_cast<DivOP>(n)) {
+            auto divisor = std::dynamic_pointer_cast<Value>(division->right());
+            fail = fail || !isConstant(divisor) || !truth(*divisor);
+        } else if (!std::dynamic_pointer_cast<Value>(n) &&
+                   (!std::dynamic_pointer_cast<Variable>(n) ||
+                    std::dynamic_pointer_cast<Array>(n)) &&
+                   !std::dynamic_pointer_cast<AddOP>(n) &&
+                   !std::dynamic_pointer_cast<MnsOP>(n) &&
+                   !std::dynamic_pointer_cast<TmsOP>(n)) {
+            fail = true;
+        }
+    });
+    return fail;
+}
+
+/**
+ * @brief  Truth value of a constant (python semantic: a character is always
+ *         true).
+ */
+bool truth(Value const &value) {
+    switch (value.type()) {
+    case INT:
+        return value.value()._int != 0;
+    case FLT:
+        return value.value()._flt != 0;
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief  Access to an element of an array at the index given by the variable
+ *         `index` (like `t[i]` in a loop on `i`).
+ */
+bool isElement(std::shared_ptr<Node> const &node, std::string const &index) {
+    auto access = std::dynamic_pointer_cast<ArrayAccess>(node);
+    if (access == nullptr) {
+        return false;
+    }
+    auto variable = std::dynamic_pointer_cast<Variable>(access->index());
+    return variable != nullptr &&
+           !std::dynamic_pointer_cast<ArrayAccess>(variable) &&
+           variable->id() == index;
+}
+
+/**
+ * @brief  Arrays declared in the function that are never aliased by another
+ *         array (`set(a, b)` makes `a` and `b` the same list). The elements of
+ *         such arrays can only be modified through their name or by the
+ *         functions that receive them.
+ */
+std::set<std::string> localArrays(std::shared_ptr<Function> const &function) {
+    std::set<std::string> declared;
+    std::set<std::string> aliased;
+
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        if (auto array = std::dynamic_pointer_cast<ArrayDeclaration>(node)) {
+            declared.insert(array->id());
+        } else if (auto assignment =
+                       std::dynamic_pointer_cast<Assignment>(node)) {
+            auto value =
+                std::dynamic_pointer_cast<Variable>(assignment->value());
+            if (isArray(assignment->variable()->type()) && value != nullptr) {
+                aliased.insert(assignment->variable()->id());
+                aliased.insert(value->id());
+            }
+        }
+    });
+    for (std::string const &id : aliased) {
+        declared.erase(id);
+    }
+    return declared;
+}
+
+/**
+ * @brief  Sizes of the local arrays of the function (see localArrays), the
+ *         smallest one when a name is declared several times.
+ */
+std::map<std::string, int>
+arraySizes(std::shared_ptr<Function> const &function) {
+    std::set<std::string> locals = localArrays(function);
+    std::map<std::string, int> sizes;
+
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        auto array = std::dynamic_pointer_cast<ArrayDeclaration>(node);
+        if (array == nullptr || !locals.count(array->id())) {
+            return;
+        }
+        auto it = sizes.find(array->id());
+        if (it == sizes.end() || array->size() < it->second) {
+            sizes[array->id()] = array->size();
+        }
+    });
+    return sizes;
+}
+
+/**
+ * @brief  True when the range of the loop is known to be in the arrays it
+ *         accesses: its bounds are constants with 0 <= begin < end, and the
+ *         arrays are local arrays (see arraySizes) of at least `end` elements.
+ */
+bool inBounds(std::shared_ptr<For> const &loop,
+              std::map<std::string, int> const &sizes) {
+    auto begin = std::dynamic_pointer_cast<Value>(loop->begin());
+    auto end = std::dynamic_pointer_cast<Value>(loop->end());
+    bool found = true;
+
+    if (begin == nullptr || end == nullptr || begin->type() != INT ||
+        end->type() != INT || begin->value()._int < 0 ||
+        begin->value()._int >= end->value()._int) {
+        return false;
+    }
+    visit(loop->block(), [&](std::shared_ptr<Node> const &node) {
+        auto access = std::dynamic_pointer_cast<ArrayAccess>(node);
+        if (access == nullptr) {
+            return;
+        }
+        auto it = sizes.find(access->id());
+        found = found && it != sizes.end() &&
+                end->value()._int <= it->second;
+    });
+    return found;
+}
+
+/**
+ * @brief  True when the program has a function named `name`. The function
+ *         hides the python builtin of the same name in the generated script.
+ */
+bool defines(std::shared_ptr<Program> const &program, std::string const &name) {
+    for (std::shared_ptr<Function> const &function : program->functions()) {
+        if (function->id() == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief  Names of the parameters and of the variables of the function. They
+ *         hide the python builtins of the same name in the function.
+ */
+std::set<std::string> localNames(std::shared_ptr<Function> const &function) {
+    std::set<std::string> names;
+
+    for (Variable const &parameter : function->parameters()) {
+        names.insert(parameter.id());
+    }
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        if (auto variable = std::dynamic_pointer_cast<Variable>(node)) {
+            names.insert(variable->id());
+        } else if (auto declaration =
+                       std::dynamic_pointer_cast<Declaration>(node)) {
+            names.insert(declaration->variable().id());
+        } else if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+            names.insert(loop->variable().id());
+        }
+    });
+    return names;
+}
@@ -0,0 +1,29 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+#include "ast/ast.hpp"
+#include "ast/program.hpp"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+/**
+ * @brief  Helpers shared by the optimization passes.
+ */
+
+size_t countNodes(std::shared_ptr<Node> const &node);
+bool isPure(std::shared_ptr<Node> const &node);
+bool isConstant(std::shared_ptr<Node> const &node);
+bool canFail(std::shared_ptr<Node> const &node);
+bool truth(Value const &value);
+bool isElement(std::shared_ptr<Node> const &node, std::string const &index);
+std::set<std::string> localArrays(std::shared_ptr<Function> const &function);
+std::map<std::string, int>
+arraySizes(std::shared_ptr<Function> const &function);
+bool inBounds(std::shared_ptr<For> const &loop,
+              std::map<std::string, int> const &sizes);
+bool defines(std::shared_ptr<Program> const &program, std::string const &name);
+std::set<std::string> localNames(std::shared_ptr<Function> const &function);
+
+#endif
@@ -0,0 +1,97 @@
+#include "optimizer/callgraph.hpp"
+#include <utility>
+#include <vector>
+
+/**
+ * @brief  Build the call graph by looking for the function calls in the body
+ *         of all the functions.
+ */
+CallGraph::CallGraph(std::shared_ptr<Program> program) {
+    for (std::shared_ptr<Function> function : program->functions()) {
+        std::set<std::string> &callees = callees_[function->id()];
+
+        functions_.push_back(function->id());
+        visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+            if (auto call = std::dynamic_pointer_cast<FunctionCall>(node)) {
+                callees.insert(call->functionName());
+            }
+        });
+    }
+    for (std::string const &function : functions_) {
+        for (std::string const &callee : callees(function)) {
+            if (reachable(callee).count(function)) {
+                recursive_.insert(function);
+                break;
+            }
+        }
+    }
+}
+
+std::set<std::string> const &
+CallGraph::callees(std::string const &function) const {
+    static const std::set<std::string> none;
+    auto it = callees_.find(function);
+    return it == callees_.end() ? none : it->second;
+}
+
+/**
+ * @brief  A function is recursive when it can call itself, directly or through
+ *         other functions.
+ */
+bool CallGraph::isRecursive(std::string const &function) const {
+    return recursive_.count(function) > 0;
+}
+
+/**
+ * @brief  Functions that can be called when `root` runs (`root` included).
+ */
+std::set<std::string> CallGraph::reachable(std::string const &root) const {
+    std::set<std::string> reached = {root};
+    std::vector<std::string> stack = {root};
+
+    while (!stack.empty()) {
+        std::string function = std::move(stack.back());
+        stack.pop_back();
+
+        for (std::string const &callee : callees(function)) {
+            if (reached.insert(callee).second) {
+                stack.push_back(callee);
+            }
+        }
+    }
+    return reached;
+}
+
+/**
+ * @brief  Functions of the program ordered so the callees come before their
+ *         callers (post-order of a depth first search). The order in the
+ *         cycles of recursive functions is arbitrary.
+ */
+std::list<std::string> CallGraph::bottomUp() const {
+    std::list<std::string> order;
+    std::set<std::string> seen;
+    // the iterator points to the next callee to explore
+    std::vector<std::pair<std::string, std::set<std::string>::const_iterator>>
+        stack;
+
+    for (std::string const &function : functions_) {
+        if (!seen.insert(function).second) {
+            continue;
+        }
+        stack.push_back({function, callees(function).begin()});
+        while (!stack.empty()) {
+            auto &[current, next] = stack.back();
+
+            if (next == callees(current).end()) {
+                order.push_back(current);
+                stack.pop_back();
+            } else {
+                std::string const &callee = *next++;
+                if (callees_.count(callee) && seen.insert(callee).second) {
+                    stack.push_back({callee, callees(callee).begin()});
+                }
+            }
+        }
+    }
+    return order;
+}
@@ -0,0 +1,29 @@
+#ifndef CALL_GRAPH_H
+#define CALL_GRAPH_H
+#include "ast/program.hpp"
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+/**
+ * @brief  Call graph of a program: for each function, the set of functions it
+ *         calls.
+ */
+class CallGraph {
+  public:
+    CallGraph(std::shared_ptr<Program> program);
+
+    std::set<std::string> const &callees(std::string const &function) const;
+    bool isRecursive(std::string const &function) const;
+    std::set<std::string> reachable(std::string const &root) const;
+    std::list<std::string> bottomUp() const;
+
+  private:
+    std::list<std::string> functions_ = {};
+    std::map<std::string, std::set<std::string>> callees_ = {};
+    std::set<std::string> recursive_ = {};
+};
+
+#endif
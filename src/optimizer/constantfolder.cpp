@@ -0,0 +1,308 @@
+#include "optimizer/constantfolder.hpp"
+#include "optimizer/analysis.hpp"
+#include <cmath>
+#include <map>
+#include <string>
+
+/******************************************************************************/
+/*                                   values                                   */
+/******************************************************************************/
+
+static std::shared_ptr<Value> intValue(long long value) {
+    LiteralValue literal;
+    literal._int = value;
+    return std::make_shared<Value>(literal, INT);
+}
+
+static std::shared_ptr<Value> fltValue(double value) {
+    LiteralValue literal;
+    literal._flt = value;
+    return std::make_shared<Value>(literal, FLT);
+}
+
+/**
+ * @brief  The booleans are represented by the integers 1 and 0 (like in the
+ *         generated code where True == 1 and False == 0).
+ */
+static std::shared_ptr<Value> boolValue(bool value) {
+    return intValue(value ? 1 : 0);
+}
+
+static double toFlt(Value const &value) {
+    return value.type() == INT ? (double)value.value()._int
+                               : value.value()._flt;
+}
+
+/**
+ * @brief  Convert a constant to the type of the variable it is assigned to.
+ *
+ * @return  The converted constant or nullptr if the conversion is not possible.
+ */
+static std::shared_ptr<Value> convert(std::shared_ptr<Value> const &value,
+                                      PrimitiveType type) {
+    if (value->type() == type && (type == INT || type == FLT)) {
+        return value;
+    } else if (type == FLT && value->type() == INT) {
+        return fltValue((double)value->value()._int);
+    } else if (type == INT && value->type() == FLT) {
+        double flt = value->value()._flt;
+        // int() truncates toward zero, out of range values are not converted
+        if (!std::isfinite(flt) || std::fabs(flt) >= 9.2e18) {
+            return nullptr;
+        }
+        return intValue((long long)flt);
+    }
+    return nullptr;
+}
+
+/******************************************************************************/
+/*                                 operations                                 */
+/******************************************************************************/
+
+/**
+ * @brief  Evaluate an arithmetic operation. The integer operations are folded
+ *         only when they don't overflow (python integers are not bounded), and
+ *         `div` is the true division: the division of integers gives a float,
+ *         folded only when the integers are exact doubles.
+ */
+static std::shared_ptr<Value> arithmetic(char op, Value const &left,
+                                         Value const &right) {
+    const double exact = 9007199254740992.0; // 2^53
+
+    if (left.type() == INT && right.type() == INT && op == '/') {
+        long long l = left.value()._int;
+        long long r = right.value()._int;
+        if (r == 0 || std::fabs((double)l) > exact ||
+            std::fabs((double)r) > exact) {
+            return nullptr;
+        }
+        return fltValue((double)l / (double)r);
+    } else if (left.type() == INT && right.type() == INT) {
+        long long l = left.value()._int;
+        long long r = right.value()._int;
+        long long result;
+        bool overflow = true;
+
+        switch (op) {
+        case '+':
+            overflow = __builtin_add_overflow(l, r, &result);
+            break;
+        case '-':
+            overflow = __builtin_sub_overflow(l, r, &result);
+            break;
+        case '*':
+            overflow = __builtin_mul_overflow(l, r, &result);
+            break;
+        }
+        return overflow ? nullptr : intValue(result);
+    }
+    double l = toFlt(left);
+    double r = toFlt(right);
+
+    switch (op) {
+    case '+':
+        return fltValue(l + r);
+    case '-':
+        return fltValue(l - r);
+    case '*':
+        return fltValue(l * r);
+    case '/':
+        return r == 0 ? nullptr : fltValue(l / r);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief  Evaluate a comparison. `compare` gives the result from the sign of
+ *         `left - right`.
+ */
+template <typename Compare>
+static std::shared_ptr<Value>
+comparison(Value const &left, Value const &right, Compare compare) {
+    const double exact = 9007199254740992.0; // 2^53
+
+    if (left.type() == CHR && right.type() == CHR) {
+        int l = (unsigned char)left.value()._chr;
+        int r = (unsigned char)right.value()._chr;
+        return boolValue(compare(l < r ? -1 : (l > r ? 1 : 0)));
+    } else if (left.type() == INT && right.type() == INT) {
+        long long l = left.value()._int;
+        long long r = right.value()._int;
+        return boolValue(compare(l < r ? -1 : (l > r ? 1 : 0)));
+    } else if (left.type() == CHR || right.type() == CHR) {
+        return nullptr;
+    }
+    // python compares int and float exactly, which is the case here only when
+    // the integer is representable as a double
+    if ((left.type() == INT && std::fabs(toFlt(left)) > exact) ||
+        (right.type() == INT && std::fabs(toFlt(right)) > exact)) {
+        return nullptr;
+    }
+    double l = toFlt(left);
+    double r = toFlt(right);
+    if (std::isnan(l) || std::isnan(r)) {
+        return boolValue(false);
+    }
+    return boolValue(compare(l < r ? -1 : (l > r ? 1 : 0)));
+}
+
+/**
+ * @brief  Replace `node` by its value when its operands are constants. The
+ *         logical operators are simplified when one operand is constant, but
+ *         an operand that is not constant is never removed (it may have side
+ *         effects).
+ *
+ * @return  The replacement of the node (the node itself if nothing is done).
+ */
+std::shared_ptr<Node> ConstantFolder::fold(std::shared_ptr<Node> const &node) {
+    std::shared_ptr<Value> result = nullptr;
+
+    if (auto notOp = std::dynamic_pointer_cast<NotOP>(node)) {
+        auto param = std::dynamic_pointer_cast<Value>(notOp->param());
+        return isConstant(param) ? boolValue(!truth(*param)) : node;
+    }
+
+    auto operation = std::dynamic_pointer_cast<BinaryOperation>(node);
+    if (operation == nullptr) {
+        return node;
+    }
+    auto left = std::dynamic_pointer_cast<Value>(operation->left());
+    auto right = std::dynamic_pointer_cast<Value>(operation->right());
+    if (!isConstant(left)) {
+        left = nullptr;
+    }
+    if (!isConstant(right)) {
+        right = nullptr;
+    }
+
+    if (std::dynamic_pointer_cast<AndOP>(node)) {
+        if (left) {
+            return truth(*left) ? operation->right() : boolValue(false);
+        } else if (right && truth(*right)) {
+            return operation->left();
+        }
+        return node;
+    } else if (std::dynamic_pointer_cast<OrOP>(node)) {
+        if (left) {
+            return truth(*left) ? boolValue(true) : operation->right();
+        } else if (right && !truth(*right)) {
+            return operation->left();
+        }
+        return node;
+    } else if (left == nullptr || right == nullptr) {
+        return node;
+    }
+
+    if (std::dynamic_pointer_cast<AddOP>(node)) {
+        result = arithmetic('+', *left, *right);
+    } else if (std::dynamic_pointer_cast<MnsOP>(node)) {
+        result = arithmetic('-', *left, *right);
+    } else if (std::dynamic_pointer_cast<TmsOP>(node)) {
+        result = arithmetic('*', *left, *right);
+    } else if (std::dynamic_pointer_cast<DivOP>(node)) {
+        result = arithmetic('/', *left, *right);
+    } else if (std::dynamic_pointer_cast<EqlOP>(node)) {
+        result = comparison(*left, *right, [](int c) { return c == 0; });
+    } else if (std::dynamic_pointer_cast<SupOP>(node)) {
+        result = comparison(*left, *right, [](int c) { return c > 0; });
+    } else if (std::dynamic_pointer_cast<InfOP>(node)) {
+        result = comparison(*left, *right, [](int c) { return c < 0; });
+    } else if (std::dynamic_pointer_cast<SeqOP>(node)) {
+        result = comparison(*left, *right, [](int c) { return c >= 0; });
+    } else if (std::dynamic_pointer_cast<IeqOP>(node)) {
+        result = comparison(*left, *right, [](int c) { return c <= 0; });
+    } else if (std::dynamic_pointer_cast<XorOP>(node)) {
+        result = boolValue(truth(*left) != truth(*right));
+    }
+    return result != nullptr ? result : node;
+}
+
+/******************************************************************************/
+/*                                propagation                                 */
+/******************************************************************************/
+
+/**
+ * @brief  Propagate the constants assigned to the local variables. Only the
+ *         assignments of the top level block of the function are considered,
+ *         and the variable must not be written anywhere else (parameters, loop
+ *         variables and `ipt` targets are excluded), so the constant is valid
+ *         in all the instructions that follow the assignment.
+ *
+ * NOTE: the assignment is kept (the dead code elimination removes it).
+ *
+ * @return  true if a variable has been replaced.
+ */
+bool ConstantFolder::propagate(std::shared_ptr<Function> function) {
+    std::map<std::string, int> writes;
+    bool changed = false;
+
+    for (Variable const &parameter : function->parameters()) {
+        writes[parameter.id()] += 2;
+    }
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        if (auto assignment = std::dynamic_pointer_cast<Assignment>(node)) {
+            writes[assignment->variable()->id()]++;
+        } else if (auto read = std::dynamic_pointer_cast<Read>(node)) {
+            auto target = std::dynamic_pointer_cast<Variable>(read->variable());
+            if (target != nullptr) {
+                writes[target->id()] += 2;
+            }
+        } else if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+            writes[loop->variable().id()] += 2;
+        }
+    });
+
+    auto const &instructions = function->block()->instructions();
+    for (auto it = instructions.begin(); it != instructions.end(); ++it) {
+        auto assignment = std::dynamic_pointer_cast<Assignment>(*it);
+        if (assignment == nullptr ||
+            std::dynamic_pointer_cast<Array>(assignment->variable()) ||
+            writes[assignment->variable()->id()] != 1) {
+            continue;
+        }
+        auto value = std::dynamic_pointer_cast<Value>(assignment->value());
+        if (value == nullptr) {
+            continue;
+        }
+        std::string const &name = assignment->variable()->id();
+        auto constant = convert(value, assignment->variable()->type());
+        if (constant == nullptr) {
+            continue;
+        }
+        for (auto next = std::next(it); next != instructions.end(); ++next) {
+            rewrite(*next, [&](std::shared_ptr<Node> const &node) {
+                auto variable = std::dynamic_pointer_cast<Variable>(node);
+                if (variable == nullptr ||
+                    std::dynamic_pointer_cast<Array>(node) ||
+                    variable->id() != name) {
+                    return node;
+                }
+                changed = true;
+                return std::static_pointer_cast<Node>(constant);
+            });
+        }
+    }
+    return changed;
+}
+
+/******************************************************************************/
+/*                                    pass                                    */
+/******************************************************************************/
+
+/**
+ * @brief  Fold and propagate the constants until nothing changes (a propagated
+ *         constant can make new expressions constant).
+ */
+void ConstantFolder::optimize(std::shared_ptr<Function> function) {
+    do {
+        rewrite(function->block(), [this](std::shared_ptr<Node> const &node) {
+            return fold(node);
+        });
+    } while (propagate(function));
+}
+
+void ConstantFolder::optimize(std::shared_ptr<Program> program) {
+    for (std::shared_ptr<Function> function : program->functions()) {
+        optimize(function);
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef CONSTANT_FOLDER_H
+#define CONSTANT_FOLDER_H
+#include "ast/program.hpp"
+#include <memory>
+
+/**
+ * @brief  Constant folding and constant propagation. The operators applied on
+ *         values are replaced by their result, and the local variables
+ *         assigned only once with a constant are replaced by this constant
+ *         in the instructions that follow the assignment.
+ *
+ * NOTE: the results must be the ones computed by the generated code, so the
+ *       operations that can't be reproduced exactly (integer overflow, integer
+ *       division, division by zero, ...) are not folded.
+ */
+class ConstantFolder {
+  public:
+    void optimize(std::shared_ptr<Program> program);
+    void optimize(std::shared_ptr<Function> function);
+
+  private:
+    std::shared_ptr<Node> fold(std::shared_ptr<Node> const &node);
+    bool propagate(std::shared_ptr<Function> function);
+};
+
+#endif
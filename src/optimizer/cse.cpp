@@ -0,0 +1,440 @@
+#include "optimizer/cse.hpp"
+#include "optimizer/analysis.hpp"
+#include "optimizer/purity.hpp"
+#include <cstring>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/******************************************************************************/
+/*                              value numbering                               */
+/******************************************************************************/
+
+/**
+ * @brief  Expression that may be replaced by a variable. `holder` is the
+ *         variable that holds its value at this point, if any.
+ */
+struct Occurrence {
+    std::shared_ptr<Node> node;
+    std::shared_ptr<Node> parent;
+    size_t statement;
+    bool conditional;
+    std::string holder;
+};
+
+/**
+ * @brief  Variable assigned with the value of an expression, and its version
+ *         after the assignment.
+ */
+struct Holder {
+    std::string variable;
+    size_t version;
+};
+
+/**
+ * @brief  Value numbers of the expressions of a basic block. The versions of
+ *         the variables and the arrays are incremented on each write. The
+ *         arrays that are not local may be aliases, so they also depend on the
+ *         version of the memory, which changes when any of them is written.
+ */
+class Numbering {
+  public:
+    Numbering(std::set<std::string> const &pure,
+              std::set<std::string> const &locals)
+        : pure_(pure), locals_(locals) {}
+
+    void statement(std::shared_ptr<Node> const &statement, size_t index);
+
+    std::map<size_t, std::vector<Occurrence>> occurrences = {};
+    std::unordered_map<size_t, Holder> holders = {};
+
+  private:
+    size_t number(std::shared_ptr<Node> const &node);
+    std::string arrayKey(std::string const &id);
+    void write(std::shared_ptr<Node> const &target);
+    void expression(std::shared_ptr<Node> const &root,
+                    std::shared_ptr<Node> const &parent, size_t index);
+
+    std::set<std::string> const &pure_;
+    std::set<std::string> const &locals_;
+    std::unordered_map<std::string, size_t> numbers_ = {};
+    std::unordered_map<std::string, size_t> versions_ = {};
+    std::unordered_map<Node *, size_t> values_ = {};
+    std::unordered_set<Node *> targets_ = {};
+    size_t memory_ = 0;
+};
+
+static bool isCandidate(std::shared_ptr<Node> const &node) {
+    return std::dynamic_pointer_cast<AddOP>(node) ||
+           std::dynamic_pointer_cast<MnsOP>(node) ||
+           std::dynamic_pointer_cast<TmsOP>(node) ||
+           std::dynamic_pointer_cast<DivOP>(node) ||
+           std::dynamic_pointer_cast<FunctionCall>(node) ||
+           std::dynamic_pointer_cast<ArrayAccess>(node);
+}
+
+std::string Numbering::arrayKey(std::string const &id) {
+    std::string key = id + "#" + std::to_string(versions_[id]);
+    if (!locals_.count(id)) {
+        key += "#" + std::to_string(memory_);
+    }
+    return key;
+}
+
+/**
+ * @brief  Value number of an expression which sub-expressions are already
+ *         numbered.
+ *
+ * @return  The number, or 0 when the expression is not numbered.
+ */
+size_t Numbering::number(std::shared_ptr<Node> const &node) {
+    auto typed = std::dynamic_pointer_cast<TypedNode>(node);
+    std::string key;
+
+    if (typed == nullptr) {
+        return 0;
+    }
+    key = std::to_string(typed->type()) + "|";
+    if (auto value = std::dynamic_pointer_cast<Value>(node)) {
+        long long bits = 0;
+        switch (value->type()) {
+        case INT:
+            key += "i" + std::to_string(value->value()._int);
+            break;
+        case FLT:
+            std::memcpy(&bits, &value->value()._flt, sizeof(bits));
+            key += "f" + std::to_string(bits);
+            break;
+        case CHR:
+            key += "c" + std::to_string((int)value->value()._chr);
+            break;
+        default:
+            return 0;
+        }
+    } else if (auto access = std::dynamic_pointer_cast<ArrayAccess>(node)) {
+        size_t index = values_[access->index().get()];
+        if (index == 0) {
+            return 0;
+        }
+        key += "[" + arrayKey(access->id()) + "|" + std::to_string(index);
+    } else if (auto variable = std::dynamic_pointer_cast<Variable>(node)) {
+        if (isArray(variable->type())) {
+            key += "a" + arrayKey(variable->id());
+        } else {
+            key += "v" + variable->id() + "#" +
+                   std::to_string(versions_[variable->id()]);
+        }
+    } else if (auto call = std::dynamic_pointer_cast<FunctionCall>(node)) {
+        if (!pure_.count(call->functionName())) {
+            return 0;
+        }
+        key += "f" + call->functionName();
+        for (std::shared_ptr<TypedNode> const &param : call->params()) {
+            size_t value = values_[param.get()];
+            if (value == 0) {
+                return 0;
+            }
+            key += "|" + std::to_string(value);
+        }
+    } else if (auto operation =
+                   std::dynamic_pointer_cast<BinaryOperation>(node)) {
+        size_t left = values_[operation->left().get()];
+        size_t right = values_[operation->right().get()];
+        if (left == 0 || right == 0 || !isCandidate(node)) {
+            return 0;
+        }
+        key += std::string(std::dynamic_pointer_cast<AddOP>(node)   ? "+"
+                           : std::dynamic_pointer_cast<MnsOP>(node) ? "-"
+                           : std::dynamic_pointer_cast<TmsOP>(node) ? "*"
+                                                                    : "/") +
+               std::to_string(left) + "|" + std::to_string(right);
+    } else {
+        return 0;
+    }
+    auto it = numbers_.find(key);
+    if (it != numbers_.end()) {
+        return it->second;
+    }
+    size_t value = numbers_.size() + 1;
+    numbers_[key] = value;
+    return value;
+}
+
+/**
+ * @brief  Number the expression `root` in post-order and record the
+ *         occurrences of the candidates. The right operand of `and` / `or`
+ *         is conditional.
+ */
+void Numbering::expression(std::shared_ptr<Node> const &root,
+                           std::shared_ptr<Node> const &parent, size_t index) {
+    struct Item {
+        std::shared_ptr<Node> node;
+        std::shared_ptr<Node> parent;
+        bool conditional;
+        bool expanded;
+    };
+    std::vector<Item> stack = {{root, parent, false, false}};
+
+    while (!stack.empty()) {
+        Item &item = stack.back();
+
+        if (item.node == nullptr) {
+            stack.pop_back();
+        } else if (!item.expanded) {
+            item.expanded = true;
+            Item copy = item;
+            bool shortCircuit = std::dynamic_pointer_cast<AndOP>(copy.node) ||
+                                std::dynamic_pointer_cast<OrOP>(copy.node);
+            std::list<std::shared_ptr<Node>> children = copy.node->children();
+            for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                bool conditional = copy.conditional ||
+                                   (shortCircuit && *it == children.back());
+                stack.push_back({*it, copy.node, conditional, false});
+            }
+        } else {
+            Item done = std::move(item);
+            stack.pop_back();
+            size_t value = number(done.node);
+            values_[done.node.get()] = value;
+            if (value == 0 || done.parent == nullptr ||
+                targets_.count(done.node.get()) || !isCandidate(done.node)) {
+                continue;
+            }
+            std::string holder;
+            auto it = holders.find(value);
+            if (it != holders.end() &&
+                versions_[it->second.variable] == it->second.version) {
+                holder = it->second.variable;
+            }
+            occurrences[value].push_back(
+                {done.node, done.parent, index, done.conditional, holder});
+        }
+    }
+}
+
+/**
+ * @brief  Increment the version of the variable or the array written by a
+ *         statement.
+ */
+void Numbering::write(std::shared_ptr<Node> const &target) {
+    auto variable = std::dynamic_pointer_cast<Variable>(target);
+
+    if (variable == nullptr) {
+        return;
+    }
+    ++versions_[variable->id()];
+    if ((std::dynamic_pointer_cast<Array>(variable) ||
+         isArray(variable->type())) &&
+        !locals_.count(variable->id())) {
+        ++memory_;
+    }
+}
+
+/**
+ * @brief  Number the expressions of the statement, then apply its writes. The
+ *         statements that call functions which are not pure are not numbered
+ *         (the calls may modify the arrays between two evaluations).
+ */
+void Numbering::statement(std::shared_ptr<Node> const &statement,
+                          size_t index) {
+    std::list<std::shared_ptr<Node>> roots = {statement};
+    std::shared_ptr<Node> parent = nullptr;
+    std::vector<std::shared_ptr<Node>> arguments;
+
+    values_.clear();
+    targets_.clear();
+    if (auto cnd = std::dynamic_pointer_cast<Cnd>(statement)) {
+        roots = {cnd->condition()};
+        parent = statement;
+    } else if (auto loop = std::dynamic_pointer_cast<For>(statement)) {
+        roots = {loop->begin(), loop->end(), loop->step()};
+        parent = statement;
+    } else if (auto assignment =
+                   std::dynamic_pointer_cast<Assignment>(statement)) {
+        targets_.insert(assignment->variable().get());
+    } else if (auto read = std::dynamic_pointer_cast<Read>(statement)) {
+        targets_.insert(read->variable().get());
+    }
+
+    for (std::shared_ptr<Node> const &root : roots) {
+        visit(root, [&](std::shared_ptr<Node> const &node) {
+            auto call = std::dynamic_pointer_cast<FunctionCall>(node);
+            if (call == nullptr || pure_.count(call->functionName())) {
+                return;
+            }
+            arguments.push_back(nullptr);
+            for (std::shared_ptr<TypedNode> const &param : call->params()) {
+                auto array = std::dynamic_pointer_cast<Variable>(param);
+                if (array != nullptr && isArray(array->type())) {
+                    arguments.push_back(array);
+                }
+            }
+        });
+    }
+    if (arguments.empty()) {
+        for (std::shared_ptr<Node> const &root : roots) {
+            expression(root, parent, index);
+        }
+    } else {
+        // the calls may write the arrays they receive and the other arrays
+        ++memory_;
+        for (std::shared_ptr<Node> const &array : arguments) {
+            write(array);
+        }
+    }
+
+    if (auto assignment = std::dynamic_pointer_cast<Assignment>(statement)) {
+        std::shared_ptr<Variable> target = assignment->variable();
+        std::shared_ptr<TypedNode> value = assignment->value();
+        write(target);
+        size_t number = values_[value.get()];
+        if (number != 0 && isCandidate(value) &&
+            !std::dynamic_pointer_cast<Array>(target) &&
+            !isArray(target->type()) && target->type() == value->type()) {
+            holders[number] = {target->id(), versions_[target->id()]};
+        }
+    } else if (auto read = std::dynamic_pointer_cast<Read>(statement)) {
+        write(read->variable());
+    } else if (auto declaration =
+                   std::dynamic_pointer_cast<Declaration>(statement)) {
+        ++versions_[declaration->variable().id()];
+    } else if (std::dynamic_pointer_cast<ArrayDeclaration>(statement)) {
+        write(statement);
+    }
+}
+
+/******************************************************************************/
+/*                                elimination                                 */
+/******************************************************************************/
+
+/**
+ * @brief  Eliminate the common subexpressions of a basic block. The largest
+ *         expression computed several times is replaced first, then the block
+ *         is numbered again, until no expression is computed twice. The first
+ *         occurrence must not be conditional, unless the expression can't
+ *         fail (it's computed before the statement).
+ *
+ * @return  True if the block changed.
+ */
+bool CommonSubexpressionEliminator::eliminate(
+    std::vector<std::shared_ptr<Node>> &statements) {
+    bool changed = false;
+
+    while (true) {
+        Numbering numbering(pure_, locals_);
+        std::vector<Occurrence> const *best = nullptr;
+        size_t bestSize = 0;
+
+        for (size_t i = 0; i < statements.size(); ++i) {
+            numbering.statement(statements[i], i);
+        }
+        for (auto const &[value, occurrences] : numbering.occurrences) {
+            if (occurrences.size() < 2 ||
+                (occurrences.front().conditional &&
+                 canFail(occurrences.front().node))) {
+                continue;
+            }
+            size_t size = countNodes(occurrences.front().node);
+            if (size > bestSize) {
+                best = &occurrences;
+                bestSize = size;
+            }
+        }
+        if (best == nullptr) {
+            return changed;
+        }
+
+        // the variable assigned by the first occurrence is reused when it
+        // still holds the value at each other occurrence
+        Occurrence const &first = best->front();
+        auto expression = std::dynamic_pointer_cast<TypedNode>(first.node);
+        auto assignment =
+            std::dynamic_pointer_cast<Assignment>(statements[first.statement]);
+        std::string variable;
+        bool held = assignment != nullptr && assignment->value() == first.node;
+        for (size_t i = 1; held && i < best->size(); ++i) {
+            held = (*best)[i].holder == assignment->variable()->id();
+        }
+        if (held) {
+            variable = assignment->variable()->id();
+        } else {
+            variable = "_cse" + std::to_string(++temporaries_);
+            statements.insert(
+                statements.begin() + first.statement,
+                std::make_shared<Assignment>(
+                    std::make_shared<Variable>(variable, expression->type()),
+                    expression));
+        }
+        for (size_t i = held ? 1 : 0; i < best->size(); ++i) {
+            Occurrence const &occurrence = (*best)[i];
+            occurrence.parent->replace(
+                occurrence.node,
+                std::make_shared<Variable>(variable, expression->type()));
+        }
+        eliminated_ += best->size() - 1;
+        changed = true;
+    }
+}
+
+/******************************************************************************/
+/*                                    pass                                    */
+/******************************************************************************/
+
+/**
+ * @brief  Split the blocks of the function in basic blocks. The nested blocks
+ *         are treated with an explicit stack.
+ */
+void CommonSubexpressionEliminator::optimize(
+    std::shared_ptr<Function> function) {
+    std::vector<std::shared_ptr<Block>> blocks = {function->block()};
+
+    locals_ = localArrays(function);
+    while (!blocks.empty()) {
+        std::shared_ptr<Block> block = std::move(blocks.back());
+        blocks.pop_back();
+        std::list<std::shared_ptr<Node>> instructions;
+        std::vector<std::shared_ptr<Node>> statements;
+        bool changed = false;
+
+        auto flush = [&]() {
+            changed = eliminate(statements) || changed;
+            instructions.insert(instructions.end(), statements.begin(),
+                                statements.end());
+            statements.clear();
+        };
+        for (std::shared_ptr<Node> const &node : block->instructions()) {
+            if (auto cnd = std::dynamic_pointer_cast<Cnd>(node)) {
+                statements.push_back(node);
+                flush();
+                blocks.push_back(cnd->block());
+                if (cnd->elseBlock() != nullptr) {
+                    blocks.push_back(cnd->elseBlock());
+                }
+            } else if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+                statements.push_back(node);
+                flush();
+                blocks.push_back(loop->block());
+            } else if (auto whl = std::dynamic_pointer_cast<Whl>(node)) {
+                flush();
+                instructions.push_back(node);
+                blocks.push_back(whl->block());
+            } else {
+                statements.push_back(node);
+            }
+        }
+        flush();
+        if (changed) {
+            block->instructions(instructions);
+        }
+    }
+}
+
+void CommonSubexpressionEliminator::optimize(
+    std::shared_ptr<Program> program) {
+    pure_ = PurityAnalysis(program).pure();
+    for (std::shared_ptr<Function> function : program->functions()) {
+        optimize(function);
+    }
+}
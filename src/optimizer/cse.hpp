@@ -0,0 +1,42 @@
+#ifndef CSE_H
+#define CSE_H
+#include "ast/program.hpp"
+#include <cstddef>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief  Common subexpression elimination in the basic blocks. The
+ *         expressions of a sequence of statements are numbered (local value
+ *         numbering): two expressions get the same number when they compute
+ *         the same value, i.e. same operations on the same versions of the
+ *         variables and arrays. An expression computed several times is
+ *         computed once in a temporary, or reuses the variable it was assigned
+ *         to when the variable is not modified in the meantime.
+ *
+ *         The arithmetic, the array accesses and the calls of pure functions
+ *         are eliminated. A basic block ends before a `whl` and after the
+ *         condition of a `cnd` or the bounds of a `for`.
+ */
+class CommonSubexpressionEliminator {
+  public:
+    void optimize(std::shared_ptr<Program> program);
+    void optimize(std::shared_ptr<Function> function);
+
+    /**
+     * @brief  Number of expressions reused so far.
+     */
+    size_t eliminated() const { return eliminated_; }
+
+  private:
+    bool eliminate(std::vector<std::shared_ptr<Node>> &statements);
+
+    std::set<std::string> pure_ = {};
+    std::set<std::string> locals_ = {}; //< local arrays of the function
+    size_t eliminated_ = 0;
+    size_t temporaries_ = 0;
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "optimizer/deadcode.hpp"
+#include "optimizer/analysis.hpp"
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/******************************************************************************/
+/*                              unreachable code                              */
+/******************************************************************************/
+
+/**
+ * @brief  Find the statements after which the end of the block is never
+ *         reached: `ret`, the blocks that contain such statement and the `cnd`
+ *         which both branches terminate. The tree is traversed in post-order so
+ *         the sub-nodes are treated before their parent.
+ */
+static std::unordered_set<Node *>
+terminatingNodes(std::shared_ptr<Function> function) {
+    std::unordered_set<Node *> terminating;
+
+    rewrite(function->block(), [&](std::shared_ptr<Node> const &node) {
+        if (std::dynamic_pointer_cast<Return>(node)) {
+            terminating.insert(node.get());
+        } else if (auto block = std::dynamic_pointer_cast<Block>(node)) {
+            for (std::shared_ptr<Node> const &instruction :
+                 block->instructions()) {
+                if (terminating.count(instruction.get())) {
+                    terminating.insert(node.get());
+                    break;
+                }
+            }
+        } else if (auto cnd = std::dynamic_pointer_cast<Cnd>(node)) {
+            if (cnd->elseBlock() != nullptr &&
+                terminating.count(cnd->block().get()) &&
+                terminating.count(cnd->elseBlock().get())) {
+                terminating.insert(node.get());
+            }
+        }
+        return node;
+    });
+    return terminating;
+}
+
+/**
+ * @brief  A `for` loop with constant bounds that doesn't run (a zero step is
+ *         kept since it raises an error at runtime).
+ */
+static bool isEmptyLoop(std::shared_ptr<For> loop) {
+    auto begin = std::dynamic_pointer_cast<Value>(loop->begin());
+    auto end = std::dynamic_pointer_cast<Value>(loop->end());
+    auto step = std::dynamic_pointer_cast<Value>(loop->step());
+
+    if (begin == nullptr || end == nullptr || step == nullptr ||
+        begin->type() != INT || end->type() != INT || step->type() != INT) {
+        return false;
+    }
+    long long b = begin->value()._int;
+    long long e = end->value()._int;
+    long long s = step->value()._int;
+    return (s > 0 && b >= e) || (s < 0 && b <= e);
+}
+
+/**
+ * @brief  Remove the unreachable statements, the constant branches and the
+ *         declarations in all the blocks of the function. The blocks are
+ *         treated with an explicit stack, and the instructions of a branch
+ *         which condition is constant are spliced in the parent block (they
+ *         are treated again there).
+ */
+void DeadCodeEliminator::simplifyBlocks(std::shared_ptr<Function> function) {
+    std::unordered_set<Node *> terminating = terminatingNodes(function);
+    std::vector<std::shared_ptr<Block>> blocks = {function->block()};
+
+    while (!blocks.empty()) {
+        std::shared_ptr<Block> block = std::move(blocks.back());
+        blocks.pop_back();
+        std::list<std::shared_ptr<Node>> pending = block->instructions();
+        std::list<std::shared_ptr<Node>> instructions;
+        std::vector<std::shared_ptr<Node>> removed;
+
+        while (!pending.empty()) {
+            std::shared_ptr<Node> node = std::move(pending.front());
+            pending.pop_front();
+
+            if (std::dynamic_pointer_cast<Declaration>(node)) {
+                removed_ += countNodes(node);
+                removed.push_back(std::move(node));
+                continue;
+            } else if (auto cnd = std::dynamic_pointer_cast<Cnd>(node)) {
+                if (isConstant(cnd->condition())) {
+                    auto condition =
+                        std::dynamic_pointer_cast<Value>(cnd->condition());
+                    std::shared_ptr<Block> kept =
+                        truth(*condition) ? cnd->block() : cnd->elseBlock();
+                    removed_ += countNodes(node);
+                    if (kept != nullptr) {
+                        removed_ -= countNodes(kept) - 1;
+                        pending.insert(pending.begin(),
+                                       kept->instructions().begin(),
+                                       kept->instructions().end());
+                    }
+                    removed.push_back(std::move(node));
+                    continue;
+                } else if (isPure(cnd->condition()) &&
+                           cnd->block()->instructions().empty() &&
+                           (cnd->elseBlock() == nullptr ||
+                            cnd->elseBlock()->instructions().empty())) {
+                    removed_ += countNodes(node);
+                    removed.push_back(std::move(node));
+                    continue;
+                }
+                blocks.push_back(cnd->block());
+                if (cnd->elseBlock() != nullptr) {
+                    blocks.push_back(cnd->elseBlock());
+                }
+            } else if (auto loop = std::dynamic_pointer_cast<Whl>(node)) {
+                auto condition =
+                    std::dynamic_pointer_cast<Value>(loop->condition());
+                if (isConstant(condition) && !truth(*condition)) {
+                    removed_ += countNodes(node);
+                    removed.push_back(std::move(node));
+                    continue;
+                }
+                blocks.push_back(loop->block());
+            } else if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+                if (isEmptyLoop(loop)) {
+                    removed_ += countNodes(node);
+                    removed.push_back(std::move(node));
+                    continue;
+                }
+                blocks.push_back(loop->block());
+            }
+            instructions.push_back(node);
+
+            // the remaining instructions are unreachable
+            if (terminating.count(node.get())) {
+                for (std::shared_ptr<Node> &unreachable : pending) {
+                    removed_ += countNodes(unreachable);
+                    removed.push_back(std::move(unreachable));
+                }
+                break;
+            }
+        }
+        if (!removed.empty()) {
+            block->instructions(instructions);
+            // the removed trees can be deep (see release)
+            for (std::shared_ptr<Node> &node : removed) {
+                release(std::move(node));
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+/*                                dead stores                                 */
+/******************************************************************************/
+
+/**
+ * @brief  Remove the assignments of the variables that are never read, and the
+ *         declarations of the arrays that are never used. The variables are
+ *         identified by their name: the generated functions have only one
+ *         scope, so a variable declared in a nested block is the same as the
+ *         one with the same name in the function.
+ *
+ * NOTE: the arrays are references, so the stores in their elements are removed
+ *       only for the local arrays that are never aliased.
+ */
+void DeadCodeEliminator::removeDeadStores(std::shared_ptr<Function> function) {
+    std::unordered_set<Node *> targets;
+    std::unordered_set<std::string> localArrays;
+    std::map<std::string, int> reads;
+    std::map<std::string, int> uses;
+
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        if (auto assignment = std::dynamic_pointer_cast<Assignment>(node)) {
+            std::shared_ptr<Variable> target = assignment->variable();
+            targets.insert(target.get());
+            // `set(a, b)` makes `a` an alias of the array `b`
+            if (isArray(target->type()) &&
+                !std::dynamic_pointer_cast<Value>(assignment->value())) {
+                reads[target->id()]++;
+            }
+        } else if (auto read = std::dynamic_pointer_cast<Read>(node)) {
+            targets.insert(read->variable().get());
+        } else if (auto array =
+                       std::dynamic_pointer_cast<ArrayDeclaration>(node)) {
+            localArrays.insert(array->id());
+        }
+    });
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        auto variable = std::dynamic_pointer_cast<Variable>(node);
+        if (variable == nullptr ||
+            std::dynamic_pointer_cast<ArrayDeclaration>(node)) {
+            return;
+        }
+        uses[variable->id()]++;
+        if (!targets.count(node.get())) {
+            reads[variable->id()]++;
+        }
+    });
+
+    rewrite(function->block(), [&](std::shared_ptr<Node> const &node) {
+        if (auto assignment = std::dynamic_pointer_cast<Assignment>(node)) {
+            std::shared_ptr<Variable> target = assignment->variable();
+            // the strings are copied in the arrays (`a[:]=...`)
+            bool store = std::dynamic_pointer_cast<ArrayAccess>(target) ||
+                         isArray(target->type());
+            if (reads[target->id()] == 0 &&
+                (!store || localArrays.count(target->id())) &&
+                isPure(target) &&
+                isPure(assignment->value())) {
+                removed_ += countNodes(node);
+                return std::shared_ptr<Node>(nullptr);
+            }
+        } else if (auto array =
+                       std::dynamic_pointer_cast<ArrayDeclaration>(node)) {
+            if (uses[array->id()] == 0) {
+                removed_ += countNodes(node);
+                return std::shared_ptr<Node>(nullptr);
+            }
+        }
+        return node;
+    });
+}
+
+/******************************************************************************/
+/*                                    pass                                    */
+/******************************************************************************/
+
+/**
+ * @brief  Run the eliminations until nothing is removed (removing a store can
+ *         make an array unused, ...).
+ */
+void DeadCodeEliminator::optimize(std::shared_ptr<Function> function) {
+    size_t before;
+
+    do {
+        before = removed_;
+        simplifyBlocks(function);
+        removeDeadStores(function);
+    } while (removed_ != before);
+}
+
+void DeadCodeEliminator::optimize(std::shared_ptr<Program> program) {
+    for (std::shared_ptr<Function> function : program->functions()) {
+        optimize(function);
+    }
+}
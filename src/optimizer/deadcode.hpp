@@ -0,0 +1,35 @@
+#ifndef DEAD_CODE_H
+#define DEAD_CODE_H
+#include "ast/program.hpp"
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief  Dead code elimination. The pass removes:
+ *         - the statements that follow a `ret` (unreachable code),
+ *         - the branches of the `cnd` which condition is constant, and the
+ *           loops that never run,
+ *         - the declarations (they are only comments in the generated code),
+ *           and the arrays that are never used,
+ *         - the assignments of variables that are never read (dead stores).
+ *
+ * NOTE: the expressions that call a function are never removed.
+ */
+class DeadCodeEliminator {
+  public:
+    void optimize(std::shared_ptr<Program> program);
+    void optimize(std::shared_ptr<Function> function);
+
+    /**
+     * @brief  Number of AST nodes removed so far.
+     */
+    size_t removed() const { return removed_; }
+
+  private:
+    void simplifyBlocks(std::shared_ptr<Function> function);
+    void removeDeadStores(std::shared_ptr<Function> function);
+
+    size_t removed_ = 0;
+};
+
+#endif
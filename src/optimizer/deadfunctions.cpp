@@ -0,0 +1,36 @@
+#include "optimizer/deadfunctions.hpp"
+#include "optimizer/callgraph.hpp"
+#include <set>
+#include <sstream>
+
+/**
+ * @brief  Remove the functions that are not reachable from `main`. Nothing is
+ *         removed from a program without `main` (it's not runnable anyway).
+ */
+void DeadFunctionEliminator::optimize(std::shared_ptr<Program> program) {
+    CallGraph graph(program);
+    std::set<std::string> reachable = graph.reachable("main");
+    std::list<std::shared_ptr<Function>> functions;
+    bool hasMain = false;
+
+    for (std::shared_ptr<Function> function : program->functions()) {
+        hasMain = hasMain || function->id() == "main";
+        if (reachable.count(function->id())) {
+            functions.push_back(function);
+        }
+    }
+    if (!hasMain || functions.size() == program->functions().size()) {
+        return;
+    }
+    for (std::shared_ptr<Function> function : program->functions()) {
+        if (reachable.count(function->id())) {
+            continue;
+        }
+        // the size of the code, followed by an empty line (see Program)
+        std::ostringstream code;
+        Emitter::compile(code, function);
+        saved_ += code.str().size() + 1;
+        removed_.push_back(function->id());
+    }
+    program->functions(functions);
+}
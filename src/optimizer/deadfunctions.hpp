@@ -0,0 +1,34 @@
+#ifndef DEAD_FUNCTIONS_H
+#define DEAD_FUNCTIONS_H
+#include "ast/program.hpp"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+
+/**
+ * @brief  Dead function elimination. The functions that `main` can't reach in
+ *         the call graph (the unused functions of the `use`d files, and the
+ *         functions which calls have all been inlined or evaluated) are not
+ *         generated.
+ */
+class DeadFunctionEliminator {
+  public:
+    void optimize(std::shared_ptr<Program> program);
+
+    /**
+     * @brief  Names of the functions removed so far.
+     */
+    std::list<std::string> const &removed() const { return removed_; }
+
+    /**
+     * @brief  Size of the code the removed functions would have generated.
+     */
+    size_t saved() const { return saved_; }
+
+  private:
+    std::list<std::string> removed_ = {};
+    size_t saved_ = 0;
+};
+
+#endif
@@ -0,0 +1,678 @@
+#include "optimizer/evaluator.hpp"
+#include "optimizer/analysis.hpp"
+#include "optimizer/purity.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using Scalar = CompileTimeEvaluator::Scalar;
+using Result = CompileTimeEvaluator::Result;
+
+/**
+ * @brief  Thrown when the evaluation is abandoned.
+ */
+struct Abort {};
+
+/**
+ * @brief  Value of a variable: a scalar or a python list (the lists are
+ *         given by reference to the functions).
+ */
+struct Object {
+    Scalar scalar;
+    std::shared_ptr<std::vector<Scalar>> array = nullptr;
+};
+
+using Frame = std::unordered_map<std::string, Object>;
+using Functions = std::map<std::string, std::shared_ptr<Function>>;
+
+/******************************************************************************/
+/*                                   values                                   */
+/******************************************************************************/
+
+static Scalar intScalar(long long value) {
+    Scalar scalar;
+    scalar.type = INT;
+    scalar.i = value;
+    return scalar;
+}
+
+static Scalar fltScalar(double value) {
+    Scalar scalar;
+    scalar.type = FLT;
+    scalar.f = value;
+    return scalar;
+}
+
+/**
+ * @brief  The booleans are the integers 1 and 0 (like in the constant folder).
+ */
+static Scalar boolScalar(bool value) { return intScalar(value ? 1 : 0); }
+
+static bool isNumber(Scalar const &scalar) {
+    return scalar.type == INT || scalar.type == FLT;
+}
+
+static double toFlt(Scalar const &scalar) {
+    return scalar.type == INT ? (double)scalar.i : scalar.f;
+}
+
+/**
+ * @brief  Truth value (python semantic: a character is never empty).
+ */
+static bool truth(Scalar const &scalar) {
+    switch (scalar.type) {
+    case INT:
+        return scalar.i != 0;
+    case FLT:
+        return scalar.f != 0;
+    case CHR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief  Key of a call in the cache: the name of the function and the exact
+ *         values of the arguments.
+ *
+ * @return  false if an argument is an array (the call is not cached).
+ */
+static bool callKey(std::shared_ptr<Function> const &function,
+                    std::vector<Object> const &arguments, std::string &key) {
+    key = function->id();
+    for (Object const &argument : arguments) {
+        long long bits = 0;
+        if (argument.array != nullptr) {
+            return false;
+        }
+        switch (argument.scalar.type) {
+        case INT:
+            key += "|i" + std::to_string(argument.scalar.i);
+            break;
+        case FLT:
+            std::memcpy(&bits, &argument.scalar.f, sizeof(bits));
+            key += "|f" + std::to_string(bits);
+            break;
+        default:
+            key += "|c" + std::to_string((int)argument.scalar.c);
+            break;
+        }
+    }
+    return true;
+}
+
+/******************************************************************************/
+/*                                 operations                                 */
+/******************************************************************************/
+
+/**
+ * @brief  `+`, `-` and `*`. Like in the constant folder, the evaluation stops
+ *         when an integer operation overflows (python integers are not
+ *         bounded).
+ */
+static Scalar arithmetic(char op, Scalar const &left, Scalar const &right) {
+    if (!isNumber(left) || !isNumber(right)) {
+        throw Abort();
+    }
+    if (left.type == INT && right.type == INT) {
+        long long result = 0;
+        bool overflow = true;
+        switch (op) {
+        case '+':
+            overflow = __builtin_add_overflow(left.i, right.i, &result);
+            break;
+        case '-':
+            overflow = __builtin_sub_overflow(left.i, right.i, &result);
+            break;
+        case '*':
+            overflow = __builtin_mul_overflow(left.i, right.i, &result);
+            break;
+        }
+        if (overflow) {
+            throw Abort();
+        }
+        return intScalar(result);
+    }
+    switch (op) {
+    case '+':
+        return fltScalar(toFlt(left) + toFlt(right));
+    case '-':
+        return fltScalar(toFlt(left) - toFlt(right));
+    default:
+        return fltScalar(toFlt(left) * toFlt(right));
+    }
+}
+
+/**
+ * @brief  Division: `div` is the true division, an integer division (typed
+ *         `int`) is int(a/b) which rounds toward zero. The true division of
+ *         integers is exact only when they are representable as doubles, and
+ *         then int(a/b) is the truncated quotient.
+ */
+static Scalar division(bool integer, Scalar const &left, Scalar const &right) {
+    const double exact = 9007199254740992.0; // 2^53
+
+    if (!isNumber(left) || !isNumber(right) || toFlt(right) == 0 ||
+        (left.type == INT && std::fabs(toFlt(left)) > exact) ||
+        (right.type == INT && std::fabs(toFlt(right)) > exact)) {
+        throw Abort();
+    } else if (integer && left.type == INT && right.type == INT) {
+        return intScalar(left.i / right.i);
+    } else if (integer) {
+        throw Abort();
+    }
+    return fltScalar(toFlt(left) / toFlt(right));
+}
+
+/**
+ * @brief  Comparison of two values, python doesn't compare the characters and
+ *         the numbers.
+ */
+static bool comparison(std::shared_ptr<Node> const &operation,
+                       Scalar const &left, Scalar const &right) {
+    const double exact = 9007199254740992.0; // 2^53
+    int order = 0;
+
+    if (left.type == CHR && right.type == CHR) {
+        int l = (unsigned char)left.c;
+        int r = (unsigned char)right.c;
+        order = l < r ? -1 : (l > r ? 1 : 0);
+    } else if (left.type == INT && right.type == INT) {
+        order = left.i < right.i ? -1 : (left.i > right.i ? 1 : 0);
+    } else if (!isNumber(left) || !isNumber(right) ||
+               (left.type == INT && std::fabs(toFlt(left)) > exact) ||
+               (right.type == INT && std::fabs(toFlt(right)) > exact)) {
+        throw Abort();
+    } else if (std::isnan(toFlt(left)) || std::isnan(toFlt(right))) {
+        return false;
+    } else {
+        double l = toFlt(left);
+        double r = toFlt(right);
+        order = l < r ? -1 : (l > r ? 1 : 0);
+    }
+
+    if (std::dynamic_pointer_cast<EqlOP>(operation)) {
+        return order == 0;
+    } else if (std::dynamic_pointer_cast<SupOP>(operation)) {
+        return order > 0;
+    } else if (std::dynamic_pointer_cast<InfOP>(operation)) {
+        return order < 0;
+    } else if (std::dynamic_pointer_cast<SeqOP>(operation)) {
+        return order >= 0;
+    }
+    return order <= 0;
+}
+
+/**
+ * @brief  Conversion added by the generated code when a value of static type
+ *         `source` is assigned to a variable of type `target` (see
+ *         `conversion` in ast.cpp).
+ */
+static Scalar convert(Scalar const &value, PrimitiveType target,
+                      PrimitiveType source) {
+    if (source == target) {
+        return value;
+    }
+    switch (target) {
+    case INT:
+        if (value.type == FLT) {
+            // int() truncates toward zero
+            if (!std::isfinite(value.f) || std::fabs(value.f) >= 9.2e18) {
+                throw Abort();
+            }
+            return intScalar((long long)value.f);
+        } else if (value.type != INT) {
+            throw Abort();
+        }
+        return value;
+    case FLT:
+        if (!isNumber(value)) {
+            throw Abort();
+        }
+        return fltScalar(toFlt(value));
+    case CHR:
+        if (source != INT) {
+            return value;
+        } else if (value.type != INT || value.i < 0 || value.i > 127) {
+            throw Abort();
+        } else {
+            Scalar chr;
+            chr.type = CHR;
+            chr.c = (char)value.i;
+            return chr;
+        }
+    default:
+        return value;
+    }
+}
+
+/******************************************************************************/
+/*                                interpreter                                 */
+/******************************************************************************/
+
+/**
+ * @brief  Interpreter of the AST, used for one evaluation. The statements and
+ *         the expressions are evaluated recursively, so the nesting is
+ *         limited, and the calls are limited to a depth that python accepts.
+ */
+class Interpreter {
+  public:
+    Interpreter(Functions const &functions,
+                std::map<std::string, Result> &cache, size_t steps,
+                size_t memory)
+        : functions_(functions), cache_(cache), steps_(steps),
+          memory_(memory) {}
+
+    Scalar call(std::shared_ptr<Function> const &function,
+                std::vector<Object> const &arguments);
+
+  private:
+    /**
+     * @brief  Count the nesting of the recursive calls of the interpreter.
+     */
+    struct Nesting {
+        Nesting(size_t &depth) : depth_(depth) {
+            if (++depth_ > 5000) {
+                throw Abort();
+            }
+        }
+        ~Nesting() { --depth_; }
+        size_t &depth_;
+    };
+
+    bool block(std::shared_ptr<Block> const &block, Frame &frame,
+               Object &result);
+    bool statement(std::shared_ptr<Node> const &node, Frame &frame,
+                   Object &result);
+    void assign(std::shared_ptr<Assignment> const &assignment, Frame &frame);
+    Object expression(std::shared_ptr<Node> const &node, Frame &frame);
+    Scalar scalar(std::shared_ptr<Node> const &node, Frame &frame);
+    Scalar &element(std::shared_ptr<ArrayAccess> const &access, Frame &frame);
+    void step();
+
+    static constexpr size_t maxCalls = 500; //< python allows 1000 frames
+
+    Functions const &functions_;
+    std::map<std::string, Result> &cache_;
+    size_t steps_;
+    size_t memory_;
+    size_t nesting_ = 0;
+    size_t calls_ = 0;
+    size_t deepest_ = 0;
+};
+
+void Interpreter::step() {
+    if (steps_ == 0) {
+        throw Abort();
+    }
+    --steps_;
+}
+
+/**
+ * @brief  Evaluate a call. The results are cached with the depth of the calls
+ *         needed to compute them, so a cached result is used only when python
+ *         could compute it at the current depth.
+ */
+Scalar Interpreter::call(std::shared_ptr<Function> const &function,
+                         std::vector<Object> const &arguments) {
+    std::string key;
+    bool cached = callKey(function, arguments, key);
+    size_t before = calls_;
+
+    if (cached) {
+        auto it = cache_.find(key);
+        if (it != cache_.end()) {
+            if (!it->second.valid || before + it->second.depth > maxCalls) {
+                throw Abort();
+            }
+            deepest_ = std::max(deepest_, before + it->second.depth);
+            return it->second.value;
+        }
+    }
+    if (++calls_ > maxCalls ||
+        arguments.size() != function->parameters().size()) {
+        throw Abort();
+    }
+    size_t outer = deepest_;
+    deepest_ = calls_;
+
+    Frame frame;
+    Object result;
+    auto argument = arguments.begin();
+    for (Variable const &parameter : function->parameters()) {
+        Object value = *argument++;
+        // the arguments are converted to the types of the parameters
+        if (value.array == nullptr) {
+            value.scalar =
+                convert(value.scalar, parameter.type(), value.scalar.type);
+        }
+        frame[parameter.id()] = value;
+    }
+    if (!block(function->block(), frame, result)) {
+        result = Object(); // None
+    }
+    if (result.array != nullptr) {
+        throw Abort();
+    }
+
+    size_t depth = deepest_ - before;
+    deepest_ = std::max(outer, deepest_);
+    calls_ = before;
+    if (cached) {
+        cache_[key] = {true, result.scalar, depth};
+    }
+    return result.scalar;
+}
+
+/**
+ * @return  true if a `ret` has been executed (`result` is the returned value).
+ */
+bool Interpreter::block(std::shared_ptr<Block> const &block, Frame &frame,
+                        Object &result) {
+    for (std::shared_ptr<Node> const &instruction : block->instructions()) {
+        if (statement(instruction, frame, result)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Interpreter::statement(std::shared_ptr<Node> const &node, Frame &frame,
+                            Object &result) {
+    Nesting nesting(nesting_);
+
+    step();
+    if (auto assignment = std::dynamic_pointer_cast<Assignment>(node)) {
+        assign(assignment, frame);
+    } else if (auto array = std::dynamic_pointer_cast<ArrayDeclaration>(node)) {
+        // `[0]*n` (the lists of characters are also filled with 0)
+        if (array->size() < 0 || (size_t)array->size() > memory_) {
+            throw Abort();
+        }
+        memory_ -= array->size();
+        Scalar zero = array->type() == ARR_FLT ? fltScalar(0) : intScalar(0);
+        frame[array->id()].array =
+            std::make_shared<std::vector<Scalar>>(array->size(), zero);
+    } else if (std::dynamic_pointer_cast<Declaration>(node)) {
+        // nothing is generated
+    } else if (std::dynamic_pointer_cast<FunctionCall>(node)) {
+        expression(node, frame);
+    } else if (auto ret = std::dynamic_pointer_cast<Return>(node)) {
+        auto typed = std::dynamic_pointer_cast<TypedNode>(ret->returnExpr());
+        result = Object();
+        if (ret->returnExpr() != nullptr) {
+            result = expression(ret->returnExpr(), frame);
+        }
+        if (typed != nullptr && typed->type() != NIL) {
+            if (result.array != nullptr) {
+                throw Abort();
+            }
+            result.scalar = convert(result.scalar, ret->type(), typed->type());
+        }
+        return true;
+    } else if (auto cnd = std::dynamic_pointer_cast<Cnd>(node)) {
+        if (truth(scalar(cnd->condition(), frame))) {
+            return block(cnd->block(), frame, result);
+        } else if (cnd->elseBlock() != nullptr) {
+            return block(cnd->elseBlock(), frame, result);
+        }
+    } else if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+        // `range` accepts only integers, and it's evaluated once
+        Scalar begin = scalar(loop->begin(), frame);
+        Scalar end = scalar(loop->end(), frame);
+        Scalar increment = scalar(loop->step(), frame);
+        if (begin.type != INT || end.type != INT || increment.type != INT ||
+            increment.i == 0) {
+            throw Abort();
+        }
+        long long i = begin.i;
+        while (increment.i > 0 ? i < end.i : i > end.i) {
+            step();
+            frame[loop->variable().id()] = {intScalar(i)};
+            if (block(loop->block(), frame, result)) {
+                return true;
+            }
+            if (__builtin_add_overflow(i, increment.i, &i)) {
+                break;
+            }
+        }
+    } else if (auto whl = std::dynamic_pointer_cast<Whl>(node)) {
+        while (truth(scalar(whl->condition(), frame))) {
+            step();
+            if (block(whl->block(), frame, result)) {
+                return true;
+            }
+        }
+    } else {
+        throw Abort();
+    }
+    return false;
+}
+
+/**
+ * @brief  Assignment of a scalar or an element of an array (the value is
+ *         evaluated first, like in python).
+ */
+void Interpreter::assign(std::shared_ptr<Assignment> const &assignment,
+                         Frame &frame) {
+    std::shared_ptr<Variable> target = assignment->variable();
+    std::shared_ptr<TypedNode> value = assignment->value();
+    auto access = std::dynamic_pointer_cast<ArrayAccess>(target);
+
+    if (access == nullptr && isArray(target->type())) {
+        throw Abort();
+    }
+    Scalar result =
+        convert(scalar(value, frame), target->type(), value->type());
+    if (access != nullptr) {
+        element(access, frame) = result;
+    } else {
+        frame[target->id()] = {result};
+    }
+}
+
+Scalar &Interpreter::element(std::shared_ptr<ArrayAccess> const &access,
+                             Frame &frame) {
+    auto it = frame.find(access->id());
+    if (it == frame.end() || it->second.array == nullptr) {
+        throw Abort();
+    }
+    std::shared_ptr<std::vector<Scalar>> array = it->second.array;
+    Scalar index = scalar(access->index(), frame);
+    long long size = (long long)array->size();
+    if (index.type != INT || index.i < -size || index.i >= size) {
+        throw Abort();
+    }
+    // the negative indexes start from the end of the list
+    return (*array)[index.i < 0 ? index.i + size : index.i];
+}
+
+Scalar Interpreter::scalar(std::shared_ptr<Node> const &node, Frame &frame) {
+    Object object = expression(node, frame);
+    if (object.array != nullptr) {
+        throw Abort();
+    }
+    return object.scalar;
+}
+
+Object Interpreter::expression(std::shared_ptr<Node> const &node,
+                               Frame &frame) {
+    Nesting nesting(nesting_);
+
+    step();
+    if (auto value = std::dynamic_pointer_cast<Value>(node)) {
+        Scalar result;
+        result.type = value->type();
+        switch (value->type()) {
+        case INT:
+            result.i = value->value()._int;
+            break;
+        case FLT:
+            result.f = value->value()._flt;
+            break;
+        case CHR:
+            result.c = value->value()._chr;
+            break;
+        default:
+            throw Abort();
+        }
+        return {result};
+    } else if (auto access = std::dynamic_pointer_cast<ArrayAccess>(node)) {
+        return {element(access, frame)};
+    } else if (auto variable = std::dynamic_pointer_cast<Variable>(node)) {
+        auto it = frame.find(variable->id());
+        if (it == frame.end()) {
+            throw Abort();
+        }
+        return it->second;
+    } else if (auto call = std::dynamic_pointer_cast<FunctionCall>(node)) {
+        auto function = functions_.find(call->functionName());
+        std::vector<Object> arguments;
+        if (function == functions_.end()) {
+            throw Abort();
+        }
+        for (std::shared_ptr<TypedNode> const &param : call->params()) {
+            arguments.push_back(expression(param, frame));
+        }
+        return {this->call(function->second, arguments)};
+    } else if (auto notOp = std::dynamic_pointer_cast<NotOP>(node)) {
+        return {boolScalar(!truth(scalar(notOp->param(), frame)))};
+    }
+
+    auto operation = std::dynamic_pointer_cast<BinaryOperation>(node);
+    if (operation == nullptr) {
+        throw Abort();
+    }
+    if (std::dynamic_pointer_cast<AndOP>(node)) {
+        return {boolScalar(truth(scalar(operation->left(), frame)) &&
+                           truth(scalar(operation->right(), frame)))};
+    } else if (std::dynamic_pointer_cast<OrOP>(node)) {
+        return {boolScalar(truth(scalar(operation->left(), frame)) ||
+                           truth(scalar(operation->right(), frame)))};
+    }
+    Scalar left = scalar(operation->left(), frame);
+    Scalar right = scalar(operation->right(), frame);
+    if (std::dynamic_pointer_cast<AddOP>(node)) {
+        return {arithmetic('+', left, right)};
+    } else if (std::dynamic_pointer_cast<MnsOP>(node)) {
+        return {arithmetic('-', left, right)};
+    } else if (std::dynamic_pointer_cast<TmsOP>(node)) {
+        return {arithmetic('*', left, right)};
+    } else if (auto div = std::dynamic_pointer_cast<DivOP>(node)) {
+        return {division(div->type() == INT, left, right)};
+    } else if (std::dynamic_pointer_cast<XorOP>(node)) {
+        return {boolScalar(truth(left) != truth(right))};
+    }
+    return {boolScalar(comparison(node, left, right))};
+}
+
+/******************************************************************************/
+/*                                    pass                                    */
+/******************************************************************************/
+
+/**
+ * @brief  The value can be written as a literal in the generated code (the
+ *         characters are written between quotes without escape).
+ */
+static std::shared_ptr<Value> literal(Scalar const &scalar) {
+    LiteralValue literal;
+
+    switch (scalar.type) {
+    case INT:
+        literal._int = scalar.i;
+        break;
+    case FLT:
+        literal._flt = scalar.f;
+        break;
+    case CHR:
+        if (scalar.c < ' ' || scalar.c > '~' || scalar.c == '\'' ||
+            scalar.c == '\\') {
+            return nullptr;
+        }
+        literal._chr = scalar.c;
+        break;
+    default:
+        return nullptr;
+    }
+    return std::make_shared<Value>(literal, scalar.type);
+}
+
+/**
+ * @brief  Replace the calls of pure functions with constant arguments by their
+ *         result. The calls used as statements are left to the dead code
+ *         elimination.
+ */
+void CompileTimeEvaluator::optimize(std::shared_ptr<Program> program) {
+    PurityAnalysis purity(program);
+    Functions functions;
+    std::unordered_set<Node *> statements;
+
+    if (steps_ == 0) {
+        return;
+    }
+    for (std::shared_ptr<Function> function : program->functions()) {
+        functions[function->id()] = function;
+    }
+    for (std::shared_ptr<Function> function : program->functions()) {
+        visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+            if (auto block = std::dynamic_pointer_cast<Block>(node)) {
+                for (std::shared_ptr<Node> const &instruction :
+                     block->instructions()) {
+                    statements.insert(instruction.get());
+                }
+            }
+        });
+    }
+
+    for (std::shared_ptr<Function> function : program->functions()) {
+        rewrite(function->block(), [&](std::shared_ptr<Node> const &node) {
+            auto call = std::dynamic_pointer_cast<FunctionCall>(node);
+            if (call == nullptr || statements.count(node.get()) ||
+                !purity.isPure(call->functionName()) ||
+                !functions.count(call->functionName())) {
+                return node;
+            }
+            std::shared_ptr<Function> callee = functions[call->functionName()];
+            std::vector<Object> arguments;
+            std::string key;
+            for (std::shared_ptr<TypedNode> const &param : call->params()) {
+                auto value = std::dynamic_pointer_cast<Value>(param);
+                if (!isConstant(value)) {
+                    return node;
+                }
+                Object argument;
+                argument.scalar.type = value->type();
+                argument.scalar.i = value->type() == INT ? value->value()._int
+                                                         : 0;
+                argument.scalar.f = value->type() == FLT ? value->value()._flt
+                                                         : 0;
+                argument.scalar.c = value->type() == CHR ? value->value()._chr
+                                                         : 0;
+                arguments.push_back(argument);
+            }
+
+            Scalar result;
+            try {
+                Interpreter interpreter(functions, cache_, steps_, memory_);
+                result = interpreter.call(callee, arguments);
+            } catch (Abort const &) {
+                // the evaluation fails with the same limits next time
+                callKey(callee, arguments, key);
+                cache_[key] = {false, Scalar(), 0};
+                return node;
+            }
+            // the value must have the type the generated code would give it
+            std::shared_ptr<Value> value = literal(result);
+            if (value == nullptr || result.type != call->type() ||
+                result.type != callee->type()) {
+                return node;
+            }
+            ++evaluated_;
+            return std::static_pointer_cast<Node>(value);
+        });
+    }
+}
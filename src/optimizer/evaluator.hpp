@@ -0,0 +1,66 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+#include "ast/program.hpp"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * @brief  Compile-time evaluation of the calls of pure functions which
+ *         arguments are constants. The body of the function is interpreted on
+ *         the AST, and the call is replaced by the value it returns.
+ *
+ *         The interpreter follows the semantic of the generated code, and the
+ *         evaluation is abandoned (the call is kept) as soon as it can't be
+ *         reproduced exactly: integer overflow, error raised by python, too
+ *         many steps, too much memory allocated for the arrays or too deep
+ *         recursion.
+ *
+ * NOTE: the results of the calls are cached, so the recursive functions like
+ *       `fib` are evaluated in linear time.
+ */
+class CompileTimeEvaluator {
+  public:
+    /**
+     * @brief  `steps` is the maximal number of nodes evaluated for one call,
+     *         and `memory` the maximal number of array elements it allocates.
+     */
+    CompileTimeEvaluator(size_t steps, size_t memory = 1000000)
+        : steps_(steps), memory_(memory) {}
+
+    void optimize(std::shared_ptr<Program> program);
+
+    /**
+     * @brief  Number of calls replaced by their value so far.
+     */
+    size_t evaluated() const { return evaluated_; }
+
+    /**
+     * @brief  Scalar value of the interpreter (`NIL` is `None`).
+     */
+    struct Scalar {
+        PrimitiveType type = NIL;
+        long long i = 0;
+        double f = 0;
+        char c = 0;
+    };
+
+    /**
+     * @brief  Cached result of a call, with the depth of the recursion needed
+     *         to compute it (`valid` is false when the evaluation failed).
+     */
+    struct Result {
+        bool valid;
+        Scalar value;
+        size_t depth;
+    };
+
+  private:
+    size_t steps_;
+    size_t memory_;
+    size_t evaluated_ = 0;
+    std::map<std::string, Result> cache_ = {};
+};
+
+#endif
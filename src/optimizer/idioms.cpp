@@ -0,0 +1,521 @@
+#include "optimizer/idioms.hpp"
+#include "ast/python.hpp"
+#include "optimizer/analysis.hpp"
+#include <list>
+#include <vector>
+
+/******************************************************************************/
+/*                                  helpers                                   */
+/******************************************************************************/
+
+static std::shared_ptr<Value> intValue(long long value) {
+    LiteralValue literal;
+    literal._int = value;
+    return std::make_shared<Value>(literal, INT);
+}
+
+/**
+ * @brief  Reference to the scalar variable `id`.
+ */
+static bool isScalar(std::shared_ptr<Node> const &node, std::string const &id) {
+    auto variable = std::dynamic_pointer_cast<Variable>(node);
+    return variable != nullptr && !std::dynamic_pointer_cast<Array>(node) &&
+           !isArray(variable->type()) && variable->id() == id;
+}
+
+/**
+ * @brief  Arithmetic on constants and scalar variables: it has no effect and
+ *         its value only depends on the variables.
+ */
+static bool isSimple(std::shared_ptr<Node> const &node) {
+    bool simple = true;
+
+    visit(node, [&](std::shared_ptr<Node> const &n) {
+        auto variable = std::dynamic_pointer_cast<Variable>(n);
+        if (variable != nullptr) {
+            simple = simple && isScalar(n, variable->id());
+        } else if (!isConstant(n) && !std::dynamic_pointer_cast<AddOP>(n) &&
+                   !std::dynamic_pointer_cast<MnsOP>(n) &&
+                   !std::dynamic_pointer_cast<TmsOP>(n) &&
+                   !std::dynamic_pointer_cast<DivOP>(n)) {
+            simple = false;
+        }
+    });
+    return simple;
+}
+
+/**
+ * @brief  Variables of a simple expression.
+ */
+static std::set<std::string> variables(std::shared_ptr<Node> const &node) {
+    std::set<std::string> variables;
+
+    visit(node, [&](std::shared_ptr<Node> const &n) {
+        if (auto variable = std::dynamic_pointer_cast<Variable>(n)) {
+            variables.insert(variable->id());
+        }
+    });
+    return variables;
+}
+
+/**
+ * @brief  Key of a simple expression, two expressions with the same key have
+ *         the same value.
+ */
+static std::string key(std::shared_ptr<Node> const &node) {
+    std::string key;
+
+    visit(node, [&](std::shared_ptr<Node> const &n) {
+        if (auto value = std::dynamic_pointer_cast<Value>(n)) {
+            switch (value->type()) {
+            case INT:
+                key += "i" + std::to_string(value->value()._int);
+                break;
+            case FLT:
+                key += "f" + floatLiteral(value->value()._flt);
+                break;
+            default:
+                key += "c" + std::to_string((int)value->value()._chr);
+                break;
+            }
+        } else if (auto variable = std::dynamic_pointer_cast<Variable>(n)) {
+            key += "v" + variable->id();
+        } else if (std::dynamic_pointer_cast<AddOP>(n)) {
+            key += "+";
+        } else if (std::dynamic_pointer_cast<MnsOP>(n)) {
+            key += "-";
+        } else if (std::dynamic_pointer_cast<TmsOP>(n)) {
+            key += "*";
+        } else {
+            key += "/";
+        }
+        key += " ";
+    });
+    return key;
+}
+
+/**
+ * @brief  Variables used by statements. The calls, the input and output and
+ *         the returns fix the statements in place.
+ */
+struct Effects {
+    std::set<std::string> written = {}; //< scalars written
+    std::set<std::string> used = {};    //< scalars read or written
+    std::set<std::string> arrays = {};  //< arrays written
+    bool fixed = false;
+};
+
+static void findEffects(std::shared_ptr<Node> const &root, Effects &effects) {
+    visit(root, [&](std::shared_ptr<Node> const &node) {
+        std::shared_ptr<Variable> target = nullptr;
+
+        if (auto assignment = std::dynamic_pointer_cast<Assignment>(node)) {
+            target = assignment->variable();
+        } else if (auto read = std::dynamic_pointer_cast<Read>(node)) {
+            target = std::dynamic_pointer_cast<Variable>(read->variable());
+            effects.fixed = true;
+        } else if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+            effects.written.insert(loop->variable().id());
+            effects.used.insert(loop->variable().id());
+        } else if (std::dynamic_pointer_cast<Print>(node) ||
+                   std::dynamic_pointer_cast<FunctionCall>(node) ||
+                   std::dynamic_pointer_cast<Return>(node)) {
+            effects.fixed = true;
+        } else if (auto variable = std::dynamic_pointer_cast<Variable>(node)) {
+            if (isScalar(node, variable->id())) {
+                effects.used.insert(variable->id());
+            }
+        }
+        if (target == nullptr) {
+            return;
+        } else if (isScalar(target, target->id())) {
+            effects.written.insert(target->id());
+        } else {
+            effects.arrays.insert(target->id());
+        }
+    });
+}
+
+/**
+ * @brief  Arrays used in a loop, the irregular ones are not only accessed at
+ *         the index of the loop.
+ */
+struct Accesses {
+    std::set<std::string> arrays = {};
+    std::set<std::string> irregular = {};
+};
+
+static Accesses findAccesses(std::shared_ptr<Node> const &root,
+                             std::string const &index) {
+    Accesses accesses;
+
+    visit(root, [&](std::shared_ptr<Node> const &node) {
+        auto variable = std::dynamic_pointer_cast<Variable>(node);
+        if (std::dynamic_pointer_cast<ArrayAccess>(node)) {
+            accesses.arrays.insert(variable->id());
+            if (!isElement(node, index)) {
+                accesses.irregular.insert(variable->id());
+            }
+        } else if (variable != nullptr && !isScalar(node, variable->id())) {
+            accesses.arrays.insert(variable->id());
+            accesses.irregular.insert(variable->id());
+        }
+    });
+    return accesses;
+}
+
+/**
+ * @brief  Step of the statement `set(i, add(i, k))` (or `mns(i, k)`), 0 when
+ *         the statement is not an increment of `counter`.
+ */
+static long long increment(std::shared_ptr<Node> const &statement,
+                           std::string const &counter) {
+    auto assignment = std::dynamic_pointer_cast<Assignment>(statement);
+    if (assignment == nullptr ||
+        !isScalar(assignment->variable(), counter)) {
+        return 0;
+    }
+    auto operation =
+            std::dynamic_pointer_cast<BinaryOperation>(assignment->value());
+    bool add = std::dynamic_pointer_cast<AddOP>(operation) != nullptr;
+    bool mns = std::dynamic_pointer_cast<MnsOP>(operation) != nullptr;
+    if (!add && !mns) {
+        return 0;
+    }
+    std::shared_ptr<Node> step = operation->right();
+    if (add && isScalar(operation->right(), counter)) {
+        step = operation->left();
+    } else if (!isScalar(operation->left(), counter)) {
+        return 0;
+    }
+    auto value = std::dynamic_pointer_cast<Value>(step);
+    if (value == nullptr || value->type() != INT) {
+        return 0;
+    }
+    return add ? value->value()._int : -value->value()._int;
+}
+
+/******************************************************************************/
+/*                               counted loops                                */
+/******************************************************************************/
+
+/**
+ * @brief  `whl (inf(i, n)) bgn ... set(i, add(i, k)) end` becomes
+ *         `for i rng(i, n, k) bgn ... end` when `i` and `n` are not modified
+ *         by the other statements of the loop. `for` leaves the last value
+ *         of the range in `i`, so `cnd inf(i, n) bgn set(i, add(i, k)) end`
+ *         gives the value that stopped the `whl`.
+ */
+void LoopIdioms::count(std::shared_ptr<Block> const &block) {
+    std::list<std::shared_ptr<Node>> instructions;
+    bool changed = false;
+
+    for (std::shared_ptr<Node> const &instruction : block->instructions()) {
+        instructions.push_back(instruction);
+        auto loop = std::dynamic_pointer_cast<Whl>(instruction);
+        if (loop == nullptr) {
+            continue;
+        }
+        auto condition =
+                std::dynamic_pointer_cast<BinaryOperation>(loop->condition());
+        auto inf = std::dynamic_pointer_cast<InfOP>(condition);
+        auto ieq = std::dynamic_pointer_cast<IeqOP>(condition);
+        auto sup = std::dynamic_pointer_cast<SupOP>(condition);
+        auto seq = std::dynamic_pointer_cast<SeqOP>(condition);
+        if (!inf && !ieq && !sup && !seq) {
+            continue;
+        }
+        auto counter = std::dynamic_pointer_cast<Variable>(condition->left());
+        auto end = std::dynamic_pointer_cast<TypedNode>(condition->right());
+        if (counter == nullptr || !isScalar(counter, counter->id()) ||
+            counter->type() != INT || end == nullptr || end->type() != INT ||
+            !isSimple(end) || variables(end).count(counter->id())) {
+            continue;
+        }
+        std::list<std::shared_ptr<Node>> body = loop->block()->instructions();
+        long long step =
+                body.empty() ? 0 : increment(body.back(), counter->id());
+        if (step == 0 || ((inf || ieq) && step < 0) ||
+            ((sup || seq) && step > 0)) {
+            continue;
+        }
+        std::shared_ptr<Node> last = body.back();
+        Effects effects;
+        body.pop_back();
+        for (std::shared_ptr<Node> const &statement : body) {
+            findEffects(statement, effects);
+        }
+        bool invariant = !effects.written.count(counter->id());
+        for (std::string const &variable : variables(end)) {
+            invariant = invariant && !effects.written.count(variable);
+        }
+        if (!invariant) {
+            continue;
+        }
+
+        // the range excludes its end
+        auto limit = std::dynamic_pointer_cast<TypedNode>(clone(end));
+        if (ieq) {
+            limit = std::make_shared<AddOP>(limit, intValue(1));
+        } else if (seq) {
+            limit = std::make_shared<MnsOP>(limit, intValue(1));
+        }
+        loop->block()->instructions(body);
+        std::shared_ptr<Block> fix = std::make_shared<Block>();
+        fix->add(last);
+        auto counted = std::make_shared<For>(
+                Variable(counter->id(), INT),
+                std::make_shared<Variable>(counter->id(), INT), limit,
+                intValue(step), loop->block());
+        // the loop keeps its counters in the profile
+        static_cast<Profiled &>(*counted) = *loop;
+        instructions.back() = counted;
+        instructions.push_back(std::make_shared<Cnd>(condition, fix));
+        changed = true;
+        ++counted_;
+    }
+    if (changed) {
+        block->instructions(instructions);
+    }
+}
+
+/******************************************************************************/
+/*                                   fusion                                   */
+/******************************************************************************/
+
+/**
+ * @brief  Two loops on the same range can be fused when:
+ *         - the range is not changed by the first loop,
+ *         - the loops don't call functions, print, read or return (the order
+ *           of the effects would change),
+ *         - a scalar written by a loop is not used by the other one,
+ *         - an array written by a loop and used by the other one (or an
+ *           array that may be an alias) is only accessed at the index of the
+ *           loop: the iteration `i` of the second loop only depends on the
+ *           iteration `i` of the first one, which is still before it.
+ */
+bool LoopIdioms::fusable(std::shared_ptr<For> const &first,
+                         std::shared_ptr<For> const &second) const {
+    std::string const &index = first->variable().id();
+    std::list<std::pair<std::shared_ptr<Node>, std::shared_ptr<Node>>> range =
+            {{first->begin(), second->begin()},
+             {first->end(), second->end()},
+             {first->step(), second->step()}};
+    Effects effects[2];
+
+    if (second->variable().id() != index) {
+        return false;
+    }
+    findEffects(first->block(), effects[0]);
+    findEffects(second->block(), effects[1]);
+    if (effects[0].fixed || effects[1].fixed) {
+        return false;
+    }
+    for (auto const &[expression, other] : range) {
+        if (!isSimple(expression) || key(expression) != key(other)) {
+            return false;
+        }
+        for (std::string const &variable : variables(expression)) {
+            if (variable == index || effects[0].written.count(variable)) {
+                return false;
+            }
+        }
+    }
+    for (int loop = 0; loop < 2; ++loop) {
+        for (std::string const &variable : effects[loop].written) {
+            if (variable != index && effects[1 - loop].used.count(variable)) {
+                return false;
+            }
+        }
+    }
+
+    Accesses accesses[2] = {findAccesses(first->block(), index),
+                            findAccesses(second->block(), index)};
+    for (std::string const &a : accesses[0].arrays) {
+        for (std::string const &b : accesses[1].arrays) {
+            bool alias = a == b || (!locals_.count(a) && !locals_.count(b));
+            bool written =
+                    effects[0].arrays.count(a) || effects[1].arrays.count(b);
+            bool irregular = accesses[0].irregular.count(a) ||
+                             accesses[1].irregular.count(b);
+            if (alias && written && irregular) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void LoopIdioms::fuse(std::shared_ptr<Block> const &block) {
+    std::list<std::shared_ptr<Node>> instructions;
+    bool changed = false;
+
+    for (std::shared_ptr<Node> const &instruction : block->instructions()) {
+        auto loop = std::dynamic_pointer_cast<For>(instruction);
+        auto previous = instructions.empty()
+                                ? nullptr
+                                : std::dynamic_pointer_cast<For>(
+                                          instructions.back());
+        if (loop != nullptr && previous != nullptr &&
+            fusable(previous, loop)) {
+            for (std::shared_ptr<Node> const &statement :
+                 loop->block()->instructions()) {
+                previous->block()->add(statement);
+            }
+            changed = true;
+            ++fused_;
+        } else {
+            instructions.push_back(instruction);
+        }
+    }
+    if (changed) {
+        block->instructions(instructions);
+    }
+}
+
+/******************************************************************************/
+/*                                reductions                                  */
+/******************************************************************************/
+
+/**
+ * @brief  Idiom of a loop on a range with a step of 1 and only one statement.
+ */
+For::Idiom LoopIdioms::idiom(std::shared_ptr<For> const &loop) const {
+    auto step = std::dynamic_pointer_cast<Value>(loop->step());
+    std::string const &index = loop->variable().id();
+
+    if (step == nullptr || step->type() != INT || step->value()._int != 1 ||
+        loop->block()->instructions().size() != 1) {
+        return For::LOOP;
+    }
+    std::shared_ptr<Node> statement = loop->block()->instructions().front();
+
+    // fill: set(t[i], v)
+    if (auto assignment = std::dynamic_pointer_cast<Assignment>(statement)) {
+        std::shared_ptr<Variable> target = assignment->variable();
+        std::shared_ptr<Node> value = assignment->value();
+        if (isElement(target, index)) {
+            return isSimple(value) && !variables(value).count(index)
+                           ? For::FILL
+                           : For::LOOP;
+        }
+
+        // sum: set(s, add(s, t[i]))
+        auto add = std::dynamic_pointer_cast<AddOP>(value);
+        if (!isScalar(target, target->id()) || target->id() == index ||
+            target->type() != INT || add == nullptr || add->type() != INT) {
+            return For::LOOP;
+        }
+        std::shared_ptr<Node> element = add->right();
+        if (!isScalar(add->left(), target->id())) {
+            element = add->left();
+            if (!isScalar(add->right(), target->id())) {
+                return For::LOOP;
+            }
+        }
+        auto access = std::dynamic_pointer_cast<ArrayAccess>(element);
+        return isElement(element, index) && access->type() == INT ? For::SUM
+                                                                  : For::LOOP;
+    }
+
+    // extremums: cnd inf(t[i], m) bgn set(m, t[i]) end
+    auto cnd = std::dynamic_pointer_cast<Cnd>(statement);
+    if (cnd == nullptr || cnd->elseBlock() != nullptr ||
+        cnd->block()->instructions().size() != 1) {
+        return For::LOOP;
+    }
+    auto condition =
+            std::dynamic_pointer_cast<BinaryOperation>(cnd->condition());
+    auto assignment = std::dynamic_pointer_cast<Assignment>(
+            cnd->block()->instructions().front());
+    bool inf = std::dynamic_pointer_cast<InfOP>(condition) != nullptr;
+    bool sup = std::dynamic_pointer_cast<SupOP>(condition) != nullptr;
+    if ((!inf && !sup) || assignment == nullptr) {
+        return For::LOOP;
+    }
+    std::shared_ptr<Variable> target = assignment->variable();
+    auto element = std::dynamic_pointer_cast<ArrayAccess>(assignment->value());
+    if (!isScalar(target, target->id()) || target->id() == index ||
+        !isElement(element, index) || element->type() != target->type() ||
+        (target->type() != INT && target->type() != FLT)) {
+        return For::LOOP;
+    }
+    auto same = [&](std::shared_ptr<Node> const &node) {
+        return isElement(node, index) &&
+               std::dynamic_pointer_cast<ArrayAccess>(node)->id() ==
+                       element->id();
+    };
+    if (same(condition->left()) && isScalar(condition->right(), target->id())) {
+        return inf ? For::MINIMUM : For::MAXIMUM;
+    } else if (isScalar(condition->left(), target->id()) &&
+               same(condition->right())) {
+        return inf ? For::MAXIMUM : For::MINIMUM;
+    }
+    return For::LOOP;
+}
+
+/******************************************************************************/
+/*                                  optimize                                  */
+/******************************************************************************/
+
+void LoopIdioms::optimize(std::shared_ptr<Program> program) {
+    // the idioms use the builtins `len` (see For::compileSliced), `sum`, `min`
+    // and `max`, a function of the program can hide them
+    hidden_.clear();
+    for (char const *builtin : {"len", "sum", "min", "max"}) {
+        if (defines(program, builtin)) {
+            hidden_.insert(builtin);
+        }
+    }
+    for (std::shared_ptr<Function> function : program->functions()) {
+        optimize(function);
+    }
+}
+
+void LoopIdioms::optimize(std::shared_ptr<Function> function) {
+    std::vector<std::shared_ptr<Block>> blocks;
+    std::set<std::string> hidden = hidden_;
+    std::map<std::string, int> sizes;
+
+    locals_ = localArrays(function);
+    // the parameters and the variables hide the builtins too
+    for (std::string const &name : localNames(function)) {
+        if (name == "len" || name == "sum" || name == "min" || name == "max") {
+            hidden.insert(name);
+        }
+    }
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        if (auto block = std::dynamic_pointer_cast<Block>(node)) {
+            blocks.push_back(block);
+        }
+    });
+    for (std::shared_ptr<Block> const &block : blocks) {
+        count(block);
+    }
+    // the inner loops are fused first, the blocks of the fused loops are not
+    // used after
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+        fuse(*it);
+    }
+    sizes = arraySizes(function);
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        auto loop = std::dynamic_pointer_cast<For>(node);
+        if (loop == nullptr || loop->idiom() != For::LOOP) {
+            return;
+        }
+        For::Idiom found = idiom(loop);
+        if ((found == For::SUM && hidden.count("sum")) ||
+            (found == For::MINIMUM && hidden.count("min")) ||
+            (found == For::MAXIMUM && hidden.count("max"))) {
+            found = For::LOOP;
+        }
+        // the bounds are checked with `len` when they are not known
+        bool known = inBounds(loop, sizes);
+        if (!known && hidden.count("len")) {
+            found = For::LOOP;
+        }
+        loop->idiom(found);
+        loop->inBounds(found != For::LOOP && known);
+        replaced_ += found != For::LOOP;
+    });
+}
@@ -0,0 +1,59 @@
+#ifndef IDIOMS_H
+#define IDIOMS_H
+#include "ast/program.hpp"
+#include <cstddef>
+#include <memory>
+#include <set>
+#include <string>
+
+/**
+ * @brief  Recognition of the common loops:
+ *         - a `whl` that counts with an integer variable (`whl (inf(i, n))`
+ *           ending with `set(i, add(i, 1))`) becomes a `for` on a range, a
+ *           `cnd` after the loop gives the last value of the counter,
+ *         - two adjacent `for` on the same range are fused when the
+ *           iterations of the second loop don't depend on the next iterations
+ *           of the first one,
+ *         - the sums of integers (`set(s, add(s, t[i]))`), the minimums and
+ *           the maximums (`cnd inf(t[i], m) bgn set(m, t[i]) end`) and the
+ *           fills (`set(t[i], v)`) on a range are computed by `sum`, `min`,
+ *           `max` or a slice assignment (see For::compile).
+ *
+ * NOTE: the sums of floats are not replaced, python's `sum` would not give
+ *       the same rounding.
+ */
+class LoopIdioms {
+  public:
+    void optimize(std::shared_ptr<Program> program);
+    void optimize(std::shared_ptr<Function> function);
+
+    /**
+     * @brief  Number of `whl` loops replaced by a `for`.
+     */
+    size_t counted() const { return counted_; }
+
+    /**
+     * @brief  Number of loops fused with the previous one.
+     */
+    size_t fused() const { return fused_; }
+
+    /**
+     * @brief  Number of loops replaced by a builtin or a slice assignment.
+     */
+    size_t replaced() const { return replaced_; }
+
+  private:
+    void count(std::shared_ptr<Block> const &block);
+    void fuse(std::shared_ptr<Block> const &block);
+    bool fusable(std::shared_ptr<For> const &first,
+                 std::shared_ptr<For> const &second) const;
+    For::Idiom idiom(std::shared_ptr<For> const &loop) const;
+
+    std::set<std::string> locals_ = {}; //< local arrays of the function
+    std::set<std::string> hidden_ = {}; //< builtins hidden by a function
+    size_t counted_ = 0;
+    size_t fused_ = 0;
+    size_t replaced_ = 0;
+};
+
+#endif
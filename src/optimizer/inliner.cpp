@@ -0,0 +1,449 @@
+#include "optimizer/inliner.hpp"
+#include "optimizer/analysis.hpp"
+#include "optimizer/callgraph.hpp"
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+using Arguments = std::map<std::string, std::shared_ptr<Node>>;
+
+/******************************************************************************/
+/*                                  analysis                                  */
+/******************************************************************************/
+
+/**
+ * @brief  The `ret` statements are always the last instruction of their block.
+ *         The body of a function can be inlined when they are all in tail
+ *         position: at the end of the function, or at the end of the branches
+ *         of a `cnd` in tail position. Then, the function ends right after any
+ *         `ret`, so they can be replaced by assignments of the result.
+ *         The returned values must also have the return type of the function
+ *         (otherwise they are converted by the `ret`).
+ *
+ * @param  block     Body of the function.
+ * @param  complete  Set to true when all the paths end with a `ret`.
+ */
+static bool hasTailReturns(std::shared_ptr<Block> block, bool &complete) {
+    std::vector<std::shared_ptr<Block>> blocks = {block};
+    size_t returns = 0;
+    size_t tailReturns = 0;
+    bool converted = false;
+
+    visit(block, [&](std::shared_ptr<Node> const &node) {
+        if (auto ret = std::dynamic_pointer_cast<Return>(node)) {
+            auto value =
+                std::dynamic_pointer_cast<TypedNode>(ret->returnExpr());
+            converted = converted || value->type() != ret->type();
+            ++returns;
+        }
+    });
+    if (converted) {
+        return false;
+    }
+    complete = true;
+    while (!blocks.empty()) {
+        std::shared_ptr<Block> current = std::move(blocks.back());
+        blocks.pop_back();
+        std::shared_ptr<Node> last = current->instructions().empty()
+                                         ? nullptr
+                                         : current->instructions().back();
+
+        if (std::dynamic_pointer_cast<Return>(last)) {
+            ++tailReturns;
+        } else if (auto cnd = std::dynamic_pointer_cast<Cnd>(last)) {
+            blocks.push_back(cnd->block());
+            if (cnd->elseBlock() != nullptr) {
+                blocks.push_back(cnd->elseBlock());
+            } else {
+                complete = false;
+            }
+        } else {
+            complete = false;
+        }
+    }
+    return returns == tailReturns;
+}
+
+/**
+ * @brief  Scalar variables written in `root` (assigned, read with `ipt` or used
+ *         as loop variable).
+ */
+static std::set<std::string> writtenVariables(std::shared_ptr<Node> root) {
+    std::set<std::string> written;
+
+    visit(root, [&](std::shared_ptr<Node> const &node) {
+        std::shared_ptr<TypedNode> target = nullptr;
+
+        if (auto assignment = std::dynamic_pointer_cast<Assignment>(node)) {
+            target = assignment->variable();
+        } else if (auto read = std::dynamic_pointer_cast<Read>(node)) {
+            target = read->variable();
+        } else if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+            written.insert(loop->variable().id());
+        }
+        auto variable = std::dynamic_pointer_cast<Variable>(target);
+        if (variable && !std::dynamic_pointer_cast<ArrayAccess>(target)) {
+            written.insert(variable->id());
+        }
+    });
+    return written;
+}
+
+/**
+ * @brief  The simple arguments (constants and variables) can be substituted to
+ *         the parameters: they can be evaluated several times, and later than
+ *         in the call.
+ */
+static bool isSimple(std::shared_ptr<Node> const &argument) {
+    return isConstant(argument) ||
+           (std::dynamic_pointer_cast<Variable>(argument) &&
+            !std::dynamic_pointer_cast<ArrayAccess>(argument));
+}
+
+/**
+ * @brief  The `ret expression` statement when it's the only instruction of the
+ *         function (declarations aside), nullptr otherwise.
+ */
+static std::shared_ptr<Return>
+singleReturn(std::shared_ptr<Function> function) {
+    std::shared_ptr<Return> result = nullptr;
+
+    for (std::shared_ptr<Node> const &node :
+         function->block()->instructions()) {
+        if (std::dynamic_pointer_cast<Declaration>(node)) {
+            continue;
+        } else if (result != nullptr) {
+            return nullptr;
+        }
+        result = std::dynamic_pointer_cast<Return>(node);
+        if (result == nullptr) {
+            return nullptr;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief  Replace the parameters by the arguments, and rename the other
+ *         variables by adding `prefix` to their name.
+ *
+ * @return  The new root.
+ */
+static std::shared_ptr<Node> substitute(std::shared_ptr<Node> const &root,
+                                        std::string const &prefix,
+                                        Arguments const &arguments) {
+    // the shared nodes are traversed once per parent, they are renamed once
+    std::unordered_set<Node *> renamed;
+
+    return rewrite(root, [&](std::shared_ptr<Node> const &node) {
+        if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+            Variable variable = loop->variable();
+            variable.id(prefix + variable.id());
+            loop->variable(variable);
+        } else if (auto declaration =
+                       std::dynamic_pointer_cast<Declaration>(node)) {
+            Variable variable = declaration->variable();
+            variable.id(prefix + variable.id());
+            declaration->variable(variable);
+        }
+        auto variable = std::dynamic_pointer_cast<Variable>(node);
+        if (variable == nullptr) {
+            return node;
+        }
+        auto it = arguments.find(variable->id());
+        if (it == arguments.end()) {
+            if (renamed.insert(node.get()).second) {
+                variable->id(prefix + variable->id());
+            }
+            return node;
+        } else if (std::dynamic_pointer_cast<ArrayAccess>(node)) {
+            // array parameter, the argument is the array variable
+            if (renamed.insert(node.get()).second) {
+                variable->id(
+                    std::dynamic_pointer_cast<Variable>(it->second)->id());
+            }
+            return node;
+        }
+        return isSimple(it->second) ? clone(it->second) : it->second;
+    });
+}
+
+/**
+ * @brief  Without profile, the functions under the threshold are inlined. With
+ *         a profile, a call site that never ran is left as is, and the larger
+ *         functions are inlined at the hot call sites.
+ */
+bool Inliner::worthInlining(std::shared_ptr<FunctionCall> const &call,
+                            Callee const &callee) const {
+    auto it = frequencies_.find(call.get());
+    if (it == frequencies_.end()) {
+        return callee.size <= threshold_;
+    } else if (it->second == 0) {
+        return false;
+    }
+    return callee.size <= (profile_->hot(it->second) ? threshold_ * HOT_FACTOR
+                                                     : threshold_);
+}
+
+/******************************************************************************/
+/*                                expressions                                 */
+/******************************************************************************/
+
+/**
+ * @brief  Replace a call to a function which body is `ret expression` by the
+ *         expression. The arguments that are not simple must be used exactly
+ *         once in a pure expression (so their evaluation order doesn't
+ *         matter), and at most one of them can call a function.
+ *
+ * @return  The expression or nullptr if the call can't be inlined.
+ */
+std::shared_ptr<Node>
+Inliner::inlineExpression(std::shared_ptr<FunctionCall> call) {
+    auto it = callees_.find(call->functionName());
+    if (it == callees_.end()) {
+        return nullptr;
+    }
+    std::shared_ptr<Function> callee = it->second.function;
+    std::shared_ptr<Return> ret = singleReturn(callee);
+    if (ret == nullptr || !worthInlining(call, it->second) ||
+        callee->parameters().size() != call->params().size()) {
+        return nullptr;
+    }
+    std::map<std::string, int> uses;
+    visit(ret->returnExpr(), [&](std::shared_ptr<Node> const &node) {
+        if (auto variable = std::dynamic_pointer_cast<Variable>(node)) {
+            uses[variable->id()]++;
+        }
+    });
+
+    bool pure = isPure(ret->returnExpr());
+    int impureArguments = 0;
+    Arguments arguments;
+    auto argument = call->params().begin();
+    for (Variable const &parameter : callee->parameters()) {
+        std::shared_ptr<Node> value = *argument++;
+        int count = uses[parameter.id()];
+
+        auto typed = std::dynamic_pointer_cast<TypedNode>(value);
+        if (isArray(parameter.type()) &&
+            !std::dynamic_pointer_cast<Variable>(value)) {
+            return nullptr;
+        } else if (!isArray(parameter.type()) &&
+                   (typed == nullptr || typed->type() != parameter.type())) {
+            // the argument would need a conversion to the parameter type
+            return nullptr;
+        } else if (!isSimple(value)) {
+            if (!isPure(value)) {
+                ++impureArguments;
+            }
+            if (count > 1 || (count == 1 && !pure) ||
+                (count == 0 && !isPure(value)) || impureArguments > 1) {
+                return nullptr;
+            }
+        }
+        arguments[parameter.id()] = value;
+    }
+    ++inlined_;
+    return substitute(clone(ret->returnExpr()), "", arguments);
+}
+
+/******************************************************************************/
+/*                                 statements                                 */
+/******************************************************************************/
+
+/**
+ * @brief  Inline the call of a statement `f(...)`, `set(x, f(...))` or
+ *         `ret f(...)`. The arguments are assigned to new variables (the
+ *         simple ones are substituted when the parameter is never written),
+ *         then the body of the function follows, where the `ret` are replaced
+ *         depending on the statement.
+ *
+ * @param  statement     Statement of the caller.
+ * @param  instructions  The instructions that replace the statement.
+ *
+ * @return  true if the call has been inlined.
+ */
+bool Inliner::inlineStatement(std::shared_ptr<Node> statement,
+                              std::list<std::shared_ptr<Node>> &instructions) {
+    auto assignment = std::dynamic_pointer_cast<Assignment>(statement);
+    auto ret = std::dynamic_pointer_cast<Return>(statement);
+    std::shared_ptr<FunctionCall> call;
+
+    if (assignment != nullptr) {
+        call = std::dynamic_pointer_cast<FunctionCall>(assignment->value());
+    } else if (ret != nullptr) {
+        call = std::dynamic_pointer_cast<FunctionCall>(ret->returnExpr());
+    } else {
+        call = std::dynamic_pointer_cast<FunctionCall>(statement);
+    }
+    if (call == nullptr) {
+        return false;
+    }
+    auto it = callees_.find(call->functionName());
+    if (it == callees_.end() || (assignment && !it->second.complete)) {
+        return false;
+    }
+    std::shared_ptr<Function> callee = it->second.function;
+    if (callee->parameters().size() != call->params().size() ||
+        !worthInlining(call, it->second)) {
+        return false;
+    }
+    std::string prefix = "_" + callee->id() + "_" + std::to_string(++sites_) +
+                         "_";
+    std::set<std::string> written = writtenVariables(callee->block());
+    std::list<std::shared_ptr<Node>> bindings;
+    Arguments arguments;
+
+    auto argument = call->params().begin();
+    for (Variable const &parameter : callee->parameters()) {
+        std::shared_ptr<TypedNode> value = *argument++;
+
+        if (isArray(parameter.type())) {
+            if (!std::dynamic_pointer_cast<Variable>(value)) {
+                return false;
+            }
+            // the array is a reference, so it can be bound by assignment
+            if (!written.count(parameter.id())) {
+                arguments[parameter.id()] = value;
+                continue;
+            }
+        } else if (isSimple(value) && value->type() == parameter.type() &&
+                   !written.count(parameter.id())) {
+            arguments[parameter.id()] = value;
+            continue;
+        }
+        // the value is converted to the type of the parameter, like in a call
+        bindings.push_back(std::make_shared<Assignment>(
+            std::make_shared<Variable>(prefix + parameter.id(),
+                                       parameter.type()),
+            value));
+    }
+
+    auto body = std::dynamic_pointer_cast<Block>(
+        substitute(clone(callee->block()), prefix, arguments));
+    rewrite(body, [&](std::shared_ptr<Node> const &node) {
+        auto result = std::dynamic_pointer_cast<Return>(node);
+        if (result == nullptr) {
+            return node;
+        }
+        auto value = std::dynamic_pointer_cast<TypedNode>(result->returnExpr());
+        if (ret != nullptr) {
+            // the value is converted to the return type of the caller
+            return std::static_pointer_cast<Node>(
+                std::make_shared<Return>(value, ret->type()));
+        } else if (assignment != nullptr) {
+            auto target = std::dynamic_pointer_cast<Variable>(
+                clone(assignment->variable()));
+            return std::static_pointer_cast<Node>(
+                std::make_shared<Assignment>(target, value));
+        } else if (isPure(value)) {
+            return std::shared_ptr<Node>(nullptr);
+        } else if (std::dynamic_pointer_cast<FunctionCall>(value)) {
+            return std::static_pointer_cast<Node>(value);
+        }
+        // the result is not used but its evaluation has side effects
+        return std::static_pointer_cast<Node>(std::make_shared<Assignment>(
+            std::make_shared<Variable>(prefix + "result", NIL), value));
+    });
+
+    instructions.splice(instructions.end(), bindings);
+    instructions.insert(instructions.end(), body->instructions().begin(),
+                        body->instructions().end());
+    ++inlined_;
+    return true;
+}
+
+/******************************************************************************/
+/*                                    pass                                    */
+/******************************************************************************/
+
+/**
+ * @brief  Inline the calls of the function `caller`. The calls in expressions
+ *         are treated first, then the blocks are rebuilt to replace the
+ *         statements.
+ */
+void Inliner::inlineCalls(std::shared_ptr<Function> caller) {
+    std::unordered_set<Node *> statements;
+
+    if (profile_ != nullptr && profile_->used()) {
+        frequencies_ = profile_->frequencies(caller);
+    }
+
+    visit(caller->block(), [&](std::shared_ptr<Node> const &node) {
+        if (auto block = std::dynamic_pointer_cast<Block>(node)) {
+            for (std::shared_ptr<Node> const &instruction :
+                 block->instructions()) {
+                statements.insert(instruction.get());
+            }
+        }
+    });
+    rewrite(caller->block(), [&](std::shared_ptr<Node> const &node) {
+        auto call = std::dynamic_pointer_cast<FunctionCall>(node);
+        if (call == nullptr || statements.count(node.get())) {
+            return node;
+        }
+        std::shared_ptr<Node> expression = inlineExpression(call);
+        return expression != nullptr ? expression : node;
+    });
+
+    std::vector<std::shared_ptr<Block>> blocks = {caller->block()};
+    while (!blocks.empty()) {
+        std::shared_ptr<Block> block = std::move(blocks.back());
+        blocks.pop_back();
+        std::list<std::shared_ptr<Node>> instructions;
+        std::vector<std::shared_ptr<Node>> replaced;
+
+        for (std::shared_ptr<Node> const &node : block->instructions()) {
+            if (inlineStatement(node, instructions)) {
+                replaced.push_back(node);
+                continue;
+            }
+            instructions.push_back(node);
+            for (std::shared_ptr<Node> const &child : node->children()) {
+                if (auto nested = std::dynamic_pointer_cast<Block>(child)) {
+                    blocks.push_back(nested);
+                }
+            }
+        }
+        if (!replaced.empty()) {
+            block->instructions(instructions);
+            for (std::shared_ptr<Node> &node : replaced) {
+                release(std::move(node));
+            }
+        }
+    }
+}
+
+/**
+ * @brief  The functions are treated from the callees to the callers, so the
+ *         inlined bodies are already optimized.
+ */
+void Inliner::optimize(std::shared_ptr<Program> program) {
+    std::map<std::string, std::shared_ptr<Function>> functions;
+    CallGraph graph(program);
+
+    if (threshold_ == 0) {
+        return;
+    }
+    for (std::shared_ptr<Function> function : program->functions()) {
+        functions[function->id()] = function;
+    }
+    // the hot call sites accept larger functions
+    size_t limit = threshold_;
+    if (profile_ != nullptr && profile_->used()) {
+        limit = threshold_ * HOT_FACTOR;
+    }
+    for (std::string const &name : graph.bottomUp()) {
+        std::shared_ptr<Function> function = functions[name];
+        bool complete;
+
+        inlineCalls(function);
+        size_t size = countNodes(function->block());
+        // the native functions are called from python (see NativeSelector)
+        if (!graph.isRecursive(name) && name != "main" && size <= limit &&
+            !function->native() &&
+            hasTailReturns(function->block(), complete)) {
+            callees_[name] = {function, complete, size};
+        }
+    }
+}
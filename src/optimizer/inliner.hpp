@@ -0,0 +1,69 @@
+#ifndef INLINER_H
+#define INLINER_H
+#include "ast/program.hpp"
+#include "optimizer/profile.hpp"
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief  Function inlining. The calls to the small non-recursive functions
+ *         are replaced by the body of the function:
+ *         - when the body is just `ret expression`, the call is replaced by the
+ *           expression anywhere,
+ *         - otherwise, the calls used as statement, assigned (`set(x, f())`)
+ *           or returned (`ret f()`) are replaced by the instructions of the
+ *           function. The local variables are renamed and the `ret` are
+ *           transformed in assignments of the result.
+ *
+ *         The size of a function is its number of AST nodes, and only the
+ *         functions which size is under the threshold are inlined. With a
+ *         profile (see Profile), the threshold is multiplied by HOT_FACTOR at
+ *         the hot call sites, and the call sites that never ran are not
+ *         inlined.
+ */
+class Inliner {
+  public:
+    static constexpr size_t HOT_FACTOR = 4;
+
+    Inliner(size_t threshold, Profile const *profile = nullptr)
+        : threshold_(threshold), profile_(profile) {}
+
+    void optimize(std::shared_ptr<Program> program);
+
+    /**
+     * @brief  Number of calls inlined so far.
+     */
+    size_t inlined() const { return inlined_; }
+
+  private:
+    /**
+     * @brief  Function that can be inlined. `complete` is true when all the
+     *         paths of its body end with a `ret`.
+     */
+    struct Callee {
+        std::shared_ptr<Function> function;
+        bool complete;
+        size_t size;
+    };
+
+    bool worthInlining(std::shared_ptr<FunctionCall> const &call,
+                       Callee const &callee) const;
+    void inlineCalls(std::shared_ptr<Function> caller);
+    std::shared_ptr<Node> inlineExpression(std::shared_ptr<FunctionCall> call);
+    bool inlineStatement(std::shared_ptr<Node> statement,
+                         std::list<std::shared_ptr<Node>> &instructions);
+
+    size_t threshold_;
+    Profile const *profile_;
+    size_t inlined_ = 0;
+    size_t sites_ = 0; //< used to rename the local variables
+    std::map<std::string, Callee> callees_ = {};
+    // frequencies of the nodes of the caller in the profile
+    std::unordered_map<Node const *, size_t> frequencies_ = {};
+};
+
+#endif
@@ -0,0 +1,484 @@
+#include "optimizer/licm.hpp"
+#include "optimizer/analysis.hpp"
+#include "optimizer/purity.hpp"
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/******************************************************************************/
+/*                                   writes                                   */
+/******************************************************************************/
+
+/**
+ * @brief  Variables and arrays modified in a loop. The arrays given to a
+ *         function that is not pure may be modified by the call.
+ */
+struct Writes {
+    std::set<std::string> scalars;
+    std::set<std::string> arrays;
+};
+
+/**
+ * @brief  Add the writes done by `node` (not by its sub-nodes).
+ */
+static void addWrites(std::shared_ptr<Node> const &node, Writes &writes,
+                      std::set<std::string> const &pure) {
+    std::shared_ptr<Variable> target = nullptr;
+
+    if (auto assignment = std::dynamic_pointer_cast<Assignment>(node)) {
+        target = assignment->variable();
+    } else if (auto read = std::dynamic_pointer_cast<Read>(node)) {
+        target = std::dynamic_pointer_cast<Variable>(read->variable());
+    } else if (auto forLoop = std::dynamic_pointer_cast<For>(node)) {
+        writes.scalars.insert(forLoop->variable().id());
+    } else if (auto call = std::dynamic_pointer_cast<FunctionCall>(node)) {
+        if (pure.count(call->functionName())) {
+            return;
+        }
+        for (std::shared_ptr<TypedNode> const &param : call->params()) {
+            auto array = std::dynamic_pointer_cast<Variable>(param);
+            if (array != nullptr && isArray(array->type())) {
+                writes.arrays.insert(array->id());
+            }
+        }
+    }
+    if (target == nullptr) {
+        return;
+    } else if (std::dynamic_pointer_cast<ArrayAccess>(target) ||
+               isArray(target->type())) {
+        writes.arrays.insert(target->id());
+    } else {
+        writes.scalars.insert(target->id());
+    }
+}
+
+/**
+ * @brief  An array may be modified in the loop when it's written directly, or
+ *         when it may be an alias of a written array (only the local arrays
+ *         are known to be distinct).
+ */
+static bool mayChange(std::string const &array, Writes const &writes,
+                      std::set<std::string> const &locals) {
+    if (writes.arrays.count(array)) {
+        return true;
+    } else if (locals.count(array)) {
+        return false;
+    }
+    for (std::string const &written : writes.arrays) {
+        if (!locals.count(written)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/******************************************************************************/
+/*                                expressions                                 */
+/******************************************************************************/
+
+static bool isNumeric(std::shared_ptr<Node> const &node) {
+    auto typed = std::dynamic_pointer_cast<TypedNode>(node);
+    return typed != nullptr && (typed->type() == INT || typed->type() == FLT);
+}
+
+/**
+ * @brief  Expressions that are worth a temporary.
+ */
+static bool isHoistable(std::shared_ptr<Node> const &node) {
+    return std::dynamic_pointer_cast<AddOP>(node) ||
+           std::dynamic_pointer_cast<MnsOP>(node) ||
+           std::dynamic_pointer_cast<TmsOP>(node) ||
+           std::dynamic_pointer_cast<DivOP>(node) ||
+           std::dynamic_pointer_cast<FunctionCall>(node) ||
+           std::dynamic_pointer_cast<ArrayAccess>(node);
+}
+
+/**
+ * @brief  A `for` loop with constant bounds that runs at least once.
+ */
+static bool alwaysRuns(std::shared_ptr<For> const &loop) {
+    auto begin = std::dynamic_pointer_cast<Value>(loop->begin());
+    auto end = std::dynamic_pointer_cast<Value>(loop->end());
+    auto step = std::dynamic_pointer_cast<Value>(loop->step());
+
+    if (begin == nullptr || end == nullptr || step == nullptr ||
+        begin->type() != INT || end->type() != INT || step->type() != INT) {
+        return false;
+    }
+    long long b = begin->value()._int;
+    long long e = end->value()._int;
+    long long s = step->value()._int;
+    return (s > 0 && b < e) || (s < 0 && b > e);
+}
+
+/******************************************************************************/
+/*                                   loops                                    */
+/******************************************************************************/
+
+/**
+ * @brief  A loop of the function. The writes of a loop include the writes of
+ *         the loops it contains, so the writes of the enclosing loops are
+ *         supersets of each other.
+ */
+struct Loop {
+    std::shared_ptr<Block> block = nullptr; //< block where the loop is
+    Writes writes = {};
+    std::unordered_map<Node *, std::shared_ptr<Variable>> temporaries = {};
+    std::list<std::shared_ptr<Node>> assignments = {};
+};
+
+/**
+ * @brief  Level and safety of an expression (see analyze).
+ */
+struct Invariance {
+    size_t level;
+    bool safe;
+};
+
+/**
+ * @brief  State of the pass on a function. The chain is the list of the loops
+ *         that contain the current node, from the outermost.
+ */
+struct LoopNest {
+    std::set<std::string> const &pure;
+    std::set<std::string> locals; //< local arrays of the function
+    std::unordered_map<Node *, Loop> loops = {};
+    std::unordered_map<Node *, Invariance> invariances = {};
+    std::vector<Node *> chain = {};
+};
+
+static bool isLoop(std::shared_ptr<Node> const &node) {
+    return std::dynamic_pointer_cast<For>(node) ||
+           std::dynamic_pointer_cast<Whl>(node);
+}
+
+/**
+ * @brief  Find the loops of the function and their writes in one traversal:
+ *         the writes of a node go to the innermost loop, and the writes of a
+ *         loop are merged in the enclosing one when it's left.
+ */
+static void findLoops(LoopNest &context,
+                      std::shared_ptr<Function> const &function) {
+    struct Item {
+        std::shared_ptr<Node> node;
+        bool leave;
+    };
+    std::vector<Item> stack = {{function->block(), false}};
+    std::vector<Loop *> open;
+
+    while (!stack.empty()) {
+        Item item = std::move(stack.back());
+        stack.pop_back();
+
+        if (item.node == nullptr) {
+            continue;
+        } else if (item.leave) {
+            Loop *loop = open.back();
+            open.pop_back();
+            if (!open.empty()) {
+                Writes &outer = open.back()->writes;
+                outer.scalars.insert(loop->writes.scalars.begin(),
+                                     loop->writes.scalars.end());
+                outer.arrays.insert(loop->writes.arrays.begin(),
+                                    loop->writes.arrays.end());
+            }
+            continue;
+        }
+        if (isLoop(item.node)) {
+            open.push_back(&context.loops[item.node.get()]);
+            stack.push_back({item.node, true});
+        }
+        if (!open.empty()) {
+            addWrites(item.node, open.back()->writes, context.pure);
+        }
+        std::list<std::shared_ptr<Node>> children = item.node->children();
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            stack.push_back({*it, false});
+        }
+    }
+}
+
+/******************************************************************************/
+/*                                 invariance                                 */
+/******************************************************************************/
+
+/**
+ * @brief  First loop of the chain from which `written` is false. `written`
+ *         is true on the outer loops and false on the inner ones (the writes
+ *         of the enclosing loops include each other), so the loop is found
+ *         with a binary search.
+ */
+static size_t firstUnwritten(size_t depth,
+                             std::function<bool(size_t)> const &written) {
+    size_t low = 0;
+    size_t high = depth;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (written(middle)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief  Analyze an expression in post-order. The level of an expression is
+ *         the first loop of the chain from which it's invariant (`depth` when
+ *         it's not invariant), an expression is safe when it can't fail.
+ *         The results are kept, so each expression is analyzed once.
+ */
+static Invariance const &analyze(LoopNest &context,
+                                 std::shared_ptr<Node> const &root,
+                                 size_t depth) {
+    struct Item {
+        std::shared_ptr<Node> node;
+        bool expanded;
+    };
+    std::vector<Item> stack = {{root, false}};
+    auto level = [&](std::shared_ptr<Node> const &node) {
+        auto it = context.invariances.find(node.get());
+        return it == context.invariances.end() ? depth : it->second.level;
+    };
+    auto isSafe = [&](std::shared_ptr<Node> const &node) {
+        auto it = context.invariances.find(node.get());
+        return it != context.invariances.end() && it->second.safe;
+    };
+    auto arrayLevel = [&](std::string const &array) {
+        return firstUnwritten(depth, [&](size_t i) {
+            return mayChange(array, context.loops[context.chain[i]].writes,
+                             context.locals);
+        });
+    };
+
+    while (!stack.empty()) {
+        Item &item = stack.back();
+
+        if (item.node == nullptr ||
+            context.invariances.count(item.node.get())) {
+            stack.pop_back();
+            continue;
+        } else if (!item.expanded) {
+            item.expanded = true;
+            std::list<std::shared_ptr<Node>> children = item.node->children();
+            for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                stack.push_back({*it, false});
+            }
+            continue;
+        }
+        std::shared_ptr<Node> node = std::move(item.node);
+        stack.pop_back();
+        Invariance info = {depth, false};
+
+        if (auto access = std::dynamic_pointer_cast<ArrayAccess>(node)) {
+            info.level = std::max(level(access->index()),
+                                  arrayLevel(access->id()));
+        } else if (auto variable = std::dynamic_pointer_cast<Variable>(node)) {
+            if (isArray(variable->type())) {
+                info.level = arrayLevel(variable->id());
+            } else {
+                info.level = firstUnwritten(depth, [&](size_t i) {
+                    return context.loops[context.chain[i]].writes.scalars.count(
+                        variable->id());
+                });
+                info.safe = true;
+            }
+        } else if (std::dynamic_pointer_cast<Value>(node)) {
+            info = {0, true};
+        } else if (auto call = std::dynamic_pointer_cast<FunctionCall>(node)) {
+            if (context.pure.count(call->functionName())) {
+                info.level = 0;
+                for (std::shared_ptr<TypedNode> const &param : call->params()) {
+                    info.level = std::max(info.level, level(param));
+                }
+            }
+        } else if (auto notOp = std::dynamic_pointer_cast<NotOP>(node)) {
+            info.level = level(notOp->param());
+        } else if (auto operation =
+                       std::dynamic_pointer_cast<BinaryOperation>(node)) {
+            std::shared_ptr<Node> left = operation->left();
+            std::shared_ptr<Node> right = operation->right();
+            info.level = std::max(level(left), level(right));
+            // python raises an error on `/` by 0, and on the arithmetic with
+            // characters
+            if (std::dynamic_pointer_cast<DivOP>(node)) {
+                auto divisor = std::dynamic_pointer_cast<Value>(right);
+                info.safe = isSafe(left) && isNumeric(left) &&
+                            isNumeric(right) && isConstant(divisor) &&
+                            truth(*divisor);
+            } else if (std::dynamic_pointer_cast<TypedNode>(node)) {
+                info.safe = isSafe(left) && isSafe(right) &&
+                            isNumeric(left) && isNumeric(right);
+            }
+        }
+        context.invariances[node.get()] = info;
+    }
+    return context.invariances[root.get()];
+}
+
+/******************************************************************************/
+/*                                  hoisting                                  */
+/******************************************************************************/
+
+/**
+ * @brief  Replace the invariant expressions of the loops by temporaries, in
+ *         one traversal of the function from the top.
+ *
+ *         Each node knows the loops that contain it (the first `depth` loops
+ *         of the chain), and the first loop of the chain from which it's
+ *         `guaranteed`: evaluated before any side effect each time the loop
+ *         starts (the condition of a `whl`, the first statements of a `for`
+ *         that always runs, but never the right operand of `and` / `or` or a
+ *         nested block).
+ *
+ *         An expression is hoisted before the outermost loop where it's
+ *         invariant and, unless it's safe, guaranteed. Its sub-expressions
+ *         are then treated as if they were only in the outer loops, so they
+ *         may leave more loops.
+ */
+static void hoist(LoopNest &context, std::shared_ptr<Function> const &function,
+                  size_t &hoisted) {
+    struct Item {
+        std::shared_ptr<Node> node;
+        std::shared_ptr<Node> parent;
+        size_t depth;
+        size_t guaranteed;
+    };
+    std::vector<Item> stack = {{function->block(), nullptr, 0, 0}};
+    std::unordered_set<Node *> targets;
+
+    while (!stack.empty()) {
+        Item item = std::move(stack.back());
+        stack.pop_back();
+        std::shared_ptr<Node> node = item.node;
+        size_t depth = item.depth;
+
+        if (node == nullptr) {
+            continue;
+        }
+        if (depth > 0 && !targets.count(node.get()) && isHoistable(node) &&
+            !std::dynamic_pointer_cast<Block>(item.parent)) {
+            Invariance const &info = analyze(context, node, depth);
+            size_t first =
+                std::max(info.level, info.safe ? 0 : item.guaranteed);
+            if (first < depth) {
+                Loop &loop = context.loops[context.chain[first]];
+                std::shared_ptr<Variable> &temporary =
+                    loop.temporaries[node.get()];
+                bool treated = temporary != nullptr;
+                if (!treated) {
+                    auto expression =
+                        std::dynamic_pointer_cast<TypedNode>(node);
+                    temporary = std::make_shared<Variable>(
+                        "_inv" + std::to_string(++hoisted),
+                        expression->type());
+                    loop.assignments.push_back(
+                        std::make_shared<Assignment>(temporary, expression));
+                }
+                item.parent->replace(
+                    node, std::make_shared<Variable>(temporary->id(),
+                                                     temporary->type()));
+                if (treated) {
+                    continue;
+                }
+                depth = first;
+                item.guaranteed = std::min(item.guaranteed, first);
+            }
+        }
+
+        if (auto assignment = std::dynamic_pointer_cast<Assignment>(node)) {
+            targets.insert(assignment->variable().get());
+        } else if (auto read = std::dynamic_pointer_cast<Read>(node)) {
+            targets.insert(read->variable().get());
+        } else if (isLoop(node)) {
+            context.loops[node.get()].block =
+                std::dynamic_pointer_cast<Block>(item.parent);
+            context.chain.resize(depth);
+            context.chain.push_back(node.get());
+        }
+
+        if (auto whl = std::dynamic_pointer_cast<Whl>(node)) {
+            stack.push_back({whl->block(), node, depth + 1, depth + 1});
+            stack.push_back({whl->condition(), node, depth + 1,
+                             item.guaranteed});
+            continue;
+        } else if (auto forLoop = std::dynamic_pointer_cast<For>(node)) {
+            // the bounds are computed before the loop, the first statements
+            // are guaranteed until one has side effects
+            bool guaranteed = alwaysRuns(forLoop);
+            std::vector<Item> statements;
+            for (std::shared_ptr<Node> const &statement :
+                 forLoop->block()->instructions()) {
+                statements.push_back({statement, forLoop->block(), depth + 1,
+                                      guaranteed ? depth : depth + 1});
+                guaranteed = guaranteed &&
+                             std::dynamic_pointer_cast<Assignment>(statement) &&
+                             isPure(statement);
+            }
+            stack.insert(stack.end(), statements.rbegin(), statements.rend());
+            stack.push_back({forLoop->step(), node, depth, item.guaranteed});
+            stack.push_back({forLoop->end(), node, depth, item.guaranteed});
+            stack.push_back({forLoop->begin(), node, depth, item.guaranteed});
+            continue;
+        }
+
+        bool shortCircuit = std::dynamic_pointer_cast<AndOP>(node) ||
+                            std::dynamic_pointer_cast<OrOP>(node);
+        std::list<std::shared_ptr<Node>> children = node->children();
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            bool guaranteed = !std::dynamic_pointer_cast<Block>(*it) &&
+                              !(shortCircuit && *it == children.back());
+            stack.push_back(
+                {*it, node, depth, guaranteed ? item.guaranteed : depth});
+        }
+    }
+}
+
+/******************************************************************************/
+/*                                    pass                                    */
+/******************************************************************************/
+
+/**
+ * @brief  The writes of the loops are computed once for the function, and
+ *         the function is traversed once to hoist the expressions, so the
+ *         pass is linear in the size of the function (up to the number of
+ *         variables written in the loops).
+ */
+void LoopInvariantCodeMotion::optimize(std::shared_ptr<Function> function) {
+    LoopNest context = {pure_, localArrays(function)};
+    std::vector<std::shared_ptr<Block>> blocks;
+
+    findLoops(context, function);
+    hoist(context, function, hoisted_);
+
+    // insert the temporaries before their loops
+    for (auto const &[node, loop] : context.loops) {
+        if (!loop.assignments.empty() && loop.block != nullptr) {
+            blocks.push_back(loop.block);
+        }
+    }
+    std::sort(blocks.begin(), blocks.end());
+    blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+    for (std::shared_ptr<Block> const &block : blocks) {
+        std::list<std::shared_ptr<Node>> instructions;
+        for (std::shared_ptr<Node> const &node : block->instructions()) {
+            auto it = context.loops.find(node.get());
+            if (it != context.loops.end()) {
+                instructions.splice(instructions.end(), it->second.assignments);
+            }
+            instructions.push_back(node);
+        }
+        block->instructions(instructions);
+    }
+}
+
+void LoopInvariantCodeMotion::optimize(std::shared_ptr<Program> program) {
+    pure_ = PurityAnalysis(program).pure();
+    for (std::shared_ptr<Function> function : program->functions()) {
+        optimize(function);
+    }
+}
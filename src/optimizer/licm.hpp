@@ -0,0 +1,40 @@
+#ifndef LICM_H
+#define LICM_H
+#include "ast/program.hpp"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <set>
+#include <string>
+
+/**
+ * @brief  Loop-invariant code motion. The expressions of a `for` or a `whl`
+ *         that give the same value at each iteration are computed once in a
+ *         temporary before the loop:
+ *         - the arithmetic on variables that are not written in the loop is
+ *           always hoisted (it can't fail),
+ *         - the array accesses and the calls of pure functions may fail, so
+ *           they are hoisted only when they are evaluated before any side
+ *           effect of the loop (condition of a `whl`, first statements of a
+ *           `for` that always runs).
+ *
+ *         An expression is hoisted out of all the loops where it's
+ *         invariant. The writes of the loops are computed once per function,
+ *         so the pass stays linear in the nesting of the loops.
+ */
+class LoopInvariantCodeMotion {
+  public:
+    void optimize(std::shared_ptr<Program> program);
+    void optimize(std::shared_ptr<Function> function);
+
+    /**
+     * @brief  Number of expressions hoisted so far.
+     */
+    size_t hoisted() const { return hoisted_; }
+
+  private:
+    std::set<std::string> pure_ = {};
+    size_t hoisted_ = 0;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#include "optimizer/memoizer.hpp"
+#include "optimizer/callgraph.hpp"
+#include "optimizer/purity.hpp"
+
+void Memoizer::optimize(std::shared_ptr<Program> program) {
+    PurityAnalysis purity(program);
+    CallGraph callGraph(program);
+
+    for (std::shared_ptr<Function> function : program->functions()) {
+        bool scalars = true;
+        for (Variable const &parameter : function->parameters()) {
+            scalars = scalars && !isArray(parameter.type());
+        }
+        if (scalars && function->type() != NIL &&
+            purity.isPure(function->id()) &&
+            callGraph.isRecursive(function->id()) && !function->memoized()) {
+            function->memoized(true);
+            ++memoized_;
+        }
+    }
+}
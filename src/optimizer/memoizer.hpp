@@ -0,0 +1,26 @@
+#ifndef MEMOIZER_H
+#define MEMOIZER_H
+#include "ast/program.hpp"
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief  Memoization of the pure recursive functions which parameters are
+ *         scalars: their results are cached in the generated code
+ *         (`functools.lru_cache`), so the recursive algorithms like `fib` are
+ *         no longer exponential.
+ */
+class Memoizer {
+  public:
+    void optimize(std::shared_ptr<Program> program);
+
+    /**
+     * @brief  Number of functions memoized so far.
+     */
+    size_t memoized() const { return memoized_; }
+
+  private:
+    size_t memoized_ = 0;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "optimizer/native.hpp"
+#include "optimizer/callgraph.hpp"
+#include "optimizer/vectorizer.hpp"
+#include <map>
+
+/**
+ * @brief  Type of the values exchanged with the library.
+ */
+static bool isNumeric(PrimitiveType type) {
+    return type == INT || type == FLT || type == ARR_INT || type == ARR_FLT;
+}
+
+/**
+ * @brief  The function itself can be compiled in C (its callees are not
+ *         checked).
+ */
+static bool isCompilable(std::shared_ptr<Function> const &function) {
+    bool compilable = !function->memoized() &&
+                      (function->type() == NIL || isNumeric(function->type()));
+
+    for (Variable const &parameter : function->parameters()) {
+        compilable = compilable && isNumeric(parameter.type());
+    }
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        if (std::dynamic_pointer_cast<Print>(node) ||
+            std::dynamic_pointer_cast<Read>(node)) {
+            compilable = false;
+        }
+    });
+    return compilable;
+}
+
+void NativeSelector::select(std::shared_ptr<Program> program,
+                            std::list<std::string> const &requested) {
+    CallGraph callGraph(program);
+    std::map<std::string, std::shared_ptr<Function>> functions;
+    std::set<std::string> compilable;
+    bool changed = true;
+
+    for (std::shared_ptr<Function> function : program->functions()) {
+        functions[function->id()] = function;
+        if (isCompilable(function)) {
+            compilable.insert(function->id());
+        }
+    }
+    // a function that calls a function which stays in python stays in python
+    while (changed) {
+        changed = false;
+        for (auto it = compilable.begin(); it != compilable.end();) {
+            bool callees = true;
+            for (std::string const &callee : callGraph.callees(*it)) {
+                callees = callees && compilable.count(callee) > 0;
+            }
+            if (callees) {
+                ++it;
+            } else {
+                it = compilable.erase(it);
+                changed = true;
+            }
+        }
+    }
+
+    for (std::string const &function : requested) {
+        // the inlined functions may have been removed
+        if (functions.count(function) == 0) {
+            continue;
+        } else if (compilable.count(function) == 0) {
+            rejected_.push_back(function);
+            continue;
+        }
+        std::set<std::string> reachable = callGraph.reachable(function);
+        selected_.insert(reachable.begin(), reachable.end());
+    }
+
+    bool arrays = false;
+    for (std::string const &function : selected_) {
+        functions[function]->native(true);
+        for (Variable const &parameter : functions[function]->parameters()) {
+            arrays = arrays || isArray(parameter.type());
+        }
+    }
+    if (arrays) {
+        Vectorizer::useBuffers(program);
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef NATIVE_H
+#define NATIVE_H
+#include "ast/program.hpp"
+#include <list>
+#include <memory>
+#include <set>
+#include <string>
+
+/**
+ * @brief  Selection of the functions compiled in C in a shared library and
+ *         called from the script through ctypes (`--native`). A function can
+ *         be native when it doesn't use `shw` nor `ipt`, when its parameters
+ *         and its result are int, flt or arrays of them, when it is not
+ *         memoized, and when the functions it calls can be native too (they
+ *         are then native as well).
+ *
+ *         When a native function has an array parameter, the int and flt
+ *         arrays of the program are NumPy arrays (see Vectorizer), so the
+ *         library works on their elements without copy.
+ */
+class NativeSelector {
+  public:
+    void select(std::shared_ptr<Program> program,
+                std::list<std::string> const &requested);
+
+    /**
+     * @brief  Native functions, with the functions they call.
+     */
+    std::set<std::string> const &selected() const { return selected_; }
+
+    /**
+     * @brief  Requested functions that stay in python.
+     */
+    std::list<std::string> const &rejected() const { return rejected_; }
+
+  private:
+    std::set<std::string> selected_ = {};
+    std::list<std::string> rejected_ = {};
+};
+
+#endif
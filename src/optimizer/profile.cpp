@@ -0,0 +1,194 @@
+#include "optimizer/profile.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief  Number the sites of the program: a function has one counter, a loop
+ *         or a `cnd` has two. The header of the profile gives the number of
+ *         counters and a hash (FNV-1a) of the kinds of the sites and of the
+ *         names of the functions.
+ *
+ * @return  The sites in the order of their counters.
+ */
+std::vector<std::shared_ptr<Node>>
+Profile::number(std::shared_ptr<Program> const &program) {
+    std::vector<std::shared_ptr<Node>> sites;
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&](std::string const &text) {
+        for (char c : text) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+        }
+    };
+
+    counters_ = 0;
+    for (std::shared_ptr<Function> const &function : program->functions()) {
+        function->site(++counters_);
+        mix("F" + function->id() + "\n");
+        sites.push_back(function);
+        visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+            auto site = std::dynamic_pointer_cast<Profiled>(node);
+            if (site == nullptr) {
+                return;
+            }
+            site->site(counters_ + 1);
+            counters_ += 2;
+            mix(std::dynamic_pointer_cast<Cnd>(node)   ? "C"
+                : std::dynamic_pointer_cast<For>(node) ? "L"
+                                                       : "W");
+            sites.push_back(node);
+        });
+    }
+    std::ostringstream oss;
+    oss << "# s3c profile " << counters_ << " " << std::hex << hash;
+    header_ = oss.str();
+    return sites;
+}
+
+/**
+ * @brief  Add the counters of the profile to the generated script. The
+ *         instrumented program is not inlined (see optimize), so the calls of
+ *         all the functions are counted.
+ */
+void Profile::instrument(std::shared_ptr<Program> program,
+                         std::string const &file) {
+    for (std::shared_ptr<Node> const &site : number(program)) {
+        std::dynamic_pointer_cast<Profiled>(site)->instrumented(true);
+    }
+    program->instrument(file, header_, counters_);
+}
+
+/**
+ * @brief  Read the profile written by the instrumented script and give the
+ *         counts to the sites of the program.
+ *
+ * @throws  std::runtime_error when the file can't be read or when it is the
+ *          profile of another program.
+ */
+void Profile::read(std::shared_ptr<Program> program, std::string const &file) {
+    std::vector<std::shared_ptr<Node>> sites = number(program);
+    std::vector<size_t> counts = {0}; // the counters start at 1
+    std::ifstream is(file);
+    std::string line;
+
+    if (!is) {
+        throw std::runtime_error("cannot read the profile " + file + ".");
+    }
+    if (!std::getline(is, line) || line != header_) {
+        throw std::runtime_error("the profile " + file +
+                                 " was generated for another program.");
+    }
+    while (counts.size() <= counters_ && std::getline(is, line)) {
+        if (line.empty() || line.size() > 19 ||
+            line.find_first_not_of("0123456789") != std::string::npos) {
+            throw std::runtime_error("bad counter in the profile " + file +
+                                     ".");
+        }
+        counts.push_back(std::stoull(line));
+    }
+    if (counts.size() != counters_ + 1) {
+        throw std::runtime_error("the profile " + file + " is incomplete.");
+    }
+
+    for (size_t count : counts) {
+        maximum_ = std::max(maximum_, count);
+    }
+    for (std::shared_ptr<Node> const &node : sites) {
+        auto site = std::dynamic_pointer_cast<Profiled>(node);
+        if (std::dynamic_pointer_cast<Function>(node)) {
+            site->counts(counts[site->site()], counts[site->site()]);
+        } else {
+            site->counts(counts[site->site()], counts[site->site() + 1]);
+        }
+    }
+    used_ = true;
+    for (std::shared_ptr<Function> const &function : program->functions()) {
+        if (hot(function->count())) {
+            hotFunctions_.push_back(function->id());
+        }
+    }
+}
+
+/**
+ * @brief  A frequency is hot when it is at least 1% of the largest count of
+ *         the profile.
+ */
+bool Profile::hot(size_t frequency) const {
+    return used_ && frequency > 0 && frequency >= maximum_ / 100;
+}
+
+/**
+ * @brief  Estimated number of executions of the nodes of a function: the
+ *         calls of the function, the iterations of the loops, the true or
+ *         false conditions of the `cnd`. The nodes added by the optimizations
+ *         have the frequency of their parent.
+ *
+ * @return  The frequencies, empty when the function is not in the profile.
+ */
+std::unordered_map<Node const *, size_t>
+Profile::frequencies(std::shared_ptr<Function> const &function) const {
+    std::unordered_map<Node const *, size_t> result;
+    std::vector<std::pair<std::shared_ptr<Node>, size_t>> nodes;
+
+    if (!function->profiled()) {
+        return result;
+    }
+    nodes.emplace_back(function->block(), function->count());
+    while (!nodes.empty()) {
+        auto [node, frequency] = std::move(nodes.back());
+        nodes.pop_back();
+        auto site = std::dynamic_pointer_cast<Profiled>(node);
+        auto cnd = std::dynamic_pointer_cast<Cnd>(node);
+
+        result[node.get()] = frequency;
+        for (std::shared_ptr<Node> const &child : node->children()) {
+            size_t childFrequency = frequency;
+
+            if (site != nullptr && site->profiled() &&
+                std::dynamic_pointer_cast<Block>(child)) {
+                childFrequency = site->body();
+                if (cnd != nullptr && child == cnd->elseBlock()) {
+                    childFrequency = site->count() > site->body()
+                                         ? site->count() - site->body()
+                                         : 0;
+                }
+            }
+            nodes.emplace_back(child, childFrequency);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief  The `cnd` which else branch runs more often than the other one are
+ *         inverted: the condition is negated and the branches are swapped, so
+ *         the likely branch comes first and falls through.
+ */
+void Profile::layout(std::shared_ptr<Program> program) {
+    for (std::shared_ptr<Function> const &function : program->functions()) {
+        rewrite(function->block(), [&](std::shared_ptr<Node> const &node) {
+            auto cnd = std::dynamic_pointer_cast<Cnd>(node);
+            if (cnd == nullptr || !cnd->profiled() ||
+                cnd->elseBlock() == nullptr ||
+                cnd->count() - std::min(cnd->count(), cnd->body()) <=
+                    cnd->body()) {
+                return node;
+            }
+            std::shared_ptr<Node> condition = cnd->condition();
+            if (auto negation = std::dynamic_pointer_cast<NotOP>(condition)) {
+                condition = negation->param();
+            } else {
+                condition = std::make_shared<NotOP>(condition);
+            }
+            auto inverted = std::make_shared<Cnd>(condition, cnd->elseBlock());
+            inverted->elseBlock(cnd->block());
+            inverted->site(cnd->site());
+            inverted->counts(cnd->count(), cnd->count() - cnd->body());
+            ++inverted_;
+            return std::static_pointer_cast<Node>(inverted);
+        });
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+#include "ast/program.hpp"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief  Profile-guided optimization. The functions, the loops and the `cnd`
+ *         of the parsed program are the sites of the profile, they are
+ *         numbered in the order of the program and have their counters (see
+ *         Profiled): the calls of a function, the executions and the
+ *         iterations of a loop, the executions and the true conditions of a
+ *         `cnd`.
+ *         - `--profile-generate` instruments the script, which adds its
+ *           counters to the profile file when it exits,
+ *         - `--profile-use` reads the file and gives the counts to the nodes
+ *           before the optimizations: the inliner accepts larger functions at
+ *           the hot call sites and leaves the sites that never ran, the
+ *           vectorizer leaves the short loops, and the `cnd` which else
+ *           branch runs more often are inverted (see layout).
+ *
+ *         The first line of the file identifies the program (the number of
+ *         counters and a hash of the sites), so the profile of another program
+ *         is not used.
+ */
+class Profile {
+  public:
+    void instrument(std::shared_ptr<Program> program, std::string const &file);
+    void read(std::shared_ptr<Program> program, std::string const &file);
+    void layout(std::shared_ptr<Program> program);
+
+    /**
+     * @brief  True when the counts of a profile have been read.
+     */
+    bool used() const { return used_; }
+
+    bool hot(size_t frequency) const;
+    std::unordered_map<Node const *, size_t>
+    frequencies(std::shared_ptr<Function> const &function) const;
+
+    /**
+     * @brief  Functions which number of calls is hot, in the order of the
+     *         program.
+     */
+    std::list<std::string> const &hotFunctions() const {
+        return hotFunctions_;
+    }
+
+    /**
+     * @brief  Number of `cnd` inverted so far.
+     */
+    size_t inverted() const { return inverted_; }
+
+  private:
+    std::vector<std::shared_ptr<Node>>
+    number(std::shared_ptr<Program> const &program);
+
+    std::string header_ = "";
+    size_t counters_ = 0;
+    size_t maximum_ = 0; //< largest count of the profile
+    bool used_ = false;
+    std::list<std::string> hotFunctions_ = {};
+    size_t inverted_ = 0;
+};
+
+#endif
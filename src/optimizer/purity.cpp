@@ -0,0 +1,50 @@
+#include "optimizer/purity.hpp"
+#include "optimizer/analysis.hpp"
+#include "optimizer/callgraph.hpp"
+
+/**
+ * @brief  A function has side effects by itself when it prints, reads, or
+ *         writes an array that is not local (the calls are treated with the
+ *         call graph).
+ */
+static bool hasEffects(std::shared_ptr<Function> const &function) {
+    std::set<std::string> locals = localArrays(function);
+    bool effects = false;
+
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        if (std::dynamic_pointer_cast<Print>(node) ||
+            std::dynamic_pointer_cast<Read>(node)) {
+            effects = true;
+        } else if (auto assignment =
+                       std::dynamic_pointer_cast<Assignment>(node)) {
+            std::shared_ptr<Variable> target = assignment->variable();
+            if ((std::dynamic_pointer_cast<ArrayAccess>(target) ||
+                 isArray(target->type())) &&
+                !locals.count(target->id())) {
+                effects = true;
+            }
+        }
+    });
+    return effects;
+}
+
+PurityAnalysis::PurityAnalysis(std::shared_ptr<Program> program) {
+    CallGraph callGraph(program);
+    std::set<std::string> candidates;
+
+    for (std::shared_ptr<Function> function : program->functions()) {
+        if (!hasEffects(function)) {
+            candidates.insert(function->id());
+        }
+    }
+    // the unknown functions are not candidates
+    for (std::string const &function : candidates) {
+        bool pure = true;
+        for (std::string const &callee : callGraph.reachable(function)) {
+            pure = pure && candidates.count(callee);
+        }
+        if (pure) {
+            pure_.insert(function);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef PURITY_H
+#define PURITY_H
+#include "ast/program.hpp"
+#include <memory>
+#include <set>
+#include <string>
+
+/**
+ * @brief  Interprocedural purity analysis. A function is pure when it has no
+ *         side effects: it doesn't print, read or modify the arrays it
+ *         receives, and all the functions it can reach in the call graph are
+ *         pure too (so the recursive functions can be pure).
+ *
+ * NOTE: a pure function may still fail (division by zero, index out of range)
+ *       or never return.
+ */
+class PurityAnalysis {
+  public:
+    PurityAnalysis(std::shared_ptr<Program> program);
+
+    bool isPure(std::string const &function) const {
+        return pure_.count(function) > 0;
+    }
+    std::set<std::string> const &pure() const { return pure_; }
+
+  private:
+    std::set<std::string> pure_ = {};
+};
+
+#endif
@@ -0,0 +1,211 @@
+#include "optimizer/tailcalls.hpp"
+#include <list>
+#include <string>
+#include <vector>
+
+static std::shared_ptr<Value> intValue(long long value) {
+    LiteralValue literal;
+    literal._int = value;
+    return std::make_shared<Value>(literal, INT);
+}
+
+/******************************************************************************/
+/*                                 tail calls                                 */
+/******************************************************************************/
+
+/**
+ * @brief  Statement in tail position and the block that contains it.
+ */
+struct Tail {
+    std::shared_ptr<Block> block;
+    std::shared_ptr<Node> statement;
+};
+
+/**
+ * @brief  Find the statements in tail position: the last statement of the
+ *         body and, when it's a `cnd`, the last statements of its branches.
+ *         `fallsThrough` is set when a path reaches the end of the body without
+ *         any statement (empty block or `cnd` without `els`).
+ */
+static std::vector<Tail> tailStatements(std::shared_ptr<Block> const &body,
+                                        bool &fallsThrough) {
+    std::vector<std::shared_ptr<Block>> blocks = {body};
+    std::vector<Tail> tails;
+
+    while (!blocks.empty()) {
+        std::shared_ptr<Block> block = std::move(blocks.back());
+        blocks.pop_back();
+
+        if (block->instructions().empty()) {
+            fallsThrough = true;
+            continue;
+        }
+        std::shared_ptr<Node> last = block->instructions().back();
+        if (auto cnd = std::dynamic_pointer_cast<Cnd>(last)) {
+            blocks.push_back(cnd->block());
+            if (cnd->elseBlock() != nullptr) {
+                blocks.push_back(cnd->elseBlock());
+            } else {
+                fallsThrough = true;
+            }
+        } else {
+            tails.push_back({block, last});
+        }
+    }
+    return tails;
+}
+
+/**
+ * @brief  Call of the function itself in the tail statement `statement`. The
+ *         array arguments must be variables: the assignment of a string to the
+ *         parameter would copy it in the array of the caller.
+ *
+ * @return  The call, or nullptr if the statement is not a self tail call.
+ */
+static std::shared_ptr<FunctionCall>
+selfCall(std::shared_ptr<Function> const &function,
+         std::shared_ptr<Node> const &statement) {
+    std::shared_ptr<FunctionCall> call = nullptr;
+
+    if (auto ret = std::dynamic_pointer_cast<Return>(statement)) {
+        call = std::dynamic_pointer_cast<FunctionCall>(ret->returnExpr());
+    } else if (function->type() == NIL) {
+        call = std::dynamic_pointer_cast<FunctionCall>(statement);
+    }
+    if (call == nullptr || call->functionName() != function->id() ||
+        call->params().size() != function->parameters().size()) {
+        return nullptr;
+    }
+    auto parameter = function->parameters().begin();
+    for (std::shared_ptr<TypedNode> const &argument : call->params()) {
+        if (isArray(parameter->type()) &&
+            (!std::dynamic_pointer_cast<Variable>(argument) ||
+             std::dynamic_pointer_cast<ArrayAccess>(argument))) {
+            return nullptr;
+        }
+        ++parameter;
+    }
+    return call;
+}
+
+static bool reads(std::shared_ptr<Node> const &expression,
+                  std::string const &id) {
+    bool found = false;
+    visit(expression, [&](std::shared_ptr<Node> const &node) {
+        auto variable = std::dynamic_pointer_cast<Variable>(node);
+        found = found || (variable != nullptr && variable->id() == id);
+    });
+    return found;
+}
+
+/**
+ * @brief  Assignments of the arguments of the call to the parameters. The
+ *         arguments are evaluated before the call, so when an argument reads a
+ *         parameter assigned before it, all the arguments are first computed
+ *         in temporaries.
+ *
+ * NOTE: the targets have the types of the parameters, so the arguments are
+ *       converted like in a call.
+ */
+static std::list<std::shared_ptr<Node>>
+assignParameters(std::shared_ptr<Function> const &function,
+                 std::shared_ptr<FunctionCall> const &call) {
+    std::vector<std::pair<Variable, std::shared_ptr<TypedNode>>> assigned;
+    std::list<std::shared_ptr<Node>> temporaries;
+    std::list<std::shared_ptr<Node>> assignments;
+    bool conflict = false;
+
+    auto parameter = function->parameters().begin();
+    for (std::shared_ptr<TypedNode> const &argument : call->params()) {
+        auto variable = std::dynamic_pointer_cast<Variable>(argument);
+        if (variable == nullptr ||
+            std::dynamic_pointer_cast<ArrayAccess>(argument) ||
+            variable->id() != parameter->id()) {
+            assigned.push_back({*parameter, argument});
+        }
+        ++parameter;
+    }
+    for (size_t i = 0; i < assigned.size(); ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            conflict = conflict ||
+                       reads(assigned[i].second, assigned[j].first.id());
+        }
+    }
+
+    for (auto const &[parameter, argument] : assigned) {
+        std::shared_ptr<TypedNode> value = argument;
+        if (conflict) {
+            auto temporary = std::make_shared<Variable>(
+                "_tail_" + parameter.id(), argument->type());
+            temporaries.push_back(
+                std::make_shared<Assignment>(temporary, argument));
+            value = std::make_shared<Variable>(temporary->id(),
+                                               temporary->type());
+        }
+        assignments.push_back(std::make_shared<Assignment>(
+            std::make_shared<Variable>(parameter.id(), parameter.type()),
+            value));
+    }
+    temporaries.splice(temporaries.end(), assignments);
+    return temporaries;
+}
+
+/******************************************************************************/
+/*                                    pass                                    */
+/******************************************************************************/
+
+void TailCallEliminator::optimize(std::shared_ptr<Function> function) {
+    std::string const flag = "_recurse";
+    bool fallsThrough = false;
+    std::vector<Tail> tails = tailStatements(function->block(), fallsThrough);
+    std::vector<std::pair<Tail, std::shared_ptr<FunctionCall>>> calls;
+
+    for (Tail const &tail : tails) {
+        if (auto call = selfCall(function, tail.statement)) {
+            calls.push_back({tail, call});
+        } else if (!std::dynamic_pointer_cast<Return>(tail.statement)) {
+            fallsThrough = true;
+        }
+    }
+    if (calls.empty()) {
+        return;
+    }
+
+    for (auto const &[tail, call] : calls) {
+        std::list<std::shared_ptr<Node>> instructions =
+            tail.block->instructions();
+        instructions.pop_back();
+        instructions.splice(instructions.end(),
+                            assignParameters(function, call));
+        if (fallsThrough) {
+            instructions.push_back(std::make_shared<Assignment>(
+                std::make_shared<Variable>(flag, INT), intValue(1)));
+        }
+        tail.block->instructions(instructions);
+        ++eliminated_;
+    }
+
+    // the body is wrapped in the loop, the paths that don't end with a tail
+    // call stop the loop with `ret` or with the flag
+    auto body = std::make_shared<Block>();
+    std::list<std::shared_ptr<Node>> instructions;
+    std::shared_ptr<TypedNode> condition = intValue(1);
+    body->instructions(function->block()->instructions());
+    if (fallsThrough) {
+        std::list<std::shared_ptr<Node>> loop = body->instructions();
+        loop.push_front(std::make_shared<Assignment>(
+            std::make_shared<Variable>(flag, INT), intValue(0)));
+        body->instructions(loop);
+        instructions.push_back(std::make_shared<Assignment>(
+            std::make_shared<Variable>(flag, INT), intValue(1)));
+        condition = std::make_shared<Variable>(flag, INT);
+    }
+    instructions.push_back(std::make_shared<Whl>(condition, body));
+    function->block()->instructions(instructions);
+}
+
+void TailCallEliminator::optimize(std::shared_ptr<Program> program) {
+    for (std::shared_ptr<Function> function : program->functions()) {
+        optimize(function);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef TAIL_CALLS_H
+#define TAIL_CALLS_H
+#include "ast/program.hpp"
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief  Self tail-call elimination. When a function calls itself in tail
+ *         position (`ret f(...)`, or a call statement that ends a `nil`
+ *         function), the body of the function is wrapped in a `whl` loop and
+ *         the call is replaced by the assignment of the arguments to the
+ *         parameters. The recursion then runs in constant stack.
+ *
+ *         The loop is `whl (1)` when all the paths of the body end with a `ret`
+ *         or a tail call. Otherwise, a flag tells if the loop must continue.
+ */
+class TailCallEliminator {
+  public:
+    void optimize(std::shared_ptr<Program> program);
+    void optimize(std::shared_ptr<Function> function);
+
+    /**
+     * @brief  Number of tail calls eliminated so far.
+     */
+    size_t eliminated() const { return eliminated_; }
+
+  private:
+    size_t eliminated_ = 0;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "optimizer/typeinference.hpp"
+#include <list>
+
+/**
+ * @brief  Type of the result of an arithmetic operation (like in python: the
+ *         operations on integers give integers, but `div` is the true division
+ *         which always gives a float).
+ */
+static PrimitiveType arithmeticType(std::shared_ptr<Node> const &operation) {
+    auto binary = std::dynamic_pointer_cast<BinaryOperation>(operation);
+    auto l = std::dynamic_pointer_cast<TypedNode>(binary->left());
+    auto r = std::dynamic_pointer_cast<TypedNode>(binary->right());
+
+    if (l == nullptr || r == nullptr || l->type() == NIL || r->type() == NIL) {
+        return NIL;
+    } else if (std::dynamic_pointer_cast<DivOP>(operation)) {
+        return FLT;
+    }
+    return selectType(l->type(), r->type());
+}
+
+/**
+ * @brief  Set the types of the nodes of a function. The variables which type
+ *         is unknown (NIL) get the type of the values assigned to them when
+ *         all these values have the same type. This is repeated until no new
+ *         type is found.
+ */
+void TypeInference::infer(std::shared_ptr<Function> function) {
+    std::map<std::string, PrimitiveType> types;
+    bool changed = true;
+
+    for (Variable const &parameter : function->parameters()) {
+        types[parameter.id()] = parameter.type();
+    }
+    visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+        if (auto access = std::dynamic_pointer_cast<ArrayAccess>(node)) {
+            if (access->type() != NIL) {
+                types[access->id()] = getArrayType(access->type());
+            }
+        } else if (auto variable = std::dynamic_pointer_cast<Variable>(node)) {
+            if (variable->type() != NIL) {
+                types[variable->id()] = variable->type();
+            }
+        } else if (auto loop = std::dynamic_pointer_cast<For>(node)) {
+            if (loop->variable().type() != NIL) {
+                types[loop->variable().id()] = loop->variable().type();
+            }
+        } else if (auto declaration =
+                       std::dynamic_pointer_cast<Declaration>(node)) {
+            types[declaration->variable().id()] =
+                declaration->variable().type();
+        }
+    });
+
+    while (changed) {
+        std::map<std::string, std::list<PrimitiveType>> assigned;
+        changed = false;
+
+        rewrite(function->block(), [&](std::shared_ptr<Node> const &node) {
+            // the types given by the parser are kept (the scopes are known
+            // there)
+            if (auto access = std::dynamic_pointer_cast<ArrayAccess>(node)) {
+                if (access->type() == NIL) {
+                    access->type(getValueType(types[access->id()]));
+                }
+            } else if (auto variable =
+                           std::dynamic_pointer_cast<Variable>(node)) {
+                if (variable->type() == NIL) {
+                    variable->type(types[variable->id()]);
+                }
+            } else if (auto call =
+                           std::dynamic_pointer_cast<FunctionCall>(node)) {
+                auto it = returnTypes_.find(call->functionName());
+                call->type(it == returnTypes_.end() ? NIL : it->second);
+            } else if (std::dynamic_pointer_cast<BinaryOperation>(node)) {
+                if (auto typed = std::dynamic_pointer_cast<TypedNode>(node)) {
+                    typed->type(arithmeticType(node));
+                }
+            } else if (auto assignment =
+                           std::dynamic_pointer_cast<Assignment>(node)) {
+                std::shared_ptr<Variable> target = assignment->variable();
+                if (!std::dynamic_pointer_cast<ArrayAccess>(target)) {
+                    assigned[target->id()].push_back(
+                        assignment->value()->type());
+                }
+            }
+            return node;
+        });
+
+        for (auto const &[name, values] : assigned) {
+            PrimitiveType type = values.front();
+            if (types[name] != NIL || type == NIL) {
+                continue;
+            }
+            for (PrimitiveType value : values) {
+                if (value != type) {
+                    type = NIL;
+                }
+            }
+            if (type != NIL) {
+                types[name] = type;
+                changed = true;
+            }
+        }
+    }
+}
+
+void TypeInference::infer(std::shared_ptr<Program> program) {
+    for (std::shared_ptr<Function> function : program->functions()) {
+        returnTypes_[function->id()] = function->type();
+    }
+    for (std::shared_ptr<Function> function : program->functions()) {
+        infer(function);
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef TYPE_INFERENCE_H
+#define TYPE_INFERENCE_H
+#include "ast/program.hpp"
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * @brief  Type inference. The static type of every typed node is recomputed
+ *         from its sub-nodes: the variables get the type of their declaration
+ *         (or of the values assigned to them for the variables created by the
+ *         optimizations), the function calls get the return type of the
+ *         function, and the operators the type of their result. The emitter
+ *         relies on these types to avoid useless conversions.
+ */
+class TypeInference {
+  public:
+    void infer(std::shared_ptr<Program> program);
+    void infer(std::shared_ptr<Function> function);
+
+  private:
+    std::map<std::string, PrimitiveType> returnTypes_ = {};
+};
+
+#endif
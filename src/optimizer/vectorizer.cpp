@@ -0,0 +1,118 @@
+#include "optimizer/vectorizer.hpp"
+#include "optimizer/analysis.hpp"
+
+/**
+ * @brief  Element of an int or flt array at the index of the loop.
+ */
+static bool isNumber(std::shared_ptr<Node> const &node,
+                     std::string const &variable) {
+    auto access = std::dynamic_pointer_cast<ArrayAccess>(node);
+    return isElement(node, variable) &&
+           (access->type() == INT || access->type() == FLT);
+}
+
+/**
+ * @brief  Arithmetic on numbers, that can be computed on the whole arrays.
+ */
+static bool isElementWise(std::shared_ptr<Node> const &expression,
+                          std::string const &variable) {
+    bool elementWise = true;
+
+    visit(expression, [&](std::shared_ptr<Node> const &node) {
+        auto typed = std::dynamic_pointer_cast<TypedNode>(node);
+        if (typed == nullptr ||
+            (typed->type() != INT && typed->type() != FLT)) {
+            elementWise = false;
+        } else if (std::dynamic_pointer_cast<ArrayAccess>(node)) {
+            elementWise = elementWise && isNumber(node, variable);
+        } else if (!std::dynamic_pointer_cast<AddOP>(node) &&
+                   !std::dynamic_pointer_cast<MnsOP>(node) &&
+                   !std::dynamic_pointer_cast<TmsOP>(node) &&
+                   !std::dynamic_pointer_cast<DivOP>(node) &&
+                   !std::dynamic_pointer_cast<Value>(node) &&
+                   !std::dynamic_pointer_cast<Variable>(node)) {
+            elementWise = false;
+        }
+    });
+    return elementWise;
+}
+
+bool Vectorizer::vectorizable(std::shared_ptr<For> const &loop) const {
+    auto step = std::dynamic_pointer_cast<Value>(loop->step());
+    std::string const &variable = loop->variable().id();
+
+    if (step == nullptr || step->type() != INT || step->value()._int != 1 ||
+        loop->block()->instructions().empty()) {
+        return false;
+    }
+    // the NumPy calls cost more than the iterations of the short loops
+    if (loop->profiled() && loop->body() < SHORT_LOOP * loop->count()) {
+        return false;
+    }
+    for (std::shared_ptr<Node> const &instruction :
+         loop->block()->instructions()) {
+        auto assignment = std::dynamic_pointer_cast<Assignment>(instruction);
+        if (assignment == nullptr ||
+            !isNumber(assignment->variable(), variable) ||
+            !isElementWise(assignment->value(), variable)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Vectorizer::optimize(std::shared_ptr<Program> program) {
+    size_t vectorized = vectorized_;
+
+    // the sliced loops check the bounds with `len` (see For::compileSliced),
+    // and use `numpy`, a function, a parameter or a variable can hide them
+    bool hidden = defines(program, "len");
+    for (std::shared_ptr<Function> function : program->functions()) {
+        std::set<std::string> names = localNames(function);
+        std::map<std::string, int> sizes = arraySizes(function);
+        if (names.count("numpy")) {
+            continue;
+        }
+        visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+            auto loop = std::dynamic_pointer_cast<For>(node);
+            if (loop == nullptr || loop->vectorized() || !vectorizable(loop)) {
+                return;
+            }
+            bool known = inBounds(loop, sizes);
+            if (known || (!hidden && !names.count("len"))) {
+                loop->vectorized(true);
+                loop->inBounds(known);
+                ++vectorized_;
+            }
+        });
+    }
+    if (vectorized_ == vectorized) {
+        return;
+    }
+
+    // the arrays are given to the functions, so they all have the same type
+    useBuffers(program);
+}
+
+/**
+ * @brief  The int and flt arrays of the program are NumPy arrays (they are
+ *         printed as lists).
+ */
+void Vectorizer::useBuffers(std::shared_ptr<Program> program) {
+    program->buffers(true);
+    for (std::shared_ptr<Function> function : program->functions()) {
+        visit(function->block(), [&](std::shared_ptr<Node> const &node) {
+            auto array = std::dynamic_pointer_cast<ArrayDeclaration>(node);
+            auto print = std::dynamic_pointer_cast<Print>(node);
+            if (array != nullptr && array->type() != ARR_CHR) {
+                array->buffer(true);
+            } else if (print != nullptr) {
+                auto content =
+                        std::dynamic_pointer_cast<Variable>(print->content());
+                print->buffer(content != nullptr &&
+                              isArray(content->type()) &&
+                              content->type() != ARR_CHR);
+            }
+        });
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef VECTORIZER_H
+#define VECTORIZER_H
+#include "ast/program.hpp"
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief  Vectorization of the element-wise `for` loops (`--vectorize`): a
+ *         loop with a step of 1 which body only assigns elements of int or flt
+ *         arrays at the index of the loop, with arithmetic on the elements of
+ *         the arrays at the same index, the loop variable, the other variables
+ *         and the constants, is generated as NumPy operations on slices. Each
+ *         iteration only uses the elements at its index, so the iterations are
+ *         independent (even when the arrays are aliases).
+ *
+ *         When a loop is vectorized, all the int and flt arrays of the program
+ *         are NumPy arrays (they are given to the other functions). With a
+ *         profile (see Profile), the loops which run less than SHORT_LOOP
+ *         iterations on average are not vectorized.
+ *
+ * NOTE: the integers of the NumPy arrays have 64 bits and wrap around in the
+ *       operations on the slices, so the vectorized int operations are done
+ *       on Python integers when the magnitude of the elements allows an
+ *       overflow, which raises OverflowError when the result is stored.
+ */
+class Vectorizer {
+  public:
+    static constexpr size_t SHORT_LOOP = 16;
+
+    void optimize(std::shared_ptr<Program> program);
+    static void useBuffers(std::shared_ptr<Program> program);
+
+    /**
+     * @brief  Number of loops vectorized so far.
+     */
+    size_t vectorized() const { return vectorized_; }
+
+  private:
+    bool vectorizable(std::shared_ptr<For> const &loop) const;
+
+    size_t vectorized_ = 0;
+};
+
+#endif
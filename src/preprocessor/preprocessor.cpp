@@ -1,6 +1,6 @@
 #include "preprocessor.hpp"
-#include <algorithm>
 #include <regex>
+#include <sstream>
 
 /**
  * @brief  Get the path to the project and launch the preprocessor.
@@ -13,68 +13,90 @@ void Preprocessor::process(std::string pathToMain) {
     while (tmp[tmp.length() - 1] != '/')
         tmp.pop_back();
     pathToProject = tmp;
-    process_rec(pathToMain);
+    processFile(pathToMain);
 }
 
 /**
- * @brief  Follow all the includes statemnents in the file and write all the
- *         code in one file that will be parsed and transpiled.
+ * @brief  Load a file and push it on the stack of the files being processed.
+ *         The content is read at once, so the number of opened files doesn't
+ *         depend on the length of the include chains.
  *
- * @param  fileName  Name of the file to process.
+ * @param  fileName  Name of the file to open.
  */
-void Preprocessor::process_rec(std::string fileName) {
-    int lineCount = 1;
-    std::string line;
-    std::string includedFileName;
-    std::regex includeStmt("^use .+$");
-    std::regex fileIndicator("-->.*");
-    std::ifstream currentFile;
+void Preprocessor::open(std::string fileName) {
+    std::ifstream file(fileName);
+    std::ostringstream content;
 
-    // close the previously opened file (recursive call)
-    filesStack.push_back(fileName);
-    currentFile.open(fileName);
-
-    if (!currentFile.is_open()) {
+    if (!file.is_open()) {
         std::ostringstream oss;
         oss << fileName << " doesn't exist." << std::endl;
         throw std::logic_error(oss.str());
     }
+    content << file.rdbuf();
+    openedFiles.insert(fileName);
+    filesStack.push_back(
+        {fileName, std::istringstream(content.str()), 1, ""});
 
     // file indicator for the parser
     outputFile << "-->" << fileName << "-0" << std::endl;
+}
 
-    while (std::getline(currentFile, line)) {
+/**
+ * @brief  Follow all the includes statemnents in the file and write all the
+ *         code in one file that will be parsed and transpiled. The included
+ *         files are pushed on a stack instead of being processed recursively,
+ *         so the length of the include chains is not limited by the call
+ *         stack.
+ *
+ * @param  fileName  Name of the file to process.
+ */
+void Preprocessor::processFile(std::string fileName) {
+    std::string line;
+    std::string includedFileName;
+    std::regex includeStmt("^use .+$");
+    std::regex fileIndicator("-->.*");
+
+    open(fileName);
+    while (!filesStack.empty()) {
+        OpenedFile &currentFile = filesStack.back();
+
+        if (!std::getline(currentFile.stream, line)) {
+            // when it's done, we go back to the file that included it
+            filesStack.pop_back();
+            if (!filesStack.empty()) {
+                OpenedFile &includer = filesStack.back();
+                outputFile << "-->" << includer.name << "-"
+                           << (includer.lineCount - 1) << std::endl;
+                outputFile << "~~~ " << includer.include << std::endl;
+                includer.lineCount++;
+            }
+            continue;
+        }
         // if the user tries to add a file indicator, we make
         // sure that the program is not parsed
         if (std::regex_match(line, fileIndicator)) {
             std::ostringstream oss;
-            oss << fileName << ":" << lineCount << ": synctax error."
-                << std::endl;
+            oss << currentFile.name << ":" << currentFile.lineCount
+                << ": synctax error." << std::endl;
             throw std::logic_error(oss.str());
         }
         // search for include statement
         if (std::regex_match(line, includeStmt)) {
-            includedFileName =
-                pathToProject + line.substr(8, line.length() - 9) + ".prog";
-            bool isTreated = std::find(treatedFiles.begin(), treatedFiles.end(),
-                                       includedFileName) != treatedFiles.end();
-            bool isInStack = std::find(filesStack.begin(), filesStack.end(),
-                                       includedFileName) != filesStack.end();
-            if (!isTreated && !isInStack) {
-                // treat the file
-                process_rec(includedFileName);
-                outputFile << "-->" << fileName << "-" << (lineCount - 1)
-                           << std::endl;
+            includedFileName = pathToProject + line.substr(4) + ".prog";
+            // the file is treated only if it has never been opened (already
+            // treated or in the stack)
+            if (openedFiles.count(includedFileName) == 0) {
+                // treat the file, the include line is written when we come
+                // back to the current file
+                currentFile.include = line;
+                open(includedFileName);
+                continue;
             }
-            outputFile << "# " << line << std::endl;
+            outputFile << "~~~ " << line << std::endl;
         } else {
             // put the line in the output file
             outputFile << line << std::endl;
         }
-        lineCount++;
+        currentFile.lineCount++;
     }
-    // when it's done, the file is considered as treated
-    treatedFiles.push_back(filesStack.back());
-    filesStack.pop_back();
-    currentFile.close();
 }
@@ -1,7 +1,9 @@
 #ifndef PREPROCESSOR_H
 #define PREPROCESSOR_H
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 /*
@@ -11,15 +13,24 @@
 
 class Preprocessor {
       public:
-        void process_rec(std::string fileName);
+        void processFile(std::string fileName);
         void process(std::string pathToMain);
         Preprocessor(std::string outputFileName)
             : outputFile(std::ofstream(outputFileName)) {}
         ~Preprocessor() = default;
 
       private:
-        std::vector<std::string> treatedFiles;
-        std::vector<std::string> filesStack;
+        struct OpenedFile {
+                std::string name;
+                std::istringstream stream;
+                int lineCount;
+                std::string include; // include statement being processed
+        };
+
+        void open(std::string fileName);
+
+        std::unordered_set<std::string> openedFiles;
+        std::vector<OpenedFile> filesStack;
         std::ofstream outputFile;
         std::string pathToProject;
 };
@@ -8,18 +8,58 @@ void ContextManager::enterScope() {
         auto newScope = std::make_shared<Symtable>(currentScope);
         currentScope->addScope(newScope);
         currentScope = newScope;
+        scopesNames.push_back({});
 }
 
-void ContextManager::leaveScope() { currentScope = currentScope->getFather(); }
+/**
+ * The symbols defined in the scope are not visible anymore, their definitions
+ * are the last ones of the index as the inner scopes are already left.
+ */
+void ContextManager::leaveScope() {
+        for (std::string const &name : scopesNames.back()) {
+                auto definition = definitions.find(name);
+                definition->second.pop_back();
+                if (definition->second.empty()) {
+                        definitions.erase(definition);
+                }
+        }
+        scopesNames.pop_back();
+        currentScope = currentScope->getFather();
+}
+
+/**
+ * @brief  Add a definition to the index.
+ *
+ * @param  name    Name of the symbol.
+ * @param  symbol  New symbol.
+ * @param  depth   Depth of the scope where the symbol is defined.
+ */
+void ContextManager::define(std::string name, Symbol symbol, size_t depth) {
+        std::vector<Definition> &nameDefinitions = definitions[name];
+        auto it = nameDefinitions.begin();
+
+        // the definitions are sorted by depth
+        while (it != nameDefinitions.end() && it->depth < depth) {
+                ++it;
+        }
+        if (it != nameDefinitions.end() && it->depth == depth) {
+                it->symbol = symbol; // redefinition in the same scope
+        } else {
+                nameDefinitions.insert(it, {depth, symbol});
+                scopesNames[depth].push_back(name);
+        }
+}
 
 void ContextManager::newSymbol(std::string name, std::list<PrimitiveType> type,
                                Kind kind) {
         currentScope->add(name, type, kind);
+        define(name, Symbol(name, type, kind), scopesNames.size() - 1);
 }
 
 void ContextManager::newSymbol(std::string name, std::list<PrimitiveType> type,
                                unsigned int size, Kind kind) {
         currentScope->add(name, type, size, kind);
+        define(name, Symbol(name, type, size, kind), scopesNames.size() - 1);
 }
 
 /**
@@ -28,8 +68,13 @@ void ContextManager::newSymbol(std::string name, std::list<PrimitiveType> type,
 void ContextManager::newGlobalSymbol(std::string name, std::list<PrimitiveType> type,
                                      Kind kind) {
         globalScope->add(name, type, kind);
+        define(name, Symbol(name, type, kind), 0);
 }
 
 std::optional<Symbol> ContextManager::lookup(std::string name) const {
-        return currentScope->lookup(name);
+        auto definition = definitions.find(name);
+        if (definition == definitions.end()) {
+                return {};
+        }
+        return definition->second.back().symbol;
 }
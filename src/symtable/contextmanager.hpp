@@ -2,6 +2,8 @@
 #define CONTEXT_MANAGER_H
 #include "symtable/symtable.hpp"
 #include <list>
+#include <unordered_map>
+#include <vector>
 
 class ContextManager {
       public:
@@ -18,8 +20,22 @@ class ContextManager {
         std::optional<Symbol> lookup(std::string name) const;
 
       private:
+        /* definition of a symbol visible from the current scope */
+        struct Definition {
+                size_t depth; // depth of the scope where the symbol is defined
+                Symbol symbol;
+        };
+
+        void define(std::string name, Symbol symbol, size_t depth);
+
         std::shared_ptr<Symtable> currentScope = nullptr;
         std::shared_ptr<Symtable> globalScope = nullptr;
+        // index of the visible symbols (the last definition is the innermost
+        // one), this avoids walking all the scopes on each lookup
+        std::unordered_map<std::string, std::vector<Definition>> definitions;
+        // names defined in each scope of the current chain (the first element
+        // is the global scope)
+        std::vector<std::vector<std::string>> scopesNames = {{}};
 };
 
 #endif
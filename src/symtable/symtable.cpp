@@ -3,15 +3,6 @@
 
 Symtable::Symtable(std::shared_ptr<Symtable> father) : father(father) {}
 
-bool contains(std::unordered_map<std::string, Symbol> table, std::string name) {
-    for (const auto &[key, value] : table) {
-        if (key == name) {
-            return true;
-        }
-    }
-    return false;
-}
-
 /**
  * @brief  Lookup for a symbol in the symtable.
  *
@@ -27,15 +18,19 @@ bool contains(std::unordered_map<std::string, Symbol> table, std::string name) {
  *       parameter and a local variable declared at the top of the function body
  *       (in that case, only the `kind` changes).
  *
+ * NOTE: the fathers are walked with a loop, the depth of the scopes is not
+ *       limited by the call stack.
+ *
  * @return  Optional symbol which is the symbol corresponding to `name` in the
  *          current scope.
  */
 std::optional<Symbol> Symtable::lookup(std::string name) {
-    if (contains(table, name)) {
-        return table[name];
-    } else {
-        if (father != nullptr) // recherche dans la table supérieure
-            return father->lookup(name);
+    for (Symtable *scope = this; scope != nullptr;
+         scope = scope->father.get()) {
+        auto symbol = scope->table.find(name);
+        if (symbol != scope->table.end()) {
+            return symbol->second;
+        }
     }
     return {};
 }
@@ -0,0 +1,350 @@
+#include "driver.hpp"
+#include "ir/cemitter.hpp"
+#include "ir/lowering.hpp"
+#include "ir/pyemitter.hpp"
+#include "ir/verifier.hpp"
+#include "optimizer/callgraph.hpp"
+#include "tools/checks.hpp"
+#include "tools/python.hpp"
+#include "vm/bytecode.hpp"
+#include "vm/machine.hpp"
+#include "x86/codegen.hpp"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * @brief  Add execution rights to the result file.
+ */
+static void makeExecutable(std::string file) {
+    std::filesystem::permissions(file,
+            std::filesystem::perms::owner_exec
+            | std::filesystem::perms::group_exec
+            | std::filesystem::perms::others_exec,
+            std::filesystem::perm_options::add);
+}
+
+/**
+ * @brief  Lower the program in the IR and verify it.
+ */
+static std::unique_ptr<ir::Module> lower(std::shared_ptr<Program> program) {
+    std::unique_ptr<ir::Module> module = ir::Lowering().lower(program);
+    ir::Verifier verifier;
+
+    if (!verifier.verify(*module)) {
+        for (std::string const &error : verifier.errors()) {
+            std::cerr << "internal error: invalid IR: " << error << std::endl;
+        }
+        errMgr.addError("invalid IR.");
+    }
+    return module;
+}
+
+/**
+ * @brief  Write the IR or the script generated from it.
+ */
+static void generateFromIR(std::ostream &fs,
+                           std::shared_ptr<Program> program,
+                           Options const &options) {
+    std::unique_ptr<ir::Module> module = lower(program);
+
+    if (options.emitIR) {
+        fs << *module;
+    } else {
+        ir::PythonEmitter().emit(fs, *module);
+    }
+}
+
+/**
+ * @brief  Quote an argument of the shell command.
+ */
+static std::string quote(std::string const &argument) {
+    std::string quoted = "'";
+
+    for (char c : argument) {
+        quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    return quoted + "'";
+}
+
+void generateC(std::shared_ptr<Program> program, Options const &options) {
+    std::string source = options.cc.empty() ? options.output
+                                            : options.output + ".c";
+    std::unique_ptr<ir::Module> module = lower(program);
+    std::ofstream fs(source);
+
+    ir::CEmitter().emit(fs, *module);
+    fs.close();
+    if (options.cc.empty() || errMgr.getErrors()) {
+        return;
+    }
+    std::string command = options.cc + " -O2 -o " + quote(options.output) +
+                          " " + quote(source) + " -lm";
+    if (std::system(command.c_str()) != 0) {
+        std::cerr << "error: the compilation of " << source << " failed."
+                  << std::endl;
+        errMgr.addError("the compilation of " + source + " failed.");
+    }
+}
+
+/**
+ * @brief  Compile the script in bytecode with the python of the options, the
+ *         output is a zipapp which __main__ module is the bytecode (python then
+ *         doesn't compile the script when it starts), it runs with the same
+ *         python.
+ */
+static void generatePyc(std::string const &script, Options const &options) {
+    static std::string const compiler =
+        "import importlib.util, marshal, sys, zipfile\n"
+        "script, output = sys.argv[1:]\n"
+        "with open(script) as f:\n"
+        "    code = compile(f.read(), script, 'exec')\n"
+        "with open(output, 'wb') as f:\n"
+        "    f.write(b'#!' + sys.executable.encode() + b'\\n')\n"
+        "    with zipfile.ZipFile(f, 'w') as z:\n"
+        "        z.writestr('__main__.pyc', importlib.util.MAGIC_NUMBER +\n"
+        "                   bytes(12) + marshal.dumps(code))\n";
+    std::string command = options.pyc + " -c " + quote(compiler) + " " +
+                          quote(script) + " " + quote(options.output);
+
+    if (std::system(command.c_str()) != 0) {
+        std::cerr << "error: the compilation of " << script << " failed."
+                  << std::endl;
+        errMgr.addError("the compilation of " + script + " failed.");
+    }
+}
+
+/**
+ * @brief  Python identifier made of a name (the other characters than the
+ *         letters, the digits and '_' are replaced by '_').
+ */
+static std::string identifier(std::string const &name) {
+    static std::set<std::string> const keywords = {
+        "False", "None", "True", "and", "as", "assert", "async", "await",
+        "break", "class", "continue", "def", "del", "elif", "else", "except",
+        "finally", "for", "from", "global", "if", "import", "in", "is",
+        "lambda", "nonlocal", "not", "or", "pass", "raise", "return", "try",
+        "while", "with", "yield"};
+    std::string result;
+
+    for (char c : name) {
+        result += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+    if (result.empty() || std::isdigit(static_cast<unsigned char>(result[0]))
+        || keywords.count(result)) {
+        result = "_" + result;
+    }
+    return result;
+}
+
+/**
+ * @brief  Name of the module of a source file: its path from the directory of
+ *         the main file (see Preprocessor::process), without the extension.
+ */
+static std::string moduleName(std::string file, std::string const &root) {
+    if (file.rfind(root, 0) == 0) {
+        file.erase(0, root.size());
+    }
+    size_t extension = file.rfind('.');
+    if (extension != std::string::npos && extension != 0 &&
+        file.find('/', extension) == std::string::npos) {
+        file.erase(extension);
+    }
+    return identifier(file);
+}
+
+/**
+ * @brief  Write a file, unless it already has this content: its modification
+ *         time doesn't change, so python keeps the bytecode of the module in
+ *         its cache.
+ */
+static void update(std::filesystem::path const &path,
+                   std::string const &content) {
+    std::ifstream is(path, std::ios::binary);
+    std::ostringstream old;
+
+    if (is.is_open()) {
+        old << is.rdbuf();
+        if (old.str() == content) {
+            return;
+        }
+        is.close();
+    }
+    std::ofstream(path, std::ios::binary) << content;
+}
+
+void generateModules(std::shared_ptr<Program> program, Options const &options) {
+    std::filesystem::path output(options.output);
+    std::string package = identifier(output.filename().string()) + "_modules";
+    std::filesystem::path directory = output.parent_path() / package;
+    std::string root = options.input.substr(0, options.input.rfind('/') + 1);
+    std::map<std::string, std::string> modules;     // of the files
+    std::map<std::string, std::string> files;       // of the modules
+    std::map<std::string, std::string> definitions; // module of the functions
+    std::map<std::string, std::map<std::string, std::set<std::string>>>
+        imports;
+    CallGraph graph(program);
+
+    for (std::shared_ptr<Function> function : program->functions()) {
+        std::string const &file = function->file();
+        if (modules.count(file) == 0) {
+            std::string name = moduleName(file, root);
+            while (files.count(name)) {
+                name += "_";
+            }
+            modules[file] = name;
+            files[name] = file;
+        }
+        definitions[function->id()] = modules[file];
+    }
+    for (std::shared_ptr<Function> function : program->functions()) {
+        std::string const &module = definitions[function->id()];
+        for (std::string const &callee : graph.callees(function->id())) {
+            auto found = definitions.find(callee);
+            if (found != definitions.end() && found->second != module) {
+                imports[module][found->second].insert(callee);
+            }
+        }
+    }
+
+    try {
+        std::filesystem::create_directories(directory);
+        update(directory / "__init__.py", "");
+        for (auto const &[module, file] : files) {
+            std::ostringstream oss;
+            program->compileModule(oss, file, imports[module]);
+            update(directory / (module + ".py"), oss.str());
+        }
+    } catch (std::filesystem::filesystem_error &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        errMgr.addError(e.what());
+        return;
+    }
+    std::ofstream fs(options.output);
+    fs << "#!/usr/bin/env python3" << std::endl;
+    fs << "# generated using ISIMA's transpiler" << std::endl << std::endl;
+    fs << "from " << package << "." << definitions["main"] << " import main"
+       << std::endl;
+    fs << std::endl << "if __name__ == '__main__':" << std::endl << "\tmain()";
+    fs.close();
+    makeExecutable(options.output);
+}
+
+void generateHybrid(std::shared_ptr<Program> program, Options const &options) {
+    std::set<std::string> native;
+
+    for (std::shared_ptr<Function> function : program->functions()) {
+        if (function->native()) {
+            native.insert(function->id());
+        }
+    }
+    if (!native.empty()) {
+        std::string library = options.output + ".so";
+        std::string source = options.output + ".c";
+        std::unique_ptr<ir::Module> module = lower(program);
+        if (errMgr.getErrors()) {
+            return;
+        }
+        std::ofstream cs(source);
+        ir::CEmitter().emitLibrary(cs, *module, native);
+        cs.close();
+        std::string command = options.cc + " -O2 -shared -fPIC -o " +
+                              quote(library) + " " + quote(source) + " -lm";
+        if (std::system(command.c_str()) != 0) {
+            std::cerr << "error: the compilation of " << source << " failed."
+                      << std::endl;
+            errMgr.addError("the compilation of " + source + " failed.");
+            return;
+        }
+        program->native(std::filesystem::path(library).filename().string());
+    }
+    std::ofstream fs(options.output);
+    program->compile(fs);
+    fs.close();
+    makeExecutable(options.output);
+}
+
+void generateNative(std::shared_ptr<Program> program, Options const &options) {
+    std::unique_ptr<ir::Module> module = lower(program);
+
+    if (errMgr.getErrors()) {
+        return;
+    }
+    try {
+        x86::CodeGenerator().generate(*module, options.output);
+    } catch (std::runtime_error &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        errMgr.addError(e.what());
+        return;
+    }
+    makeExecutable(options.output);
+}
+
+int run(std::shared_ptr<Program> program) {
+    std::unique_ptr<ir::Module> module = lower(program);
+    vm::Program bytecode;
+
+    if (errMgr.getErrors()) {
+        return 1;
+    }
+    try {
+        bytecode = vm::Compiler().compile(*module);
+    } catch (std::runtime_error &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    module.reset();
+    try {
+        vm::Machine(bytecode).run();
+    } catch (vm::Error &e) {
+        std::fflush(stdout);
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int execute(std::shared_ptr<Program> program, Options const &options) {
+    std::ostringstream script;
+
+    if (options.viaIR) {
+        generateFromIR(script, program, options);
+    } else {
+        program->compile(script);
+    }
+    if (errMgr.getErrors()) {
+        return 1;
+    }
+    try {
+        return executePython(script.str(), "<script>");
+    } catch (std::runtime_error &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+void generateScript(std::shared_ptr<Program> program, Options const &options) {
+    std::string script = options.pyc.empty() ? options.output
+                                             : options.output + ".py";
+    std::ofstream fs(script);
+
+    if (options.emitIR || options.viaIR) {
+        generateFromIR(fs, program, options);
+    } else {
+        program->compile(fs);
+    }
+    fs.close();
+    if (!options.pyc.empty() && !errMgr.getErrors()) {
+        generatePyc(script, options);
+    }
+    if (!errMgr.getErrors()) {
+        makeExecutable(options.output);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+#include "ast/program.hpp"
+#include "tools/options.hpp"
+#include <memory>
+#include <string>
+
+/*
+ * Backends of the transpiler: they write (or run) the optimized program in the
+ * target of the options (see Options). Their errors are added to the error
+ * manager (see errMgr).
+ */
+
+/**
+ * @brief  Write the C program generated from the IR, and compile it when a
+ *         compiler is given (the source is then <output>.c).
+ */
+void generateC(std::shared_ptr<Program> program, Options const &options);
+
+/**
+ * @brief  Write one module per source file in the package <output>_modules (the
+ *         functions called in other files are imported from their module), and
+ *         the script that runs the main function in <output>.
+ */
+void generateModules(std::shared_ptr<Program> program, Options const &options);
+
+/**
+ * @brief  Compile the native functions (see NativeSelector) in the shared
+ *         library <output>.so, and write the script that calls them.
+ */
+void generateHybrid(std::shared_ptr<Program> program, Options const &options);
+
+/**
+ * @brief  Write the x86-64 executable generated from the IR.
+ */
+void generateNative(std::shared_ptr<Program> program, Options const &options);
+
+/**
+ * @brief  Compile the program in bytecode and run it in the virtual machine,
+ *         the errors of the program are written like the python exceptions.
+ */
+int run(std::shared_ptr<Program> program);
+
+/**
+ * @brief  Compile the script in memory and run it in the embedded python,
+ *         without writing it, the result is the exit status of the script.
+ */
+int execute(std::shared_ptr<Program> program, Options const &options);
+
+/**
+ * @brief  Write the python script (or the IR with `--emit-ir`), and compile it
+ *         in bytecode with `--pyc` (the script is then <output>.py).
+ */
+void generateScript(std::shared_ptr<Program> program, Options const &options);
+
+#endif
@@ -0,0 +1,273 @@
+#include "options.hpp"
+#include <algorithm>
+#include <ostream>
+
+/**
+ * @brief  Parse the value of a numeric option.
+ */
+static size_t parseSize(std::string const &option, std::string const &value) {
+    if (value.empty() ||
+        value.find_first_not_of("0123456789") != std::string::npos) {
+        throw std::invalid_argument("bad value in " + option + ".");
+    }
+    return std::stoul(value);
+}
+
+/**
+ * @brief  Parse the file name given to an option.
+ */
+static std::string parseFile(std::string const &option,
+                             std::string const &value) {
+    if (value.empty()) {
+        throw std::invalid_argument("no file given in " + option + ".");
+    }
+    return value;
+}
+
+/**
+ * @brief  Parse a list of names separated by commas.
+ */
+static std::list<std::string> parseNames(std::string const &option,
+                                         std::string const &value) {
+    std::list<std::string> names;
+    size_t start = 0;
+
+    while (start <= value.size()) {
+        size_t end = std::min(value.find(',', start), value.size());
+        names.push_back(parseFile(option, value.substr(start, end - start)));
+        start = end + 1;
+    }
+    return names;
+}
+
+/**
+ * @brief  Parse the command line arguments.
+ *
+ * @throws  std::invalid_argument on unknown option or missing input file.
+ */
+Options parseOptions(int argc, char **argv) {
+    Options options;
+    bool instrument = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-o" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--memoize") {
+            options.memoize = true;
+        } else if (arg == "--vectorize") {
+            options.vectorize = true;
+        } else if (arg == "--emit-ir") {
+            options.emitIR = true;
+        } else if (arg == "--via-ir") {
+            options.viaIR = true;
+        } else if (arg == "--native") {
+            options.native = true;
+        } else if (arg.rfind("--native=", 0) == 0) {
+            options.native = true;
+            options.nativeFunctions = parseNames(arg, arg.substr(9));
+        } else if (arg == "--typed") {
+            options.typed = true;
+        } else if (arg == "--modules") {
+            options.modules = true;
+        } else if (arg == "--run") {
+            options.run = true;
+        } else if (arg == "--exec") {
+            options.exec = true;
+        } else if (arg == "--profile-generate") {
+            instrument = true;
+        } else if (arg.rfind("--profile-generate=", 0) == 0) {
+            instrument = true;
+            options.profileGenerate = parseFile(arg, arg.substr(19));
+        } else if (arg.rfind("--profile-use=", 0) == 0) {
+            options.profileUse = parseFile(arg, arg.substr(14));
+        } else if (arg == "--target=python") {
+            options.target = Options::PYTHON;
+        } else if (arg == "--target=c") {
+            options.target = Options::C;
+        } else if (arg == "--target=x86_64") {
+            options.target = Options::X86_64;
+        } else if (arg == "--cc") {
+            options.cc = "cc";
+        } else if (arg.rfind("--cc=", 0) == 0) {
+            options.cc = parseFile(arg, arg.substr(5));
+        } else if (arg == "--pyc") {
+            options.pyc = "python3";
+        } else if (arg.rfind("--pyc=", 0) == 0) {
+            options.pyc = parseFile(arg, arg.substr(6));
+        } else if (arg.rfind("--inline-threshold=", 0) == 0) {
+            options.inlineThreshold = parseSize(arg, arg.substr(19));
+        } else if (arg.rfind("--eval-steps=", 0) == 0) {
+            options.evalSteps = parseSize(arg, arg.substr(13));
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            throw std::invalid_argument("unknown option " + arg + ".");
+        } else if (options.input.empty()) {
+            options.input = arg;
+        } else {
+            throw std::invalid_argument("more than one input file given.");
+        }
+    }
+    if (options.input.empty()) {
+        throw std::invalid_argument("no input file given.");
+    }
+    if (instrument && !options.profileUse.empty()) {
+        throw std::invalid_argument(
+            "--profile-generate and --profile-use can't be used together.");
+    } else if (instrument && (options.emitIR || options.viaIR)) {
+        throw std::invalid_argument(
+            "the script generated from the IR can't be instrumented.");
+    } else if (instrument && options.target == Options::C) {
+        throw std::invalid_argument("the C program can't be instrumented.");
+    } else if (instrument && options.target == Options::X86_64) {
+        throw std::invalid_argument("the executable can't be instrumented.");
+    } else if (instrument && options.native) {
+        throw std::invalid_argument(
+            "the native functions can't be instrumented.");
+    } else if (instrument && options.modules) {
+        throw std::invalid_argument("the modules can't be instrumented.");
+    } else if (instrument && options.profileGenerate.empty()) {
+        options.profileGenerate = options.output + ".profile";
+    }
+    if (options.run &&
+        (instrument || options.emitIR || options.target != Options::PYTHON)) {
+        throw std::invalid_argument("--run doesn't generate a program, it "
+                                    "can't be used with --profile-generate, "
+                                    "--emit-ir or --target.");
+    } else if (options.exec &&
+               (options.emitIR || options.target != Options::PYTHON ||
+                options.run || options.native || options.modules ||
+                !options.pyc.empty())) {
+        throw std::invalid_argument("--exec runs the script in the compiler, "
+                                    "it can't be used with --emit-ir, --run, "
+                                    "--native, --modules, --pyc or --target.");
+    }
+    if (!options.cc.empty() && options.target != Options::C &&
+        !options.native) {
+        throw std::invalid_argument("--cc compiles the C program, it needs "
+                                    "--target=c or --native.");
+    } else if (options.native &&
+               (options.target != Options::PYTHON || options.emitIR ||
+                options.viaIR || options.run || options.modules ||
+                !options.pyc.empty())) {
+        throw std::invalid_argument("--native compiles functions of the script "
+                                    "generated from the AST, it can't be used "
+                                    "with --emit-ir, --via-ir, --run, "
+                                    "--modules, --pyc or --target.");
+    } else if (options.native && options.nativeFunctions.empty() &&
+               options.profileUse.empty()) {
+        throw std::invalid_argument("--native needs the names of the "
+                                    "functions or a profile (--profile-use).");
+    } else if (!options.pyc.empty() &&
+               (options.target != Options::PYTHON || options.emitIR ||
+                options.run)) {
+        throw std::invalid_argument("--pyc compiles the python script, it "
+                                    "can't be used with --emit-ir, --run or "
+                                    "--target.");
+    } else if (options.modules &&
+               (options.target != Options::PYTHON || options.emitIR ||
+                options.viaIR || options.run || !options.pyc.empty())) {
+        throw std::invalid_argument("--modules splits the script generated "
+                                    "from the AST, it can't be used with "
+                                    "--emit-ir, --via-ir, --run, --pyc or "
+                                    "--target.");
+    } else if (options.typed &&
+               (options.target != Options::PYTHON || options.emitIR ||
+                options.viaIR || options.run)) {
+        throw std::invalid_argument("--typed annotates the script generated "
+                                    "from the AST, it can't be used with "
+                                    "--emit-ir, --via-ir, --run or --target.");
+    } else if (options.typed && options.vectorize) {
+        throw std::invalid_argument(
+            "--typed and --vectorize can't be used together.");
+    } else if (options.emitIR && options.target == Options::C) {
+        throw std::invalid_argument(
+            "--emit-ir and --target=c can't be used together.");
+    } else if (options.emitIR && options.target == Options::X86_64) {
+        throw std::invalid_argument(
+            "--emit-ir and --target=x86_64 can't be used together.");
+    }
+    if (options.native && options.cc.empty()) {
+        options.cc = "cc";
+    }
+    return options;
+}
+
+void printUsage(std::ostream &os, std::string const &program) {
+    os << "usage: " << program << " <file> [options]" << std::endl
+       << "options:" << std::endl
+       << "  -o <file>  name of the generated script (default: a.out)"
+       << std::endl
+       << "  --stats    print the statistics of the optimizations"
+       << std::endl
+       << "  --inline-threshold=<n>" << std::endl
+       << "             maximal size (in AST nodes) of the inlined functions,"
+       << std::endl
+       << "             0 disables the inlining (default: 50)" << std::endl
+       << "  --eval-steps=<n>" << std::endl
+       << "             maximal number of steps of the compile-time evaluation"
+       << std::endl
+       << "             of a call, 0 disables it (default: 1000000)"
+       << std::endl
+       << "  --memoize  cache the results of the pure recursive functions"
+       << std::endl
+       << "  --vectorize" << std::endl
+       << "             generate the element-wise loops on arrays with NumPy"
+       << std::endl
+       << "  --profile-generate[=<file>]" << std::endl
+       << "             count the calls and the iterations in the script, which"
+       << std::endl
+       << "             adds them to the profile file when it exits (default:"
+       << std::endl
+       << "             <script>.profile)" << std::endl
+       << "  --profile-use=<file>" << std::endl
+       << "             guide the inlining, the vectorization and the layout of"
+       << std::endl
+       << "             the conditions with a profile" << std::endl
+       << "  --emit-ir  write the SSA intermediate representation instead of"
+       << std::endl
+       << "             the script" << std::endl
+       << "  --via-ir   generate the script from the intermediate"
+       << std::endl
+       << "             representation" << std::endl
+       << "  --target=python|c|x86_64" << std::endl
+       << "             language of the generated program (default: python),"
+       << std::endl
+       << "             the C program and the x86-64 executable (Linux) are"
+       << std::endl
+       << "             generated from the IR" << std::endl
+       << "  --cc[=<compiler>]" << std::endl
+       << "             compile the C program with `<compiler> -O2` (default:"
+       << std::endl
+       << "             cc), the C source is <output>.c" << std::endl
+       << "  --native[=<function>,...]" << std::endl
+       << "             compile the functions (default: the hot ones of the"
+       << std::endl
+       << "             profile) in the library <output>.so, which the script"
+       << std::endl
+       << "             calls through ctypes (the C source is <output>.c)"
+       << std::endl
+       << "  --pyc[=<python>]" << std::endl
+       << "             compile the script in bytecode with <python> (default:"
+       << std::endl
+       << "             python3), <output> is then a zipapp that runs the"
+       << std::endl
+       << "             bytecode and the script is <output>.py" << std::endl
+       << "  --typed    annotate the types of the functions and of their locals"
+       << std::endl
+       << "             in the script, which can be compiled with mypyc or"
+       << std::endl
+       << "             Cython" << std::endl
+       << "  --modules  write one python module per source file in the package"
+       << std::endl
+       << "             <output>_modules, <output> is the script that runs it"
+       << std::endl
+       << "  --run      run the program in the virtual machine of the compiler"
+       << std::endl
+       << "             instead of generating it" << std::endl
+       << "  --exec     compile the script in memory and run it in the python"
+       << std::endl
+       << "             embedded in the compiler" << std::endl;
+}
@@ -0,0 +1,45 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+#include <cstddef>
+#include <list>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief  Command line options of the transpiler:
+ *         `s3c <file> [options]`
+ */
+struct Options {
+    enum Target { PYTHON, C, X86_64 };
+
+    std::string input = "";       //< main file of the program
+    std::string output = "a.out"; //< generated script
+    bool stats = false;           //< print the statistics of the optimizations
+    size_t inlineThreshold = 50;  //< maximal size of the inlined functions
+    bool memoize = false;         //< cache the results of the pure functions
+    bool vectorize = false;       //< use NumPy for the element-wise loops
+    size_t evalSteps = 1000000;   //< maximal steps of a compile-time call
+    bool emitIR = false;          //< write the IR instead of the script
+    bool viaIR = false;           //< generate the script from the IR
+
+    std::string profileGenerate = ""; //< profile written by the script
+    std::string profileUse = "";      //< profile that guides the optimizations
+
+    Target target = PYTHON; //< language of the generated program
+    std::string cc = "";    //< compiler of the C program (none if empty)
+    bool run = false;       //< run the program in the virtual machine
+    bool exec = false;      //< run the script in the embedded python
+    std::string pyc = "";   //< python that compiles the script (none if empty)
+    bool modules = false;   //< one python module per source file
+    bool typed = false;     //< annotate the types in the script
+    // functions compiled in a shared library (the hot ones of the profile
+    // when the list is empty)
+    bool native = false;
+    std::list<std::string> nativeFunctions = {};
+};
+
+Options parseOptions(int argc, char **argv);
+void printUsage(std::ostream &os, std::string const &program);
+
+#endif
@@ -85,7 +85,8 @@ void ProgramBuilder::newFuncall(std::string name) {
 
 void ProgramBuilder::createFunction(std::string name,
                                     std::shared_ptr<Block> operations,
-                                    PrimitiveType returnType) {
+                                    PrimitiveType returnType,
+                                    std::string const &file) {
     std::list<PrimitiveType> type;
     for (Variable v : funParams) {
         type.push_back(v.type());
@@ -93,8 +94,11 @@ void ProgramBuilder::createFunction(std::string name,
     type.push_back(returnType);
     std::shared_ptr<Function> newfun =
         std::make_shared<Function>(name, funParams, operations, type);
+    newfun->file(file);
+    newfun->sizes(funParamsSizes);
     program->addFunction(newfun);
     funParams.clear();
+    funParamsSizes.clear();
 }
 
 void ProgramBuilder::pushFuncallParam(std::shared_ptr<TypedNode> newParam) {
@@ -107,6 +111,12 @@ void ProgramBuilder::pushFuncallParam(std::shared_ptr<TypedNode> newParam) {
 
 void ProgramBuilder::pushFunctionParam(Variable newParam) {
     funParams.push_back(newParam);
+    funParamsSizes.push_back(0);
+}
+
+void ProgramBuilder::pushFunctionParam(Array const &newParam) {
+    funParams.push_back(newParam);
+    funParamsSizes.push_back(newParam.size());
 }
 
 /******************************************************************************/
@@ -2,6 +2,7 @@
 #define PROGRAMBUILDER_H
 #include "ast/program.hpp"
 #include <memory>
+#include <string>
 
 // TODO: cette classe doit être utilisée pour construire l'abre avec le parser.
 // elle doit contenir des piles tampons pour pouvoir ajouter les opération, les
@@ -36,9 +37,11 @@ class ProgramBuilder {
 
     void pushFuncallParam(std::shared_ptr<TypedNode>);
     void pushFunctionParam(Variable);
+    void pushFunctionParam(Array const &);
     void newFuncall(std::string);
 
-    void createFunction(std::string, std::shared_ptr<Block>, PrimitiveType);
+    void createFunction(std::string, std::shared_ptr<Block>, PrimitiveType,
+                        std::string const &file);
 
   private:
     std::shared_ptr<Program> program = nullptr; // current program
@@ -46,6 +49,7 @@ class ProgramBuilder {
         {};                             // stack of blocks (the last
                                         // element is the current block)
     std::list<Variable> funParams = {}; // parameters of the last function
+    std::list<int> funParamsSizes = {}; // their sizes (0 for the scalars)
     std::list<std::list<std::shared_ptr<TypedNode>>> funcallParams =
         {}; // parameters of the last funcall
     // NOTE: maybe move this to the .y file as global variable:
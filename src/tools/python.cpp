@@ -0,0 +1,65 @@
+// Python.h must be included before the standard headers
+#ifdef S3C_PYTHON
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#endif
+#include "python.hpp"
+#include <cstdio>
+#include <iostream>
+
+#ifdef S3C_PYTHON
+
+int executePython(std::string const &script, std::string const &name) {
+    PyConfig config;
+    PyStatus status;
+    int result = 0;
+
+    // the output of the compiler is written before the one of the script
+    std::cout.flush();
+    std::fflush(stdout);
+
+    PyConfig_InitPythonConfig(&config);
+    config.parse_argv = 0;
+    char *argv[] = {const_cast<char *>(name.c_str())};
+    status = PyConfig_SetBytesArgv(&config, 1, argv);
+    if (!PyStatus_Exception(status)) {
+        status = Py_InitializeFromConfig(&config);
+    }
+    PyConfig_Clear(&config);
+    if (PyStatus_Exception(status)) {
+        throw std::runtime_error(
+            std::string("python can't be initialized: ") +
+            (status.err_msg == nullptr ? "unknown error" : status.err_msg) +
+            ".");
+    }
+
+    PyObject *code =
+        Py_CompileString(script.c_str(), name.c_str(), Py_file_input);
+    PyObject *value = nullptr;
+    if (code != nullptr) {
+        // borrowed references
+        PyObject *globals = PyModule_GetDict(PyImport_AddModule("__main__"));
+        value = PyEval_EvalCode(code, globals, globals);
+        Py_DECREF(code);
+    }
+    if (value == nullptr) {
+        // writes the traceback (or exits on SystemExit, like python)
+        PyErr_Print();
+        result = 1;
+    }
+    Py_XDECREF(value);
+    // flushes the output of the script and runs its atexit functions
+    if (Py_FinalizeEx() < 0) {
+        result = 120;
+    }
+    return result;
+}
+
+#else
+
+int executePython(std::string const &, std::string const &) {
+    throw std::runtime_error("s3c is built without python, --exec is not "
+                             "available.");
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef PYTHON_H
+#define PYTHON_H
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief  Compile the script in memory and run it in the python interpreter
+ *         embedded in the compiler (see `--exec`): the script uses the
+ *         standard input and output of the compiler, and its tracebacks are
+ *         written on the error output like python does.
+ *
+ * @param  script  source of the script
+ * @param  name  name of the script in the tracebacks
+ * @return  exit status of the script (1 when it raised an exception)
+ * @throws  std::runtime_error when python can't be initialized, or when the
+ *          compiler is built without it.
+ */
+int executePython(std::string const &script, std::string const &name);
+
+#endif
@@ -0,0 +1,455 @@
+#include "bytecode.hpp"
+#include "ast/python.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace vm {
+
+Program Compiler::compile(ir::Module const &module) {
+    program_ = Program();
+    module_ = &module;
+    functions_.clear();
+    strings_.clear();
+    // the calls can come before the callee
+    for (auto const &function : module.functions()) {
+        functions_[function->name()] = program_.functions.size();
+        program_.functions.emplace_back();
+        program_.functions.back().name = function->name();
+    }
+    for (auto const &function : module.functions()) {
+        compile(*function);
+    }
+    program_.main = functions_.at("main");
+    return std::move(program_);
+}
+
+/**
+ * @brief  The blocks are translated in their order, the jumps to the next
+ *         block are removed and the other ones are patched at the end.
+ */
+void Compiler::compile(ir::Function const &function) {
+    function_ = &program_.functions[functions_[function.name()]];
+    registers_.clear();
+    constants_.clear();
+    scratch_.clear();
+    flags_.clear();
+    copies_.clear();
+    escaping_.clear();
+    labels_.clear();
+    jumps_.clear();
+    unbound_ = ir::unboundPhis(function);
+
+    for (auto const &parameter : function.parameters()) {
+        reg(parameter.get());
+    }
+    function_->parameters = function.parameters().size();
+    for (ir::Value const *phi : unbound_) {
+        flags_[phi] = allocate();
+    }
+    for (auto const &block : function.blocks()) {
+        for (auto const &instruction : block->instructions()) {
+            if (instruction->opcode() != ir::Opcode::Phi) {
+                continue;
+            }
+            escaping_.insert(instruction->operands().begin(),
+                             instruction->operands().end());
+            for (size_t i = 0; i < instruction->targets().size(); ++i) {
+                auto &copies =
+                    copies_[{instruction->targets()[i], block.get()}];
+                // a block can be twice a predecessor (branch to the same
+                // block)
+                if (copies.empty() ||
+                    copies.back().first != instruction.get()) {
+                    copies.push_back(
+                        {instruction.get(), instruction->operands()[i]});
+                }
+            }
+        }
+    }
+
+    auto const &blocks = function.blocks();
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        labels_[blocks[i].get()] = function_->code.size();
+        next_ = i + 1 < blocks.size() ? blocks[i + 1].get() : nullptr;
+        for (auto const &instruction : blocks[i]->instructions()) {
+            if (instruction->opcode() != ir::Opcode::Phi) {
+                compile(*instruction);
+            }
+        }
+    }
+    for (auto const &[index, field, block] : jumps_) {
+        uint16_t target = operand(labels_[block], "instructions");
+        (field == 0 ? function_->code[index].a : function_->code[index].b) =
+            target;
+    }
+    operand(function_->code.size(), "instructions");
+}
+
+void Compiler::compile(ir::Instruction const &instruction) {
+    auto const &operands = instruction.operands();
+    ir::Opcode opcode = instruction.opcode();
+    PrimitiveType type = instruction.type();
+
+    // the variables that may not be assigned are checked where they are read
+    for (ir::Value const *value : operands) {
+        if (value->kind() == ir::Value::UNDEFINED) {
+            Slot zero = {0};
+            emit(CHECK, constant(zero, INT), string(value->name()));
+        } else if (unbound_.count(value)) {
+            auto phi = static_cast<ir::Instruction const *>(value);
+            emit(CHECK, flags_[value], string(phi->symbol()));
+        }
+    }
+
+    switch (opcode) {
+    case ir::Opcode::Add:
+        binary(instruction, ADDI, ADDF);
+        break;
+    case ir::Opcode::Sub:
+        binary(instruction, SUBI, SUBF);
+        break;
+    case ir::Opcode::Mul:
+        binary(instruction, MULI, MULF);
+        break;
+    case ir::Opcode::Div:
+        binary(instruction, DIVI, DIVF);
+        break;
+    case ir::Opcode::Eq:
+        binary(instruction, EQI, EQF);
+        break;
+    // the comparisons `>` and `>=` swap their operands
+    case ir::Opcode::Gt:
+        binary(instruction, LTI, LTF, true);
+        break;
+    case ir::Opcode::Lt:
+        binary(instruction, LTI, LTF);
+        break;
+    case ir::Opcode::Ge:
+        binary(instruction, LEI, LEF, true);
+        break;
+    case ir::Opcode::Le:
+        binary(instruction, LEI, LEF);
+        break;
+    case ir::Opcode::Not:
+        emit(NOT, reg(&instruction), truth(operands[0], 0));
+        break;
+    case ir::Opcode::Xor:
+        emit(XOR, reg(&instruction), truth(operands[0], 0),
+             truth(operands[1], 1));
+        break;
+    case ir::Opcode::Conv: {
+        PrimitiveType source = operands[0]->type();
+        if (type == INT) {
+            emit(source == FLT ? FTOI : CTOI, reg(&instruction),
+                 reg(operands[0]));
+        } else if (type == FLT) {
+            emit(source == CHR ? CTOF : ITOF, reg(&instruction),
+                 reg(operands[0]));
+        } else if (source == FLT) {
+            emit(FTOI, scratch(0), reg(operands[0]));
+            emit(ITOC, reg(&instruction), scratch(0));
+        } else {
+            emit(ITOC, reg(&instruction), reg(operands[0]));
+        }
+    } break;
+    case ir::Opcode::NewArray: {
+        Slot size;
+        size.i = static_cast<long long>(instruction.size());
+        emit(NEWA, reg(&instruction), constant(size, INT),
+             escaping_.count(&instruction) ? 0 : 1);
+    } break;
+    case ir::Opcode::Load:
+        emit(LOAD, reg(&instruction), reg(operands[0]), reg(operands[1]));
+        break;
+    case ir::Opcode::Store:
+        emit(STORE, reg(operands[0]), reg(operands[1]),
+             coerce(operands[2], getValueType(operands[0]->type()), 0));
+        break;
+    case ir::Opcode::Call: {
+        auto const &parameters =
+            module_->function(instruction.symbol())->parameters();
+        std::vector<uint16_t> arguments;
+        for (size_t i = 0; i < operands.size(); ++i) {
+            arguments.push_back(
+                coerce(operands[i], parameters[i]->type(), i));
+        }
+        emit(CALL, reg(&instruction), functions_.at(instruction.symbol()),
+             arguments.size());
+        arguments.resize((arguments.size() + 2) / 3 * 3, 0);
+        for (size_t i = 0; i < arguments.size(); i += 3) {
+            emit(ARG, arguments[i], arguments[i + 1], arguments[i + 2]);
+        }
+    } break;
+    case ir::Opcode::Print:
+        if (operands.empty()) {
+            emit(PRTS, string(utf8(instruction.symbol())));
+            break;
+        }
+        switch (operands[0]->type()) {
+        case FLT:
+            emit(PRTF, reg(operands[0]));
+            break;
+        case CHR:
+            emit(PRTC, reg(operands[0]));
+            break;
+        case ARR_INT:
+            emit(PRTAI, reg(operands[0]));
+            break;
+        case ARR_FLT:
+            emit(PRTAF, reg(operands[0]));
+            break;
+        case ARR_CHR:
+            emit(PRTAC, reg(operands[0]));
+            break;
+        default:
+            emit(PRTI, reg(operands[0]));
+            break;
+        }
+        break;
+    case ir::Opcode::Read:
+        emit(type == FLT ? READF : type == CHR ? READC : READI,
+             reg(&instruction));
+        break;
+    case ir::Opcode::Jump:
+        edge(instruction.block(), instruction.targets()[0]);
+        break;
+    case ir::Opcode::Branch: {
+        ir::Block const *onFalse = instruction.targets()[1];
+        if (copies_.count({instruction.block(), onFalse})) {
+            // the copies of the false edge follow the ones of the true edge
+            size_t branch = function_->code.size();
+            emit(JMPF, truth(operands[0], 0));
+            edge(instruction.block(), instruction.targets()[0], true);
+            function_->code[branch].b =
+                operand(function_->code.size(), "instructions");
+            edge(instruction.block(), onFalse);
+        } else {
+            jumps_.emplace_back(function_->code.size(), 1, onFalse);
+            emit(JMPF, truth(operands[0], 0));
+            edge(instruction.block(), instruction.targets()[0]);
+        }
+    } break;
+    case ir::Opcode::Ret:
+        if (!operands.empty()) {
+            emit(RET, coerce(operands[0],
+                             instruction.block()->function()->type(), 0));
+        } else if (instruction.block()->function()->type() != NIL) {
+            // the function ends without `ret` (the script returns None)
+            Slot zero = {0};
+            emit(RET, constant(zero, instruction.block()->function()->type()));
+        } else {
+            emit(RETN);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief  Assign the phis of the target with their values for the edge from
+ *         the source (through scratch registers when there are several, the
+ *         copies are parallel), and jump to the target unless it is the next
+ *         block. The phis that may be unbound have a flag, which is 0 when the
+ *         variable is not assigned.
+ */
+void Compiler::edge(ir::Block const *source, ir::Block const *target,
+                    bool jump) {
+    // opcode (a MOV or a conversion), phi and value of the assignments
+    std::vector<std::tuple<Opcode, uint16_t, uint16_t>> moves;
+    Slot zero = {0};
+    Slot one = {1};
+
+    auto copies = copies_.find({source, target});
+    if (copies != copies_.end()) {
+        for (auto const &[phi, value] : copies->second) {
+            if (value->kind() != ir::Value::UNDEFINED) {
+                moves.emplace_back(conversion(phi->type(), value->type()),
+                                   reg(phi), reg(value));
+            }
+            if (value->kind() == ir::Value::UNDEFINED) {
+                moves.emplace_back(MOV, flags_[phi], constant(zero, INT));
+            } else if (unbound_.count(phi) && unbound_.count(value)) {
+                moves.emplace_back(MOV, flags_[phi], flags_[value]);
+            } else if (unbound_.count(phi)) {
+                moves.emplace_back(MOV, flags_[phi], constant(one, INT));
+            }
+        }
+    }
+    if (moves.size() == 1) {
+        auto [opcode, phi, value] = moves[0];
+        emit(opcode, phi, value);
+    } else {
+        for (size_t i = 0; i < moves.size(); ++i) {
+            emit(std::get<0>(moves[i]), scratch(i), std::get<2>(moves[i]));
+        }
+        for (size_t i = 0; i < moves.size(); ++i) {
+            emit(MOV, std::get<1>(moves[i]), scratch(i));
+        }
+    }
+    if (jump || target != next_) {
+        jumps_.emplace_back(function_->code.size(), 0, target);
+        emit(JMP);
+    }
+}
+
+void Compiler::emit(Opcode opcode, size_t a, size_t b, size_t c) {
+    function_->code.push_back({opcode, operand(a, "registers"),
+                               operand(b, "registers"),
+                               operand(c, "registers")});
+}
+
+/**
+ * @brief  Register of a value, the registers of the results are created when
+ *         they are first used.
+ */
+uint16_t Compiler::reg(ir::Value const *value) {
+    if (value->kind() == ir::Value::CONSTANT) {
+        Slot slot;
+        if (value->type() == FLT) {
+            slot.f = value->floating();
+        } else {
+            slot.i = value->integer();
+        }
+        return constant(slot, value->type());
+    } else if (value->kind() == ir::Value::UNDEFINED) {
+        // never read (see CHECK)
+        Slot zero = {0};
+        return constant(zero, value->type());
+    }
+    auto found = registers_.find(value);
+    if (found != registers_.end()) {
+        return found->second;
+    }
+    uint16_t index = allocate();
+    registers_[value] = index;
+    return index;
+}
+
+/**
+ * @brief  Register of a constant, the constants are in the initial frame.
+ */
+uint16_t Compiler::constant(Slot value, PrimitiveType type) {
+    long long bits;
+
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto found = constants_.find({type, bits});
+    if (found != constants_.end()) {
+        return found->second;
+    }
+    uint16_t index = allocate();
+    function_->frame[index] = value;
+    constants_[{type, bits}] = index;
+    return index;
+}
+
+uint16_t Compiler::allocate() {
+    Slot zero = {0};
+
+    function_->frame.push_back(zero);
+    return operand(function_->frame.size() - 1, "registers");
+}
+
+/**
+ * @brief  Temporary register number `index` of the function.
+ */
+uint16_t Compiler::scratch(size_t index) {
+    while (scratch_.size() <= index) {
+        scratch_.push_back(allocate());
+    }
+    return scratch_[index];
+}
+
+/**
+ * @brief  Opcode that gives a value of type `source` to a register of type
+ *         `target`: the script computes with the value itself, the floats are
+ *         truncated where the machine needs an integer.
+ */
+Opcode Compiler::conversion(PrimitiveType target, PrimitiveType source) {
+    if (target == FLT && (source == INT || source == CHR)) {
+        return ITOF;
+    } else if ((target == INT || target == CHR) && source == FLT) {
+        return FTOI;
+    }
+    return MOV;
+}
+
+/**
+ * @brief  Register of a value given to a register of type `type`, converted
+ *         in the temporary register `index` if needed.
+ */
+uint16_t Compiler::coerce(ir::Value const *value, PrimitiveType type,
+                          size_t index) {
+    Opcode opcode = conversion(type, value->type());
+
+    if (opcode == MOV) {
+        return reg(value);
+    }
+    emit(opcode, scratch(index), reg(value));
+    return scratch(index);
+}
+
+/**
+ * @brief  Arithmetic operation or comparison, on floats if one of the operands
+ *         or the result is a float.
+ */
+void Compiler::binary(ir::Instruction const &instruction, Opcode integer,
+                      Opcode floating, bool swap) {
+    ir::Value const *left = instruction.operands()[swap ? 1 : 0];
+    ir::Value const *right = instruction.operands()[swap ? 0 : 1];
+    bool real = left->type() == FLT || right->type() == FLT ||
+                instruction.type() == FLT;
+    bool comparison = floating == EQF || floating == LTF || floating == LEF;
+
+    if (!real) {
+        emit(integer, reg(&instruction), reg(left), reg(right));
+    } else if (floating == DIVF && left->type() == INT &&
+               right->type() == INT) {
+        // python: "float division" only when an operand is a float
+        emit(DIVIF, reg(&instruction), reg(left), reg(right));
+    } else if (instruction.type() == FLT || comparison) {
+        emit(floating, reg(&instruction), coerce(left, FLT, 0),
+             coerce(right, FLT, 1));
+    } else {
+        // a float given to an integer
+        emit(floating, scratch(2), coerce(left, FLT, 0),
+             coerce(right, FLT, 1));
+        emit(FTOI, reg(&instruction), scratch(2));
+    }
+}
+
+/**
+ * @brief  Register of a condition: the floats are compared to 0 in the
+ *         temporary register `index`.
+ */
+uint16_t Compiler::truth(ir::Value const *value, size_t index) {
+    if (value->type() != FLT) {
+        return reg(value);
+    }
+    emit(TSTF, scratch(index), reg(value));
+    return scratch(index);
+}
+
+uint16_t Compiler::string(std::string const &text) {
+    auto found = strings_.find(text);
+    if (found != strings_.end()) {
+        return operand(found->second, "strings");
+    }
+    strings_[text] = program_.strings.size();
+    program_.strings.push_back(text);
+    return operand(program_.strings.size() - 1, "strings");
+}
+
+/**
+ * @brief  Check that a number fits in an operand.
+ */
+uint16_t Compiler::operand(size_t value, char const *what) const {
+    if (value > UINT16_MAX) {
+        throw std::runtime_error("the function " + function_->name +
+                                 " has too many " + what +
+                                 " for the virtual machine.");
+    }
+    return static_cast<uint16_t>(value);
+}
+
+} // namespace vm
@@ -0,0 +1,172 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+#include "ir/ir.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief  Bytecode of the virtual machine that runs the programs in the
+ *         compiler (see `--run`). It is a register machine: each function has
+ *         a frame of registers, the parameters first, then the constants,
+ *         then one register per value of the IR. The instructions have three
+ *         16 bits operands (registers, jump targets or indices in the tables
+ *         of the program) and the opcodes give the type of the registers
+ *         (int, flt or chr, the characters are given by their code).
+ */
+namespace vm {
+
+/*
+ * opcodes of the instructions, the operands are written a, b and c
+ */
+#define VM_OPCODES(X)                                                          \
+    X(MOV)   /* a = b */                                                       \
+    X(ADDI)  /* a = b + c (the int operations stop on overflow) */             \
+    X(SUBI)                                                                    \
+    X(MULI)                                                                    \
+    X(DIVI)  /* division rounded toward zero */                                \
+    X(ADDF)                                                                    \
+    X(SUBF)                                                                    \
+    X(MULF)                                                                    \
+    X(DIVF)                                                                    \
+    X(DIVIF) /* a = b / c, true division of two int registers */               \
+    X(EQI)   /* a = b == c */                                                  \
+    X(EQF)                                                                     \
+    X(LTI)   /* a = b < c */                                                   \
+    X(LTF)                                                                     \
+    X(LEI)   /* a = b <= c */                                                  \
+    X(LEF)                                                                     \
+    X(NOT)   /* a = !b */                                                      \
+    X(XOR)   /* a = !b != !c */                                                \
+    X(TSTF)  /* a = b != 0.0 */                                                \
+    X(FTOI)  /* conversions: a = b */                                          \
+    X(CTOI)                                                                    \
+    X(CTOF)                                                                    \
+    X(ITOF)                                                                    \
+    X(ITOC)                                                                    \
+    X(NEWA)  /* a = array of b (int register) elements, reused if c != 0 */    \
+    X(LOAD)  /* a = b[c] */                                                    \
+    X(STORE) /* a[b] = c */                                                    \
+    X(CALL)  /* a = function b, c arguments given by the next ARG */           \
+    X(ARG)   /* arguments of a call: a, b, c */                                \
+    X(RET)   /* return a */                                                    \
+    X(RETN)  /* return without value */                                        \
+    X(JMP)   /* goto a */                                                      \
+    X(JMPF)  /* if !a goto b */                                                \
+    X(CHECK) /* stop if a is 0: the variable b (string) is not assigned */     \
+    X(PRTS)  /* print the string a */                                          \
+    X(PRTI)  /* print a */                                                     \
+    X(PRTF)                                                                    \
+    X(PRTC)                                                                    \
+    X(PRTAI)                                                                   \
+    X(PRTAF)                                                                   \
+    X(PRTAC)                                                                   \
+    X(READI) /* a = value read on the standard input */                        \
+    X(READF)                                                                   \
+    X(READC)
+
+enum Opcode : uint16_t {
+#define VM_ENUM(opcode) opcode,
+    VM_OPCODES(VM_ENUM)
+#undef VM_ENUM
+};
+
+struct Code {
+    Opcode opcode;
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+};
+
+/**
+ * @brief  Array of the machine: its size and its elements (allocated with
+ *         it).
+ */
+struct Array;
+
+/**
+ * @brief  Content of a register or of an element of an array.
+ */
+union Slot {
+    long long i;
+    double f;
+    Array *a;
+};
+
+struct Array {
+    long long size;
+    Slot *data;
+};
+
+struct Function {
+    std::string name;
+    std::vector<Code> code;
+    std::vector<Slot> frame; //< initial registers (the constants are set)
+    size_t parameters = 0;   //< the parameters are the first registers
+};
+
+struct Program {
+    std::vector<Function> functions;
+    std::vector<std::string> strings; //< printed strings and variable names
+    size_t main = 0;
+};
+
+/**
+ * @brief  Translation of the IR in bytecode. The phis are registers assigned
+ *         on the edges that lead to their block, like in the C backend (see
+ *         ir::CEmitter).
+ *
+ * @throws  std::runtime_error when a function has too many registers or
+ *          instructions for the 16 bits operands.
+ */
+class Compiler {
+  public:
+    Program compile(ir::Module const &module);
+
+  private:
+    void compile(ir::Function const &function);
+    void compile(ir::Instruction const &instruction);
+    void binary(ir::Instruction const &instruction, Opcode integer,
+                Opcode floating, bool swap = false);
+    void edge(ir::Block const *source, ir::Block const *target,
+              bool jump = false);
+    void emit(Opcode opcode, size_t a = 0, size_t b = 0, size_t c = 0);
+    uint16_t reg(ir::Value const *value);
+    uint16_t allocate();
+    uint16_t constant(Slot value, PrimitiveType type);
+    uint16_t scratch(size_t index);
+    static Opcode conversion(PrimitiveType target, PrimitiveType source);
+    uint16_t coerce(ir::Value const *value, PrimitiveType type, size_t index);
+    uint16_t truth(ir::Value const *value, size_t index);
+    uint16_t string(std::string const &text);
+    uint16_t operand(size_t value, char const *what) const;
+
+    ir::Module const *module_ = nullptr;
+    Program program_ = {};
+    Function *function_ = nullptr;
+    std::map<std::string, size_t> functions_ = {};
+    std::map<std::string, size_t> strings_ = {};
+    std::map<ir::Value const *, uint16_t> registers_ = {};
+    std::map<std::pair<PrimitiveType, long long>, uint16_t> constants_ = {};
+    std::vector<uint16_t> scratch_ = {};
+    std::set<ir::Value const *> escaping_ = {}; //< arrays that flow in a phi
+    std::set<ir::Value const *> unbound_ = {};  //< see ir::unboundPhis
+    std::map<ir::Value const *, uint16_t> flags_ = {}; //< of the unbound phis
+    // assignments of the phis on the edges (source and target blocks)
+    std::map<std::pair<ir::Block const *, ir::Block const *>,
+             std::vector<std::pair<ir::Value const *, ir::Value const *>>>
+            copies_ = {};
+    std::map<ir::Block const *, size_t> labels_ = {};
+    ir::Block const *next_ = nullptr; //< block after the current one
+    // jumps to patch: instruction, operand (0 for a, 1 for b), target block
+    std::vector<std::tuple<size_t, int, ir::Block const *>> jumps_ = {};
+};
+
+} // namespace vm
+
+#endif
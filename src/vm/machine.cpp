@@ -0,0 +1,736 @@
+#include "machine.hpp"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace vm {
+
+/**
+ * @brief  Maximal number of frames, deeper calls stop the program.
+ */
+static constexpr size_t MAX_DEPTH = 1000000;
+
+static char const *OVERFLOW_ERROR =
+    "OverflowError: integer overflow (the integers have 64 bits)";
+
+/******************************************************************************/
+/*                                 arithmetic                                 */
+/******************************************************************************/
+
+static long long add(long long a, long long b) {
+#if defined(__GNUC__)
+    long long r;
+    if (__builtin_add_overflow(a, b, &r)) {
+        throw Error(OVERFLOW_ERROR);
+    }
+    return r;
+#else
+    if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN - b)) {
+        throw Error(OVERFLOW_ERROR);
+    }
+    return a + b;
+#endif
+}
+
+static long long sub(long long a, long long b) {
+#if defined(__GNUC__)
+    long long r;
+    if (__builtin_sub_overflow(a, b, &r)) {
+        throw Error(OVERFLOW_ERROR);
+    }
+    return r;
+#else
+    if ((b < 0 && a > LLONG_MAX + b) || (b > 0 && a < LLONG_MIN + b)) {
+        throw Error(OVERFLOW_ERROR);
+    }
+    return a - b;
+#endif
+}
+
+static long long mul(long long a, long long b) {
+#if defined(__GNUC__)
+    long long r;
+    if (__builtin_mul_overflow(a, b, &r)) {
+        throw Error(OVERFLOW_ERROR);
+    }
+    return r;
+#else
+    if (a != 0 && b != 0 &&
+        (a > 0 ? (b > 0 ? a > LLONG_MAX / b : b < LLONG_MIN / a)
+               : (b > 0 ? a < LLONG_MIN / b : a < LLONG_MAX / b))) {
+        throw Error(OVERFLOW_ERROR);
+    }
+    return a * b;
+#endif
+}
+
+/**
+ * @brief  The quotient is rounded toward zero, like python's int(a/b).
+ */
+static long long divide(long long a, long long b) {
+    if (b == 0) {
+        throw Error("ZeroDivisionError: division by zero");
+    } else if (a == LLONG_MIN && b == -1) {
+        throw Error(OVERFLOW_ERROR);
+    }
+    return a / b;
+}
+
+/**
+ * @brief  Element of an array, the negative indices count from the end.
+ */
+static Slot &element(Array *array, long long index, char const *error) {
+    if (index < 0) {
+        index += array->size;
+    }
+    if (index < 0 || index >= array->size) {
+        throw Error(error);
+    }
+    return array->data[index];
+}
+
+/******************************************************************************/
+/*                                conversions                                 */
+/******************************************************************************/
+
+static long long toInt(double x) {
+    if (std::isnan(x)) {
+        throw Error("ValueError: cannot convert float NaN to integer");
+    } else if (std::isinf(x)) {
+        throw Error("OverflowError: cannot convert float infinity to integer");
+    } else if (x >= 9223372036854775808.0 || x < -9223372036854775808.0) {
+        throw Error(OVERFLOW_ERROR);
+    }
+    return static_cast<long long>(x);
+}
+
+/**
+ * @brief  The character in UTF-8.
+ */
+static std::string utf8(long long c) {
+    std::string bytes;
+
+    if (c < 0x80) {
+        bytes += static_cast<char>(c);
+    } else if (c < 0x800) {
+        bytes += static_cast<char>(0xC0 | c >> 6);
+        bytes += static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        bytes += static_cast<char>(0xE0 | c >> 12);
+        bytes += static_cast<char>(0x80 | (c >> 6 & 0x3F));
+        bytes += static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+        bytes += static_cast<char>(0xF0 | c >> 18);
+        bytes += static_cast<char>(0x80 | (c >> 12 & 0x3F));
+        bytes += static_cast<char>(0x80 | (c >> 6 & 0x3F));
+        bytes += static_cast<char>(0x80 | (c & 0x3F));
+    }
+    return bytes;
+}
+
+/**
+ * @brief  Error of a bad literal: the message followed by python's repr of
+ *         the text (UTF-8).
+ */
+static Error literalError(char const *message, std::string const &text) {
+    char quote = text.find('\'') != std::string::npos &&
+                                 text.find('"') == std::string::npos
+                         ? '"'
+                         : '\'';
+    auto const *p = reinterpret_cast<unsigned char const *>(text.c_str());
+    auto const *end = p + text.size();
+    std::string result = std::string(message) + ": " + quote;
+
+    while (p < end) {
+        auto const *start = p;
+        long long c = *p++;
+        int length = c < 0x80 ? 0 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : 3;
+
+        if (length > 0) {
+            c &= 0x3F >> length;
+        }
+        while (length-- > 0 && p < end && (*p & 0xC0) == 0x80) {
+            c = c << 6 | (*p++ & 0x3F);
+        }
+        if (c == quote || c == '\\') {
+            result += '\\';
+            result += static_cast<char>(c);
+        } else if (c == '\n') {
+            result += "\\n";
+        } else if (c == '\t') {
+            result += "\\t";
+        } else if (c == '\r') {
+            result += "\\r";
+        } else if (c < 0x20 || (0x7F <= c && c <= 0xA0)) {
+            char hexadecimal[8];
+            std::snprintf(hexadecimal, sizeof(hexadecimal), "\\x%02llx", c);
+            result += hexadecimal;
+        } else {
+            result.append(reinterpret_cast<char const *>(start), p - start);
+        }
+    }
+    return Error(result + quote);
+}
+
+/**
+ * @brief  Value of a digit (the zeros of the strings are the integer 0).
+ */
+static long long digit(long long c, char const *error) {
+    if (c != 0 && (c < '0' || c > '9')) {
+        throw literalError(error, utf8(c));
+    }
+    return c == 0 ? 0 : c - '0';
+}
+
+static long long toChar(long long i) {
+    if (i < 0 || i > 0x10FFFF) {
+        throw Error("ValueError: chr() arg not in range(0x110000)");
+    }
+    return i;
+}
+
+/******************************************************************************/
+/*                                   output                                   */
+/******************************************************************************/
+
+static void put(long long c) {
+    std::fputs(utf8(c).c_str(), stdout);
+}
+
+static void printInt(long long x) { std::printf("%lld", x); }
+
+/**
+ * @brief  The shortest digits that give back the value, written like python's
+ *         repr.
+ */
+static void printFloat(double x) {
+    char buffer[32];
+    std::string digits;
+
+    if (std::isnan(x)) {
+        std::fputs("nan", stdout);
+        return;
+    } else if (std::isinf(x)) {
+        std::fputs(x > 0 ? "inf" : "-inf", stdout);
+        return;
+    }
+    for (int precision = 1; precision <= 17; ++precision) {
+        std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, x);
+        if (std::strtod(buffer, nullptr) == x) {
+            break;
+        }
+    }
+    char const *p = buffer;
+    if (*p == '-') {
+        std::putchar('-');
+        ++p;
+    }
+    for (; *p != 'e'; ++p) {
+        if (*p != '.') {
+            digits += *p;
+        }
+    }
+    int exponent = std::atoi(p + 1);
+    while (digits.size() > 1 && digits.back() == '0') {
+        digits.pop_back();
+    }
+    int n = static_cast<int>(digits.size());
+    if (exponent < -4 || exponent >= 16) {
+        std::putchar(digits[0]);
+        if (n > 1) {
+            std::printf(".%s", digits.c_str() + 1);
+        }
+        std::printf("e%c%02d", exponent < 0 ? '-' : '+', std::abs(exponent));
+    } else if (exponent < 0) {
+        std::printf("0.%.*s%s", -exponent - 1, "0000", digits.c_str());
+    } else {
+        for (int i = 0; i <= exponent; ++i) {
+            std::putchar(i < n ? digits[i] : '0');
+        }
+        std::printf(".%s",
+                    n > exponent + 1 ? digits.c_str() + exponent + 1 : "0");
+    }
+}
+
+static void printChar(long long c) {
+    if (c == 0) {
+        std::putchar('0');
+    } else {
+        put(c);
+    }
+}
+
+/**
+ * @brief  Element of a list of characters, like python's repr.
+ */
+static void reprChar(long long c) {
+    if (c == 0) {
+        std::putchar('0');
+    } else if (c == '\'') {
+        std::fputs("\"'\"", stdout);
+    } else if (c == '\\') {
+        std::fputs("'\\\\'", stdout);
+    } else if (c == '\n') {
+        std::fputs("'\\n'", stdout);
+    } else if (c == '\t') {
+        std::fputs("'\\t'", stdout);
+    } else if (c == '\r') {
+        std::fputs("'\\r'", stdout);
+    } else if (c < 0x20 || (0x7F <= c && c <= 0xA0)) {
+        std::printf("'\\x%02llx'", c);
+    } else {
+        std::putchar('\'');
+        put(c);
+        std::putchar('\'');
+    }
+}
+
+template <typename Print>
+static void printArray(Array const *array, Print print) {
+    std::putchar('[');
+    for (long long i = 0; i < array->size; ++i) {
+        if (i > 0) {
+            std::fputs(", ", stdout);
+        }
+        print(array->data[i]);
+    }
+    std::putchar(']');
+}
+
+/******************************************************************************/
+/*                                   input                                    */
+/******************************************************************************/
+
+/**
+ * @brief  Line of the standard input without its '\n'.
+ */
+static std::string line() {
+    std::string text;
+    int c;
+
+    while ((c = std::getchar()) != EOF && c != '\n') {
+        text += static_cast<char>(c);
+    }
+    if (c == EOF && text.empty()) {
+        throw Error("EOFError: EOF when reading a line");
+    }
+    return text;
+}
+
+/**
+ * @brief  Python's int(): blanks around a sign and digits (with single '_'
+ *         between them).
+ */
+static long long readInt() {
+    std::string text = line();
+    char const *p = text.c_str();
+    long long value = 0;
+    bool negative = false;
+    int digits = 0;
+
+    while (std::isspace(static_cast<unsigned char>(*p))) {
+        ++p;
+    }
+    if (*p == '+' || *p == '-') {
+        negative = *p++ == '-';
+    }
+    while (std::isdigit(static_cast<unsigned char>(*p)) ||
+           (*p == '_' && digits > 0 &&
+            std::isdigit(static_cast<unsigned char>(p[1])))) {
+        if (*p != '_') {
+            if (value > (LLONG_MAX - (*p - '0')) / 10) {
+                throw Error(OVERFLOW_ERROR);
+            }
+            value = 10 * value + (*p - '0');
+            ++digits;
+        }
+        ++p;
+    }
+    while (std::isspace(static_cast<unsigned char>(*p))) {
+        ++p;
+    }
+    if (digits == 0 || *p != '\0') {
+        throw literalError("ValueError: invalid literal for int() with base 10",
+                           text);
+    }
+    return negative ? -value : value;
+}
+
+/**
+ * @brief  Python's float(): strtod, without the single '_' between two
+ *         digits.
+ */
+static double readFloat() {
+    static char const *message =
+            "ValueError: could not convert string to float";
+    std::string text = line();
+    std::string number;
+    char *end;
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '_') {
+            number += text[i];
+        } else if (i == 0 || i + 1 == text.size() ||
+                   !std::isdigit(static_cast<unsigned char>(text[i - 1])) ||
+                   !std::isdigit(static_cast<unsigned char>(text[i + 1]))) {
+            throw literalError(message, text);
+        }
+    }
+    char const *p = number.c_str();
+    while (std::isspace(static_cast<unsigned char>(*p))) {
+        ++p;
+    }
+    double value = std::strtod(p, &end);
+    if (end == p || std::strpbrk(p, "xX(") != nullptr) {
+        throw literalError(message, text);
+    }
+    while (std::isspace(static_cast<unsigned char>(*end))) {
+        ++end;
+    }
+    if (*end != '\0') {
+        throw literalError(message, text);
+    }
+    return value;
+}
+
+/**
+ * @brief  First character (UTF-8) of the line.
+ */
+static long long readChar() {
+    std::string text = line();
+    auto const *p = reinterpret_cast<unsigned char const *>(text.c_str());
+    long long c = *p;
+    int length = c < 0x80 ? 0 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : 3;
+
+    if (length > 0) {
+        c &= 0x3F >> length;
+    }
+    while (length-- > 0 && (*++p & 0xC0) == 0x80) {
+        c = c << 6 | (*p & 0x3F);
+    }
+    return c;
+}
+
+/******************************************************************************/
+/*                                  machine                                   */
+/******************************************************************************/
+
+Machine::~Machine() { release(0); }
+
+Array *Machine::allocate(long long size) {
+    size_t bytes = sizeof(Array) + static_cast<size_t>(size) * sizeof(Slot);
+    auto array = static_cast<Array *>(std::calloc(1, bytes));
+    if (array == nullptr) {
+        throw Error("MemoryError");
+    }
+    array->size = size;
+    array->data = reinterpret_cast<Slot *>(array + 1);
+    arrays_.push_back(array);
+    return array;
+}
+
+/**
+ * @brief  Free the arrays created after the first `count` ones.
+ */
+void Machine::release(size_t count) {
+    while (arrays_.size() > count) {
+        std::free(arrays_.back());
+        arrays_.pop_back();
+    }
+}
+
+/**
+ * @brief  Run the main function of the program.
+ *
+ * @throws  Error when the program stops on an error.
+ */
+void Machine::run() {
+    // caller of a frame: its function, its registers, where it resumes, the
+    // register of the result and the number of arrays before the call
+    struct Frame {
+        Function const *function;
+        size_t base;
+        Code const *pc;
+        uint16_t result;
+        size_t arrays;
+    };
+    std::vector<Frame> frames;
+    Function const *function = &program_.functions[program_.main];
+    size_t base = 0;
+    size_t arrays = 0;
+    Slot value = {0};
+
+    stack_.assign(function->frame.begin(), function->frame.end());
+    Slot *r = stack_.data();
+    Code const *pc = function->code.data();
+
+#if defined(__GNUC__)
+#define VM_CASE(opcode) L_##opcode:
+#define VM_DISPATCH() goto *labels[pc->opcode]
+#define VM_LABEL(opcode) &&L_##opcode,
+    static void *const labels[] = {VM_OPCODES(VM_LABEL)};
+#undef VM_LABEL
+    VM_DISPATCH();
+#else
+#define VM_CASE(opcode) case opcode:
+#define VM_DISPATCH() continue
+    for (;;) switch (pc->opcode) {
+#endif
+#define VM_NEXT()                                                              \
+    ++pc;                                                                      \
+    VM_DISPATCH()
+
+    VM_CASE(MOV) {
+        r[pc->a] = r[pc->b];
+        VM_NEXT();
+    }
+    VM_CASE(ADDI) {
+        r[pc->a].i = add(r[pc->b].i, r[pc->c].i);
+        VM_NEXT();
+    }
+    VM_CASE(SUBI) {
+        r[pc->a].i = sub(r[pc->b].i, r[pc->c].i);
+        VM_NEXT();
+    }
+    VM_CASE(MULI) {
+        r[pc->a].i = mul(r[pc->b].i, r[pc->c].i);
+        VM_NEXT();
+    }
+    VM_CASE(DIVI) {
+        r[pc->a].i = divide(r[pc->b].i, r[pc->c].i);
+        VM_NEXT();
+    }
+    VM_CASE(ADDF) {
+        r[pc->a].f = r[pc->b].f + r[pc->c].f;
+        VM_NEXT();
+    }
+    VM_CASE(SUBF) {
+        r[pc->a].f = r[pc->b].f - r[pc->c].f;
+        VM_NEXT();
+    }
+    VM_CASE(MULF) {
+        r[pc->a].f = r[pc->b].f * r[pc->c].f;
+        VM_NEXT();
+    }
+    VM_CASE(DIVF) {
+        if (r[pc->c].f == 0) {
+            throw Error("ZeroDivisionError: float division by zero");
+        }
+        r[pc->a].f = r[pc->b].f / r[pc->c].f;
+        VM_NEXT();
+    }
+    VM_CASE(DIVIF) {
+        if (r[pc->c].i == 0) {
+            throw Error("ZeroDivisionError: division by zero");
+        }
+        r[pc->a].f = (double)r[pc->b].i / (double)r[pc->c].i;
+        VM_NEXT();
+    }
+    VM_CASE(EQI) {
+        r[pc->a].i = r[pc->b].i == r[pc->c].i;
+        VM_NEXT();
+    }
+    VM_CASE(EQF) {
+        r[pc->a].i = r[pc->b].f == r[pc->c].f;
+        VM_NEXT();
+    }
+    VM_CASE(LTI) {
+        r[pc->a].i = r[pc->b].i < r[pc->c].i;
+        VM_NEXT();
+    }
+    VM_CASE(LTF) {
+        r[pc->a].i = r[pc->b].f < r[pc->c].f;
+        VM_NEXT();
+    }
+    VM_CASE(LEI) {
+        r[pc->a].i = r[pc->b].i <= r[pc->c].i;
+        VM_NEXT();
+    }
+    VM_CASE(LEF) {
+        r[pc->a].i = r[pc->b].f <= r[pc->c].f;
+        VM_NEXT();
+    }
+    VM_CASE(NOT) {
+        r[pc->a].i = !r[pc->b].i;
+        VM_NEXT();
+    }
+    VM_CASE(XOR) {
+        r[pc->a].i = !r[pc->b].i != !r[pc->c].i;
+        VM_NEXT();
+    }
+    VM_CASE(TSTF) {
+        r[pc->a].i = r[pc->b].f != 0;
+        VM_NEXT();
+    }
+    VM_CASE(FTOI) {
+        r[pc->a].i = toInt(r[pc->b].f);
+        VM_NEXT();
+    }
+    VM_CASE(CTOI) {
+        r[pc->a].i = digit(
+            r[pc->b].i, "ValueError: invalid literal for int() with base 10");
+        VM_NEXT();
+    }
+    VM_CASE(CTOF) {
+        r[pc->a].f = static_cast<double>(digit(
+            r[pc->b].i, "ValueError: could not convert string to float"));
+        VM_NEXT();
+    }
+    VM_CASE(ITOF) {
+        r[pc->a].f = static_cast<double>(r[pc->b].i);
+        VM_NEXT();
+    }
+    VM_CASE(ITOC) {
+        r[pc->a].i = toChar(r[pc->b].i);
+        VM_NEXT();
+    }
+    VM_CASE(NEWA) {
+        Array *array = r[pc->a].a;
+        if (pc->c != 0 && array != nullptr) {
+            std::memset(array->data, 0,
+                        static_cast<size_t>(array->size) * sizeof(Slot));
+        } else {
+            r[pc->a].a = allocate(r[pc->b].i);
+        }
+        VM_NEXT();
+    }
+    VM_CASE(LOAD) {
+        r[pc->a] = element(r[pc->b].a, r[pc->c].i,
+                           "IndexError: list index out of range");
+        VM_NEXT();
+    }
+    VM_CASE(STORE) {
+        element(r[pc->a].a, r[pc->b].i,
+                "IndexError: list assignment index out of range") = r[pc->c];
+        VM_NEXT();
+    }
+    VM_CASE(CALL) {
+        Function const *callee = &program_.functions[pc->b];
+        size_t top = base + function->frame.size();
+        size_t size = top + callee->frame.size();
+
+        if (frames.size() >= MAX_DEPTH) {
+            throw Error("RecursionError: maximum recursion depth exceeded");
+        }
+        if (stack_.size() < size) {
+            stack_.resize(std::max(size, 2 * stack_.size()));
+            r = stack_.data() + base;
+        }
+        Slot *registers = stack_.data() + top;
+        std::copy(callee->frame.begin(), callee->frame.end(), registers);
+        Code const *arguments = pc + 1;
+        for (uint16_t i = 0; i < pc->c; ++i) {
+            Code const &argument = arguments[i / 3];
+            registers[i] = r[i % 3 == 0   ? argument.a
+                             : i % 3 == 1 ? argument.b
+                                          : argument.c];
+        }
+        frames.push_back({function, base, arguments + (pc->c + 2) / 3, pc->a,
+                          arrays});
+        function = callee;
+        base = top;
+        arrays = arrays_.size();
+        r = registers;
+        pc = callee->code.data();
+        VM_DISPATCH();
+    }
+    VM_CASE(ARG) {
+        // read by CALL
+        VM_NEXT();
+    }
+    VM_CASE(RET) {
+        value = r[pc->a];
+        goto leave;
+    }
+    VM_CASE(RETN) {
+        value.i = 0;
+    leave:
+        release(arrays);
+        if (frames.empty()) {
+            std::fflush(stdout);
+            return;
+        }
+        Frame const &caller = frames.back();
+        function = caller.function;
+        base = caller.base;
+        arrays = caller.arrays;
+        r = stack_.data() + base;
+        r[caller.result] = value;
+        pc = caller.pc;
+        frames.pop_back();
+        VM_DISPATCH();
+    }
+    VM_CASE(JMP) {
+        pc = function->code.data() + pc->a;
+        VM_DISPATCH();
+    }
+    VM_CASE(JMPF) {
+        if (r[pc->a].i == 0) {
+            pc = function->code.data() + pc->b;
+            VM_DISPATCH();
+        }
+        VM_NEXT();
+    }
+    VM_CASE(CHECK) {
+        if (r[pc->a].i == 0) {
+            throw Error("UnboundLocalError: cannot access local variable '" +
+                        program_.strings[pc->b] +
+                        "' where it is not associated with a value");
+        }
+        VM_NEXT();
+    }
+    VM_CASE(PRTS) {
+        std::string const &text = program_.strings[pc->a];
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        VM_NEXT();
+    }
+    VM_CASE(PRTI) {
+        printInt(r[pc->a].i);
+        VM_NEXT();
+    }
+    VM_CASE(PRTF) {
+        printFloat(r[pc->a].f);
+        VM_NEXT();
+    }
+    VM_CASE(PRTC) {
+        printChar(r[pc->a].i);
+        VM_NEXT();
+    }
+    VM_CASE(PRTAI) {
+        printArray(r[pc->a].a, [](Slot s) { printInt(s.i); });
+        VM_NEXT();
+    }
+    VM_CASE(PRTAF) {
+        printArray(r[pc->a].a, [](Slot s) { printFloat(s.f); });
+        VM_NEXT();
+    }
+    VM_CASE(PRTAC) {
+        printArray(r[pc->a].a, [](Slot s) { reprChar(s.i); });
+        VM_NEXT();
+    }
+    VM_CASE(READI) {
+        r[pc->a].i = readInt();
+        VM_NEXT();
+    }
+    VM_CASE(READF) {
+        r[pc->a].f = readFloat();
+        VM_NEXT();
+    }
+    VM_CASE(READC) {
+        r[pc->a].i = readChar();
+        VM_NEXT();
+    }
+#if !defined(__GNUC__)
+    }
+#endif
+#undef VM_CASE
+#undef VM_DISPATCH
+#undef VM_NEXT
+}
+
+} // namespace vm
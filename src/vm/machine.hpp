@@ -0,0 +1,51 @@
+#ifndef MACHINE_H
+#define MACHINE_H
+#include "bytecode.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace vm {
+
+/**
+ * @brief  Error that stops the program, its message is the one of the python
+ *         exception (ex: "ZeroDivisionError: integer division by zero").
+ */
+class Error : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief  Interpreter of the bytecode. The frames of the calls are on a stack
+ *         of registers (not on the stack of the compiler), the instructions
+ *         are dispatched with computed gotos when the compiler supports them
+ *         (GCC and Clang), with a switch otherwise.
+ *
+ *         The arrays belong to the frame that creates them and are freed when
+ *         it returns (the functions can't return an array). An array that
+ *         doesn't flow in a phi is reused each time its `newarray` runs in the
+ *         frame.
+ *
+ * NOTE: like the C backend, the integers have 64 bits and an overflow stops
+ *       the program.
+ */
+class Machine {
+  public:
+    explicit Machine(Program const &program) : program_(program) {}
+    ~Machine();
+
+    void run();
+
+  private:
+    Array *allocate(long long size);
+    void release(size_t count);
+
+    Program const &program_;
+    std::vector<Slot> stack_ = {};
+    std::vector<Array *> arrays_ = {}; //< arrays of the frames
+};
+
+} // namespace vm
+
+#endif
@@ -0,0 +1,333 @@
+#include "allocator.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace x86 {
+
+/*
+ * allocated registers, in their order of preference
+ */
+static Register const CALLER_GPRS[] = {R8, R9, R10};
+static Register const CALLEE_GPRS[] = {RBX, R12, R13, R14, R15};
+static Xmm const CALLER_XMMS[] = {XMM3, XMM4, XMM5, XMM6, XMM7};
+static Xmm const CALLEE_XMMS[] = {XMM8,  XMM9,  XMM10, XMM11,
+                                  XMM12, XMM13, XMM14, XMM15};
+
+Operand Location::operand() const {
+    if (kind == GPR) {
+        return gpr();
+    } else if (kind == XMM) {
+        return xmm();
+    }
+    return mem(RBP, offset);
+}
+
+bool Location::operator==(Location const &other) const {
+    return kind == other.kind &&
+           (kind == STACK ? offset == other.offset : reg == other.reg);
+}
+
+Location Location::of(Register reg) {
+    return {GPR, static_cast<uint8_t>(reg), 0};
+}
+
+Location Location::of(Xmm reg) { return {XMM, static_cast<uint8_t>(reg), 0}; }
+
+Location Location::slot(int32_t offset) { return {STACK, 0, offset}; }
+
+void Allocator::allocate(ir::Function const &function) {
+    blocks_.clear();
+    positions_.clear();
+    calls_.clear();
+    liveIn_.clear();
+    liveOut_.clear();
+    ranges_.clear();
+    order_.clear();
+    locations_.clear();
+    savedGprs_.clear();
+    savedXmms_.clear();
+    slots_ = 0;
+
+    number(function);
+    computeLiveness(function);
+    buildIntervals(function);
+    scan();
+}
+
+/**
+ * @brief  Location of a parameter or of the result of an instruction (NONE
+ *         for the instructions without result).
+ */
+Location const &Allocator::location(ir::Value const *value) const {
+    static Location const none = {};
+    auto found = locations_.find(value);
+    return found == locations_.end() ? none : found->second;
+}
+
+/**
+ * @brief  New slot of the frame, below the saved rbp.
+ */
+int32_t Allocator::slot() {
+    ++slots_;
+    if (slots_ > INT32_MAX / 16) {
+        throw std::runtime_error("the frame is too large.");
+    }
+    return -8 * static_cast<int32_t>(slots_);
+}
+
+bool Allocator::tracked(ir::Value const *value) {
+    if (value->kind() == ir::Value::PARAMETER) {
+        return true;
+    } else if (value->kind() != ir::Value::INSTRUCTION) {
+        return false;
+    }
+    auto instruction = static_cast<ir::Instruction const *>(value);
+    return ir::hasResult(instruction->opcode()) && value->type() != NIL;
+}
+
+bool Allocator::floating(ir::Value const *value) {
+    return value->type() == FLT;
+}
+
+/**
+ * @brief  Positions: the parameters and the first block start at 0, each
+ *         block starts with its phis, then each instruction takes two
+ *         positions. The end of a block is the position of its terminator.
+ */
+void Allocator::number(ir::Function const &function) {
+    size_t position = 0;
+
+    for (auto const &block : function.blocks()) {
+        size_t start = position;
+        position += 2;
+        for (auto const &instruction : block->instructions()) {
+            if (instruction->opcode() == ir::Opcode::Phi) {
+                positions_[instruction.get()] = start;
+                continue;
+            }
+            positions_[instruction.get()] = position;
+            switch (instruction->opcode()) {
+            case ir::Opcode::Call:
+            case ir::Opcode::Print:
+            case ir::Opcode::Read:
+            case ir::Opcode::NewArray:
+                calls_.push_back(position);
+                break;
+            default:
+                break;
+            }
+            position += 2;
+        }
+        blocks_[block.get()] = {start, position - 2};
+    }
+}
+
+/**
+ * @brief  Live values at the start and at the end of the blocks (the operands
+ *         of the phis are live at the end of their predecessor).
+ */
+void Allocator::computeLiveness(ir::Function const &function) {
+    auto const &blocks = function.blocks();
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+        for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+            ir::Block const *block = it->get();
+            std::set<ir::Value const *> out;
+
+            for (ir::Block const *successor : block->successors()) {
+                auto const &in = liveIn_[successor];
+                out.insert(in.begin(), in.end());
+                for (auto const &phi : successor->instructions()) {
+                    if (phi->opcode() != ir::Opcode::Phi) {
+                        break;
+                    }
+                    for (size_t i = 0; i < phi->targets().size(); ++i) {
+                        if (phi->targets()[i] == block &&
+                            tracked(phi->operands()[i])) {
+                            out.insert(phi->operands()[i]);
+                        }
+                    }
+                }
+            }
+            std::set<ir::Value const *> in = out;
+            auto const &instructions = block->instructions();
+            for (auto i = instructions.rbegin(); i != instructions.rend();
+                 ++i) {
+                in.erase(i->get());
+                if ((*i)->opcode() == ir::Opcode::Phi) {
+                    continue;
+                }
+                for (ir::Value const *operand : (*i)->operands()) {
+                    if (tracked(operand)) {
+                        in.insert(operand);
+                    }
+                }
+            }
+            if (in != liveIn_[block] || out != liveOut_[block]) {
+                liveIn_[block] = std::move(in);
+                liveOut_[block] = std::move(out);
+                changed = true;
+            }
+        }
+    }
+}
+
+void Allocator::extend(ir::Value const *value, size_t position) {
+    auto found = ranges_.find(value);
+    if (found == ranges_.end()) {
+        ranges_[value] = {position, position};
+        order_.push_back(value);
+    } else {
+        found->second.first = std::min(found->second.first, position);
+        found->second.second = std::max(found->second.second, position);
+    }
+}
+
+void Allocator::buildIntervals(ir::Function const &function) {
+    for (auto const &parameter : function.parameters()) {
+        extend(parameter.get(), 0);
+    }
+    for (auto const &block : function.blocks()) {
+        auto [start, end] = blocks_[block.get()];
+        for (ir::Value const *value : liveIn_[block.get()]) {
+            extend(value, start);
+        }
+        for (ir::Value const *value : liveOut_[block.get()]) {
+            extend(value, end);
+        }
+        for (auto const &instruction : block->instructions()) {
+            if (tracked(instruction.get())) {
+                extend(instruction.get(), positions_[instruction.get()]);
+            }
+            if (instruction->opcode() != ir::Opcode::Phi) {
+                for (ir::Value const *operand : instruction->operands()) {
+                    if (tracked(operand)) {
+                        extend(operand, positions_[instruction.get()]);
+                    }
+                }
+                continue;
+            }
+            // the copies of the phi are at the end of its predecessors
+            for (ir::Block const *predecessor : instruction->targets()) {
+                extend(instruction.get(), blocks_[predecessor].second);
+            }
+        }
+    }
+}
+
+void Allocator::scan() {
+    std::vector<Interval> intervals;
+    std::map<ir::Value const *, size_t> parameters;
+
+    for (ir::Value const *value : order_) {
+        auto [start, end] = ranges_[value];
+        auto call = std::upper_bound(calls_.begin(), calls_.end(), start);
+        bool crosses = call != calls_.end() && *call < end;
+        intervals.push_back({value, start, end, crosses});
+        if (value->kind() == ir::Value::PARAMETER) {
+            parameters[value] = parameters.size();
+        }
+    }
+    std::stable_sort(intervals.begin(), intervals.end(),
+                     [](Interval const &a, Interval const &b) {
+                         return a.start < b.start;
+                     });
+
+    std::vector<Interval const *> active;
+    std::set<uint8_t> usedGprs;
+    std::set<uint8_t> usedXmms;
+    auto spill = [&](ir::Value const *value) {
+        auto parameter = parameters.find(value);
+        if (parameter != parameters.end()) {
+            // the slot where the caller writes the argument
+            locations_[value] = Location::slot(
+                16 + 8 * static_cast<int32_t>(parameter->second));
+        } else {
+            locations_[value] = Location::slot(slot());
+        }
+    };
+    auto callee = [](Location const &location) {
+        return location.kind == Location::GPR
+                   ? std::find(std::begin(CALLEE_GPRS), std::end(CALLEE_GPRS),
+                               location.gpr()) != std::end(CALLEE_GPRS)
+                   : location.reg >= static_cast<uint8_t>(XMM8);
+    };
+
+    for (Interval const &interval : intervals) {
+        bool real = floating(interval.value);
+        std::set<uint8_t> &used = real ? usedXmms : usedGprs;
+
+        // expire the intervals that end before this one
+        for (auto it = active.begin(); it != active.end();) {
+            if ((*it)->end < interval.start) {
+                Location const &location = locations_[(*it)->value];
+                (location.kind == Location::XMM ? usedXmms : usedGprs)
+                    .erase(location.reg);
+                it = active.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        std::vector<Location> candidates;
+        if (real) {
+            if (!interval.crossesCall) {
+                for (Xmm reg : CALLER_XMMS) {
+                    candidates.push_back(Location::of(reg));
+                }
+            }
+            for (Xmm reg : CALLEE_XMMS) {
+                candidates.push_back(Location::of(reg));
+            }
+        } else {
+            if (!interval.crossesCall) {
+                for (Register reg : CALLER_GPRS) {
+                    candidates.push_back(Location::of(reg));
+                }
+            }
+            for (Register reg : CALLEE_GPRS) {
+                candidates.push_back(Location::of(reg));
+            }
+        }
+        auto free = std::find_if(candidates.begin(), candidates.end(),
+                                 [&](Location const &location) {
+                                     return !used.count(location.reg);
+                                 });
+        if (free != candidates.end()) {
+            locations_[interval.value] = *free;
+            used.insert(free->reg);
+            active.push_back(&interval);
+            continue;
+        }
+
+        // spill the interval that ends last
+        Interval const *victim = nullptr;
+        for (Interval const *other : active) {
+            Location const &location = locations_[other->value];
+            bool sameClass = (location.kind == Location::XMM) == real;
+            if (sameClass && (!interval.crossesCall || callee(location)) &&
+                (victim == nullptr || other->end > victim->end)) {
+                victim = other;
+            }
+        }
+        if (victim != nullptr && victim->end > interval.end) {
+            locations_[interval.value] = locations_[victim->value];
+            spill(victim->value);
+            std::replace(active.begin(), active.end(), victim, &interval);
+        } else {
+            spill(interval.value);
+        }
+    }
+
+    for (auto const &[value, location] : locations_) {
+        if (location.kind == Location::GPR && callee(location)) {
+            savedGprs_.insert(location.gpr());
+        } else if (location.kind == Location::XMM && callee(location)) {
+            savedXmms_.insert(location.xmm());
+        }
+    }
+}
+
+} // namespace x86
@@ -0,0 +1,92 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+#include "assembler.hpp"
+#include "ir/ir.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace x86 {
+
+/**
+ * @brief  Place of a value in the generated code: a general purpose register
+ *         (the integers, the characters and the arrays), an xmm register (the
+ *         floats) or a slot of the frame ([rbp + offset]).
+ */
+struct Location {
+    enum Kind { NONE, GPR, XMM, STACK };
+
+    Kind kind = NONE;
+    uint8_t reg = 0;
+    int32_t offset = 0;
+
+    Register gpr() const { return static_cast<Register>(reg); }
+    Xmm xmm() const { return static_cast<Xmm>(reg); }
+    Operand operand() const;
+    bool operator==(Location const &other) const;
+    bool operator!=(Location const &other) const { return !(*this == other); }
+
+    static Location of(Register reg);
+    static Location of(Xmm reg);
+    static Location slot(int32_t offset);
+};
+
+/**
+ * @brief  Linear scan register allocation (Poletto & Sarkar) of the values of
+ *         a function: the blocks are numbered in their order, and the live
+ *         interval of a value goes from its first to its last position where
+ *         it is live (a phi is defined at the start of its block and at the
+ *         end of its predecessors, where its copies are). The interval with
+ *         the furthest end is spilled when the registers are missing.
+ *
+ *         The values that are live across a call are in the registers saved
+ *         by the callee (rbx, r12 to r15 and xmm8 to xmm15, the generated
+ *         functions save them), the other ones can also use r8 to r10 and
+ *         xmm3 to xmm7. The other registers are scratch registers of the
+ *         code generator and of the runtime.
+ */
+class Allocator {
+  public:
+    void allocate(ir::Function const &function);
+
+    Location const &location(ir::Value const *value) const;
+    int32_t slot();
+    size_t slots() const { return slots_; }
+    std::set<Register> const &savedGprs() const { return savedGprs_; }
+    std::set<Xmm> const &savedXmms() const { return savedXmms_; }
+
+  private:
+    struct Interval {
+        ir::Value const *value;
+        size_t start;
+        size_t end;
+        bool crossesCall;
+    };
+
+    void number(ir::Function const &function);
+    void computeLiveness(ir::Function const &function);
+    void buildIntervals(ir::Function const &function);
+    void scan();
+    void extend(ir::Value const *value, size_t position);
+    static bool tracked(ir::Value const *value);
+    static bool floating(ir::Value const *value);
+
+    std::map<ir::Block const *, std::pair<size_t, size_t>> blocks_ = {};
+    std::map<ir::Value const *, size_t> positions_ = {};
+    std::vector<size_t> calls_ = {};
+    std::map<ir::Block const *, std::set<ir::Value const *>> liveIn_ = {};
+    std::map<ir::Block const *, std::set<ir::Value const *>> liveOut_ = {};
+    std::map<ir::Value const *, std::pair<size_t, size_t>> ranges_ = {};
+    std::vector<ir::Value const *> order_ = {}; //< values in their order
+    std::map<ir::Value const *, Location> locations_ = {};
+    std::set<Register> savedGprs_ = {};
+    std::set<Xmm> savedXmms_ = {};
+    size_t slots_ = 0;
+};
+
+} // namespace x86
+
+#endif
@@ -0,0 +1,507 @@
+#include "assembler.hpp"
+#include <stdexcept>
+
+namespace x86 {
+
+Condition negate(Condition condition) {
+    // the conditions go by pairs (even: condition, odd: its negation)
+    return static_cast<Condition>(condition ^ 1);
+}
+
+Memory mem(Register base, int32_t displacement) {
+    Memory memory;
+    memory.base = base;
+    memory.displacement = displacement;
+    return memory;
+}
+
+Memory mem(Register base, Register index, uint8_t scale,
+           int32_t displacement) {
+    Memory memory;
+    memory.base = base;
+    memory.index = index;
+    memory.scale = scale;
+    memory.displacement = displacement;
+    return memory;
+}
+
+Memory mem(Label label, int32_t displacement) {
+    Memory memory;
+    memory.label = label;
+    memory.displacement = displacement;
+    return memory;
+}
+
+static bool isByte(int64_t value) { return value >= -128 && value <= 127; }
+
+static uint8_t code(Register reg) { return static_cast<uint8_t>(reg); }
+
+static uint8_t code(Xmm reg) { return static_cast<uint8_t>(reg); }
+
+/******************************************************************************/
+/*                                   labels                                   */
+/******************************************************************************/
+
+Label Assembler::label() {
+    labels_.push_back(-1);
+    reserved_.push_back(false);
+    return Label{labels_.size() - 1};
+}
+
+void Assembler::bind(Label label) {
+    labels_[label.id] = static_cast<int64_t>(code_.size());
+}
+
+/**
+ * @brief  Label of `size` bytes in the data that follows the code, they are
+ *         zero when the program starts.
+ */
+Label Assembler::reserve(size_t size, size_t alignment) {
+    Label result = label();
+
+    data_ = (data_ + alignment - 1) / alignment * alignment;
+    labels_[result.id] = static_cast<int64_t>(data_);
+    reserved_[result.id] = true;
+    data_ += size;
+    return result;
+}
+
+uint64_t Assembler::address(Label label) const {
+    return (reserved_[label.id] ? dataAddress_ : codeAddress_) +
+           static_cast<uint64_t>(labels_[label.id]);
+}
+
+/**
+ * @brief  Code loaded at `codeAddress`, with its data at `dataAddress`: the
+ *         relative displacements are resolved.
+ */
+std::vector<uint8_t> Assembler::finish(uint64_t codeAddress,
+                                       uint64_t dataAddress) {
+    codeAddress_ = codeAddress;
+    dataAddress_ = dataAddress;
+    for (Fixup const &fixup : fixups_) {
+        if (labels_[fixup.target.id] < 0) {
+            throw std::logic_error("x86: unbound label");
+        }
+        int64_t displacement =
+            static_cast<int64_t>(address(fixup.target)) + fixup.addend -
+            static_cast<int64_t>(codeAddress + fixup.end);
+        auto value = static_cast<uint32_t>(displacement);
+        for (size_t i = 0; i < 4; ++i) {
+            code_[fixup.position + i] = static_cast<uint8_t>(value >> 8 * i);
+        }
+    }
+    return code_;
+}
+
+/******************************************************************************/
+/*                                  encoding                                  */
+/******************************************************************************/
+
+void Assembler::emit32(uint32_t value) {
+    for (size_t i = 0; i < 4; ++i) {
+        emit8(static_cast<uint8_t>(value >> 8 * i));
+    }
+}
+
+/**
+ * @brief  Instruction with a ModRM byte: the mandatory prefix, the REX prefix,
+ *         the opcode and the operand (`reg` is the register field). The
+ *         immediate (of `immediate` bytes) is written by the caller. `bytes`
+ *         tells that the registers are used as bytes (then spl, bpl, sil and
+ *         dil need a REX prefix).
+ */
+void Assembler::encode(std::vector<uint8_t> const &opcode, uint8_t reg,
+                       Operand const &operand, bool wide, size_t immediate,
+                       uint8_t prefix, bool bytes) {
+    Memory const &address = operand.address;
+    bool rip = operand.memory && address.label.id != SIZE_MAX;
+    uint8_t rex = 0x40 | (wide ? 8 : 0) | (reg >> 3) << 2;
+
+    if (operand.memory && !rip) {
+        rex |= (code(address.index) >> 3) << 1 | code(address.base) >> 3;
+    } else if (!operand.memory) {
+        rex |= operand.reg >> 3;
+    }
+    if (prefix != 0) {
+        emit8(prefix);
+    }
+    if (rex != 0x40 || (bytes && ((reg >= 4 && reg < 8) ||
+                                  (!operand.memory && operand.reg >= 4 &&
+                                   operand.reg < 8)))) {
+        emit8(rex);
+    }
+    for (uint8_t byte : opcode) {
+        emit8(byte);
+    }
+    reg &= 7;
+    if (!operand.memory) {
+        emit8(static_cast<uint8_t>(0xC0 | reg << 3 | (operand.reg & 7)));
+    } else if (rip) {
+        emit8(static_cast<uint8_t>(reg << 3 | 5));
+        fixups_.push_back({code_.size(), address.label, address.displacement,
+                           code_.size() + 4 + immediate});
+        emit32(0);
+    } else {
+        uint8_t base = code(address.base) & 7;
+        bool sib = address.index != RSP || base == 4;
+        int32_t displacement = address.displacement;
+        uint8_t mod = displacement == 0 && base != 5 ? 0
+                      : isByte(displacement)         ? 1
+                                                     : 2;
+        emit8(static_cast<uint8_t>(mod << 6 | reg << 3 | (sib ? 4 : base)));
+        if (sib) {
+            uint8_t scale = address.scale == 8   ? 3
+                            : address.scale == 4 ? 2
+                            : address.scale == 2 ? 1
+                                                 : 0;
+            uint8_t index = code(address.index) & 7;
+            emit8(static_cast<uint8_t>(scale << 6 | index << 3 | base));
+        }
+        if (mod == 1) {
+            emit8(static_cast<uint8_t>(displacement));
+        } else if (mod == 2) {
+            emit32(static_cast<uint32_t>(displacement));
+        }
+    }
+}
+
+void Assembler::alu(Alu operation, Register destination,
+                    Operand const &source) {
+    encode({static_cast<uint8_t>(operation * 8 + 3)}, code(destination),
+           source);
+}
+
+void Assembler::alu(Alu operation, Operand const &destination,
+                    Register source) {
+    encode({static_cast<uint8_t>(operation * 8 + 1)}, code(source),
+           destination);
+}
+
+void Assembler::alu(Alu operation, Operand const &destination,
+                    int32_t immediate) {
+    if (isByte(immediate)) {
+        encode({0x83}, operation, destination, true, 1);
+        emit8(static_cast<uint8_t>(immediate));
+    } else {
+        encode({0x81}, operation, destination, true, 4);
+        emit32(static_cast<uint32_t>(immediate));
+    }
+}
+
+void Assembler::unary(uint8_t extension, Operand const &operand) {
+    encode({0xF7}, extension, operand);
+}
+
+void Assembler::shift(uint8_t extension, Operand const &operand,
+                      uint8_t count) {
+    encode({0xC1}, extension, operand, true, 1);
+    emit8(count);
+}
+
+void Assembler::sse(uint8_t prefix, uint8_t opcode, uint8_t reg,
+                    Operand const &operand, bool wide) {
+    encode({0x0F, opcode}, reg, operand, wide, 0, prefix);
+}
+
+void Assembler::jump(std::vector<uint8_t> const &opcode, Label target) {
+    for (uint8_t byte : opcode) {
+        emit8(byte);
+    }
+    fixups_.push_back({code_.size(), target, 0, code_.size() + 4});
+    emit32(0);
+}
+
+/******************************************************************************/
+/*                                  integers                                  */
+/******************************************************************************/
+
+void Assembler::mov(Register destination, Operand const &source) {
+    encode({0x8B}, code(destination), source);
+}
+
+void Assembler::mov(Memory const &destination, Register source) {
+    encode({0x89}, code(source), destination);
+}
+
+void Assembler::mov(Register destination, int64_t immediate) {
+    if (immediate >= 0 && immediate <= UINT32_MAX) {
+        // the 32 bits moves clear the upper half
+        if (code(destination) >= 8) {
+            emit8(0x41);
+        }
+        emit8(static_cast<uint8_t>(0xB8 + (code(destination) & 7)));
+        emit32(static_cast<uint32_t>(immediate));
+    } else if (immediate >= INT32_MIN && immediate <= INT32_MAX) {
+        encode({0xC7}, 0, destination, true, 4);
+        emit32(static_cast<uint32_t>(immediate));
+    } else {
+        emit8(static_cast<uint8_t>(0x48 | code(destination) >> 3));
+        emit8(static_cast<uint8_t>(0xB8 + (code(destination) & 7)));
+        emit32(static_cast<uint32_t>(immediate));
+        emit32(static_cast<uint32_t>(static_cast<uint64_t>(immediate) >> 32));
+    }
+}
+
+void Assembler::mov(Memory const &destination, int32_t immediate) {
+    encode({0xC7}, 0, destination, true, 4);
+    emit32(static_cast<uint32_t>(immediate));
+}
+
+void Assembler::movb(Memory const &destination, Register source) {
+    encode({0x88}, code(source), destination, false, 0, 0, true);
+}
+
+void Assembler::movb(Memory const &destination, int8_t immediate) {
+    encode({0xC6}, 0, destination, false, 1);
+    emit8(static_cast<uint8_t>(immediate));
+}
+
+void Assembler::movzxb(Register destination, Operand const &source) {
+    encode({0x0F, 0xB6}, code(destination), source, true, 0, 0, true);
+}
+
+void Assembler::lea(Register destination, Memory const &source) {
+    encode({0x8D}, code(destination), source);
+}
+
+void Assembler::add(Register destination, Operand const &source) {
+    alu(ADD, destination, source);
+}
+
+void Assembler::add(Operand const &destination, int32_t immediate) {
+    alu(ADD, destination, immediate);
+}
+
+void Assembler::adc(Register destination, Operand const &source) {
+    alu(ADC, destination, source);
+}
+
+void Assembler::sub(Register destination, Operand const &source) {
+    alu(SUB, destination, source);
+}
+
+void Assembler::sub(Operand const &destination, int32_t immediate) {
+    alu(SUB, destination, immediate);
+}
+
+void Assembler::sbb(Register destination, Operand const &source) {
+    alu(SBB, destination, source);
+}
+
+void Assembler::and_(Register destination, Operand const &source) {
+    alu(AND, destination, source);
+}
+
+void Assembler::and_(Operand const &destination, int32_t immediate) {
+    alu(AND, destination, immediate);
+}
+
+void Assembler::or_(Register destination, Operand const &source) {
+    alu(OR, destination, source);
+}
+
+void Assembler::or_(Operand const &destination, int32_t immediate) {
+    alu(OR, destination, immediate);
+}
+
+void Assembler::xor_(Register destination, Operand const &source) {
+    alu(XOR, destination, source);
+}
+
+void Assembler::xor_(Operand const &destination, int32_t immediate) {
+    alu(XOR, destination, immediate);
+}
+
+void Assembler::cmp(Register left, Operand const &right) {
+    alu(CMP, left, right);
+}
+
+void Assembler::cmp(Memory const &left, Register right) {
+    alu(CMP, left, right);
+}
+
+void Assembler::cmp(Operand const &left, int32_t immediate) {
+    alu(CMP, left, immediate);
+}
+
+void Assembler::test(Operand const &left, Register right) {
+    encode({0x85}, code(right), left);
+}
+
+void Assembler::imul(Register destination, Operand const &source) {
+    encode({0x0F, 0xAF}, code(destination), source);
+}
+
+void Assembler::imul(Register destination, Operand const &source,
+                     int32_t immediate) {
+    if (isByte(immediate)) {
+        encode({0x6B}, code(destination), source, true, 1);
+        emit8(static_cast<uint8_t>(immediate));
+    } else {
+        encode({0x69}, code(destination), source, true, 4);
+        emit32(static_cast<uint32_t>(immediate));
+    }
+}
+
+void Assembler::neg(Operand const &operand) { unary(3, operand); }
+
+void Assembler::inc(Operand const &operand) { encode({0xFF}, 0, operand); }
+
+void Assembler::dec(Operand const &operand) { encode({0xFF}, 1, operand); }
+
+void Assembler::mul(Operand const &operand) { unary(4, operand); }
+
+void Assembler::div(Operand const &operand) { unary(6, operand); }
+
+void Assembler::idiv(Operand const &operand) { unary(7, operand); }
+
+void Assembler::cqo() {
+    emit8(0x48);
+    emit8(0x99);
+}
+
+void Assembler::shl(Operand const &operand, uint8_t count) {
+    shift(4, operand, count);
+}
+
+void Assembler::shr(Operand const &operand, uint8_t count) {
+    shift(5, operand, count);
+}
+
+void Assembler::sar(Operand const &operand, uint8_t count) {
+    shift(7, operand, count);
+}
+
+void Assembler::shl(Operand const &operand) { encode({0xD3}, 4, operand); }
+
+void Assembler::shr(Operand const &operand) { encode({0xD3}, 5, operand); }
+
+void Assembler::bsr(Register destination, Operand const &source) {
+    encode({0x0F, 0xBD}, code(destination), source);
+}
+
+void Assembler::setcc(Condition condition, Register destination) {
+    encode({0x0F, static_cast<uint8_t>(0x90 + condition)}, 0, destination,
+           false, 0, 0, true);
+}
+
+void Assembler::cmov(Condition condition, Register destination,
+                     Operand const &source) {
+    encode({0x0F, static_cast<uint8_t>(0x40 + condition)}, code(destination),
+           source);
+}
+
+/******************************************************************************/
+/*                                  control                                   */
+/******************************************************************************/
+
+void Assembler::jmp(Label target) { jump({0xE9}, target); }
+
+void Assembler::jcc(Condition condition, Label target) {
+    jump({0x0F, static_cast<uint8_t>(0x80 + condition)}, target);
+}
+
+void Assembler::call(Label target) { jump({0xE8}, target); }
+
+void Assembler::ret() { emit8(0xC3); }
+
+void Assembler::push(Register reg) {
+    if (code(reg) >= 8) {
+        emit8(0x41);
+    }
+    emit8(static_cast<uint8_t>(0x50 + (code(reg) & 7)));
+}
+
+void Assembler::pop(Register reg) {
+    if (code(reg) >= 8) {
+        emit8(0x41);
+    }
+    emit8(static_cast<uint8_t>(0x58 + (code(reg) & 7)));
+}
+
+void Assembler::leave() { emit8(0xC9); }
+
+void Assembler::syscall() {
+    emit8(0x0F);
+    emit8(0x05);
+}
+
+void Assembler::repStosq() {
+    emit8(0xF3);
+    emit8(0x48);
+    emit8(0xAB);
+}
+
+/******************************************************************************/
+/*                                   floats                                   */
+/******************************************************************************/
+
+void Assembler::movsd(Xmm destination, Operand const &source) {
+    sse(0xF2, 0x10, code(destination), source);
+}
+
+void Assembler::movsd(Memory const &destination, Xmm source) {
+    sse(0xF2, 0x11, code(source), destination);
+}
+
+void Assembler::addsd(Xmm destination, Operand const &source) {
+    sse(0xF2, 0x58, code(destination), source);
+}
+
+void Assembler::subsd(Xmm destination, Operand const &source) {
+    sse(0xF2, 0x5C, code(destination), source);
+}
+
+void Assembler::mulsd(Xmm destination, Operand const &source) {
+    sse(0xF2, 0x59, code(destination), source);
+}
+
+void Assembler::divsd(Xmm destination, Operand const &source) {
+    sse(0xF2, 0x5E, code(destination), source);
+}
+
+void Assembler::ucomisd(Xmm left, Operand const &right) {
+    sse(0x66, 0x2E, code(left), right);
+}
+
+void Assembler::xorpd(Xmm destination, Operand const &source) {
+    sse(0x66, 0x57, code(destination), source);
+}
+
+void Assembler::cvtsi2sd(Xmm destination, Operand const &source) {
+    sse(0xF2, 0x2A, code(destination), source, true);
+}
+
+void Assembler::cvttsd2si(Register destination, Operand const &source) {
+    sse(0xF2, 0x2C, code(destination), source, true);
+}
+
+void Assembler::movq(Xmm destination, Register source) {
+    sse(0x66, 0x6E, code(destination), source, true);
+}
+
+void Assembler::movq(Register destination, Xmm source) {
+    sse(0x66, 0x7E, code(source), destination, true);
+}
+
+/******************************************************************************/
+/*                                    data                                    */
+/******************************************************************************/
+
+void Assembler::bytes(std::string const &data) {
+    code_.insert(code_.end(), data.begin(), data.end());
+}
+
+void Assembler::quad(uint64_t value) {
+    emit32(static_cast<uint32_t>(value));
+    emit32(static_cast<uint32_t>(value >> 32));
+}
+
+void Assembler::align(size_t alignment) {
+    while (code_.size() % alignment != 0) {
+        emit8(0);
+    }
+}
+
+} // namespace x86
@@ -0,0 +1,277 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief  Encoder of the x86-64 instructions used by the native backend (see
+ *         `--target=x86_64`). The operands are written in the Intel order
+ *         (destination first), the integer instructions work on 64 bits.
+ */
+namespace x86 {
+
+/*
+ * the enumerations are scoped so that the registers are not taken for
+ * immediates, the constants below give their short names
+ */
+enum class Register : uint8_t {
+    RAX,
+    RCX,
+    RDX,
+    RBX,
+    RSP,
+    RBP,
+    RSI,
+    RDI,
+    R8,
+    R9,
+    R10,
+    R11,
+    R12,
+    R13,
+    R14,
+    R15,
+};
+
+enum class Xmm : uint8_t {
+    XMM0,
+    XMM1,
+    XMM2,
+    XMM3,
+    XMM4,
+    XMM5,
+    XMM6,
+    XMM7,
+    XMM8,
+    XMM9,
+    XMM10,
+    XMM11,
+    XMM12,
+    XMM13,
+    XMM14,
+    XMM15,
+};
+
+constexpr Register RAX = Register::RAX;
+constexpr Register RCX = Register::RCX;
+constexpr Register RDX = Register::RDX;
+constexpr Register RBX = Register::RBX;
+constexpr Register RSP = Register::RSP;
+constexpr Register RBP = Register::RBP;
+constexpr Register RSI = Register::RSI;
+constexpr Register RDI = Register::RDI;
+constexpr Register R8 = Register::R8;
+constexpr Register R9 = Register::R9;
+constexpr Register R10 = Register::R10;
+constexpr Register R11 = Register::R11;
+constexpr Register R12 = Register::R12;
+constexpr Register R13 = Register::R13;
+constexpr Register R14 = Register::R14;
+constexpr Register R15 = Register::R15;
+
+constexpr Xmm XMM0 = Xmm::XMM0;
+constexpr Xmm XMM1 = Xmm::XMM1;
+constexpr Xmm XMM2 = Xmm::XMM2;
+constexpr Xmm XMM3 = Xmm::XMM3;
+constexpr Xmm XMM4 = Xmm::XMM4;
+constexpr Xmm XMM5 = Xmm::XMM5;
+constexpr Xmm XMM6 = Xmm::XMM6;
+constexpr Xmm XMM7 = Xmm::XMM7;
+constexpr Xmm XMM8 = Xmm::XMM8;
+constexpr Xmm XMM9 = Xmm::XMM9;
+constexpr Xmm XMM10 = Xmm::XMM10;
+constexpr Xmm XMM11 = Xmm::XMM11;
+constexpr Xmm XMM12 = Xmm::XMM12;
+constexpr Xmm XMM13 = Xmm::XMM13;
+constexpr Xmm XMM14 = Xmm::XMM14;
+constexpr Xmm XMM15 = Xmm::XMM15;
+
+/*
+ * condition codes of jcc, setcc and cmovcc
+ */
+enum Condition : uint8_t {
+    O,
+    NO,
+    B, // unsigned <
+    AE,
+    E,
+    NE,
+    BE,
+    A,
+    S,
+    NS,
+    P, // unordered (after ucomisd)
+    NP,
+    L, // signed <
+    GE,
+    LE,
+    G,
+};
+
+Condition negate(Condition condition);
+
+/**
+ * @brief  Position in the code, or in the zeroed data that follows it (see
+ *         Assembler::reserve). A label is created by the assembler and bound
+ *         once.
+ */
+struct Label {
+    size_t id = SIZE_MAX;
+};
+
+/**
+ * @brief  Memory operand: [base + index * scale + displacement], or
+ *         [label + displacement] (relative to the instruction pointer).
+ */
+struct Memory {
+    Register base = RBP;
+    Register index = RSP; //< RSP: no index
+    uint8_t scale = 1;
+    int32_t displacement = 0;
+    Label label = {};
+};
+
+Memory mem(Register base, int32_t displacement = 0);
+Memory mem(Register base, Register index, uint8_t scale,
+           int32_t displacement = 0);
+Memory mem(Label label, int32_t displacement = 0);
+
+/**
+ * @brief  Register (general purpose or xmm) or memory operand of an
+ *         instruction.
+ */
+struct Operand {
+    Operand(Register reg) : reg(static_cast<uint8_t>(reg)) {}
+    Operand(Xmm reg) : reg(static_cast<uint8_t>(reg)) {}
+    Operand(Memory const &memory) : memory(true), address(memory) {}
+
+    bool memory = false;
+    uint8_t reg = 0;
+    Memory address = {};
+};
+
+class Assembler {
+  public:
+    Label label();
+    void bind(Label label);
+    Label reserve(size_t size, size_t alignment = 8);
+    size_t size() const { return code_.size(); }
+    std::vector<uint8_t> finish(uint64_t codeAddress, uint64_t dataAddress);
+    size_t data() const { return data_; }
+    uint64_t address(Label label) const;
+
+    // integers
+    void mov(Register destination, Operand const &source);
+    void mov(Memory const &destination, Register source);
+    void mov(Register destination, int64_t immediate);
+    void mov(Memory const &destination, int32_t immediate);
+    void movb(Memory const &destination, Register source);
+    void movb(Memory const &destination, int8_t immediate);
+    void movzxb(Register destination, Operand const &source);
+    void lea(Register destination, Memory const &source);
+    void add(Register destination, Operand const &source);
+    void add(Operand const &destination, int32_t immediate);
+    void adc(Register destination, Operand const &source);
+    void sub(Register destination, Operand const &source);
+    void sub(Operand const &destination, int32_t immediate);
+    void sbb(Register destination, Operand const &source);
+    void and_(Register destination, Operand const &source);
+    void and_(Operand const &destination, int32_t immediate);
+    void or_(Register destination, Operand const &source);
+    void or_(Operand const &destination, int32_t immediate);
+    void xor_(Register destination, Operand const &source);
+    void xor_(Operand const &destination, int32_t immediate);
+    void cmp(Register left, Operand const &right);
+    void cmp(Memory const &left, Register right);
+    void cmp(Operand const &left, int32_t immediate);
+    void test(Operand const &left, Register right);
+    void imul(Register destination, Operand const &source);
+    void imul(Register destination, Operand const &source, int32_t immediate);
+    void neg(Operand const &operand);
+    void inc(Operand const &operand);
+    void dec(Operand const &operand); //< keeps the carry flag
+    void mul(Operand const &operand);
+    void div(Operand const &operand);
+    void idiv(Operand const &operand);
+    void cqo();
+    void shl(Operand const &operand, uint8_t count);
+    void shr(Operand const &operand, uint8_t count);
+    void sar(Operand const &operand, uint8_t count);
+    void shl(Operand const &operand); //< shift by cl
+    void shr(Operand const &operand);
+    void bsr(Register destination, Operand const &source);
+    void setcc(Condition condition, Register destination);
+    void cmov(Condition condition, Register destination,
+              Operand const &source);
+
+    // control
+    void jmp(Label target);
+    void jcc(Condition condition, Label target);
+    void call(Label target);
+    void ret();
+    void push(Register reg);
+    void pop(Register reg);
+    void leave();
+    void syscall();
+    void repStosq();
+
+    // floats
+    void movsd(Xmm destination, Operand const &source);
+    void movsd(Memory const &destination, Xmm source);
+    void addsd(Xmm destination, Operand const &source);
+    void subsd(Xmm destination, Operand const &source);
+    void mulsd(Xmm destination, Operand const &source);
+    void divsd(Xmm destination, Operand const &source);
+    void ucomisd(Xmm left, Operand const &right);
+    void xorpd(Xmm destination, Operand const &source);
+    void cvtsi2sd(Xmm destination, Operand const &source);
+    void cvttsd2si(Register destination, Operand const &source);
+    void movq(Xmm destination, Register source);
+    void movq(Register destination, Xmm source);
+
+    // data
+    void bytes(std::string const &data);
+    void quad(uint64_t value);
+    void align(size_t alignment);
+
+  private:
+    enum Alu { ADD, OR, ADC, SBB, AND, SUB, XOR, CMP };
+
+    void alu(Alu operation, Register destination, Operand const &source);
+    void alu(Alu operation, Operand const &destination, Register source);
+    void alu(Alu operation, Operand const &destination, int32_t immediate);
+    void unary(uint8_t extension, Operand const &operand);
+    void shift(uint8_t extension, Operand const &operand, uint8_t count);
+    void sse(uint8_t prefix, uint8_t opcode, uint8_t reg,
+             Operand const &operand, bool wide = false);
+    void encode(std::vector<uint8_t> const &opcode, uint8_t reg,
+                Operand const &operand, bool wide = true,
+                size_t immediate = 0, uint8_t prefix = 0,
+                bool bytes = false);
+    void jump(std::vector<uint8_t> const &opcode, Label target);
+    void emit8(uint8_t byte) { code_.push_back(byte); }
+    void emit32(uint32_t value);
+
+    // a relative displacement: its position, its target and the end of its
+    // instruction (the displacement is relative to it)
+    struct Fixup {
+        size_t position;
+        Label target;
+        int32_t addend;
+        size_t end;
+    };
+
+    std::vector<uint8_t> code_ = {};
+    std::vector<int64_t> labels_ = {}; //< offset, -1 if not bound
+    std::vector<bool> reserved_ = {};  //< the label is in the data
+    std::vector<Fixup> fixups_ = {};
+    size_t data_ = 0; //< size of the zeroed data
+    uint64_t codeAddress_ = 0;
+    uint64_t dataAddress_ = 0;
+};
+
+} // namespace x86
+
+#endif
@@ -0,0 +1,1133 @@
+#include "codegen.hpp"
+#include "ast/python.hpp"
+#include "elf.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace x86 {
+
+static uint64_t bits(double value) {
+    uint64_t result;
+
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+void CodeGenerator::generate(ir::Module const &module,
+                             std::string const &path) {
+    a_ = Assembler();
+    runtime_ = std::make_unique<Runtime>(a_);
+    module_ = &module;
+    functions_.clear();
+    for (auto const &function : module.functions()) {
+        functions_[function->name()] = a_.label();
+    }
+    runtime_->emit(functions_.at("main"));
+    for (auto const &function : module.functions()) {
+        compile(*function);
+    }
+    runtime_->emitData();
+    writeExecutable(path, a_, runtime_->routine(Runtime::START));
+}
+
+/******************************************************************************/
+/*                                 functions                                  */
+/******************************************************************************/
+
+/**
+ * @brief  The blocks are translated in their order, the code of the rare
+ *         cases and the messages of the unbound variables follow them.
+ */
+void CodeGenerator::compile(ir::Function const &function) {
+    function_ = &function;
+    labels_.clear();
+    flags_.clear();
+    arrays_.clear();
+    uses_.clear();
+    copies_.clear();
+    escaping_.clear();
+    unboundVariables_.clear();
+    cold_.clear();
+    fused_ = nullptr;
+    unbound_ = ir::unboundPhis(function);
+    allocator_.allocate(function);
+
+    for (auto const &block : function.blocks()) {
+        for (auto const &instruction : block->instructions()) {
+            for (ir::Value const *operand : instruction->operands()) {
+                ++uses_[operand];
+            }
+            if (instruction->opcode() != ir::Opcode::Phi) {
+                continue;
+            }
+            escaping_.insert(instruction->operands().begin(),
+                             instruction->operands().end());
+            for (size_t i = 0; i < instruction->targets().size(); ++i) {
+                auto &copies =
+                    copies_[{instruction->targets()[i], block.get()}];
+                // a block can be twice a predecessor (branch to the same
+                // block)
+                if (copies.empty() ||
+                    copies.back().first != instruction.get()) {
+                    copies.push_back(
+                        {instruction.get(), instruction->operands()[i]});
+                }
+            }
+        }
+    }
+
+    prologue(function);
+    auto const &blocks = function.blocks();
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        a_.bind(label(blocks[i].get()));
+        next_ = i + 1 < blocks.size() ? blocks[i + 1].get() : nullptr;
+        auto const &instructions = blocks[i]->instructions();
+        for (auto it = instructions.begin(); it != instructions.end(); ++it) {
+            auto following = std::next(it);
+            following_ =
+                following == instructions.end() ? nullptr : following->get();
+            if ((*it)->opcode() != ir::Opcode::Phi) {
+                compile(**it);
+            }
+        }
+    }
+    epilogue();
+    for (auto const &code : cold_) {
+        code();
+    }
+    for (auto const &[variable, stub] : unboundVariables_) {
+        std::string message = "UnboundLocalError: cannot access local "
+                              "variable '" +
+                              variable +
+                              "' where it is not associated with a value";
+        a_.bind(stub);
+        a_.lea(RDI, mem(runtime_->string(message)));
+        a_.mov(RSI, static_cast<int64_t>(message.size()));
+        a_.jmp(runtime_->routine(Runtime::FAIL));
+    }
+}
+
+/**
+ * @brief  Frame: the saved rbp, the slots of the allocator (spilled values,
+ *         saved registers, flags of the unbound phis, reused arrays and top
+ *         of the heap), then the arguments of the calls at [rsp].
+ */
+void CodeGenerator::prologue(ir::Function const &function) {
+    size_t arguments = 0;
+    bool arrays = false;
+
+    savedGprs_.clear();
+    savedXmms_.clear();
+    for (Register reg : allocator_.savedGprs()) {
+        savedGprs_.emplace_back(reg, allocator_.slot());
+    }
+    for (Xmm reg : allocator_.savedXmms()) {
+        savedXmms_.emplace_back(reg, allocator_.slot());
+    }
+    for (ir::Value const *phi : unbound_) {
+        flags_[phi] = allocator_.slot();
+    }
+    for (auto const &block : function.blocks()) {
+        for (auto const &instruction : block->instructions()) {
+            if (instruction->opcode() == ir::Opcode::Call) {
+                arguments =
+                    std::max(arguments, instruction->operands().size());
+            } else if (instruction->opcode() == ir::Opcode::NewArray) {
+                arrays = true;
+                if (!escaping_.count(instruction.get())) {
+                    arrays_[instruction.get()] = allocator_.slot();
+                }
+            }
+        }
+    }
+    heapMark_ = arrays ? allocator_.slot() : 0;
+    size_t frame = (allocator_.slots() * 8 + 15) / 16 * 16 +
+                   (arguments * 8 + 15) / 16 * 16;
+    if (frame > INT32_MAX / 2) {
+        throw std::runtime_error("the frame of the function " +
+                                 function.name() + " is too large.");
+    }
+
+    a_.bind(functions_.at(function.name()));
+    a_.push(RBP);
+    a_.mov(RBP, RSP);
+    if (frame > 0) {
+        a_.sub(RSP, static_cast<int32_t>(frame));
+    }
+    a_.cmp(RSP, mem(runtime_->stackLimit()));
+    a_.jcc(B, runtime_->error(Runtime::RECURSION));
+    for (auto [reg, slot] : savedGprs_) {
+        a_.mov(mem(RBP, slot), reg);
+    }
+    for (auto [reg, slot] : savedXmms_) {
+        a_.movsd(mem(RBP, slot), reg);
+    }
+    if (heapMark_ != 0) {
+        a_.mov(RAX, mem(runtime_->heapTop()));
+        a_.mov(mem(RBP, heapMark_), RAX);
+    }
+    for (auto const &[value, slot] : flags_) {
+        a_.mov(mem(RBP, slot), 0);
+    }
+    for (auto const &[value, slot] : arrays_) {
+        a_.mov(mem(RBP, slot), 0);
+    }
+    auto const &parameters = function.parameters();
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        Location const &location = where(parameters[i].get());
+        Memory argument = mem(RBP, 16 + 8 * static_cast<int32_t>(i));
+        if (location.kind == Location::GPR) {
+            a_.mov(location.gpr(), argument);
+        } else if (location.kind == Location::XMM) {
+            a_.movsd(location.xmm(), argument);
+        }
+    }
+    epilogue_ = a_.label();
+}
+
+/**
+ * @brief  The arrays of the function are freed (the functions don't return
+ *         arrays) and the registers are restored.
+ */
+void CodeGenerator::epilogue() {
+    a_.bind(epilogue_);
+    if (heapMark_ != 0) {
+        a_.mov(RCX, mem(RBP, heapMark_));
+        a_.mov(mem(runtime_->heapTop()), RCX);
+    }
+    for (auto [reg, slot] : savedGprs_) {
+        a_.mov(reg, mem(RBP, slot));
+    }
+    for (auto [reg, slot] : savedXmms_) {
+        a_.movsd(reg, mem(RBP, slot));
+    }
+    a_.leave();
+    a_.ret();
+}
+
+/******************************************************************************/
+/*                                instructions                                */
+/******************************************************************************/
+
+void CodeGenerator::compile(ir::Instruction const &instruction) {
+    auto const &operands = instruction.operands();
+
+    check(instruction);
+    switch (instruction.opcode()) {
+    case ir::Opcode::Add:
+    case ir::Opcode::Sub:
+    case ir::Opcode::Mul:
+    case ir::Opcode::Div:
+        binary(instruction);
+        break;
+    case ir::Opcode::Eq:
+    case ir::Opcode::Gt:
+    case ir::Opcode::Lt:
+    case ir::Opcode::Ge:
+    case ir::Opcode::Le:
+        compare(instruction);
+        break;
+    case ir::Opcode::Not: {
+        Register reg = truth(operands[0], RAX);
+        a_.xor_(reg, 1);
+        define(&instruction, reg);
+    } break;
+    case ir::Opcode::Xor: {
+        Register left = truth(operands[0], RAX);
+        Register right = truth(operands[1], RCX);
+        a_.xor_(left, right);
+        define(&instruction, left);
+    } break;
+    case ir::Opcode::Conv:
+        convert(instruction);
+        break;
+    case ir::Opcode::NewArray:
+        newArray(instruction);
+        break;
+    case ir::Opcode::Load: {
+        Register array = element(instruction, Runtime::INDEX);
+        Memory address = mem(array, RDX, 8, 8);
+        if (instruction.type() == FLT) {
+            Xmm reg = floatResult(&instruction, XMM0);
+            a_.movsd(reg, address);
+            define(&instruction, reg);
+        } else {
+            Register reg = result(&instruction, RAX);
+            a_.mov(reg, address);
+            define(&instruction, reg);
+        }
+    } break;
+    case ir::Opcode::Store: {
+        Register array = element(instruction, Runtime::INDEX_ASSIGNMENT);
+        Memory address = mem(array, RDX, 8, 8);
+        int32_t value;
+        if (getValueType(operands[0]->type()) == FLT) {
+            a_.movsd(address, xmm(operands[2], XMM0));
+        } else if (operands[2]->type() != FLT &&
+                   immediate(operands[2], value)) {
+            a_.mov(address, value);
+        } else {
+            a_.mov(address, integer(operands[2], RAX));
+        }
+    } break;
+    case ir::Opcode::Call:
+        call(instruction);
+        break;
+    case ir::Opcode::Print:
+        print(instruction);
+        break;
+    case ir::Opcode::Read:
+        if (instruction.type() == FLT) {
+            a_.call(runtime_->routine(Runtime::READ_FLOAT));
+            define(&instruction, XMM0);
+        } else {
+            a_.call(runtime_->routine(instruction.type() == CHR
+                                          ? Runtime::READ_CHAR
+                                          : Runtime::READ_INT));
+            define(&instruction, RAX);
+        }
+        break;
+    case ir::Opcode::Jump:
+        edge(instruction.block(), instruction.targets()[0]);
+        if (instruction.targets()[0] != next_) {
+            a_.jmp(label(instruction.targets()[0]));
+        }
+        break;
+    case ir::Opcode::Branch:
+        branch(instruction);
+        break;
+    case ir::Opcode::Ret:
+        ret(instruction);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief  The variables that may not be assigned are checked where they are
+ *         read.
+ */
+void CodeGenerator::check(ir::Instruction const &instruction) {
+    for (ir::Value const *value : instruction.operands()) {
+        if (value->kind() == ir::Value::UNDEFINED) {
+            a_.jmp(unbound(value->name()));
+        } else if (unbound_.count(value)) {
+            auto phi = static_cast<ir::Instruction const *>(value);
+            a_.cmp(mem(RBP, flags_.at(value)), 0);
+            a_.jcc(E, unbound(phi->symbol()));
+        }
+    }
+}
+
+/**
+ * @brief  Arithmetic operation, on floats if one of the operands or the
+ *         result is a float (a float given to an integer is truncated).
+ */
+void CodeGenerator::binary(ir::Instruction const &instruction) {
+    ir::Value const *left = instruction.operands()[0];
+    ir::Value const *right = instruction.operands()[1];
+    ir::Opcode opcode = instruction.opcode();
+    bool real = left->type() == FLT || right->type() == FLT ||
+                instruction.type() == FLT;
+    int32_t value;
+
+    if (!real && opcode == ir::Opcode::Div) {
+        divide(instruction);
+    } else if (!real) {
+        Register reg = result(&instruction, RAX);
+        load(reg, left);
+        if (immediate(right, value)) {
+            if (opcode == ir::Opcode::Add) {
+                a_.add(reg, value);
+            } else if (opcode == ir::Opcode::Sub) {
+                a_.sub(reg, value);
+            } else {
+                a_.imul(reg, reg, value);
+            }
+        } else {
+            Operand source = operand(right, RCX);
+            if (opcode == ir::Opcode::Add) {
+                a_.add(reg, source);
+            } else if (opcode == ir::Opcode::Sub) {
+                a_.sub(reg, source);
+            } else {
+                a_.imul(reg, source);
+            }
+        }
+        a_.jcc(O, runtime_->error(Runtime::OVERFLOW));
+        define(&instruction, reg);
+    } else {
+        Xmm reg = instruction.type() == FLT ? floatResult(&instruction, XMM0)
+                                            : XMM0;
+        load(reg, left);
+        Operand source = floatOperand(right, XMM1);
+        switch (opcode) {
+        case ir::Opcode::Add:
+            a_.addsd(reg, source);
+            break;
+        case ir::Opcode::Sub:
+            a_.subsd(reg, source);
+            break;
+        case ir::Opcode::Mul:
+            a_.mulsd(reg, source);
+            break;
+        default:
+            if (right->kind() != ir::Value::CONSTANT ||
+                (right->type() == FLT ? right->floating() == 0
+                                      : right->integer() == 0)) {
+                Label divisor = a_.label();
+                a_.xorpd(XMM2, XMM2);
+                a_.ucomisd(XMM2, source);
+                a_.jcc(P, divisor);
+                // python: "float division" only when an operand is a float
+                a_.jcc(E, runtime_->error(
+                              left->type() == FLT || right->type() == FLT
+                                  ? Runtime::FLOAT_DIVISION
+                                  : Runtime::INT_DIVISION));
+                a_.bind(divisor);
+            }
+            a_.divsd(reg, source);
+            break;
+        }
+        if (instruction.type() == FLT) {
+            define(&instruction, reg);
+        } else {
+            Register truncated = result(&instruction, RAX);
+            ftoi(truncated, reg);
+            define(&instruction, truncated);
+        }
+    }
+}
+
+/**
+ * @brief  Division of the integers rounded toward zero, like python's
+ *         int(a/b): it's the quotient of idiv.
+ */
+void CodeGenerator::divide(ir::Instruction const &instruction) {
+    ir::Value const *right = instruction.operands()[1];
+    Label done = a_.label();
+
+    load(RAX, instruction.operands()[0]);
+    if (right->kind() == ir::Value::CONSTANT) {
+        long long divisor = right->integer();
+        if (divisor == 0) {
+            a_.jmp(runtime_->error(Runtime::INT_DIVISION));
+        } else if (divisor == -1) {
+            a_.neg(RAX);
+            a_.jcc(O, runtime_->error(Runtime::OVERFLOW));
+        } else if (divisor != 1) {
+            a_.mov(RCX, static_cast<int64_t>(divisor));
+            a_.cqo();
+            a_.idiv(RCX);
+        }
+    } else {
+        load(RCX, right);
+        a_.test(RCX, RCX);
+        a_.jcc(E, runtime_->error(Runtime::INT_DIVISION));
+        // the minimum divided by -1 overflows in idiv
+        a_.cmp(RCX, -1);
+        a_.jcc(E, cold([this, done]() {
+                   a_.neg(RAX);
+                   a_.jcc(O, runtime_->error(Runtime::OVERFLOW));
+                   a_.jmp(done);
+               }));
+        a_.cqo();
+        a_.idiv(RCX);
+    }
+    a_.bind(done);
+    define(&instruction, RAX);
+}
+
+/**
+ * @brief  Comparison: the result is 0 or 1, or the flags when the branch that
+ *         follows is its only use. The comparisons of floats are false when
+ *         an operand is nan (`<` and `<=` swap their operands: ucomisd sets
+ *         the carry when they are unordered).
+ */
+void CodeGenerator::compare(ir::Instruction const &instruction) {
+    ir::Value const *left = instruction.operands()[0];
+    ir::Value const *right = instruction.operands()[1];
+    ir::Opcode opcode = instruction.opcode();
+    bool real = left->type() == FLT || right->type() == FLT;
+    Condition condition;
+    int32_t value;
+
+    if (!real) {
+        Register reg = gpr(left, RAX);
+        if (immediate(right, value)) {
+            a_.cmp(reg, value);
+        } else {
+            a_.cmp(reg, operand(right, RCX));
+        }
+        condition = opcode == ir::Opcode::Eq   ? E
+                    : opcode == ir::Opcode::Gt ? G
+                    : opcode == ir::Opcode::Lt ? L
+                    : opcode == ir::Opcode::Ge ? GE
+                                               : LE;
+    } else if (opcode == ir::Opcode::Lt || opcode == ir::Opcode::Le) {
+        a_.ucomisd(xmm(right, XMM0), floatOperand(left, XMM1));
+        condition = opcode == ir::Opcode::Lt ? A : AE;
+    } else {
+        a_.ucomisd(xmm(left, XMM0), floatOperand(right, XMM1));
+        condition = opcode == ir::Opcode::Gt ? A : opcode == ir::Opcode::Ge ? AE
+                                                                           : E;
+    }
+
+    bool equal = real && opcode == ir::Opcode::Eq;
+    if (!equal && uses_[&instruction] == 1 && following_ != nullptr &&
+        following_->opcode() == ir::Opcode::Branch &&
+        following_->operands()[0] == &instruction) {
+        fused_ = &instruction;
+        fusedCondition_ = condition;
+        return;
+    }
+    Register reg = result(&instruction, RAX);
+    a_.setcc(condition, reg);
+    if (equal) {
+        a_.setcc(NP, RCX);
+        a_.and_(reg, RCX);
+    }
+    a_.movzxb(reg, reg);
+    define(&instruction, reg);
+}
+
+/**
+ * @brief  Conversion of the operand to the type of the instruction, like the
+ *         virtual machine (a character is a digit for int() and float()).
+ */
+void CodeGenerator::convert(ir::Instruction const &instruction) {
+    ir::Value const *value = instruction.operands()[0];
+    PrimitiveType source = value->type();
+    PrimitiveType type = instruction.type();
+    auto digit = [this](Runtime::Error error) {
+        Label valid = a_.label();
+        a_.test(RAX, RAX);
+        a_.jcc(E, valid);
+        a_.sub(RAX, '0');
+        a_.cmp(RAX, 9);
+        a_.jcc(BE, valid);
+        // the message shows the character
+        a_.lea(RDI, mem(RAX, '0'));
+        a_.mov(RSI, -1);
+        a_.jmp(runtime_->error(error));
+        a_.bind(valid);
+    };
+
+    if (type == FLT) {
+        Xmm reg = floatResult(&instruction, XMM0);
+        if (source == CHR) {
+            load(RAX, value);
+            digit(Runtime::FLOAT_LITERAL);
+            a_.cvtsi2sd(reg, RAX);
+        } else {
+            load(reg, value);
+        }
+        define(&instruction, reg);
+        return;
+    }
+    Register reg = result(&instruction, RAX);
+    if (source == FLT) {
+        ftoi(reg, xmm(value, XMM0));
+    } else {
+        load(reg, value);
+    }
+    if (type == INT && source != FLT) {
+        if (reg != RAX) {
+            a_.mov(RAX, reg);
+        }
+        digit(Runtime::INT_LITERAL);
+        reg = RAX;
+    } else if (type != INT) {
+        a_.cmp(reg, 0x10FFFF);
+        a_.jcc(A, runtime_->error(Runtime::CHR_RANGE));
+    }
+    define(&instruction, reg);
+}
+
+/**
+ * @brief  The arrays that don't flow in a phi are created once by call of the
+ *         function, then zeroed each time their `newarray` runs.
+ */
+void CodeGenerator::newArray(ir::Instruction const &instruction) {
+    auto slot = arrays_.find(&instruction);
+    Label created = a_.label();
+
+    if (slot != arrays_.end()) {
+        Label create = a_.label();
+        a_.mov(RDI, mem(RBP, slot->second));
+        a_.test(RDI, RDI);
+        a_.jcc(E, create);
+        a_.call(runtime_->routine(Runtime::CLEAR_ARRAY));
+        a_.jmp(created);
+        a_.bind(create);
+    }
+    a_.mov(RDI, static_cast<int64_t>(instruction.size()));
+    a_.call(runtime_->routine(Runtime::NEW_ARRAY));
+    if (slot != arrays_.end()) {
+        a_.mov(mem(RBP, slot->second), RAX);
+    }
+    a_.bind(created);
+    define(&instruction, RAX);
+}
+
+/**
+ * @brief  Array of a load or a store (its register is returned) and its
+ *         index in rdx, the negative indices count from the end.
+ */
+Register CodeGenerator::element(ir::Instruction const &instruction,
+                                Runtime::Error error) {
+    Register array = gpr(instruction.operands()[0], RCX);
+    ir::Value const *index = instruction.operands()[1];
+    int32_t value;
+
+    if (immediate(index, value) && value >= 0) {
+        a_.cmp(mem(array), value);
+        a_.jcc(LE, runtime_->error(error));
+        a_.mov(RDX, value);
+        return array;
+    }
+    Label checked = a_.label();
+    load(RDX, index);
+    a_.test(RDX, RDX);
+    a_.jcc(S, cold([this, array, checked]() {
+               a_.add(RDX, mem(array));
+               a_.jmp(checked);
+           }));
+    a_.bind(checked);
+    a_.cmp(RDX, mem(array));
+    a_.jcc(AE, runtime_->error(error));
+    return array;
+}
+
+/**
+ * @brief  The arguments (converted to the types of the parameters) are
+ *         written at [rsp], where the callee reads them.
+ */
+void CodeGenerator::call(ir::Instruction const &instruction) {
+    ir::Function const *callee = module_->function(instruction.symbol());
+    auto const &parameters = callee->parameters();
+    auto const &operands = instruction.operands();
+    int32_t value;
+
+    for (size_t i = 0; i < operands.size(); ++i) {
+        Memory argument = mem(RSP, 8 * static_cast<int32_t>(i));
+        if (parameters[i]->type() == FLT) {
+            a_.movsd(argument, xmm(operands[i], XMM0));
+        } else if (operands[i]->type() != FLT &&
+                   immediate(operands[i], value)) {
+            a_.mov(argument, value);
+        } else {
+            a_.mov(argument, integer(operands[i], RAX));
+        }
+    }
+    a_.call(functions_.at(instruction.symbol()));
+    if (callee->type() == FLT) {
+        define(&instruction, XMM0);
+    } else {
+        define(&instruction, RAX);
+    }
+}
+
+void CodeGenerator::print(ir::Instruction const &instruction) {
+    auto const &operands = instruction.operands();
+
+    if (operands.empty()) {
+        std::string text = utf8(instruction.symbol());
+        if (!text.empty()) {
+            a_.lea(RDI, mem(runtime_->string(text)));
+            a_.mov(RSI, static_cast<int64_t>(text.size()));
+            a_.call(runtime_->routine(Runtime::WRITE));
+        }
+        return;
+    }
+    switch (operands[0]->type()) {
+    case FLT:
+        load(XMM0, operands[0]);
+        a_.call(runtime_->routine(Runtime::PRINT_FLOAT));
+        break;
+    case CHR:
+        load(RDI, operands[0]);
+        a_.call(runtime_->routine(Runtime::PRINT_CHAR));
+        break;
+    case ARR_INT:
+    case ARR_FLT:
+    case ARR_CHR:
+        load(RDI, operands[0]);
+        a_.mov(RSI, operands[0]->type() == ARR_INT   ? 0
+                    : operands[0]->type() == ARR_FLT ? 1
+                                                     : 2);
+        a_.call(runtime_->routine(Runtime::PRINT_ARRAY));
+        break;
+    default:
+        load(RDI, operands[0]);
+        a_.call(runtime_->routine(Runtime::PRINT_INT));
+        break;
+    }
+}
+
+/**
+ * @brief  Conditional branch: the copies of an edge are written after the
+ *         jump of the other edge.
+ */
+void CodeGenerator::branch(ir::Instruction const &instruction) {
+    ir::Value const *value = instruction.operands()[0];
+    ir::Block const *block = instruction.block();
+    ir::Block const *onTrue = instruction.targets()[0];
+    ir::Block const *onFalse = instruction.targets()[1];
+    Condition condition = NE;
+
+    if (fused_ == value) {
+        condition = fusedCondition_;
+    } else {
+        Register reg = value->type() == FLT ? truth(value, RAX)
+                                            : gpr(value, RAX);
+        a_.test(reg, reg);
+    }
+    fused_ = nullptr;
+    if (!copies_.count({block, onTrue})) {
+        a_.jcc(condition, label(onTrue));
+        edge(block, onFalse);
+        if (onFalse != next_) {
+            a_.jmp(label(onFalse));
+        }
+    } else if (!copies_.count({block, onFalse})) {
+        a_.jcc(negate(condition), label(onFalse));
+        edge(block, onTrue);
+        if (onTrue != next_) {
+            a_.jmp(label(onTrue));
+        }
+    } else {
+        Label otherwise = a_.label();
+        a_.jcc(negate(condition), otherwise);
+        edge(block, onTrue);
+        a_.jmp(label(onTrue));
+        a_.bind(otherwise);
+        edge(block, onFalse);
+        if (onFalse != next_) {
+            a_.jmp(label(onFalse));
+        }
+    }
+}
+
+/**
+ * @brief  The result is converted to the type of the function (a function
+ *         that ends without `ret` returns 0).
+ */
+void CodeGenerator::ret(ir::Instruction const &instruction) {
+    PrimitiveType type = function_->type();
+
+    if (type == FLT) {
+        if (instruction.operands().empty()) {
+            a_.xorpd(XMM0, XMM0);
+        } else {
+            load(XMM0, instruction.operands()[0]);
+        }
+    } else if (type != NIL) {
+        if (instruction.operands().empty()) {
+            a_.xor_(RAX, RAX);
+        } else {
+            Register reg = integer(instruction.operands()[0], RAX);
+            if (reg != RAX) {
+                a_.mov(RAX, reg);
+            }
+        }
+    }
+    if (next_ != nullptr) {
+        a_.jmp(epilogue_);
+    }
+}
+
+/******************************************************************************/
+/*                                   edges                                    */
+/******************************************************************************/
+
+/**
+ * @brief  Assign the phis of the target with their values for the edge from
+ *         the source. The copies are parallel: a copy is written when its
+ *         destination is not read by the other ones, a cycle is broken by
+ *         saving a destination in r11 (or xmm1). The phis that may be unbound
+ *         have a flag, which is 0 when the variable is not assigned.
+ */
+void CodeGenerator::edge(ir::Block const *source, ir::Block const *target) {
+    std::vector<Move> moves;
+    auto copies = copies_.find({source, target});
+
+    if (copies == copies_.end()) {
+        return;
+    }
+    for (auto const &[phi, value] : copies->second) {
+        if (value->kind() == ir::Value::CONSTANT) {
+            moves.push_back({where(phi), phi->type(), Location(),
+                             value->type(), value, 0});
+        } else if (value->kind() != ir::Value::UNDEFINED &&
+                   (where(phi) != where(value) ||
+                    (phi->type() == FLT) != (value->type() == FLT))) {
+            moves.push_back({where(phi), phi->type(), where(value),
+                             value->type(), nullptr, 0});
+        }
+        if (!unbound_.count(phi)) {
+            continue;
+        }
+        Location flag = Location::slot(flags_.at(phi));
+        if (value->kind() == ir::Value::UNDEFINED) {
+            moves.push_back({flag, INT, Location(), INT, nullptr, 0});
+        } else if (unbound_.count(value)) {
+            moves.push_back({flag, INT, Location::slot(flags_.at(value)), INT,
+                             nullptr, 0});
+        } else {
+            moves.push_back({flag, INT, Location(), INT, nullptr, 1});
+        }
+    }
+
+    while (!moves.empty()) {
+        auto read = [&moves](Location const &location, size_t except) {
+            for (size_t j = 0; j < moves.size(); ++j) {
+                if (j != except && moves[j].source == location) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        size_t i = 0;
+        while (i < moves.size() && read(moves[i].destination, i)) {
+            ++i;
+        }
+        if (i == moves.size()) {
+            // cycle: the first destination is saved
+            Location saved = moves[0].destination;
+            bool real = saved.kind == Location::XMM ||
+                        (saved.kind == Location::STACK &&
+                         moves[0].destinationType == FLT);
+            Location temporary = real ? Location::of(XMM1) : Location::of(R11);
+            PrimitiveType type = real ? FLT : INT;
+            move({temporary, type, saved, type, nullptr, 0});
+            for (Move &other : moves) {
+                if (other.source == saved) {
+                    other.source = temporary;
+                }
+            }
+            i = 0;
+        }
+        move(moves[i]);
+        moves.erase(moves.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+}
+
+/**
+ * @brief  Copy with the conversion of the value to the type of the
+ *         destination (through rax or xmm0).
+ */
+void CodeGenerator::move(Move const &move) {
+    Location const &destination = move.destination;
+    bool real = move.destinationType == FLT;
+
+    if (move.source.kind == Location::NONE) {
+        if (real) {
+            double value = move.constant->type() == FLT
+                               ? move.constant->floating()
+                               : static_cast<double>(move.constant->integer());
+            Xmm reg = destination.kind == Location::XMM ? destination.xmm()
+                                                        : XMM0;
+            if (bits(value) == 0) {
+                a_.xorpd(reg, reg);
+            } else {
+                a_.movsd(reg, mem(floatConstant(value)));
+            }
+            if (destination.kind == Location::STACK) {
+                a_.movsd(mem(RBP, destination.offset), reg);
+            }
+            return;
+        }
+        Register reg = destination.kind == Location::GPR ? destination.gpr()
+                                                         : RAX;
+        if (move.constant == nullptr) {
+            a_.mov(reg, move.immediate);
+        } else if (move.constant->type() == FLT) {
+            a_.movsd(XMM0, mem(floatConstant(move.constant->floating())));
+            ftoi(reg, XMM0);
+        } else {
+            a_.mov(reg, static_cast<int64_t>(move.constant->integer()));
+        }
+        if (destination.kind == Location::STACK) {
+            a_.mov(mem(RBP, destination.offset), reg);
+        }
+        return;
+    }
+
+    bool fromReal = move.sourceType == FLT;
+    Operand source = move.source.operand();
+    if (real) {
+        Xmm reg = destination.kind == Location::XMM ? destination.xmm()
+                                                    : XMM0;
+        if (fromReal) {
+            a_.movsd(reg, source);
+        } else {
+            a_.cvtsi2sd(reg, source);
+        }
+        if (destination.kind == Location::STACK) {
+            a_.movsd(mem(RBP, destination.offset), reg);
+        }
+    } else {
+        Register reg = destination.kind == Location::GPR ? destination.gpr()
+                                                         : RAX;
+        if (fromReal) {
+            Xmm value = move.source.kind == Location::XMM ? move.source.xmm()
+                                                          : XMM0;
+            if (move.source.kind != Location::XMM) {
+                a_.movsd(XMM0, source);
+            }
+            ftoi(reg, value);
+        } else {
+            a_.mov(reg, source);
+        }
+        if (destination.kind == Location::STACK) {
+            a_.mov(mem(RBP, destination.offset), reg);
+        }
+    }
+}
+
+/******************************************************************************/
+/*                                  operands                                  */
+/******************************************************************************/
+
+Location const &CodeGenerator::where(ir::Value const *value) const {
+    return allocator_.location(value);
+}
+
+/**
+ * @brief  Integer constant that fits in an immediate (32 bits, sign
+ *         extended).
+ */
+bool CodeGenerator::immediate(ir::Value const *value, int32_t &result) const {
+    if (value->kind() != ir::Value::CONSTANT || value->type() == FLT ||
+        value->integer() < INT32_MIN || value->integer() > INT32_MAX) {
+        return false;
+    }
+    result = static_cast<int32_t>(value->integer());
+    return true;
+}
+
+/**
+ * @brief  Copy a value (an integer, a character or an array) in a register.
+ */
+void CodeGenerator::load(Register reg, ir::Value const *value) {
+    if (value->kind() == ir::Value::CONSTANT) {
+        a_.mov(reg, static_cast<int64_t>(value->integer()));
+    } else if (value->kind() == ir::Value::UNDEFINED) {
+        a_.xor_(reg, reg); // never read (see check)
+    } else if (where(value) != Location::of(reg)) {
+        a_.mov(reg, where(value).operand());
+    }
+}
+
+/**
+ * @brief  Copy a value in an xmm register, converted to a float.
+ */
+void CodeGenerator::load(Xmm reg, ir::Value const *value) {
+    Xmm source = xmm(value, reg);
+
+    if (source != reg) {
+        a_.movsd(reg, source);
+    }
+}
+
+/**
+ * @brief  Register of a value: its own register or `scratch`.
+ */
+Register CodeGenerator::gpr(ir::Value const *value, Register scratch) {
+    if (value->kind() == ir::Value::CONSTANT ||
+        value->kind() == ir::Value::UNDEFINED ||
+        where(value).kind != Location::GPR) {
+        load(scratch, value);
+        return scratch;
+    }
+    return where(value).gpr();
+}
+
+/**
+ * @brief  Register or memory operand of a value (the constants are loaded in
+ *         `scratch`).
+ */
+Operand CodeGenerator::operand(ir::Value const *value, Register scratch) {
+    if (value->kind() == ir::Value::CONSTANT ||
+        value->kind() == ir::Value::UNDEFINED) {
+        load(scratch, value);
+        return scratch;
+    }
+    return where(value).operand();
+}
+
+/**
+ * @brief  Xmm register of a value converted to a float: its own register or
+ *         `scratch`.
+ */
+Xmm CodeGenerator::xmm(ir::Value const *value, Xmm scratch) {
+    if (value->kind() == ir::Value::CONSTANT) {
+        double constant = value->type() == FLT
+                              ? value->floating()
+                              : static_cast<double>(value->integer());
+        if (bits(constant) == 0) {
+            a_.xorpd(scratch, scratch);
+        } else {
+            a_.movsd(scratch, mem(floatConstant(constant)));
+        }
+        return scratch;
+    } else if (value->kind() == ir::Value::UNDEFINED) {
+        a_.xorpd(scratch, scratch);
+        return scratch;
+    }
+    Location const &location = where(value);
+    if (value->type() != FLT) {
+        a_.cvtsi2sd(scratch, location.operand());
+    } else if (location.kind == Location::XMM) {
+        return location.xmm();
+    } else {
+        a_.movsd(scratch, location.operand());
+    }
+    return scratch;
+}
+
+/**
+ * @brief  Operand of a float: its register, its slot or its constant.
+ */
+Operand CodeGenerator::floatOperand(ir::Value const *value, Xmm scratch) {
+    if (value->kind() == ir::Value::CONSTANT && value->type() == FLT) {
+        return mem(floatConstant(value->floating()));
+    } else if (value->kind() != ir::Value::CONSTANT &&
+               value->kind() != ir::Value::UNDEFINED &&
+               value->type() == FLT) {
+        return where(value).operand();
+    }
+    return xmm(value, scratch);
+}
+
+/**
+ * @brief  Register of a value given to an integer (the floats are truncated).
+ */
+Register CodeGenerator::integer(ir::Value const *value, Register scratch) {
+    if (value->type() != FLT) {
+        return gpr(value, scratch);
+    }
+    ftoi(scratch, xmm(value, XMM0));
+    return scratch;
+}
+
+/**
+ * @brief  1 if the value is true, 0 otherwise, in `scratch` (the floats are
+ *         true when they are not 0, nan included).
+ */
+Register CodeGenerator::truth(ir::Value const *value, Register scratch) {
+    if (value->type() == FLT) {
+        a_.xorpd(XMM2, XMM2);
+        a_.ucomisd(xmm(value, XMM0), XMM2);
+        a_.setcc(NE, scratch);
+        a_.setcc(P, R11);
+        a_.or_(scratch, R11);
+    } else {
+        Register reg = gpr(value, scratch);
+        a_.test(reg, reg);
+        a_.setcc(NE, scratch);
+    }
+    a_.movzxb(scratch, scratch);
+    return scratch;
+}
+
+/**
+ * @brief  Register where the result of an instruction is computed: its own
+ *         register or `scratch` (see define).
+ */
+Register CodeGenerator::result(ir::Value const *value,
+                               Register scratch) const {
+    Location const &location = where(value);
+    return location.kind == Location::GPR ? location.gpr() : scratch;
+}
+
+Xmm CodeGenerator::floatResult(ir::Value const *value, Xmm scratch) const {
+    Location const &location = where(value);
+    return location.kind == Location::XMM ? location.xmm() : scratch;
+}
+
+/**
+ * @brief  Give the register where it is computed to the result of an
+ *         instruction.
+ */
+void CodeGenerator::define(ir::Value const *value, Register reg) {
+    Location const &location = where(value);
+
+    if (location.kind == Location::GPR && location.gpr() != reg) {
+        a_.mov(location.gpr(), reg);
+    } else if (location.kind == Location::STACK) {
+        a_.mov(mem(RBP, location.offset), reg);
+    }
+}
+
+void CodeGenerator::define(ir::Value const *value, Xmm reg) {
+    Location const &location = where(value);
+
+    if (location.kind == Location::XMM && location.xmm() != reg) {
+        a_.movsd(location.xmm(), reg);
+    } else if (location.kind == Location::STACK) {
+        a_.movsd(mem(RBP, location.offset), reg);
+    }
+}
+
+/**
+ * @brief  Truncation of a float to an integer. cvttsd2si gives the minimum
+ *         for nan and the floats out of the integers, which is only valid
+ *         when the float is -2^63 (it is checked in xmm0).
+ */
+void CodeGenerator::ftoi(Register destination, Xmm source) {
+    Label converted = a_.label();
+
+    a_.cvttsd2si(destination, source);
+    a_.cmp(destination, 1); // overflows for the minimum only
+    a_.jcc(O, cold([this, source, converted]() {
+               if (source != XMM0) {
+                   a_.movsd(XMM0, source);
+               }
+               a_.ucomisd(XMM0, mem(floatConstant(-9223372036854775808.0)));
+               a_.jcc(NE, runtime_->error(Runtime::FLOAT_TO_INT));
+               a_.jcc(P, runtime_->error(Runtime::FLOAT_TO_INT));
+               a_.jmp(converted);
+           }));
+    a_.bind(converted);
+}
+
+Label CodeGenerator::floatConstant(double value) {
+    return runtime_->constant(bits(value));
+}
+
+/**
+ * @brief  Label of code written after the function.
+ */
+Label CodeGenerator::cold(std::function<void()> code) {
+    Label label = a_.label();
+
+    cold_.push_back([this, label, code]() {
+        a_.bind(label);
+        code();
+    });
+    return label;
+}
+
+/**
+ * @brief  Label of the error of a variable that is not assigned.
+ */
+Label CodeGenerator::unbound(std::string const &variable) {
+    auto found = unboundVariables_.find(variable);
+    if (found != unboundVariables_.end()) {
+        return found->second;
+    }
+    return unboundVariables_[variable] = a_.label();
+}
+
+Label CodeGenerator::label(ir::Block const *block) {
+    auto found = labels_.find(block);
+    if (found != labels_.end()) {
+        return found->second;
+    }
+    return labels_[block] = a_.label();
+}
+
+} // namespace x86
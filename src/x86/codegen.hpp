@@ -0,0 +1,121 @@
+#ifndef CODEGEN_H
+#define CODEGEN_H
+#include "allocator.hpp"
+#include "assembler.hpp"
+#include "ir/ir.hpp"
+#include "runtime.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace x86 {
+
+/**
+ * @brief  Translation of the IR in x86-64 machine code, written in a static
+ *         executable for Linux (see `--target=x86_64`). The program behaves
+ *         like the virtual machine of the compiler: the integers have 64 bits,
+ *         and the errors stop the program with the message of the python
+ *         exception.
+ *
+ *         The values are in the registers given by the Allocator. The phis
+ *         are assigned on the edges that lead to their block (the copies are
+ *         parallel), the arguments of the calls are written on the stack and
+ *         the result is returned in rax (or xmm0). The code of the rare cases
+ *         (the errors, a negative index...) is written after the function.
+ *
+ * @throws  std::runtime_error when the program is too large.
+ */
+class CodeGenerator {
+  public:
+    void generate(ir::Module const &module, std::string const &path);
+
+  private:
+    // copy of a value on an edge: the source is a location, or a constant
+    // (`constant` or `immediate` when the location is NONE)
+    struct Move {
+        Location destination;
+        PrimitiveType destinationType;
+        Location source;
+        PrimitiveType sourceType;
+        ir::Value const *constant;
+        int64_t immediate;
+    };
+
+    void compile(ir::Function const &function);
+    void prologue(ir::Function const &function);
+    void epilogue();
+    void compile(ir::Instruction const &instruction);
+    void check(ir::Instruction const &instruction);
+    void binary(ir::Instruction const &instruction);
+    void divide(ir::Instruction const &instruction);
+    void compare(ir::Instruction const &instruction);
+    void convert(ir::Instruction const &instruction);
+    void newArray(ir::Instruction const &instruction);
+    Register element(ir::Instruction const &instruction,
+                     Runtime::Error error);
+    void call(ir::Instruction const &instruction);
+    void print(ir::Instruction const &instruction);
+    void branch(ir::Instruction const &instruction);
+    void ret(ir::Instruction const &instruction);
+    void edge(ir::Block const *source, ir::Block const *target);
+    void move(Move const &move);
+
+    Location const &where(ir::Value const *value) const;
+    bool immediate(ir::Value const *value, int32_t &result) const;
+    void load(Register reg, ir::Value const *value);
+    void load(Xmm reg, ir::Value const *value);
+    Register gpr(ir::Value const *value, Register scratch);
+    Operand operand(ir::Value const *value, Register scratch);
+    Xmm xmm(ir::Value const *value, Xmm scratch);
+    Operand floatOperand(ir::Value const *value, Xmm scratch);
+    Register integer(ir::Value const *value, Register scratch);
+    Register truth(ir::Value const *value, Register scratch);
+    Register result(ir::Value const *value, Register scratch) const;
+    Xmm floatResult(ir::Value const *value, Xmm scratch) const;
+    void define(ir::Value const *value, Register reg);
+    void define(ir::Value const *value, Xmm reg);
+    void ftoi(Register destination, Xmm source);
+    Label floatConstant(double value);
+    Label cold(std::function<void()> code);
+    Label unbound(std::string const &variable);
+    Label label(ir::Block const *block);
+
+    Assembler a_ = {};
+    std::unique_ptr<Runtime> runtime_ = nullptr;
+    ir::Module const *module_ = nullptr;
+    std::map<std::string, Label> functions_ = {};
+    Allocator allocator_ = {};
+
+    // current function
+    ir::Function const *function_ = nullptr;
+    Label epilogue_ = {};
+    std::map<ir::Block const *, Label> labels_ = {};
+    ir::Block const *next_ = nullptr;                  //< next block
+    ir::Instruction const *following_ = nullptr;       //< next instruction
+    std::set<ir::Value const *> unbound_ = {};         //< see ir::unboundPhis
+    std::set<ir::Value const *> escaping_ = {};        //< flow in a phi
+    std::map<ir::Value const *, int32_t> flags_ = {};  //< of the unbound phis
+    std::map<ir::Value const *, int32_t> arrays_ = {}; //< reused arrays
+    std::map<ir::Value const *, size_t> uses_ = {};
+    std::vector<std::pair<Register, int32_t>> savedGprs_ = {};
+    std::vector<std::pair<Xmm, int32_t>> savedXmms_ = {};
+    int32_t heapMark_ = 0; //< slot of the top of the heap (0: no arrays)
+    std::map<std::pair<ir::Block const *, ir::Block const *>,
+             std::vector<std::pair<ir::Value const *, ir::Value const *>>>
+            copies_ = {};
+    std::map<std::string, Label> unboundVariables_ = {};
+    std::vector<std::function<void()>> cold_ = {};
+    // comparison whose flags are used by the branch that follows it
+    ir::Instruction const *fused_ = nullptr;
+    Condition fusedCondition_ = E;
+};
+
+} // namespace x86
+
+#endif
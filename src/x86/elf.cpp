@@ -0,0 +1,90 @@
+#include "elf.hpp"
+#include <fstream>
+#include <vector>
+
+namespace x86 {
+
+static constexpr uint64_t BASE = 0x400000;       //< address of the file
+static constexpr uint64_t PAGE = 0x1000;
+static constexpr uint64_t HEADERS = 64 + 3 * 56; //< ELF and program headers
+static constexpr uint64_t CODE = 0x100;          //< offset of the code
+
+/**
+ * @brief  Little endian writer of the headers.
+ */
+class Writer {
+  public:
+    void u8(uint8_t value) { bytes_.push_back(value); }
+    void u16(uint16_t value) { number(value, 2); }
+    void u32(uint32_t value) { number(value, 4); }
+    void u64(uint64_t value) { number(value, 8); }
+    std::vector<uint8_t> &bytes() { return bytes_; }
+
+  private:
+    void number(uint64_t value, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            bytes_.push_back(static_cast<uint8_t>(value >> 8 * i));
+        }
+    }
+
+    std::vector<uint8_t> bytes_ = {};
+};
+
+static void segment(Writer &w, uint32_t type, uint32_t flags, uint64_t offset,
+                    uint64_t address, uint64_t file, uint64_t memory) {
+    w.u32(type);
+    w.u32(flags);
+    w.u64(offset);
+    w.u64(address); // virtual
+    w.u64(address); // physical
+    w.u64(file);
+    w.u64(memory);
+    w.u64(type == 1 ? PAGE : 16);
+}
+
+/**
+ * @brief  The file is loaded as one read and execute segment (the headers,
+ *         the code and its constants), the data is a segment without content
+ *         on the next page.
+ */
+void writeExecutable(std::string const &path, Assembler &assembler,
+                     Label entry) {
+    static_assert(HEADERS <= CODE, "the headers overlap the code");
+    uint64_t end = BASE + CODE + assembler.size();
+    uint64_t data = (end + PAGE - 1) / PAGE * PAGE;
+    std::vector<uint8_t> code = assembler.finish(BASE + CODE, data);
+    Writer w;
+
+    // ELF header: magic (\x7fELF), 64 bits, little endian, System V,
+    // executable, x86-64
+    for (int byte : {0x7F, 0x45, 0x4C, 0x46, 2, 1, 1, 0}) {
+        w.u8(byte);
+    }
+    w.u64(0);
+    w.u16(2);
+    w.u16(62);
+    w.u32(1);
+    w.u64(assembler.address(entry));
+    w.u64(64); // program headers
+    w.u64(0);  // no section headers
+    w.u32(0);
+    w.u16(64);
+    w.u16(56);
+    w.u16(3);
+    w.u16(64);
+    w.u16(0);
+    w.u16(0);
+
+    // program headers: PT_LOAD (R X), PT_LOAD (R W), PT_GNU_STACK (R W)
+    segment(w, 1, 5, 0, BASE, CODE + code.size(), CODE + code.size());
+    segment(w, 1, 6, 0, data, 0, assembler.data());
+    segment(w, 0x6474E551, 6, 0, 0, 0, 0);
+
+    w.bytes().resize(CODE, 0);
+    w.bytes().insert(w.bytes().end(), code.begin(), code.end());
+    std::ofstream fs(path, std::ios::binary);
+    fs.write(reinterpret_cast<char const *>(w.bytes().data()),
+             static_cast<std::streamsize>(w.bytes().size()));
+}
+
+} // namespace x86
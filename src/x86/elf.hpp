@@ -0,0 +1,17 @@
+#ifndef ELF_H
+#define ELF_H
+#include "assembler.hpp"
+#include <string>
+
+namespace x86 {
+
+/**
+ * @brief  Write a static ELF executable (x86-64 Linux) that loads the code of
+ *         the assembler and its zeroed data, and starts at `entry`.
+ */
+void writeExecutable(std::string const &path, Assembler &assembler,
+                     Label entry);
+
+} // namespace x86
+
+#endif
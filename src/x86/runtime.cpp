@@ -0,0 +1,1842 @@
+#include "runtime.hpp"
+
+namespace x86 {
+
+static constexpr int32_t OUT_SIZE = 1 << 16;  //< output buffer
+static constexpr int32_t IN_SIZE = 1 << 16;   //< input buffer
+static constexpr int32_t LINE_SIZE = 1 << 16; //< longest line read
+static constexpr int32_t LIMBS = 24;          //< 64 bits limbs of a bignum
+
+/*
+ * the bignums of the conversions of the floats (a length, then the limbs): r,
+ * s, m+, m- and a temporary
+ */
+enum Bignum {
+    NUMERATOR,
+    DENOMINATOR,
+    HIGH_MARGIN,
+    LOW_MARGIN,
+    TEMPORARY,
+    BIGNUMS
+};
+static constexpr int32_t BIGNUM_SIZE = 8 * (LIMBS + 1);
+
+/*
+ * system calls
+ */
+static constexpr int32_t SYS_READ = 0;
+static constexpr int32_t SYS_WRITE = 1;
+static constexpr int32_t SYS_MMAP = 9;
+static constexpr int32_t SYS_EXIT_GROUP = 231;
+static constexpr int32_t INTERRUPTED = 4; //< EINTR
+
+static char const *MESSAGES[] = {
+    "OverflowError: integer overflow (the integers have 64 bits)",
+    "ZeroDivisionError: division by zero",
+    "ZeroDivisionError: float division by zero",
+    "IndexError: list index out of range",
+    "IndexError: list assignment index out of range",
+    "ValueError: invalid literal for int() with base 10",
+    "ValueError: could not convert string to float",
+    "ValueError: chr() arg not in range(0x110000)",
+    "OverflowError: cannot convert float infinity to integer",
+    "RecursionError: maximum recursion depth exceeded",
+    "MemoryError",
+    "EOFError: EOF when reading a line",
+};
+
+static constexpr uint64_t SIGN = 0x8000000000000000;
+static constexpr uint64_t INFINITE = 0x7FF0000000000000;
+static constexpr uint64_t MANTISSA = 0x000FFFFFFFFFFFFF;
+static constexpr uint64_t HIDDEN = 0x0010000000000000; //< implicit bit
+
+Runtime::Runtime(Assembler &assembler) : a_(assembler) {
+    for (int i = 0; i < ROUTINES; ++i) {
+        routines_.push_back(a_.label());
+    }
+    for (int i = 0; i < ERRORS; ++i) {
+        errors_.push_back(a_.label());
+    }
+    for (Label *label :
+         {&putc_, &putUtf8_, &escape_, &reprChar_, &reprString_, &flush_,
+          &readLine_, &getc_, &bigSet_, &bigMul_, &bigPow10_, &bigAdd_,
+          &bigSub_, &bigCmp_, &compareScaled_, &powers_, &tens_}) {
+        *label = a_.label();
+    }
+    out_ = a_.reserve(OUT_SIZE);
+    outLength_ = a_.reserve(8);
+    outFile_ = a_.reserve(8);
+    in_ = a_.reserve(IN_SIZE);
+    inPosition_ = a_.reserve(8);
+    inLength_ = a_.reserve(8);
+    line_ = a_.reserve(LINE_SIZE);
+    stackLimit_ = a_.reserve(8);
+    heapTop_ = a_.reserve(8);
+    heapEnd_ = a_.reserve(8);
+    bignums_ = a_.reserve(BIGNUMS * BIGNUM_SIZE);
+    digits_ = a_.reserve(32);
+}
+
+/**
+ * @brief  Label of a string in the constants (written by emitData).
+ */
+Label Runtime::string(std::string const &text) {
+    auto found = strings_.find(text);
+    if (found != strings_.end()) {
+        return found->second;
+    }
+    return strings_[text] = a_.label();
+}
+
+/**
+ * @brief  Label of a 64 bits constant (written by emitData).
+ */
+Label Runtime::constant(uint64_t bits) {
+    auto found = constants_.find(bits);
+    if (found != constants_.end()) {
+        return found->second;
+    }
+    return constants_[bits] = a_.label();
+}
+
+void Runtime::write(std::string const &text) {
+    a_.lea(RDI, mem(string(text)));
+    a_.mov(RSI, static_cast<int64_t>(text.size()));
+    call(WRITE);
+}
+
+void Runtime::put(char c) {
+    a_.mov(RDI, static_cast<int64_t>(c));
+    a_.call(putc_);
+}
+
+void Runtime::loadBignum(Register reg, size_t index) {
+    a_.lea(reg, mem(bignums_, static_cast<int32_t>(index) * BIGNUM_SIZE));
+}
+
+void Runtime::emit(Label main) {
+    emitStart(main);
+    emitErrors();
+    emitOutput();
+    emitCharacters();
+    emitPrintFloat();
+    emitBignums();
+    emitInput();
+    emitReadInt();
+    emitReadFloat();
+    emitArrays();
+}
+
+void Runtime::emitData() {
+    a_.align(8);
+    a_.bind(powers_);
+    uint64_t power = 1;
+    for (int i = 0; i < 20; ++i, power *= 10) {
+        a_.quad(power);
+    }
+    a_.bind(tens_);
+    double ten = 1;
+    for (int i = 0; i <= 22; ++i, ten *= 10) {
+        uint64_t bits;
+        static_assert(sizeof(bits) == sizeof(ten), "the floats have 64 bits");
+        __builtin_memcpy(&bits, &ten, sizeof(bits));
+        a_.quad(bits);
+    }
+    for (auto const &[bits, label] : constants_) {
+        a_.bind(label);
+        a_.quad(bits);
+    }
+    for (auto const &[text, label] : strings_) {
+        a_.bind(label);
+        a_.bytes(text);
+    }
+}
+
+/******************************************************************************/
+/*                               start and exit                               */
+/******************************************************************************/
+
+/**
+ * @brief  Map `size` bytes (halved until the mapping succeeds), the address
+ *         is in rax at `done`.
+ */
+void Runtime::map(Register size, size_t minimum, Label done) {
+    Label retry = a_.label();
+
+    a_.bind(retry);
+    a_.xor_(RDI, RDI);
+    a_.mov(RSI, size);
+    a_.mov(RDX, 3);          // PROT_READ | PROT_WRITE
+    a_.mov(R10, 0x4022);     // MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE
+    a_.mov(R8, int64_t(-1)); // no file
+    a_.xor_(R9, R9);
+    a_.mov(RAX, SYS_MMAP);
+    a_.syscall();
+    a_.cmp(RAX, -4096); // the errors are -4095 to -1
+    a_.jcc(BE, done);
+    a_.shr(size, 1);
+    a_.cmp(size, static_cast<int32_t>(minimum));
+    a_.jcc(AE, retry);
+    a_.jmp(errors_[MEMORY]);
+}
+
+/**
+ * @brief  Entry point: map the stack (the recursion stops 64 KiB before its
+ *         end) and the heap, run main and exit.
+ */
+void Runtime::emitStart(Label main) {
+    Label stack = a_.label();
+    Label heap = a_.label();
+
+    a_.bind(routines_[START]);
+    a_.mov(R12, int64_t(1) << 30);
+    map(R12, 1 << 23, stack);
+    a_.bind(stack);
+    a_.lea(RSP, mem(RAX, R12, 1));
+    a_.add(RAX, 1 << 16);
+    a_.mov(mem(stackLimit_), RAX);
+    a_.mov(R12, int64_t(1) << 40);
+    map(R12, 1 << 20, heap);
+    a_.bind(heap);
+    a_.mov(mem(heapTop_), RAX);
+    a_.add(RAX, R12);
+    a_.mov(mem(heapEnd_), RAX);
+    a_.mov(mem(outFile_), 1);
+    a_.call(main);
+    a_.call(flush_);
+    a_.xor_(RDI, RDI);
+    a_.mov(RAX, SYS_EXIT_GROUP);
+    a_.syscall();
+
+    // fail: flush the output, write the message and exit with the status 1
+    a_.bind(routines_[FAIL]);
+    a_.push(RDI);
+    a_.push(RSI);
+    a_.call(flush_);
+    a_.pop(RDX);
+    a_.pop(RSI);
+    a_.mov(RDI, 2);
+    a_.mov(RAX, SYS_WRITE);
+    a_.syscall();
+    a_.lea(RSI, mem(string("\n")));
+    a_.mov(RDX, 1);
+    a_.mov(RDI, 2);
+    a_.mov(RAX, SYS_WRITE);
+    a_.syscall();
+    a_.mov(RDI, 1);
+    a_.mov(RAX, SYS_EXIT_GROUP);
+    a_.syscall();
+}
+
+void Runtime::emitErrors() {
+    for (int i = 0; i < ERRORS; ++i) {
+        a_.bind(errors_[i]);
+        if (i == FLOAT_TO_INT) {
+            // nan, infinity or a float out of the integers
+            Label infinite = a_.label();
+            a_.ucomisd(XMM0, XMM0);
+            a_.jcc(NP, infinite);
+            std::string nan = "ValueError: cannot convert float NaN to integer";
+            a_.lea(RDI, mem(string(nan)));
+            a_.mov(RSI, static_cast<int64_t>(nan.size()));
+            a_.jmp(routines_[FAIL]);
+            a_.bind(infinite);
+            a_.movq(RAX, XMM0);
+            a_.shl(RAX, 1);
+            a_.mov(RCX, static_cast<int64_t>(INFINITE << 1));
+            a_.cmp(RAX, RCX);
+            a_.jcc(NE, errors_[OVERFLOW]);
+        }
+        if (i == INT_LITERAL || i == FLOAT_LITERAL) {
+            // the message ends with the repr of the text, it is written in
+            // the output buffer, which is then flushed on the standard error
+            Label character = a_.label();
+            Label written = a_.label();
+            a_.push(RDI);
+            a_.push(RSI);
+            a_.call(flush_);
+            a_.mov(mem(outFile_), 2);
+            write(std::string(MESSAGES[i]) + ": ");
+            a_.pop(RSI);
+            a_.pop(RDI);
+            a_.test(RSI, RSI);
+            a_.jcc(S, character);
+            a_.call(reprString_);
+            a_.jmp(written);
+            a_.bind(character);
+            a_.call(reprChar_);
+            a_.bind(written);
+            put('\n');
+            a_.call(flush_);
+            a_.mov(RDI, 1);
+            a_.mov(RAX, SYS_EXIT_GROUP);
+            a_.syscall();
+            continue;
+        }
+        std::string message = MESSAGES[i];
+        a_.lea(RDI, mem(string(message)));
+        a_.mov(RSI, static_cast<int64_t>(message.size()));
+        a_.jmp(routines_[FAIL]);
+    }
+}
+
+/******************************************************************************/
+/*                                   output                                   */
+/******************************************************************************/
+
+void Runtime::emitOutput() {
+    Label loop = a_.label();
+    Label done = a_.label();
+    Label store = a_.label();
+    Label next = a_.label();
+    Label digit = a_.label();
+    Label positive = a_.label();
+
+    // flush: write the buffer on the standard output (or the standard error
+    // for the messages of the errors)
+    a_.bind(flush_);
+    a_.lea(RSI, mem(out_));
+    a_.mov(RDX, mem(outLength_));
+    a_.bind(loop);
+    a_.test(RDX, RDX);
+    a_.jcc(LE, done);
+    a_.mov(RDI, mem(outFile_));
+    a_.mov(RAX, SYS_WRITE);
+    a_.syscall();
+    a_.cmp(RAX, -INTERRUPTED);
+    a_.jcc(E, loop);
+    a_.test(RAX, RAX);
+    a_.jcc(LE, done); // the output is lost
+    a_.add(RSI, RAX);
+    a_.sub(RDX, RAX);
+    a_.jmp(loop);
+    a_.bind(done);
+    a_.mov(mem(outLength_), 0);
+    a_.ret();
+
+    // putc: write the byte dil
+    a_.bind(putc_);
+    a_.mov(RAX, mem(outLength_));
+    a_.cmp(RAX, OUT_SIZE);
+    a_.jcc(B, store);
+    a_.push(RDI);
+    a_.call(flush_);
+    a_.pop(RDI);
+    a_.xor_(RAX, RAX);
+    a_.bind(store);
+    a_.lea(RCX, mem(out_));
+    a_.movb(mem(RCX, RAX, 1), RDI);
+    a_.inc(RAX);
+    a_.mov(mem(outLength_), RAX);
+    a_.ret();
+
+    // write: the bytes are kept in r8 and r9 (putc doesn't change them)
+    loop = a_.label();
+    done = a_.label();
+    a_.bind(routines_[WRITE]);
+    a_.mov(R8, RDI);
+    a_.mov(R9, RSI);
+    a_.bind(loop);
+    a_.test(R9, R9);
+    a_.jcc(E, done);
+    a_.movzxb(RDI, mem(R8));
+    a_.call(putc_);
+    a_.inc(R8);
+    a_.dec(R9);
+    a_.jmp(loop);
+    a_.bind(done);
+    a_.ret();
+
+    // print int: the digits are written backward on the stack
+    a_.bind(routines_[PRINT_INT]);
+    a_.sub(RSP, 32);
+    a_.mov(RAX, RDI);
+    a_.lea(RSI, mem(RSP, 32));
+    a_.xor_(R8, R8);
+    a_.test(RAX, RAX);
+    a_.jcc(NS, positive);
+    a_.neg(RAX); // the minimum stays itself, it is divided unsigned
+    a_.mov(R8, 1);
+    a_.bind(positive);
+    a_.mov(RCX, 10);
+    a_.bind(digit);
+    a_.xor_(RDX, RDX);
+    a_.div(RCX);
+    a_.add(RDX, '0');
+    a_.dec(RSI);
+    a_.movb(mem(RSI), RDX);
+    a_.test(RAX, RAX);
+    a_.jcc(NE, digit);
+    a_.test(R8, R8);
+    a_.jcc(E, next);
+    a_.dec(RSI);
+    a_.movb(mem(RSI), int8_t('-'));
+    a_.bind(next);
+    a_.mov(RDI, RSI);
+    a_.lea(RSI, mem(RSP, 32));
+    a_.sub(RSI, RDI);
+    call(WRITE);
+    a_.add(RSP, 32);
+    a_.ret();
+
+    // print array: the elements are separated by ", "
+    Label element = a_.label();
+    Label floating = a_.label();
+    Label character = a_.label();
+    loop = a_.label();
+    done = a_.label();
+    next = a_.label();
+    a_.bind(routines_[PRINT_ARRAY]);
+    a_.push(RBX);
+    a_.push(R12);
+    a_.push(R13);
+    a_.mov(RBX, RDI);
+    a_.mov(R12, RSI);
+    a_.xor_(R13, R13);
+    put('[');
+    a_.bind(loop);
+    a_.cmp(R13, mem(RBX));
+    a_.jcc(GE, done);
+    a_.test(R13, R13);
+    a_.jcc(E, element);
+    write(", ");
+    a_.bind(element);
+    a_.mov(RDI, mem(RBX, R13, 8, 8));
+    a_.cmp(R12, 1);
+    a_.jcc(E, floating);
+    a_.cmp(R12, 2);
+    a_.jcc(E, character);
+    call(PRINT_INT);
+    a_.jmp(next);
+    a_.bind(floating);
+    a_.movq(XMM0, RDI);
+    call(PRINT_FLOAT);
+    a_.jmp(next);
+    a_.bind(character);
+    a_.call(reprChar_);
+    a_.bind(next);
+    a_.inc(R13);
+    a_.jmp(loop);
+    a_.bind(done);
+    put(']');
+    a_.pop(R13);
+    a_.pop(R12);
+    a_.pop(RBX);
+    a_.ret();
+}
+
+/**
+ * @brief  The characters are written in UTF-8, the zeros of the strings are
+ *         the integer 0.
+ */
+void Runtime::emitCharacters() {
+    Label two = a_.label();
+    Label three = a_.label();
+    Label lead = a_.label();
+    Label loop = a_.label();
+
+    // put: the character rdi in UTF-8
+    a_.bind(putUtf8_);
+    a_.cmp(RDI, 0x80);
+    a_.jcc(B, putc_);
+    a_.push(RBX);
+    a_.push(R12);
+    a_.mov(RBX, RDI);
+    a_.mov(R12, 1); // continuation bytes
+    a_.mov(RDI, RBX);
+    a_.shr(RDI, 6);
+    a_.or_(RDI, 0xC0);
+    a_.cmp(RBX, 0x800);
+    a_.jcc(B, lead);
+    a_.bind(two);
+    a_.mov(R12, 2);
+    a_.mov(RDI, RBX);
+    a_.shr(RDI, 12);
+    a_.or_(RDI, 0xE0);
+    a_.cmp(RBX, 0x10000);
+    a_.jcc(B, lead);
+    a_.bind(three);
+    a_.mov(R12, 3);
+    a_.mov(RDI, RBX);
+    a_.shr(RDI, 18);
+    a_.or_(RDI, 0xF0);
+    a_.bind(lead);
+    a_.call(putc_);
+    a_.bind(loop);
+    a_.dec(R12);
+    a_.imul(RCX, R12, 6);
+    a_.mov(RDI, RBX);
+    a_.shr(RDI);
+    a_.and_(RDI, 0x3F);
+    a_.or_(RDI, 0x80);
+    a_.call(putc_);
+    a_.test(R12, R12);
+    a_.jcc(NE, loop);
+    a_.pop(R12);
+    a_.pop(RBX);
+    a_.ret();
+
+    // print char
+    Label zero = a_.label();
+    a_.bind(routines_[PRINT_CHAR]);
+    a_.test(RDI, RDI);
+    a_.jcc(NE, putUtf8_);
+    a_.bind(zero);
+    a_.mov(RDI, '0');
+    a_.jmp(putc_);
+
+    // escape: the character rdi in a string quoted with rsi, like python's
+    // repr
+    Label hexadecimal = a_.label();
+    Label backslash = a_.label();
+    a_.bind(escape_);
+    a_.cmp(RDI, RSI);
+    a_.jcc(E, backslash);
+    a_.cmp(RDI, '\\');
+    a_.jcc(E, backslash);
+    for (auto [c, text] : {std::pair<char, char const *>{'\n', "\\n"},
+                           {'\t', "\\t"},
+                           {'\r', "\\r"}}) {
+        Label other = a_.label();
+        a_.cmp(RDI, c);
+        a_.jcc(NE, other);
+        a_.lea(RDI, mem(string(text)));
+        a_.mov(RSI, static_cast<int64_t>(std::string(text).size()));
+        a_.jmp(routines_[WRITE]);
+        a_.bind(other);
+    }
+    a_.cmp(RDI, 0x20);
+    a_.jcc(B, hexadecimal);
+    a_.cmp(RDI, 0x7F);
+    a_.jcc(B, putUtf8_);
+    a_.cmp(RDI, 0xA0);
+    a_.jcc(A, putUtf8_);
+    a_.bind(hexadecimal);
+    a_.push(RBX);
+    a_.mov(RBX, RDI);
+    write("\\x");
+    for (int shift : {4, 0}) {
+        a_.mov(RAX, RBX);
+        if (shift > 0) {
+            a_.shr(RAX, static_cast<uint8_t>(shift));
+        }
+        a_.and_(RAX, 0xF);
+        a_.lea(RCX, mem(string("0123456789abcdef")));
+        a_.movzxb(RDI, mem(RCX, RAX, 1));
+        a_.call(putc_);
+    }
+    a_.pop(RBX);
+    a_.ret();
+    a_.bind(backslash);
+    a_.push(RDI);
+    put('\\');
+    a_.pop(RDI);
+    a_.jmp(putc_);
+
+    // repr char: an element of a list of characters, like python's repr
+    Label single = a_.label();
+    a_.bind(reprChar_);
+    a_.test(RDI, RDI);
+    a_.jcc(E, zero);
+    a_.mov(RSI, '\'');
+    a_.cmp(RDI, '\'');
+    a_.jcc(NE, single);
+    a_.mov(RSI, '"');
+    a_.bind(single);
+    a_.push(RSI);
+    a_.push(RDI);
+    a_.mov(RDI, RSI);
+    a_.call(putc_);
+    a_.pop(RDI);
+    a_.mov(RSI, mem(RSP));
+    a_.call(escape_);
+    a_.pop(RDI);
+    a_.jmp(putc_);
+
+    // repr string: the rsi bytes (UTF-8) at rdi, like python's repr (the
+    // quotes are '"' when there are only "'" in the string)
+    //
+    // rbx: position, r12: end, r13: quote, r14: a "'" was found
+    Label scan = a_.label();
+    Label scanned = a_.label();
+    Label quoted = a_.label();
+    Label next = a_.label();
+    Label continuation = a_.label();
+    Label decoded = a_.label();
+    Label done = a_.label();
+    Label length = a_.label();
+    loop = a_.label();
+    a_.bind(reprString_);
+    for (Register reg : {RBX, R12, R13, R14}) {
+        a_.push(reg);
+    }
+    a_.mov(RBX, RDI);
+    a_.lea(R12, mem(RDI, RSI, 1));
+    a_.mov(R13, '\'');
+    a_.xor_(R14, R14);
+    a_.mov(RCX, RBX);
+    a_.bind(scan);
+    a_.cmp(RCX, R12);
+    a_.jcc(AE, scanned);
+    a_.movzxb(RAX, mem(RCX));
+    a_.cmp(RAX, '"');
+    a_.jcc(E, quoted);
+    a_.cmp(RAX, '\'');
+    a_.jcc(NE, next);
+    a_.mov(R14, 1);
+    a_.bind(next);
+    a_.inc(RCX);
+    a_.jmp(scan);
+    a_.bind(scanned);
+    a_.test(R14, R14);
+    a_.jcc(E, quoted);
+    a_.mov(R13, '"');
+    a_.bind(quoted);
+    a_.mov(RDI, R13);
+    a_.call(putc_);
+    // the characters, decoded like READ_CHAR
+    a_.bind(loop);
+    a_.cmp(RBX, R12);
+    a_.jcc(AE, done);
+    a_.movzxb(RAX, mem(RBX));
+    a_.inc(RBX);
+    a_.cmp(RAX, 0x80);
+    a_.jcc(B, decoded);
+    a_.mov(RCX, 1); // continuation bytes
+    a_.cmp(RAX, 0xE0);
+    a_.jcc(B, length);
+    a_.mov(RCX, 2);
+    a_.cmp(RAX, 0xF0);
+    a_.jcc(B, length);
+    a_.mov(RCX, 3);
+    a_.bind(length);
+    a_.mov(RDX, 0x3F);
+    a_.shr(RDX);
+    a_.and_(RAX, RDX);
+    a_.bind(continuation);
+    a_.test(RCX, RCX);
+    a_.jcc(E, decoded);
+    a_.cmp(RBX, R12);
+    a_.jcc(AE, decoded);
+    a_.movzxb(RDX, mem(RBX));
+    a_.mov(R8, RDX);
+    a_.and_(R8, 0xC0);
+    a_.cmp(R8, 0x80);
+    a_.jcc(NE, decoded);
+    a_.shl(RAX, 6);
+    a_.and_(RDX, 0x3F);
+    a_.or_(RAX, RDX);
+    a_.inc(RBX);
+    a_.dec(RCX);
+    a_.jmp(continuation);
+    a_.bind(decoded);
+    a_.mov(RDI, RAX);
+    a_.mov(RSI, R13);
+    a_.call(escape_);
+    a_.jmp(loop);
+    a_.bind(done);
+    a_.mov(RDI, R13);
+    a_.call(putc_);
+    for (Register reg : {R14, R13, R12, RBX}) {
+        a_.pop(reg);
+    }
+    a_.ret();
+}
+
+/******************************************************************************/
+/*                                   floats                                   */
+/******************************************************************************/
+
+/**
+ * @brief  Print float: the shortest digits that give back the float, like
+ *         python's repr. They are generated with the free-format algorithm
+ *         of Steele & White (as written by Burger & Dybvig): the float is
+ *         r / s * 10^k, and m+ and m- are the distances to the middle of its
+ *         neighbors, with exact integers.
+ *
+ *         rbx: bits of the float, then the digit, r12: mantissa, r13: binary
+ *         exponent, then the number of digits, r14: k, r15: 1 if the
+ *         mantissa is even (the middles are read back as the float)
+ */
+void Runtime::emitPrintFloat() {
+    Label nan = a_.label();
+    Label finite = a_.label();
+    Label positive = a_.label();
+    Label nonzero = a_.label();
+    Label equalGaps = a_.label();
+    Label subnormal = a_.label();
+    Label decomposed = a_.label();
+    Label scaleDown = a_.label();
+    Label fixup = a_.label();
+    Label generate = a_.label();
+    Label digit = a_.label();
+    Label subtract = a_.label();
+    Label got = a_.label();
+    Label high = a_.label();
+    Label up = a_.label();
+    Label last = a_.label();
+    Label exponential = a_.label();
+    Label small = a_.label();
+    Label middle = a_.label();
+    Label done = a_.label();
+    // max(e, 0) or max(-e, 0) in rdx
+    auto positivePart = [this](bool negative) {
+        a_.mov(RDX, R13);
+        if (negative) {
+            a_.neg(RDX);
+        }
+        a_.xor_(RAX, RAX);
+        a_.test(RDX, RDX);
+        a_.cmov(S, RDX, RAX);
+    };
+    auto bignum = [this](Label routine, Bignum p, Bignum q, Bignum r) {
+        loadBignum(RDI, p);
+        loadBignum(RSI, q);
+        if (r != BIGNUMS) {
+            loadBignum(RDX, r);
+        }
+        a_.call(routine);
+    };
+    auto times10 = [this](Bignum p) {
+        loadBignum(RDI, p);
+        a_.mov(RSI, 10);
+        a_.call(bigMul_);
+    };
+    auto storeDigit = [this]() {
+        a_.lea(RAX, mem(digits_));
+        a_.lea(RCX, mem(RBX, '0'));
+        a_.movb(mem(RAX, R13, 1), RCX);
+        a_.inc(R13);
+    };
+    auto zeros = [this]() {
+        // rbx zeros
+        Label loop = a_.label();
+        Label end = a_.label();
+        a_.bind(loop);
+        a_.test(RBX, RBX);
+        a_.jcc(LE, end);
+        put('0');
+        a_.dec(RBX);
+        a_.jmp(loop);
+        a_.bind(end);
+    };
+
+    a_.bind(routines_[PRINT_FLOAT]);
+    for (Register reg : {RBX, R12, R13, R14, R15}) {
+        a_.push(reg);
+    }
+    a_.sub(RSP, 16); // [rsp]: first test of the end, [rsp + 8]: unequal gaps
+    a_.movq(RBX, XMM0);
+    a_.mov(RAX, RBX);
+    a_.shl(RAX, 1);
+    a_.mov(RCX, static_cast<int64_t>(INFINITE << 1));
+    a_.cmp(RAX, RCX);
+    a_.jcc(A, nan);
+    a_.jcc(B, finite);
+    a_.test(RBX, RBX);
+    Label unsigned_ = a_.label();
+    a_.jcc(NS, unsigned_);
+    put('-');
+    a_.bind(unsigned_);
+    write("inf");
+    a_.jmp(done);
+    a_.bind(nan);
+    write("nan");
+    a_.jmp(done);
+
+    a_.bind(finite);
+    a_.test(RBX, RBX);
+    a_.jcc(NS, positive);
+    put('-');
+    a_.shl(RBX, 1);
+    a_.shr(RBX, 1);
+    a_.bind(positive);
+    a_.test(RBX, RBX);
+    a_.jcc(NE, nonzero);
+    write("0.0");
+    a_.jmp(done);
+
+    // mantissa and exponent: the float is f * 2^e
+    a_.bind(nonzero);
+    a_.mov(R13, RBX);
+    a_.shr(R13, 52);
+    a_.mov(R12, static_cast<int64_t>(MANTISSA));
+    a_.and_(R12, RBX);
+    a_.mov(mem(RSP, 8), 0);
+    a_.test(R12, R12);
+    a_.jcc(NE, equalGaps);
+    a_.cmp(R13, 1);
+    a_.jcc(BE, equalGaps);
+    a_.mov(mem(RSP, 8), 1); // the gap below is half the one above
+    a_.bind(equalGaps);
+    a_.test(R13, R13);
+    a_.jcc(E, subnormal);
+    a_.mov(RAX, static_cast<int64_t>(HIDDEN));
+    a_.or_(R12, RAX);
+    a_.sub(R13, 1075);
+    a_.jmp(decomposed);
+    a_.bind(subnormal);
+    a_.mov(R13, int64_t(-1074));
+    a_.bind(decomposed);
+    a_.mov(R15, R12);
+    a_.and_(R15, 1);
+    a_.xor_(R15, 1);
+
+    // r = f * 2^(max(e, 0) + 1 + u), s = 2^(max(-e, 0) + 1 + u),
+    // m+ = 2^(max(e, 0) + u), m- = 2^max(e, 0) (u: unequal gaps)
+    positivePart(false);
+    a_.add(RDX, mem(RSP, 8));
+    a_.inc(RDX);
+    loadBignum(RDI, NUMERATOR);
+    a_.mov(RSI, R12);
+    a_.call(bigSet_);
+    positivePart(true);
+    a_.add(RDX, mem(RSP, 8));
+    a_.inc(RDX);
+    loadBignum(RDI, DENOMINATOR);
+    a_.mov(RSI, 1);
+    a_.call(bigSet_);
+    positivePart(false);
+    a_.add(RDX, mem(RSP, 8));
+    loadBignum(RDI, HIGH_MARGIN);
+    a_.mov(RSI, 1);
+    a_.call(bigSet_);
+    positivePart(false);
+    loadBignum(RDI, LOW_MARGIN);
+    a_.mov(RSI, 1);
+    a_.call(bigSet_);
+
+    // k is estimated from the binary exponent (floor(log10(2^e)) - 1, it is
+    // never too large), the fixup makes r + m+ < s
+    a_.bsr(RAX, R12);
+    a_.add(RAX, R13);
+    a_.imul(RAX, RAX, 78913); // log10(2) * 2^18
+    a_.sar(RAX, 18);
+    a_.dec(RAX);
+    a_.mov(R14, RAX);
+    a_.test(R14, R14);
+    a_.jcc(S, scaleDown);
+    loadBignum(RDI, DENOMINATOR);
+    a_.mov(RSI, R14);
+    a_.call(bigPow10_);
+    a_.jmp(fixup);
+    a_.bind(scaleDown);
+    for (Bignum p : {NUMERATOR, HIGH_MARGIN, LOW_MARGIN}) {
+        loadBignum(RDI, p);
+        a_.mov(RSI, R14);
+        a_.neg(RSI);
+        a_.call(bigPow10_);
+    }
+    a_.bind(fixup);
+    bignum(bigAdd_, TEMPORARY, NUMERATOR, HIGH_MARGIN);
+    bignum(bigCmp_, TEMPORARY, DENOMINATOR, BIGNUMS);
+    a_.add(RAX, R15);
+    a_.test(RAX, RAX);
+    a_.jcc(LE, generate);
+    times10(DENOMINATOR);
+    a_.inc(R14);
+    a_.jmp(fixup);
+
+    // digits
+    a_.bind(generate);
+    a_.xor_(R13, R13);
+    a_.bind(digit);
+    times10(NUMERATOR);
+    times10(HIGH_MARGIN);
+    times10(LOW_MARGIN);
+    a_.xor_(RBX, RBX);
+    a_.bind(subtract);
+    bignum(bigCmp_, NUMERATOR, DENOMINATOR, BIGNUMS);
+    a_.test(RAX, RAX);
+    a_.jcc(S, got);
+    bignum(bigSub_, NUMERATOR, DENOMINATOR, BIGNUMS);
+    a_.inc(RBX);
+    a_.jmp(subtract);
+    a_.bind(got);
+    // low: r < m- (or r <= m- when even), high: r + m+ > s (or >=)
+    bignum(bigCmp_, NUMERATOR, LOW_MARGIN, BIGNUMS);
+    a_.sub(RAX, R15);
+    a_.shr(RAX, 63);
+    a_.mov(mem(RSP), RAX);
+    bignum(bigAdd_, TEMPORARY, NUMERATOR, HIGH_MARGIN);
+    bignum(bigCmp_, TEMPORARY, DENOMINATOR, BIGNUMS);
+    a_.add(RAX, R15);
+    a_.test(RAX, RAX);
+    a_.jcc(G, high);
+    a_.cmp(mem(RSP), 0);
+    a_.jcc(NE, last);
+    storeDigit();
+    a_.jmp(digit);
+    a_.bind(high);
+    a_.cmp(mem(RSP), 0);
+    a_.jcc(E, up);
+    // both: the closest one (2r against s), the even digit on a tie
+    bignum(bigAdd_, TEMPORARY, NUMERATOR, NUMERATOR);
+    bignum(bigCmp_, TEMPORARY, DENOMINATOR, BIGNUMS);
+    a_.test(RAX, RAX);
+    a_.jcc(S, last);
+    a_.jcc(G, up);
+    a_.mov(RAX, RBX);
+    a_.and_(RAX, 1);
+    a_.jcc(E, last);
+    a_.bind(up);
+    a_.inc(RBX);
+    a_.bind(last);
+    storeDigit();
+
+    // repr: 0.000ddd, ddd.ddd, ddd000.0 or d.ddde+XX, the float is
+    // 0.ddd * 10^k
+    a_.cmp(R14, -3);
+    a_.jcc(L, exponential);
+    a_.cmp(R14, 16);
+    a_.jcc(G, exponential);
+    a_.test(R14, R14);
+    a_.jcc(G, small);
+    write("0.");
+    a_.mov(RBX, R14);
+    a_.neg(RBX);
+    zeros();
+    a_.lea(RDI, mem(digits_));
+    a_.mov(RSI, R13);
+    call(WRITE);
+    a_.jmp(done);
+    a_.bind(small);
+    a_.cmp(R14, R13);
+    a_.jcc(L, middle);
+    a_.lea(RDI, mem(digits_));
+    a_.mov(RSI, R13);
+    call(WRITE);
+    a_.mov(RBX, R14);
+    a_.sub(RBX, R13);
+    zeros();
+    write(".0");
+    a_.jmp(done);
+    a_.bind(middle);
+    a_.lea(RDI, mem(digits_));
+    a_.mov(RSI, R14);
+    call(WRITE);
+    put('.');
+    a_.lea(RDI, mem(digits_));
+    a_.add(RDI, R14);
+    a_.mov(RSI, R13);
+    a_.sub(RSI, R14);
+    call(WRITE);
+    a_.jmp(done);
+
+    Label sign = a_.label();
+    Label plus = a_.label();
+    Label print = a_.label();
+    a_.bind(exponential);
+    a_.lea(RAX, mem(digits_));
+    a_.movzxb(RDI, mem(RAX));
+    a_.call(putc_);
+    a_.cmp(R13, 1);
+    a_.jcc(LE, sign);
+    put('.');
+    a_.lea(RDI, mem(digits_, 1));
+    a_.lea(RSI, mem(R13, -1));
+    call(WRITE);
+    a_.bind(sign);
+    put('e');
+    a_.lea(RBX, mem(R14, -1));
+    a_.test(RBX, RBX);
+    a_.jcc(NS, plus);
+    put('-');
+    a_.neg(RBX);
+    a_.jmp(print);
+    a_.bind(plus);
+    put('+');
+    a_.bind(print);
+    a_.cmp(RBX, 10);
+    Label twoDigits = a_.label();
+    a_.jcc(GE, twoDigits);
+    put('0');
+    a_.bind(twoDigits);
+    a_.mov(RDI, RBX);
+    call(PRINT_INT);
+
+    a_.bind(done);
+    a_.add(RSP, 16);
+    for (Register reg : {R15, R14, R13, R12, RBX}) {
+        a_.pop(reg);
+    }
+    a_.ret();
+}
+
+/**
+ * @brief  Arithmetic on the bignums: natural numbers of LIMBS limbs, their
+ *         length is the number of limbs used (the other limbs are zero).
+ */
+void Runtime::emitBignums() {
+    Label loop = a_.label();
+    Label done = a_.label();
+
+    // set: rdi = rsi * 2^rdx
+    a_.bind(bigSet_);
+    a_.mov(R8, RDI);
+    a_.mov(R9, RSI);
+    a_.mov(R10, RDX);
+    a_.lea(RDI, mem(R8, 8));
+    a_.mov(RCX, LIMBS);
+    a_.xor_(RAX, RAX);
+    a_.repStosq();
+    a_.mov(RAX, R10);
+    a_.shr(RAX, 6);
+    a_.mov(RCX, R10);
+    a_.and_(RCX, 63);
+    a_.mov(RDX, R9);
+    a_.shl(RDX);
+    a_.mov(mem(R8, RAX, 8, 8), RDX);
+    a_.lea(RDX, mem(RAX, 1));
+    a_.mov(mem(R8), RDX);
+    a_.test(RCX, RCX);
+    a_.jcc(E, done);
+    a_.mov(RDX, R9);
+    a_.neg(RCX);
+    a_.shr(RDX);
+    a_.mov(mem(R8, RAX, 8, 16), RDX);
+    a_.lea(RDX, mem(RAX, 2));
+    a_.mov(mem(R8), RDX);
+    a_.bind(done);
+    a_.ret();
+
+    // multiply: rdi *= rsi
+    loop = a_.label();
+    done = a_.label();
+    Label end = a_.label();
+    a_.bind(bigMul_);
+    a_.mov(R10, mem(RDI));
+    a_.xor_(R8, R8); // carry
+    a_.xor_(R9, R9);
+    a_.xor_(RCX, RCX);
+    a_.bind(loop);
+    a_.cmp(RCX, R10);
+    a_.jcc(AE, end);
+    a_.mov(RAX, mem(RDI, RCX, 8, 8));
+    a_.mul(RSI);
+    a_.add(RAX, R8);
+    a_.adc(RDX, R9);
+    a_.mov(mem(RDI, RCX, 8, 8), RAX);
+    a_.mov(R8, RDX);
+    a_.inc(RCX);
+    a_.jmp(loop);
+    a_.bind(end);
+    a_.test(R8, R8);
+    a_.jcc(E, done);
+    a_.mov(mem(RDI, R10, 8, 8), R8);
+    a_.inc(R10);
+    a_.mov(mem(RDI), R10);
+    a_.bind(done);
+    a_.ret();
+
+    // power of ten: rdi *= 10^rsi, by 10^19 at most
+    loop = a_.label();
+    done = a_.label();
+    Label rest = a_.label();
+    a_.bind(bigPow10_);
+    a_.push(RBX);
+    a_.push(R12);
+    a_.mov(RBX, RDI);
+    a_.mov(R12, RSI);
+    a_.bind(loop);
+    a_.cmp(R12, 19);
+    a_.jcc(B, rest);
+    a_.mov(RDI, RBX);
+    a_.mov(RSI, mem(powers_, 19 * 8));
+    a_.call(bigMul_);
+    a_.sub(R12, 19);
+    a_.jmp(loop);
+    a_.bind(rest);
+    a_.test(R12, R12);
+    a_.jcc(E, done);
+    a_.mov(RDI, RBX);
+    a_.lea(RAX, mem(powers_));
+    a_.mov(RSI, mem(RAX, R12, 8));
+    a_.call(bigMul_);
+    a_.bind(done);
+    a_.pop(R12);
+    a_.pop(RBX);
+    a_.ret();
+
+    // add: rdi = rsi + rdx (the loop keeps the carry: lea and dec)
+    loop = a_.label();
+    done = a_.label();
+    Label clear = a_.label();
+    a_.bind(bigAdd_);
+    a_.mov(R8, mem(RSI));
+    a_.mov(RAX, mem(RDX));
+    a_.cmp(R8, RAX);
+    a_.cmov(B, R8, RAX);
+    a_.mov(R10, mem(RDI));
+    a_.mov(R9, R8);
+    a_.xor_(RCX, RCX);
+    a_.bind(loop);
+    a_.mov(RAX, mem(RSI, RCX, 8, 8));
+    a_.adc(RAX, mem(RDX, RCX, 8, 8));
+    a_.mov(mem(RDI, RCX, 8, 8), RAX);
+    a_.lea(RCX, mem(RCX, 1));
+    a_.dec(R9);
+    a_.jcc(NE, loop);
+    a_.setcc(B, RAX);
+    a_.movzxb(RAX, RAX);
+    a_.mov(mem(RDI, R8, 8, 8), RAX);
+    a_.add(R8, RAX);
+    a_.mov(mem(RDI), R8);
+    a_.mov(RCX, R8);
+    a_.bind(clear); // the limbs of the previous value
+    a_.cmp(RCX, R10);
+    a_.jcc(AE, done);
+    a_.mov(mem(RDI, RCX, 8, 8), 0);
+    a_.inc(RCX);
+    a_.jmp(clear);
+    a_.bind(done);
+    a_.ret();
+
+    // subtract: rdi -= rsi (rdi >= rsi)
+    loop = a_.label();
+    a_.bind(bigSub_);
+    a_.mov(R9, mem(RDI));
+    a_.xor_(RCX, RCX);
+    a_.bind(loop);
+    a_.mov(RAX, mem(RDI, RCX, 8, 8));
+    a_.sbb(RAX, mem(RSI, RCX, 8, 8));
+    a_.mov(mem(RDI, RCX, 8, 8), RAX);
+    a_.lea(RCX, mem(RCX, 1));
+    a_.dec(R9);
+    a_.jcc(NE, loop);
+    a_.ret();
+
+    // compare: rax = -1, 0 or 1 when rdi <, = or > rsi
+    loop = a_.label();
+    Label less = a_.label();
+    Label greater = a_.label();
+    Label equal = a_.label();
+    a_.bind(bigCmp_);
+    a_.mov(RCX, mem(RDI));
+    a_.mov(RAX, mem(RSI));
+    a_.cmp(RCX, RAX);
+    a_.cmov(B, RCX, RAX);
+    a_.bind(loop);
+    a_.sub(RCX, 1);
+    a_.jcc(S, equal);
+    a_.mov(RAX, mem(RDI, RCX, 8, 8));
+    a_.cmp(RAX, mem(RSI, RCX, 8, 8));
+    a_.jcc(B, less);
+    a_.jcc(A, greater);
+    a_.jmp(loop);
+    a_.bind(equal);
+    a_.xor_(RAX, RAX);
+    a_.ret();
+    a_.bind(less);
+    a_.mov(RAX, int64_t(-1));
+    a_.ret();
+    a_.bind(greater);
+    a_.mov(RAX, 1);
+    a_.ret();
+}
+
+/******************************************************************************/
+/*                                   input                                    */
+/******************************************************************************/
+
+/**
+ * @brief  Skip the white spaces of the line (rbx: position, r12: end).
+ */
+static void skipSpaces(Assembler &a) {
+    Label loop = a.label();
+    Label next = a.label();
+    Label done = a.label();
+
+    a.bind(loop);
+    a.cmp(RBX, R12);
+    a.jcc(AE, done);
+    a.movzxb(RAX, mem(RBX));
+    a.cmp(RAX, ' ');
+    a.jcc(E, next);
+    a.sub(RAX, '\t');
+    a.cmp(RAX, '\r' - '\t');
+    a.jcc(A, done);
+    a.bind(next);
+    a.inc(RBX);
+    a.jmp(loop);
+    a.bind(done);
+}
+
+/**
+ * @brief  Sign of the number (r13 = 1 when it is negative).
+ */
+static void readSign(Assembler &a) {
+    Label minus = a.label();
+    Label done = a.label();
+
+    a.xor_(R13, R13);
+    a.cmp(RBX, R12);
+    a.jcc(AE, done);
+    a.movzxb(RAX, mem(RBX));
+    a.cmp(RAX, '-');
+    a.jcc(E, minus);
+    a.cmp(RAX, '+');
+    a.jcc(NE, done);
+    a.dec(R13);
+    a.bind(minus);
+    a.inc(R13);
+    a.inc(RBX);
+    a.bind(done);
+}
+
+void Runtime::emitInput() {
+    Label have = a_.label();
+    Label retry = a_.label();
+    Label end = a_.label();
+
+    // getc: the next byte in rax, -1 at the end of the input
+    a_.bind(getc_);
+    a_.mov(RAX, mem(inPosition_));
+    a_.cmp(RAX, mem(inLength_));
+    a_.jcc(B, have);
+    a_.call(flush_); // the prompts are written before waiting
+    a_.bind(retry);
+    a_.xor_(RDI, RDI);
+    a_.lea(RSI, mem(in_));
+    a_.mov(RDX, IN_SIZE);
+    a_.mov(RAX, SYS_READ);
+    a_.syscall();
+    a_.cmp(RAX, -INTERRUPTED);
+    a_.jcc(E, retry);
+    a_.test(RAX, RAX);
+    a_.jcc(LE, end);
+    a_.mov(mem(inLength_), RAX);
+    a_.mov(mem(inPosition_), 0);
+    a_.xor_(RAX, RAX);
+    a_.bind(have);
+    a_.lea(RCX, mem(in_));
+    a_.movzxb(RDX, mem(RCX, RAX, 1));
+    a_.inc(RAX);
+    a_.mov(mem(inPosition_), RAX);
+    a_.mov(RAX, RDX);
+    a_.ret();
+    a_.bind(end);
+    a_.mov(RAX, int64_t(-1));
+    a_.ret();
+
+    // read line: the line (without the newline) in line_, its size in rax,
+    // the end of the bytes of a line that is too long is dropped
+    Label loop = a_.label();
+    Label done = a_.label();
+    end = a_.label();
+    a_.bind(readLine_);
+    a_.push(RBX);
+    a_.push(R12);
+    a_.xor_(RBX, RBX);
+    a_.xor_(R12, R12); // something was read
+    a_.bind(loop);
+    a_.call(getc_);
+    a_.test(RAX, RAX);
+    a_.jcc(S, end);
+    a_.mov(R12, 1);
+    a_.cmp(RAX, '\n');
+    a_.jcc(E, done);
+    a_.cmp(RBX, LINE_SIZE);
+    a_.jcc(AE, loop);
+    a_.lea(RCX, mem(line_));
+    a_.movb(mem(RCX, RBX, 1), RAX);
+    a_.inc(RBX);
+    a_.jmp(loop);
+    a_.bind(end);
+    a_.test(R12, R12);
+    a_.jcc(E, errors_[END_OF_FILE]);
+    a_.bind(done);
+    a_.mov(RAX, RBX);
+    a_.pop(R12);
+    a_.pop(RBX);
+    a_.ret();
+
+    // read char: the first character of the line in UTF-8, 0 when it is empty
+    Label length = a_.label();
+    Label ret = a_.label();
+    loop = a_.label();
+    a_.bind(routines_[READ_CHAR]);
+    a_.call(readLine_);
+    a_.lea(RSI, mem(line_));
+    a_.mov(R8, RAX);
+    a_.test(RAX, RAX);
+    a_.jcc(E, ret);
+    a_.movzxb(RAX, mem(RSI));
+    a_.cmp(RAX, 0x80);
+    a_.jcc(B, ret);
+    a_.mov(RCX, 1); // continuation bytes
+    a_.cmp(RAX, 0xE0);
+    a_.jcc(B, length);
+    a_.mov(RCX, 2);
+    a_.cmp(RAX, 0xF0);
+    a_.jcc(B, length);
+    a_.mov(RCX, 3);
+    a_.bind(length);
+    a_.mov(RDX, 0x3F);
+    a_.shr(RDX);
+    a_.and_(RAX, RDX);
+    a_.mov(R9, 1);
+    a_.bind(loop);
+    a_.cmp(R9, RCX);
+    a_.jcc(A, ret);
+    a_.cmp(R9, R8);
+    a_.jcc(AE, ret);
+    a_.movzxb(RDX, mem(RSI, R9, 1));
+    a_.mov(R10, RDX);
+    a_.and_(R10, 0xC0);
+    a_.cmp(R10, 0x80);
+    a_.jcc(NE, ret);
+    a_.shl(RAX, 6);
+    a_.and_(RDX, 0x3F);
+    a_.or_(RAX, RDX);
+    a_.inc(R9);
+    a_.jmp(loop);
+    a_.bind(ret);
+    a_.ret();
+}
+
+/**
+ * @brief  Read int: like python's int(input()), with the integers of 64 bits.
+ *
+ *         rbx: position, r12: end of the line, r13: sign, r14: value,
+ *         r15: number of digits
+ */
+void Runtime::emitReadInt() {
+    Label digits = a_.label();
+    Label underscore = a_.label();
+    Label end = a_.label();
+    Label positive = a_.label();
+    Label error = a_.label();
+
+    a_.bind(routines_[READ_INT]);
+    for (Register reg : {RBX, R12, R13, R14, R15}) {
+        a_.push(reg);
+    }
+    a_.call(readLine_);
+    a_.lea(RBX, mem(line_));
+    a_.lea(R12, mem(RBX, RAX, 1));
+    skipSpaces(a_);
+    readSign(a_);
+    a_.xor_(R14, R14);
+    a_.xor_(R15, R15);
+    a_.bind(digits);
+    a_.cmp(RBX, R12);
+    a_.jcc(AE, end);
+    a_.movzxb(RAX, mem(RBX));
+    a_.sub(RAX, '0');
+    a_.cmp(RAX, 9);
+    a_.jcc(A, underscore);
+    a_.imul(R14, R14, 10);
+    a_.jcc(O, errors_[OVERFLOW]);
+    a_.add(R14, RAX);
+    a_.jcc(O, errors_[OVERFLOW]);
+    a_.inc(R15);
+    a_.inc(RBX);
+    a_.jmp(digits);
+    // a single underscore between two digits
+    a_.bind(underscore);
+    a_.cmp(RAX, '_' - '0');
+    a_.jcc(NE, end);
+    a_.test(R15, R15);
+    a_.jcc(E, end);
+    a_.lea(RCX, mem(RBX, 1));
+    a_.cmp(RCX, R12);
+    a_.jcc(AE, end);
+    a_.movzxb(RAX, mem(RCX));
+    a_.sub(RAX, '0');
+    a_.cmp(RAX, 9);
+    a_.jcc(A, end);
+    a_.inc(RBX);
+    a_.jmp(digits);
+    a_.bind(end);
+    skipSpaces(a_);
+    a_.test(R15, R15);
+    a_.jcc(E, error);
+    a_.cmp(RBX, R12);
+    a_.jcc(NE, error);
+    a_.test(R13, R13);
+    a_.jcc(E, positive);
+    a_.neg(R14);
+    a_.bind(positive);
+    a_.mov(RAX, R14);
+    for (Register reg : {R15, R14, R13, R12, RBX}) {
+        a_.pop(reg);
+    }
+    a_.ret();
+    a_.bind(error);
+    a_.lea(RDI, mem(line_));
+    a_.mov(RSI, R12);
+    a_.sub(RSI, RDI);
+    a_.jmp(errors_[INT_LITERAL]);
+}
+
+/**
+ * @brief  Read float: like python's float(input()). The decimal number is
+ *         m * 10^E (m has at most 19 digits), it is approximated with the
+ *         floats, then the approximation is moved to the closest float by
+ *         comparing the number to the middles between the floats, with
+ *         exact integers (see compareScaled).
+ *
+ *         rbx: position, r12: end of the line, r13: sign, then m, r14: E,
+ *         r15: sign
+ */
+void Runtime::emitReadFloat() {
+    Label error = a_.label();
+    Label number = a_.label();
+    Label nan = a_.label();
+    Label word = a_.label();
+    Label integral = a_.label();
+    Label dropped = a_.label();
+    Label nextIntegral = a_.label();
+    Label integralEnd = a_.label();
+    Label fraction = a_.label();
+    Label nextFraction = a_.label();
+    Label mantissaEnd = a_.label();
+    Label exponentDigit = a_.label();
+    Label capped = a_.label();
+    Label exponentEnd = a_.label();
+    Label addExponent = a_.label();
+    Label end = a_.label();
+    Label large = a_.label();
+    Label scale = a_.label();
+    Label multiply = a_.label();
+    Label multiplyRest = a_.label();
+    Label divide = a_.label();
+    Label divideRest = a_.label();
+    Label approximated = a_.label();
+    Label refine = a_.label();
+    Label finite = a_.label();
+    Label subnormal = a_.label();
+    Label decomposed = a_.label();
+    Label up = a_.label();
+    Label lower = a_.label();
+    Label equalGaps = a_.label();
+    Label compareLower = a_.label();
+    Label down = a_.label();
+    Label zero = a_.label();
+    Label infinite = a_.label();
+    Label done = a_.label();
+    Label sign = a_.label();
+    Label ret = a_.label();
+    // the word (lower case) is at the position, the position goes after it
+    auto matchWord = [this](std::string const &text, Label fail) {
+        a_.mov(RAX, R12);
+        a_.sub(RAX, RBX);
+        a_.cmp(RAX, static_cast<int32_t>(text.size()));
+        a_.jcc(L, fail);
+        for (size_t i = 0; i < text.size(); ++i) {
+            a_.movzxb(RAX, mem(RBX, static_cast<int32_t>(i)));
+            a_.or_(RAX, 0x20);
+            a_.cmp(RAX, text[i]);
+            a_.jcc(NE, fail);
+        }
+        a_.add(RBX, static_cast<int32_t>(text.size()));
+    };
+    // a decimal digit: the position is checked and the digit is in rax, a
+    // single underscore between two digits is skipped
+    auto decimalDigit = [this](Label other) {
+        Label digit = a_.label();
+        a_.cmp(RBX, R12);
+        a_.jcc(AE, other);
+        a_.movzxb(RAX, mem(RBX));
+        a_.cmp(RAX, '_');
+        a_.jcc(NE, digit);
+        a_.lea(R10, mem(line_));
+        a_.cmp(RBX, R10);
+        a_.jcc(E, other);
+        a_.lea(R10, mem(RBX, 1));
+        a_.cmp(R10, R12);
+        a_.jcc(AE, other);
+        for (int32_t offset : {-1, 1}) {
+            a_.movzxb(R10, mem(RBX, offset));
+            a_.sub(R10, '0');
+            a_.cmp(R10, 9);
+            a_.jcc(A, other);
+        }
+        a_.inc(RBX);
+        a_.movzxb(RAX, mem(RBX));
+        a_.bind(digit);
+        a_.sub(RAX, '0');
+        a_.cmp(RAX, 9);
+        a_.jcc(A, other);
+    };
+
+    a_.bind(routines_[READ_FLOAT]);
+    for (Register reg : {RBX, R12, R13, R14, R15}) {
+        a_.push(reg);
+    }
+    // [rsp]: kept digits, [rsp + 8]: a digit was read, [rsp + 16]: bits of
+    // the float, [rsp + 24]: its mantissa, [rsp + 32]: its exponent,
+    // [rsp + 40]: its biased exponent
+    a_.sub(RSP, 48);
+    a_.call(readLine_);
+    a_.lea(RBX, mem(line_));
+    a_.lea(R12, mem(RBX, RAX, 1));
+    skipSpaces(a_);
+    readSign(a_);
+    a_.mov(R15, R13);
+
+    // inf, infinity and nan
+    a_.cmp(RBX, R12);
+    a_.jcc(AE, number);
+    a_.movzxb(RAX, mem(RBX));
+    a_.or_(RAX, 0x20);
+    a_.cmp(RAX, 'a');
+    a_.jcc(B, number);
+    a_.cmp(RAX, 'z');
+    a_.jcc(A, number);
+    matchWord("inf", nan);
+    a_.mov(RAX, static_cast<int64_t>(INFINITE));
+    a_.mov(mem(RSP, 16), RAX);
+    Label infinity = a_.label();
+    matchWord("inity", infinity);
+    a_.bind(infinity);
+    a_.jmp(word);
+    a_.bind(nan);
+    matchWord("nan", error);
+    a_.mov(RAX, static_cast<int64_t>(INFINITE | (HIDDEN >> 1)));
+    a_.mov(mem(RSP, 16), RAX);
+    a_.bind(word);
+    skipSpaces(a_);
+    a_.cmp(RBX, R12);
+    a_.jcc(NE, error);
+    a_.jmp(sign);
+
+    // mantissa: the leading zeros are skipped, the digits after the 19th
+    // are dropped (the integral ones are counted in E)
+    a_.bind(number);
+    a_.xor_(R13, R13);
+    a_.xor_(R14, R14);
+    a_.mov(mem(RSP), 0);
+    a_.mov(mem(RSP, 8), 0);
+    a_.bind(integral);
+    decimalDigit(integralEnd);
+    a_.mov(mem(RSP, 8), 1);
+    a_.cmp(mem(RSP), 19);
+    a_.jcc(AE, dropped);
+    a_.mov(RCX, R13);
+    a_.or_(RCX, RAX);
+    a_.jcc(E, nextIntegral);
+    a_.imul(R13, R13, 10);
+    a_.add(R13, RAX);
+    a_.inc(mem(RSP));
+    a_.jmp(nextIntegral);
+    a_.bind(dropped);
+    a_.inc(R14);
+    a_.bind(nextIntegral);
+    a_.inc(RBX);
+    a_.jmp(integral);
+    a_.bind(integralEnd);
+    a_.cmp(RBX, R12);
+    a_.jcc(AE, mantissaEnd);
+    a_.movzxb(RAX, mem(RBX));
+    a_.cmp(RAX, '.');
+    a_.jcc(NE, mantissaEnd);
+    a_.inc(RBX);
+    a_.bind(fraction);
+    decimalDigit(mantissaEnd);
+    a_.mov(mem(RSP, 8), 1);
+    a_.cmp(mem(RSP), 19);
+    a_.jcc(AE, nextFraction);
+    a_.dec(R14);
+    a_.mov(RCX, R13);
+    a_.or_(RCX, RAX);
+    a_.jcc(E, nextFraction);
+    a_.imul(R13, R13, 10);
+    a_.add(R13, RAX);
+    a_.inc(mem(RSP));
+    a_.bind(nextFraction);
+    a_.inc(RBX);
+    a_.jmp(fraction);
+    a_.bind(mantissaEnd);
+    a_.cmp(mem(RSP, 8), 0);
+    a_.jcc(E, error);
+
+    // exponent (rcx, its sign in r8, its digits in r9), it is capped: the
+    // number is 0 or infinite long before
+    a_.cmp(RBX, R12);
+    a_.jcc(AE, end);
+    a_.movzxb(RAX, mem(RBX));
+    a_.or_(RAX, 0x20);
+    a_.cmp(RAX, 'e');
+    a_.jcc(NE, end);
+    a_.inc(RBX);
+    a_.xor_(RCX, RCX);
+    a_.xor_(R9, R9);
+    a_.push(R13);
+    readSign(a_);
+    a_.mov(R8, R13);
+    a_.pop(R13);
+    a_.bind(exponentDigit);
+    decimalDigit(exponentEnd);
+    a_.inc(R9);
+    a_.cmp(RCX, 100000);
+    a_.jcc(AE, capped);
+    a_.imul(RCX, RCX, 10);
+    a_.add(RCX, RAX);
+    a_.bind(capped);
+    a_.inc(RBX);
+    a_.jmp(exponentDigit);
+    a_.bind(exponentEnd);
+    a_.test(R9, R9);
+    a_.jcc(E, error);
+    a_.test(R8, R8);
+    a_.jcc(E, addExponent);
+    a_.neg(RCX);
+    a_.bind(addExponent);
+    a_.add(R14, RCX);
+    a_.bind(end);
+    skipSpaces(a_);
+    a_.cmp(RBX, R12);
+    a_.jcc(NE, error);
+
+    // approximation: the number has kept + E digits
+    a_.test(R13, R13);
+    a_.jcc(E, zero);
+    a_.mov(RAX, mem(RSP));
+    a_.add(RAX, R14);
+    a_.cmp(RAX, 310);
+    a_.jcc(G, infinite);
+    a_.cmp(RAX, -330);
+    a_.jcc(L, zero);
+    a_.test(R13, R13);
+    a_.jcc(S, large);
+    a_.cvtsi2sd(XMM0, R13);
+    a_.jmp(scale);
+    a_.bind(large); // unsigned: half of it, rounded to odd
+    a_.mov(RAX, R13);
+    a_.shr(RAX, 1);
+    a_.mov(RCX, R13);
+    a_.and_(RCX, 1);
+    a_.or_(RAX, RCX);
+    a_.cvtsi2sd(XMM0, RAX);
+    a_.addsd(XMM0, XMM0);
+    a_.bind(scale);
+    a_.mov(RCX, R14);
+    a_.test(RCX, RCX);
+    a_.jcc(S, divide);
+    a_.bind(multiply);
+    a_.cmp(RCX, 22);
+    a_.jcc(L, multiplyRest);
+    a_.mulsd(XMM0, mem(tens_, 22 * 8));
+    a_.sub(RCX, 22);
+    a_.jmp(multiply);
+    a_.bind(multiplyRest);
+    a_.lea(RAX, mem(tens_));
+    a_.mulsd(XMM0, mem(RAX, RCX, 8));
+    a_.jmp(approximated);
+    a_.bind(divide);
+    a_.neg(RCX);
+    Label divideLoop = a_.label();
+    a_.bind(divideLoop);
+    a_.cmp(RCX, 22);
+    a_.jcc(L, divideRest);
+    a_.divsd(XMM0, mem(tens_, 22 * 8));
+    a_.sub(RCX, 22);
+    a_.jmp(divideLoop);
+    a_.bind(divideRest);
+    a_.lea(RAX, mem(tens_));
+    a_.divsd(XMM0, mem(RAX, RCX, 8));
+    a_.bind(approximated);
+    a_.movq(RAX, XMM0);
+    a_.mov(mem(RSP, 16), RAX);
+
+    // refinement: the float f * 2^e is the closest one when the number is
+    // between the middles (2f - 1) * 2^(e - 1) and (2f + 1) * 2^(e - 1)
+    // (the one below is (4f - 1) * 2^(e - 2) at the bottom of a binade)
+    a_.bind(refine);
+    a_.mov(RAX, mem(RSP, 16));
+    a_.mov(RCX, static_cast<int64_t>(INFINITE));
+    a_.cmp(RAX, RCX);
+    a_.jcc(B, finite);
+    // infinite when the number reaches the middle after the largest float
+    a_.mov(RDI, R13);
+    a_.mov(RSI, R14);
+    a_.mov(RDX, (int64_t(1) << 54) - 1);
+    a_.mov(RCX, 970);
+    a_.call(compareScaled_);
+    a_.test(RAX, RAX);
+    a_.jcc(NS, infinite);
+    a_.mov(RAX, static_cast<int64_t>(INFINITE - 1));
+    a_.mov(mem(RSP, 16), RAX);
+    a_.jmp(refine);
+    a_.bind(finite);
+    a_.mov(RCX, RAX);
+    a_.shr(RCX, 52);
+    a_.mov(mem(RSP, 40), RCX);
+    a_.mov(RDX, static_cast<int64_t>(MANTISSA));
+    a_.and_(RDX, RAX);
+    a_.test(RCX, RCX);
+    a_.jcc(E, subnormal);
+    a_.mov(R8, static_cast<int64_t>(HIDDEN));
+    a_.or_(RDX, R8);
+    a_.sub(RCX, 1075);
+    a_.jmp(decomposed);
+    a_.bind(subnormal);
+    a_.mov(RCX, int64_t(-1074));
+    a_.bind(decomposed);
+    a_.mov(mem(RSP, 24), RDX);
+    a_.mov(mem(RSP, 32), RCX);
+    a_.mov(RDI, R13);
+    a_.mov(RSI, R14);
+    a_.lea(RDX, mem(RDX, RDX, 1, 1));
+    a_.dec(RCX);
+    a_.call(compareScaled_);
+    a_.test(RAX, RAX);
+    a_.jcc(G, up);
+    a_.jcc(L, lower);
+    a_.mov(RAX, mem(RSP, 24)); // tie: to the even mantissa
+    a_.and_(RAX, 1);
+    a_.jcc(E, done);
+    a_.inc(mem(RSP, 16));
+    a_.jmp(done);
+    a_.bind(up);
+    a_.inc(mem(RSP, 16));
+    a_.jmp(refine);
+    a_.bind(lower);
+    a_.mov(RDX, mem(RSP, 24));
+    a_.test(RDX, RDX);
+    a_.jcc(E, done);
+    a_.mov(RCX, mem(RSP, 32));
+    a_.mov(RAX, static_cast<int64_t>(HIDDEN));
+    a_.cmp(RDX, RAX);
+    a_.jcc(NE, equalGaps);
+    a_.cmp(mem(RSP, 40), 1);
+    a_.jcc(BE, equalGaps);
+    a_.shl(RDX, 2);
+    a_.dec(RDX);
+    a_.sub(RCX, 2);
+    a_.jmp(compareLower);
+    a_.bind(equalGaps);
+    a_.add(RDX, RDX);
+    a_.dec(RDX);
+    a_.dec(RCX);
+    a_.bind(compareLower);
+    a_.mov(RDI, R13);
+    a_.mov(RSI, R14);
+    a_.call(compareScaled_);
+    a_.test(RAX, RAX);
+    a_.jcc(L, down);
+    a_.jcc(G, done);
+    a_.mov(RAX, mem(RSP, 24));
+    a_.and_(RAX, 1);
+    a_.jcc(E, done);
+    a_.dec(mem(RSP, 16));
+    a_.jmp(done);
+    a_.bind(down);
+    a_.dec(mem(RSP, 16));
+    a_.jmp(refine);
+    a_.bind(zero);
+    a_.mov(mem(RSP, 16), 0);
+    a_.jmp(done);
+    a_.bind(infinite);
+    a_.mov(RAX, static_cast<int64_t>(INFINITE));
+    a_.mov(mem(RSP, 16), RAX);
+
+    a_.bind(done);
+    a_.bind(sign);
+    a_.mov(RAX, mem(RSP, 16));
+    a_.test(R15, R15);
+    a_.jcc(E, ret);
+    a_.mov(RCX, static_cast<int64_t>(SIGN));
+    a_.or_(RAX, RCX);
+    a_.bind(ret);
+    a_.movq(XMM0, RAX);
+    a_.add(RSP, 48);
+    for (Register reg : {R15, R14, R13, R12, RBX}) {
+        a_.pop(reg);
+    }
+    a_.ret();
+    a_.bind(error);
+    a_.lea(RDI, mem(line_));
+    a_.mov(RSI, R12);
+    a_.sub(RSI, RDI);
+    a_.jmp(errors_[FLOAT_LITERAL]);
+
+    // compare scaled: the sign of rdi * 10^rsi - rdx * 2^rcx in rax (rdi
+    // and rdx are unsigned)
+    Label positiveExponent = a_.label();
+    Label compare = a_.label();
+    a_.bind(compareScaled_);
+    for (Register reg : {RBX, R12, R13, R14}) {
+        a_.push(reg);
+    }
+    a_.mov(RBX, RDI);
+    a_.mov(R12, RSI);
+    a_.mov(R13, RDX);
+    a_.mov(R14, RCX);
+    // r = m * 2^max(-h, 0) * 10^max(E, 0)
+    loadBignum(RDI, NUMERATOR);
+    a_.mov(RSI, RBX);
+    a_.mov(RDX, R14);
+    a_.neg(RDX);
+    a_.xor_(RAX, RAX);
+    a_.test(RDX, RDX);
+    a_.cmov(S, RDX, RAX);
+    a_.call(bigSet_);
+    a_.test(R12, R12);
+    a_.jcc(LE, positiveExponent);
+    loadBignum(RDI, NUMERATOR);
+    a_.mov(RSI, R12);
+    a_.call(bigPow10_);
+    // s = g * 2^max(h, 0) * 10^max(-E, 0)
+    a_.bind(positiveExponent);
+    loadBignum(RDI, DENOMINATOR);
+    a_.mov(RSI, R13);
+    a_.mov(RDX, R14);
+    a_.xor_(RAX, RAX);
+    a_.test(RDX, RDX);
+    a_.cmov(S, RDX, RAX);
+    a_.call(bigSet_);
+    a_.test(R12, R12);
+    a_.jcc(GE, compare);
+    loadBignum(RDI, DENOMINATOR);
+    a_.mov(RSI, R12);
+    a_.neg(RSI);
+    a_.call(bigPow10_);
+    a_.bind(compare);
+    loadBignum(RDI, NUMERATOR);
+    loadBignum(RSI, DENOMINATOR);
+    a_.call(bigCmp_);
+    for (Register reg : {R14, R13, R12, RBX}) {
+        a_.pop(reg);
+    }
+    a_.ret();
+}
+
+/******************************************************************************/
+/*                                   arrays                                   */
+/******************************************************************************/
+
+/**
+ * @brief  An array is its size followed by its elements (8 bytes each). They
+ *         are allocated on the heap (see heapTop) and zeroed.
+ */
+void Runtime::emitArrays() {
+    a_.bind(routines_[NEW_ARRAY]);
+    a_.mov(RSI, RDI);
+    a_.mov(RAX, mem(heapTop_));
+    a_.lea(RCX, mem(RAX, RSI, 8, 8));
+    a_.cmp(RCX, mem(heapEnd_));
+    a_.jcc(A, errors_[MEMORY]);
+    a_.mov(mem(heapTop_), RCX);
+    a_.mov(mem(RAX), RSI);
+    a_.mov(RDX, RAX);
+    a_.lea(RDI, mem(RAX, 8));
+    a_.mov(RCX, RSI);
+    a_.xor_(RAX, RAX);
+    a_.repStosq();
+    a_.mov(RAX, RDX);
+    a_.ret();
+
+    a_.bind(routines_[CLEAR_ARRAY]);
+    a_.mov(RDX, RDI);
+    a_.mov(RCX, mem(RDI));
+    a_.lea(RDI, mem(RDI, 8));
+    a_.xor_(RAX, RAX);
+    a_.repStosq();
+    a_.mov(RAX, RDX);
+    a_.ret();
+}
+
+} // namespace x86
@@ -0,0 +1,113 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+#include "assembler.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace x86 {
+
+/**
+ * @brief  Runtime of the native programs, written with the assembler: the
+ *         entry point, the output (buffered, the floats are written like
+ *         python's repr), the input, the arrays and the errors. It only uses
+ *         the system calls of Linux (read, write, mmap and exit_group).
+ *
+ *         The routines take their arguments in rdi and rsi (or xmm0), return
+ *         their result in rax (or xmm0), and only change rax, rcx, rdx, rsi,
+ *         rdi, r8 to r11 and xmm0 to xmm7. The errors are labels to jump to:
+ *         they write the message of the python exception on the standard
+ *         error and exit with the status 1.
+ *
+ *         The stack and the arrays are mapped when the program starts. The
+ *         arrays are allocated like a stack: a function saves the top of the
+ *         heap (see heapTop) and restores it when it returns.
+ *
+ * NOTE: the floats read with `ipt` are rounded correctly when they have at
+ *       most 19 significant digits (the following ones are ignored).
+ */
+class Runtime {
+  public:
+    enum Routine {
+        START,
+        FAIL,        //< rdi: message, rsi: its size
+        WRITE,       //< rdi: bytes, rsi: their number
+        PRINT_INT,   //< rdi
+        PRINT_FLOAT, //< xmm0
+        PRINT_CHAR,  //< rdi: the code of the character
+        PRINT_ARRAY, //< rdi: the array, rsi: 0 (int), 1 (flt) or 2 (chr)
+        READ_INT,
+        READ_FLOAT,
+        READ_CHAR,
+        NEW_ARRAY,   //< rdi: the number of elements
+        CLEAR_ARRAY, //< rdi: the array, it is returned
+        ROUTINES,
+    };
+
+    enum Error {
+        OVERFLOW,
+        INT_DIVISION,
+        FLOAT_DIVISION,
+        INDEX,
+        INDEX_ASSIGNMENT,
+        INT_LITERAL,   //< rdi: the text, rsi: its size (-1: rdi is a character)
+        FLOAT_LITERAL, //< same as INT_LITERAL
+        CHR_RANGE,
+        FLOAT_TO_INT, //< xmm0: the float (nan, infinite or too large)
+        RECURSION,
+        MEMORY,
+        END_OF_FILE,
+        ERRORS,
+    };
+
+    explicit Runtime(Assembler &assembler);
+
+    Label routine(Routine routine) const { return routines_[routine]; }
+    Label error(Error error) const { return errors_[error]; }
+    Label stackLimit() const { return stackLimit_; }
+    Label heapTop() const { return heapTop_; }
+    Label string(std::string const &text);
+    Label constant(uint64_t bits);
+
+    void emit(Label main);
+    void emitData();
+
+  private:
+    void emitStart(Label main);
+    void emitErrors();
+    void emitOutput();
+    void emitCharacters();
+    void emitPrintFloat();
+    void emitBignums();
+    void emitInput();
+    void emitReadInt();
+    void emitReadFloat();
+    void emitArrays();
+    void map(Register size, size_t minimum, Label done);
+    void write(std::string const &text);
+    void put(char c);
+    void call(Routine routine) { a_.call(routines_[routine]); }
+    void loadBignum(Register reg, size_t index);
+
+    Assembler &a_;
+    std::vector<Label> routines_ = {};
+    std::vector<Label> errors_ = {};
+    // internal routines
+    Label putc_, putUtf8_, escape_, reprChar_, reprString_ = {};
+    Label flush_, readLine_, getc_ = {};
+    Label bigSet_, bigMul_, bigPow10_, bigAdd_, bigSub_, bigCmp_ = {};
+    Label compareScaled_ = {};
+    // data
+    Label out_, outLength_, outFile_, in_, inPosition_, inLength_, line_ = {};
+    Label stackLimit_, heapTop_, heapEnd_, bignums_, digits_ = {};
+    // constants
+    Label powers_, tens_ = {};
+    std::map<std::string, Label> strings_ = {};
+    std::map<uint64_t, Label> constants_ = {};
+};
+
+} // namespace x86
+
+#endif
@@ -0,0 +1,56 @@
+#!/bin/sh
+# Differential test of the backends: each sample of tests/ is run by the
+# virtual machine (--run), compiled in C (--target=c --cc) and in x86_64
+# (--target=x86_64), and the outputs and the exit statuses must be the ones of
+# the python script (the samples rejected by the compiler are skipped).
+#
+# usage: tests/stress/backends.sh path/to/s3c [input]
+#
+# the input (default: 3) is given on each line of the standard input.
+
+S3C=$(realpath "$1")
+INPUT=${2:-3}
+TESTS=$(realpath "$(dirname "$0")/..")
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cd "$TMP" || exit 1
+# the included files are next to the samples
+cp -r "$TESTS"/. .
+
+# run: the command with the input, its output then its exit status
+run() {
+    yes -- "$INPUT" | head -n 1000 | "$@" 2> /dev/null
+    echo "exit: $?"
+}
+
+status=0
+for prog in "$TESTS"/*.prog; do
+    name=$(basename "$prog" .prog)
+    rm -f a.out
+    "$S3C" "./$name.prog" -o "$name.py" 2> /dev/null || continue
+    run python3 "$name.py" > expected.txt
+    for backend in run c x86_64; do
+        rm -f "$name.out"
+        case $backend in
+        run) run "$S3C" "./$name.prog" --run > got.txt ;;
+        c)
+            "$S3C" "./$name.prog" --target=c --cc -o "$name.out" \
+                2> /dev/null && run "./$name.out" > got.txt ;;
+        x86_64)
+            "$S3C" "./$name.prog" --target=x86_64 -o "$name.out" \
+                2> /dev/null && run "./$name.out" > got.txt ;;
+        esac || {
+            echo "FAIL: $name ($backend, not compiled)"
+            status=1
+            continue
+        }
+        if ! cmp -s expected.txt got.txt; then
+            echo "FAIL: $name ($backend)"
+            diff expected.txt got.txt | head -n 10
+            status=1
+        fi
+    done
+done
+
+[ "$status" -eq 0 ] && echo "OK: the backends agree with python"
+exit "$status"
@@ -0,0 +1,99 @@
+#!/bin/sh
+# Stress test for the deeply nested programs: the compiler must handle nested
+# expressions, blocks, loops and include chains without overflowing its stack,
+# and in a time linear in the depth.
+#
+# usage: tests/stress/deep-nesting.sh path/to/s3c [depth]
+
+S3C=$(realpath "$1")
+DEPTH=${2:-100000}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cd "$TMP" || exit 1
+
+fail() {
+    echo "FAIL: $1"
+    head -n 20 errors.txt
+    exit 1
+}
+
+# nested operators and array accesses: set(a, add(1, ... t[t[0]] ...))
+awk -v depth="$DEPTH" 'BEGIN {
+    print "nil main() bgn"
+    print "    int a"
+    print "    int t[1]"
+    printf "    set(a, "
+    for (i = 0; i < depth; ++i) printf "add(1, "
+    for (i = 0; i < depth; ++i) printf "t["
+    printf "0"
+    for (i = 0; i < depth; ++i) printf "]"
+    for (i = 0; i < depth; ++i) printf ")"
+    print ")"
+    print "end"
+}' > expressions.prog
+"$S3C" ./expressions.prog 2> errors.txt || fail "nested expressions"
+[ -f a.out ] || fail "nested expressions (no output)"
+
+# nested blocks and function calls, the AST is displayed by the interactive
+# mode (the generated python code would be too large)
+awk -v depth="$DEPTH" 'BEGIN {
+    print "int id(int a) bgn"
+    print "    ret a"
+    print "end"
+    print "nil main() bgn"
+    print "    int a"
+    for (i = 0; i < depth; ++i) print "cnd sup(a, 1) bgn"
+    printf "set(a, "
+    for (i = 0; i < depth; ++i) printf "id("
+    printf "1"
+    for (i = 0; i < depth; ++i) printf ")"
+    print ")"
+    for (i = 0; i < depth; ++i) print "end"
+    print "end"
+}' | "$S3C" > blocks.txt 2> errors.txt || fail "nested blocks"
+[ "$(grep -c '^If(' blocks.txt)" -eq "$DEPTH" ] || fail "nested blocks (bad AST)"
+
+# nested loops compiled through all the passes in a native executable (the
+# size of the functions of the virtual machine is limited, and the indentation
+# of the python script would be quadratic in the depth)
+awk -v depth="$DEPTH" 'BEGIN {
+    print "nil main() bgn"
+    print "    int a"
+    print "    int b"
+    print "    ipt(b)"
+    print "    set(a, 0)"
+    for (i = 0; i < depth; ++i) {
+        print "whl (inf(a, tms(b, 2))) bgn"
+        print "cnd sup(b, 0) bgn"
+        print "set(a, add(a, b))"
+        print "end"
+    }
+    for (i = 0; i < depth; ++i) print "end"
+    print "    shw(a)"
+    print "end"
+}' > loops.prog
+rm -f a.out
+"$S3C" ./loops.prog --target=x86_64 2> errors.txt || fail "nested loops"
+[ "$(echo 1 | ./a.out)" = 2 ] || fail "nested loops (bad result)"
+
+# include chain: each file uses the next one
+awk -v depth="$DEPTH" 'BEGIN {
+    for (i = 0; i < depth; ++i) {
+        file = "f" i ".prog"
+        if (i + 1 < depth) print "use f" (i + 1) > file
+        print "nil f" i "() bgn" > file
+        print "end" > file
+        close(file)
+    }
+    print "use f0" > "main.prog"
+    print "nil main() bgn" > "main.prog"
+    print "end" > "main.prog"
+}'
+rm -f a.out
+"$S3C" ./main.prog --stats 2> errors.txt || fail "include chain"
+# the functions are never called, so only main is generated
+[ "$(grep -c '^def ' a.out)" -eq 1 ] || fail "include chain (bad output)"
+grep -q "^dead function elimination: $DEPTH functions removed" errors.txt ||
+    fail "include chain (functions not parsed)"
+
+echo "OK: depth $DEPTH"